@@ -64,6 +64,37 @@ namespace Falcor
         }
     }
     
+    std::vector<uint8> CopyContext::readTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex)
+    {
+        return asyncReadTextureSubresource(pTexture, subresourceIndex)->getData();
+    }
+
+    CopyContext::ReadTextureTask::SharedPtr CopyContext::asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex)
+    {
+        return ReadTextureTask::create(this, pTexture, subresourceIndex);
+    }
+
+    std::vector<uint8> CopyContext::ReadTextureTask::getData()
+    {
+        // The fence is owned by this task, so waiting on it doesn't race with the context using its own fence on another thread
+        mpFence->syncCpu();
+
+        std::vector<uint8> result(size_t(mRowSize) * mRowCount * mDepth);
+        const uint8* pData = reinterpret_cast<const uint8*>(mpBuffer->map(Buffer::MapType::Read));
+
+        for (uint32_t z = 0; z < mDepth; z++)
+        {
+            for (uint32_t y = 0; y < mRowCount; y++)
+            {
+                const size_t row = size_t(z) * mRowCount + y;
+                memcpy(result.data() + row * mRowSize, pData + row * mRowPitch, mRowSize);
+            }
+        }
+
+        mpBuffer->unmap();
+        return result;
+    }
+
     void CopyContext::updateTexture(const Texture* pTexture, const void* pData)
     {
         mCommandsPending = true;
@@ -43,12 +43,40 @@ namespace Falcor
         using SharedConstPtr = std::shared_ptr<const CopyContext>;
         virtual ~CopyContext();
 
+        /** Texture readback which doesn't stall the CPU. The copy is submitted when the task is created, the data can be fetched later from any thread.
+        */
+        class ReadTextureTask
+        {
+        public:
+            using SharedPtr = std::shared_ptr<ReadTextureTask>;
+
+            /** Record and submit the copy of a texture subresource into a readback buffer
+            */
+            static SharedPtr create(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex);
+
+            /** Wait until the GPU finished the copy and return the tightly packed texel data
+            */
+            std::vector<uint8> getData();
+
+        private:
+            ReadTextureTask() = default;
+#ifdef FALCOR_LOW_LEVEL_API
+            GpuFence::SharedPtr mpFence;
+#endif
+            std::shared_ptr<Buffer> mpBuffer;
+            uint32_t mRowSize = 0;
+            uint32_t mRowPitch = 0;
+            uint32_t mRowCount = 0;
+            uint32_t mDepth = 0;
+        };
+
         static SharedPtr create(CommandQueueHandle queue);
         void updateBuffer(const Buffer* pBuffer, const void* pData, size_t offset = 0, size_t numBytes = 0);
         void updateTexture(const Texture* pTexture, const void* pData);
         void updateTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex, const void* pData);
         void updateTextureSubresources(const Texture* pTexture, uint32_t firstSubresource, uint32_t subresourceCount, const void* pData);
         std::vector<uint8> readTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex);
+        ReadTextureTask::SharedPtr asyncReadTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex);
 
         /** Reset
         */
@@ -129,8 +129,10 @@ namespace Falcor
         updateTextureSubresources(pTexture, subresourceIndex, 1, pData);
     }
 
-    std::vector<uint8> CopyContext::readTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex)
+    CopyContext::ReadTextureTask::SharedPtr CopyContext::ReadTextureTask::create(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex)
     {
+        SharedPtr pThis = SharedPtr(new ReadTextureTask);
+
         //Get footprint
         D3D12_RESOURCE_DESC texDesc = pTexture->getApiHandle()->GetDesc();
         D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
@@ -141,35 +143,26 @@ namespace Falcor
         pDevice->GetCopyableFootprints(&texDesc, subresourceIndex, 1, 0, &footprint, &rowCount, &rowSize, &size);
 
         //Create buffer 
-        Buffer::SharedPtr pBuffer = Buffer::create(size, Buffer::BindFlags::None, Buffer::CpuAccess::Read, nullptr);
+        pThis->mpBuffer = Buffer::create(size, Buffer::BindFlags::None, Buffer::CpuAccess::Read, nullptr);
 
         //Copy from texture to buffer
         D3D12_TEXTURE_COPY_LOCATION srcLoc = { pTexture->getApiHandle(), D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX, subresourceIndex };
-        D3D12_TEXTURE_COPY_LOCATION dstLoc = { pBuffer->getApiHandle(), D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT, footprint };
-        resourceBarrier(pTexture, Resource::State::CopySource);
-        mpLowLevelData->getCommandList()->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, nullptr);
-        flush(true);
-
-        //Get buffer data
-        std::vector<uint8> result;
-		uint32_t actualRowSize = footprint.Footprint.Width * getFormatBytesPerBlock(pTexture->getFormat());
-        result.resize(rowCount * actualRowSize);
-        uint8* pData = reinterpret_cast<uint8*>(pBuffer->map(Buffer::MapType::Read));
-
-        for(uint32_t z = 0 ; z < footprint.Footprint.Depth ; z++)
-        {
-            const uint8_t* pSrcZ = pData + z * footprint.Footprint.RowPitch * rowCount;
-            uint8_t* pDstZ = result.data() + z * actualRowSize * rowCount;
-            for (uint32_t y = 0; y < rowCount; y++)
-            {
-                const uint8_t* pSrc = pSrcZ + y *  footprint.Footprint.RowPitch;
-                uint8_t* pDst = pDstZ + y * actualRowSize;
-                memcpy(pDst, pSrc, actualRowSize);
-            }
-        }
-
-        pBuffer->unmap();
-        return result;
+        D3D12_TEXTURE_COPY_LOCATION dstLoc = { pThis->mpBuffer->getApiHandle(), D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT, footprint };
+        pCtx->resourceBarrier(pTexture, Resource::State::CopySource);
+        pCtx->mpLowLevelData->getCommandList()->CopyTextureRegion(&dstLoc, 0, 0, 0, &srcLoc, nullptr);
+        pCtx->mCommandsPending = true;
+        pCtx->flush(false);
+
+        // Signal a fence owned by the task right after the copy
+        pThis->mpFence = GpuFence::create();
+        pThis->mpFence->gpuSignal(pCtx->mpLowLevelData->getCommandQueue());
+
+        // For block-compressed formats the footprint width is in texels and every row holds a row of blocks
+        pThis->mRowSize = footprint.Footprint.Width / getFormatWidthCompressionRatio(pTexture->getFormat()) * getFormatBytesPerBlock(pTexture->getFormat());
+        pThis->mRowPitch = footprint.Footprint.RowPitch;
+        pThis->mRowCount = rowCount;
+        pThis->mDepth = footprint.Footprint.Depth;
+        return pThis;
     }
     
     void CopyContext::resourceBarrier(const Resource* pResource, Resource::State newState)
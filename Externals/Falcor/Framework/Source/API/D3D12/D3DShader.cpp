@@ -28,6 +28,7 @@
 #include "Framework.h"
 #include <vector>
 #include "API/Shader.h"
+#include "Graphics/Program/ShaderCache.h"
 
 namespace Falcor
 {
@@ -127,6 +128,19 @@ namespace Falcor
 
         UINT d3dFlags = getD3dCompilerFlags(flags);
 
+        // The code generated by Slang has its includes and defines resolved, so it identifies the shader together with the compiler settings
+        const uint32_t compilerVersion = D3D_COMPILER_VERSION;
+        ShaderCache::Key cacheKey;
+        cacheKey.add(blob.data.data(), blob.data.size()).add(entryPointName).add(getTargetString(mType));
+        cacheKey.add(&d3dFlags, sizeof(d3dFlags)).add(&compilerVersion, sizeof(compilerVersion));
+
+        std::vector<uint8_t> cachedCode;
+        if (ShaderCache::load(cacheKey, cachedCode) && SUCCEEDED(D3DCreateBlob(cachedCode.size(), &pCode)))
+        {
+            memcpy(pCode->GetBufferPointer(), cachedCode.data(), cachedCode.size());
+            return pCode;
+        }
+
         HRESULT hr = D3DCompile(
             blob.data.data(),
             blob.data.size(),
@@ -145,6 +159,7 @@ namespace Falcor
             return nullptr;
         }
 
+        ShaderCache::store(cacheKey, pCode->GetBufferPointer(), pCode->GetBufferSize());
         return pCode;
     }
 
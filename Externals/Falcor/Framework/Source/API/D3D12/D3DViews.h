@@ -64,8 +64,10 @@ namespace Falcor
             }
             else
             {
+                // Dynamic buffers live at an offset inside a shared upload page
                 desc.Format = DXGI_FORMAT_R32_TYPELESS;
                 desc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_RAW;
+                desc.Buffer.FirstElement = pBuffer->getGpuAddressOffset() / sizeof(float);
                 desc.Buffer.NumElements = (uint32_t)pBuffer->getSize() / sizeof(float);
             }
             desc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
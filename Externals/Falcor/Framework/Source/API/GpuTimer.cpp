@@ -86,21 +86,29 @@ namespace Falcor
 
     double GpuTimer::getElapsedTime()
     {
-        if (mStatus != Status::End)
+        double beginTime, endTime;
+        if (getTimestamps(beginTime, endTime) == false)
         {
-            logWarning("GpuTimer::getElapsedTime() was called but the GpuTimer::end() wasn't called. No data to fetch.");
             return 0;
         }
+        return endTime - beginTime;
+    }
+
+    bool GpuTimer::getTimestamps(double& beginTime, double& endTime)
+    {
+        if (mStatus != Status::End)
+        {
+            logWarning("GpuTimer results were queried but GpuTimer::end() wasn't called. No data to fetch.");
+            return false;
+        }
 
         uint64_t result[2];
         apiResolve(result);
 
-        double start = (double)result[0];
-        double end = (double)result[1];
-        double range = end - start;
-        double elapsedTime = range * gpDevice->getGpuTimestampFrequency();
+        // Subtract before converting, raw timestamps are too large to keep sub-tick precision as doubles
+        beginTime = (double)result[0] * gpDevice->getGpuTimestampFrequency();
+        endTime = beginTime + (double)(result[1] - result[0]) * gpDevice->getGpuTimestampFrequency();
         mStatus = Status::Idle;
-
-        return elapsedTime;
+        return true;
     }
 }
@@ -65,6 +65,14 @@ namespace Falcor
         */
         double getElapsedTime();
 
+        /** Get the GPU timestamps in miliseconds of the last Begin()/End() pair. \n
+            The timestamps are in the GPU clock domain, only the difference between timestamps of the same queue is meaningful. Like getElapsedTime(), this consumes the results.
+            \param[out] beginTime Timestamp of the Begin() call
+            \param[out] endTime Timestamp of the End() call
+            \return false if End() wasn't called, in which case a warning is logged
+        */
+        bool getTimestamps(double& beginTime, double& endTime);
+
     private:
         GpuTimer();
         enum Status
@@ -200,6 +200,9 @@ namespace Falcor
             pProg->removeDefine("HAS_TEXCRD");
             pProg->removeDefine("HAS_COLORS");
             pProg->removeDefine("HAS_LIGHTMAP_UV");
+            pProg->removeDefine("PACKED_NORMAL");
+            pProg->removeDefine("PACKED_BITANGENT");
+            pProg->removeDefine("QUANTIZED_POSITION");
 
             for (const auto& l : mpBufferLayouts)
             {
@@ -207,13 +210,26 @@ namespace Falcor
                 {
                     for (uint32_t i = 0; i < l->getElementCount(); i++)
                     {
+                        // The compact formats from getPackedVertexFormat() need decoding in the shader
+                        if (l->getElementShaderLocation(i) == VERTEX_POSITION_LOC && l->getElementFormat(i) == ResourceFormat::RGBA16Unorm)
+                        {
+                            pProg->addDefine("QUANTIZED_POSITION");
+                        }
                         if (l->getElementShaderLocation(i) == VERTEX_NORMAL_LOC)
                         {
                             pProg->addDefine("HAS_NORMAL");
+                            if (l->getElementFormat(i) == ResourceFormat::RG16Snorm)
+                            {
+                                pProg->addDefine("PACKED_NORMAL");
+                            }
                         }
                         if (l->getElementShaderLocation(i) == VERTEX_BITANGENT_LOC)
                         {
                             pProg->addDefine("HAS_BITANGENT");
+                            if (l->getElementFormat(i) == ResourceFormat::RG16Snorm)
+                            {
+                                pProg->addDefine("PACKED_BITANGENT");
+                            }
                         }
                         if (l->getElementShaderLocation(i) == VERTEX_TEXCOORD_LOC)
                         {
@@ -221,27 +221,31 @@ namespace Falcor
         vkCmdCopyBufferToImage(mpLowLevelData->getCommandList(), pStaging->getApiHandle(), pTexture->getApiHandle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &vkCopy);
     }
 
-    std::vector<uint8> CopyContext::readTextureSubresource(const Texture* pTexture, uint32_t subresourceIndex)
+    CopyContext::ReadTextureTask::SharedPtr CopyContext::ReadTextureTask::create(CopyContext* pCtx, const Texture* pTexture, uint32_t subresourceIndex)
     {
-        mCommandsPending = true;
+        SharedPtr pThis = SharedPtr(new ReadTextureTask);
+
         VkBufferImageCopy vkCopy;
-        Buffer::SharedPtr pStaging;
         size_t dataSize = 0;
-        initTexAccessParams(pTexture, subresourceIndex, vkCopy, pStaging, nullptr, dataSize);
+        initTexAccessParams(pTexture, subresourceIndex, vkCopy, pThis->mpBuffer, nullptr, dataSize);
 
         // Execute the copy
-        resourceBarrier(pTexture, Resource::State::CopySource);
-        resourceBarrier(pStaging.get(), Resource::State::CopyDest);
-        vkCmdCopyImageToBuffer(mpLowLevelData->getCommandList(), pTexture->getApiHandle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, pStaging->getApiHandle(), 1, &vkCopy);
-
-        flush(true);
-
-        // Map and read the results
-        std::vector<uint8> result(dataSize);
-        uint8* pData = reinterpret_cast<uint8*>(pStaging->map(Buffer::MapType::Read));
-        std::memcpy(result.data(), pData, dataSize);
-
-        return result;
+        pCtx->mCommandsPending = true;
+        pCtx->resourceBarrier(pTexture, Resource::State::CopySource);
+        pCtx->resourceBarrier(pThis->mpBuffer.get(), Resource::State::CopyDest);
+        vkCmdCopyImageToBuffer(pCtx->mpLowLevelData->getCommandList(), pTexture->getApiHandle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, pThis->mpBuffer->getApiHandle(), 1, &vkCopy);
+        pCtx->flush(false);
+
+        // Signal a fence owned by the task right after the copy
+        pThis->mpFence = GpuFence::create();
+        pThis->mpFence->gpuSignal(pCtx->mpLowLevelData->getCommandQueue());
+
+        // The staging buffer is tightly packed
+        pThis->mRowSize = (uint32_t)dataSize;
+        pThis->mRowPitch = (uint32_t)dataSize;
+        pThis->mRowCount = 1;
+        pThis->mDepth = 1;
+        return pThis;
     }
 
     void CopyContext::resourceBarrier(const Resource* pResource, Resource::State newState)
@@ -41,6 +41,7 @@ using glm::float4;
 using glm::float2x2;
 using glm::float3x3;
 using glm::float4x4;
+using glm::float3x4;
 
 namespace Falcor {
 /*******************************************************************
@@ -91,6 +92,23 @@ struct CameraData
     float4x4            rightEyePrevViewProjMat;
 };
 
+/*******************************************************************
+                    Mesh instances
+*******************************************************************/
+
+/**
+    Per instance data when instance transforms are read from a buffer instead of InternalPerMeshCB. Matrices are laid out like in the constant buffer.
+    Shaders read it through ByteAddressBuffer loads, keep the offsets in ShaderCommon.slang in sync.
+*/
+struct MeshInstanceData
+{
+    float4x4    worldMat;               ///< World transform
+    float4x4    prevWorldMat;           ///< Previous frame world transform
+    float3x4    worldInvTransposeMat;   ///< Matrix for transforming normals
+    uint32_t    drawId;                 ///< Zero-based order/ID of the mesh instance within a SceneRenderer::renderScene call
+    uint32_t    pad[3];
+};
+
 /*******************************************************************
                     Material
 *******************************************************************/
@@ -32,7 +32,8 @@
                     Common structures & routines
 *******************************************************************/
 
-#define MAX_INSTANCES 64    ///< Max supported instances per draw call
+#define MAX_INSTANCES 64    ///< Max supported instances per draw call, unless instance data comes from a buffer
+#define MESH_INSTANCE_DATA_SIZE 192 ///< Size in bytes of MeshInstanceData
 #define MAX_BONES 128       ///< Max supported bones per model
 
 /*******************************************************************
@@ -88,6 +88,7 @@
 #include "Graphics/Program/GraphicsProgram.h"
 #include "Graphics/Program/ComputeProgram.h"
 #include "Graphics/Program/ParameterBlock.h"
+#include "Graphics/Program/ShaderCache.h"
 
 // Material
 #include "Graphics/Material/Material.h"
@@ -97,20 +98,27 @@
 
 // Model
 #include "Graphics/Model/Mesh.h"
+#include "Graphics/Model/MeshOptimizer.h"
+#include "Graphics/Model/VertexPacking.h"
 #include "Graphics/Model/Model.h"
 #include "Graphics/Model/ModelRenderer.h"
+#include "Graphics/Model/MeshBvh.h"
 
 // Scene
 #include "Graphics/Scene/Scene.h"
 #include "Graphics/Scene/SceneRenderer.h"
 #include "Graphics/Scene/Editor/SceneEditor.h"
 #include "Graphics/Scene/SceneUtils.h"
+#include "Graphics/Scene/SceneBvh.h"
+#include "Graphics/Scene/SceneCuller.h"
+#include "Graphics/Scene/ScenePackage.h"
 
 
 // Math
 #include "Utils/Math/FalcorMath.h"
 #include "Utils/Math/CubicSpline.h"
 #include "Utils/Math/ParallelReduction.h"
+#include "Utils/Math/Bvh.h"
 
 // Utils
 #include "Utils/Bitmap.h"
@@ -129,7 +137,10 @@
 #include "Utils/Video/VideoDecoder.h"
 #include "Utils/Platform/OS.h"
 #include "Utils/Platform/ProgressBar.h"
-#include "Utils/ThreadPool.h"
+#include "Utils/JobSystem.h"
+#include "Utils/FrameCapture.h"
+#include "Utils/ParallelFor.h"
+#include "Utils/ImageMetrics.h"
 
 // VR
 #include "VR/OpenVR/VRSystem.h"
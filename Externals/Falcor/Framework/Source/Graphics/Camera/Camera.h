@@ -161,6 +161,11 @@ namespace Falcor
         */
         bool isObjectCulled(const BoundingBox& box) const;
 
+        /** Get one of the world space frustum planes used by isObjectCulled(). A point p is on the inner side of the plane if dot(plane.xyz, p) + plane.w > 0.
+            \param[in] index Plane index, between 0 and 5
+        */
+        glm::vec4 getFrustumPlane(uint32_t index) const;
+
         /** Set camera data into a program's constant buffer.
             \param[in] pBuffer The constant buffer to set the parameters into.
             \param[in] varName The name of the light variable in the program.
@@ -261,7 +261,9 @@ namespace Falcor
 
     float PointLight::getPower()
     {
-        return luminance(mData.intensity) * 4.f * (float)M_PI;
+        // Solid angle of the spot cone, 4*pi for an omni-directional light
+        const float solidAngle = 2.f * (float)M_PI * (1.f - mData.cosOpeningAngle);
+        return luminance(mData.intensity) * solidAngle;
     }
 
     void PointLight::renderUI(Gui* pGui, const char* group)
@@ -37,6 +37,9 @@
 #include "Graphics/Model/Model.h"
 #include "Graphics/Model/Animation.h"
 #include "Graphics/Model/Mesh.h"
+#include "Graphics/Model/MeshOptimizer.h"
+#include "Graphics/Model/TangentSpace.h"
+#include "Graphics/Model/VertexPacking.h"
 #include "Graphics/Model/AnimationController.h"
 #include "API/Texture.h"
 #include "API/Buffer.h"
@@ -46,6 +49,7 @@
 #include "Data/VertexAttrib.h"
 #include "Utils/StringUtils.h"
 #include "API/Device.h"
+#include <algorithm>
 
 namespace Falcor
 {
@@ -59,17 +63,6 @@ namespace Falcor
 
     using VertexIdsVec = std::vector<uvec8_4>;
 
-    template<typename posType>
-    void generateSubmeshTangentData(
-        const std::vector<uint32_t>& indices,
-        uint32_t vertexCount,
-        const posType* vertexPosData,
-        const glm::vec3* vertexNormalData,
-        const glm::vec2* texCrdData,
-        uint32_t texCrdCount,
-        glm::vec3* bitangentData);
-
-
     void loadBones(const aiMesh* pAiMesh, VertexWeightsVec& weights, VertexIdsVec& ids, uint32_t vertexCount, const std::map<std::string, uint32_t>& boneNameToIdMap)
     {
         if (pAiMesh->mNumBones > 0xff)
@@ -157,24 +150,14 @@ namespace Falcor
             aiMesh* pMesh = const_cast<aiMesh*>(pAiMesh);
             pMesh->mBitangents = new aiVector3D[pMesh->mNumVertices];
 
-            const glm::vec3* pPos = (glm::vec3*)pMesh->mVertices;
-            glm::vec3* pBi = (glm::vec3*)pMesh->mBitangents;
-            glm::vec3* pNormals = (glm::vec3*)pMesh->mNormals;
             std::vector<uint32_t> indices = createIndexBufferData(pAiMesh);
 
-            uint32_t texCrdCount = 0;
-            std::vector<glm::vec2> texCrd;
-            if (pMesh->mTextureCoords[0] != nullptr)
-            {
-                texCrdCount = 1;
-                texCrd.resize(pMesh->mNumVertices);
-                for (size_t i = 0; i < pMesh->mNumVertices; ++i)
-                {
-                    texCrd[i] = glm::vec2(pMesh->mTextureCoords[0][i].x, pMesh->mTextureCoords[0][i].y);
-                }
-            }
-
-            generateSubmeshTangentData<glm::vec3>(indices, pAiMesh->mNumVertices, pPos, pNormals, (texCrdCount > 0 ? texCrd.data() : nullptr), texCrdCount, pBi);
+            // Assimp stores texture coordinates as 3D vectors, the generator only reads xy
+            generateTangentSpace(indices.data(), (uint32_t)indices.size(), pMesh->mNumVertices,
+                pMesh->mVertices, sizeof(aiVector3D),
+                pMesh->mNormals, sizeof(aiVector3D),
+                pMesh->mTextureCoords[0], sizeof(aiVector3D),
+                pMesh->mBitangents, sizeof(aiVector3D));
         }
     }
 
@@ -260,6 +243,47 @@ namespace Falcor
         }
     }
 
+    std::string getTextureFullpath(const std::string& folder, const std::string& textureName)
+    {
+        std::string fullpath = folder + '/' + textureName;
+        return replaceSubstring(fullpath, "\\", "/");
+    }
+
+    Texture::SharedPtr AssimpModelImporter::loadTexture(const std::string& fullpath, bool isSrgb)
+    {
+        if (mpSharedTextureCache == nullptr)
+        {
+            return createTextureFromFile(fullpath, true, isSrgb);
+        }
+
+        // Textures are shared across models, so look them up by canonical path rather than by the name used in the model file
+        std::string canonicalPath = canonicalizeFilename(fullpath);
+        auto key = std::make_pair(canonicalPath, isSrgb);
+        const auto& cached = mpSharedTextureCache->textures.find(key);
+        if (cached != mpSharedTextureCache->textures.end())
+        {
+            return cached->second;
+        }
+
+        Texture::SharedPtr pTex;
+        const auto& fileData = mpSharedTextureCache->fileData.find(canonicalPath);
+        if (fileData != mpSharedTextureCache->fileData.end())
+        {
+            // A null entry means decoding already failed and was reported
+            pTex = fileData->second ? createTextureFromFileData(fileData->second.get(), true, isSrgb) : nullptr;
+        }
+        else
+        {
+            pTex = createTextureFromFile(fullpath, true, isSrgb);
+        }
+
+        if (pTex)
+        {
+            mpSharedTextureCache->textures[key] = pTex;
+        }
+        return pTex;
+    }
+
     void AssimpModelImporter::loadTextures(const aiMaterial* pAiMaterial, const std::string& folder, BasicMaterial* pMaterial, bool isObjFile, bool useSrgb)
     {
         for (int i = 0; i < AI_TEXTURE_TYPE_MAX; ++i)
@@ -297,9 +321,7 @@ namespace Falcor
                 else
                 {
                     // create a new texture
-                    std::string fullpath = folder + '/' + s;
-                    fullpath = replaceSubstring(fullpath, "\\", "/");
-                    pTex = createTextureFromFile(fullpath, true, isSrgbRequired(aiType, useSrgb));
+                    pTex = loadTexture(getTextureFullpath(folder, s), isSrgbRequired(aiType, useSrgb));
                     if (pTex)
                     {
                         mTextureCache[s] = pTex;
@@ -489,16 +511,30 @@ namespace Falcor
         createAnimationController(pScene);
         IdToMesh aiToFalcorMeshId;
         aiNode* pRoot = pScene->mRootNode;
-        return parseAiSceneNode(pRoot, pScene, aiToFalcorMeshId);
+        bool result = parseAiSceneNode(pRoot, pScene, aiToFalcorMeshId);
+
+        if (is_set(mFlags, Model::LoadFlags::OptimizeMeshes))
+        {
+            logInfo("AssimpModelImporter: Optimized " + std::to_string(mOptimizerStatsAfter.triangleCount) + " triangles. ACMR " + std::to_string(mOptimizerStatsBefore.getAcmr()) + " -> " + std::to_string(mOptimizerStatsAfter.getAcmr()) +
+                ", ATVR " + std::to_string(mOptimizerStatsBefore.getAtvr()) + " -> " + std::to_string(mOptimizerStatsAfter.getAtvr()));
+        }
+
+        if (is_set(mFlags, Model::LoadFlags::PackVertexAttributes | Model::LoadFlags::QuantizePositions))
+        {
+            logInfo("AssimpModelImporter: Packed vertex buffers. " + std::to_string(mVertexBytesBeforePacking) + " bytes -> " + std::to_string(mVertexBytesAfterPacking) + " bytes");
+        }
+        return result;
     }
 
-    bool AssimpModelImporter::initModel(const std::string& filename)
+    AssimpModelImporter::ParsedFile::~ParsedFile() = default;
+
+    AssimpModelImporter::ParsedFile::UniquePtr AssimpModelImporter::parse(const std::string& filename, Model::LoadFlags flags)
     {
         std::string fullpath;
         if (findFileInDataDirectories(filename, fullpath) == false)
         {
             logError(std::string("Can't find model file ") + filename, true);
-            return false;
+            return nullptr;
         }
 
         uint32_t AssimpFlags = aiProcessPreset_TargetRealtime_MaxQuality |
@@ -508,13 +544,13 @@ namespace Falcor
             0;
 
         // aiProcessPreset_TargetRealtime_MaxQuality enabled some optimizations the user might not want
-        if(is_set(mFlags, Model::LoadFlags::FindDegeneratePrimitives) == false)
+        if(is_set(flags, Model::LoadFlags::FindDegeneratePrimitives) == false)
         {
             AssimpFlags &= ~aiProcess_FindDegenerates;
         }
 
         // Avoid merging original meshes
-        if(is_set(mFlags, Model::LoadFlags::DontMergeMeshes))
+        if(is_set(flags, Model::LoadFlags::DontMergeMeshes))
         {
             AssimpFlags &= ~aiProcess_OptimizeMeshes;
         }
@@ -522,25 +558,61 @@ namespace Falcor
         // Never use Assimp's tangent gen code
         AssimpFlags &= ~(aiProcess_CalcTangentSpace);
 
-        Assimp::Importer importer;
-        const aiScene* pScene = importer.ReadFile(fullpath, AssimpFlags);
+        ParsedFile::UniquePtr pFile = ParsedFile::UniquePtr(new ParsedFile());
+        pFile->mFilename = filename;
+        pFile->mpImporter = std::make_unique<Assimp::Importer>();
+        pFile->mpScene = pFile->mpImporter->ReadFile(fullpath, AssimpFlags);
 
-        if((pScene == nullptr) || (verifyScene(pScene) == false))
+        if((pFile->mpScene == nullptr) || (verifyScene(pFile->mpScene) == false))
         {
             std::string str("Can't open model file '");
-            str = str + std::string(filename) + "'\n" + importer.GetErrorString();
+            str = str + std::string(filename) + "'\n" + pFile->mpImporter->GetErrorString();
             logError(str, true);
-            return false;
+            return nullptr;
         }
 
         // Extract the folder name
         auto last = fullpath.find_last_of("/\\");
-        std::string modelFolder = fullpath.substr(0, last);
+        pFile->mFolder = fullpath.substr(0, last);
+
+        // Collect the texture files so they can be decoded ahead of the import
+        for (uint32_t m = 0; m < pFile->mpScene->mNumMaterials; m++)
+        {
+            const aiMaterial* pAiMaterial = pFile->mpScene->mMaterials[m];
+            for (int i = 0; i < AI_TEXTURE_TYPE_MAX; ++i)
+            {
+                aiTextureType aiType = (aiTextureType)i;
+                if (pAiMaterial->GetTextureCount(aiType) != 1)
+                {
+                    continue;
+                }
+
+                aiString path;
+                pAiMaterial->GetTexture(aiType, 0, &path);
+                std::string s(path.data);
+                if (s.empty() == false)
+                {
+                    std::string texFile = canonicalizeFilename(getTextureFullpath(pFile->mFolder, s));
+                    if (std::find(pFile->mTextureFiles.begin(), pFile->mTextureFiles.end(), texFile) == pFile->mTextureFiles.end())
+                    {
+                        pFile->mTextureFiles.push_back(texFile);
+                    }
+                }
+            }
+        }
+
+        return pFile;
+    }
+
+    bool AssimpModelImporter::initModel(const ParsedFile& file)
+    {
+        const std::string& filename = file.mFilename;
+        const aiScene* pScene = file.mpScene;
 
         // Order of initialization matters, materials, bones and animations need to loaded before mesh initialization
         bool isObjFile = hasSuffix(filename, ".obj", false);
         bool useSrgbTextures = !is_set(mFlags, Model::LoadFlags::AssumeLinearSpaceTextures);
-        if(createAllMaterials(pScene, modelFolder, isObjFile, useSrgbTextures) == false)
+        if(createAllMaterials(pScene, file.mFolder, isObjFile, useSrgbTextures) == false)
         {
             logError(std::string("Can't create materials for model ") + filename, true);
             return false;
@@ -556,9 +628,16 @@ namespace Falcor
     }
 
     bool AssimpModelImporter::import(Model& model, const std::string& filename, Model::LoadFlags flags)
+    {
+        ParsedFile::UniquePtr pFile = parse(filename, flags);
+        return pFile ? import(model, *pFile, flags, nullptr) : false;
+    }
+
+    bool AssimpModelImporter::import(Model& model, const ParsedFile& file, Model::LoadFlags flags, TextureCache* pTextureCache)
     {
         AssimpModelImporter loader(model, flags);
-        return loader.initModel(filename);
+        loader.mpSharedTextureCache = pTextureCache;
+        return loader.initModel(file);
     }
 
     bool AssimpModelImporter::isUsedNode(const aiNode* pNode) const
@@ -748,6 +827,63 @@ namespace Falcor
         return Animation::create(std::string(pAiAnim->mName.C_Str()), animationSets, duration, ticksPerSecond);
     }
 
+    /** Create the data of a single attribute vertex buffer, using the format from kLayoutData
+    */
+    std::vector<uint8_t> createVertexBufferData(const aiMesh* pAiMesh, uint32_t location, const uint8_t* pBoneIds, const vec4* pBoneWeights)
+    {
+        const uint32_t vertexStride = getFormatBytesPerBlock(kLayoutData[location].format);
+        std::vector<uint8_t> initData(vertexStride * pAiMesh->mNumVertices, 0);
+
+        for (uint32_t vertexID = 0; vertexID < pAiMesh->mNumVertices; vertexID++)
+        {
+            uint8_t* pDst = &initData[vertexStride * vertexID];
+
+            uint8_t* pSrc = nullptr;
+            uint32_t size = 0;
+            switch (location)
+            {
+            case VERTEX_POSITION_LOC:
+                pSrc = (uint8_t*)(&pAiMesh->mVertices[vertexID]);
+                size = sizeof(pAiMesh->mVertices[0]);
+                break;
+            case VERTEX_NORMAL_LOC:
+                pSrc = (uint8_t*)(&pAiMesh->mNormals[vertexID]);
+                size = sizeof(pAiMesh->mNormals[0]);
+                break;
+            case VERTEX_BITANGENT_LOC:
+                pSrc = (uint8_t*)(&pAiMesh->mBitangents[vertexID]);
+                size = sizeof(pAiMesh->mBitangents[0]);
+                break;
+            case VERTEX_DIFFUSE_COLOR_LOC:
+                pSrc = (uint8_t*)(&pAiMesh->mColors[0][vertexID]);
+                size = sizeof(pAiMesh->mColors[0][0]);
+                break;
+            case VERTEX_TEXCOORD_LOC:
+                pSrc = (uint8_t*)(&pAiMesh->mTextureCoords[0][vertexID]);
+                size = sizeof(pAiMesh->mTextureCoords[0][vertexID]);
+                break;
+            case VERTEX_LIGHTMAP_UV_LOC:
+                pSrc = (uint8_t*)(&pAiMesh->mTextureCoords[1][vertexID]);
+                size = sizeof(pAiMesh->mTextureCoords[1][vertexID]);
+                break;
+            case VERTEX_BONE_WEIGHT_LOC:
+                pSrc = (uint8_t*)(&pBoneWeights[vertexID]);
+                size = sizeof(pBoneWeights[vertexID]);
+                break;
+            case VERTEX_BONE_ID_LOC:
+                pSrc = (uint8_t*)(&pBoneIds[vertexID * 4]);
+                size = sizeof(uint8_t) * 4;
+                break;
+            default:
+                should_not_get_here();
+                continue;
+            }
+
+            memcpy(pDst, pSrc, size);
+        }
+        return initData;
+    }
+
     BoundingBox createMeshBbox(const aiMesh* pAiMesh)
     {
         glm::vec3 boxMin, boxMax;
@@ -764,8 +900,7 @@ namespace Falcor
     Mesh::SharedPtr AssimpModelImporter::createMesh(const aiMesh* pAiMesh)
     {
         uint32_t vertexCount = pAiMesh->mNumVertices;
-        uint32_t indexCount = pAiMesh->mNumFaces * pAiMesh->mFaces[0].mNumIndices;
-        auto pIB = createIndexBuffer(pAiMesh);
+        std::vector<uint32_t> indices = createIndexBufferData(pAiMesh);
         BoundingBox boundingBox = createMeshBbox(pAiMesh);
 
         const bool generateTangentSpace = (pAiMesh->HasTangentsAndBitangents() == false) && (is_set(mFlags, Model::LoadFlags::DontGenerateTangentSpace) == false);
@@ -781,8 +916,6 @@ namespace Falcor
             return nullptr;
         }
 
-        std::vector<Buffer::SharedPtr> pVBs(pLayout->getBufferCount());
-
         // Initialize the bones data
         VertexWeightsVec weights;
         VertexIdsVec ids;
@@ -791,11 +924,12 @@ namespace Falcor
             loadBones(pAiMesh, weights, ids, vertexCount, mBoneNameToIdMap);
         }
 
-        // Create corresponding vertex buffers
+        // Fill the vertex buffers. Packing happens last, the optimizer needs float positions.
+        std::vector<std::vector<uint8_t>> vertexData(pLayout->getBufferCount());
         for (uint32_t i = 0; i < pLayout->getBufferCount(); i++)
         {
             const VertexBufferLayout* pVbLayout = pLayout->getBufferLayout(i).get();
-            pVBs[i] = createVertexBuffer(pAiMesh, pVbLayout, (uint8_t*)ids.data(), weights.data());
+            vertexData[i] = createVertexBufferData(pAiMesh, pVbLayout->getElementShaderLocation(0), (uint8_t*)ids.data(), weights.data());
         }
 
         Vao::Topology topology = Vao::Topology::TriangleList;
@@ -815,10 +949,44 @@ namespace Falcor
             assert(0);
         }
 
+        if (is_set(mFlags, Model::LoadFlags::OptimizeMeshes) && (topology == Vao::Topology::TriangleList))
+        {
+            std::vector<MeshOptimizer::VertexStream> streams(vertexData.size());
+            uint32_t positionStream = 0;
+            for (uint32_t i = 0; i < pLayout->getBufferCount(); i++)
+            {
+                const uint32_t location = pLayout->getBufferLayout(i)->getElementShaderLocation(0);
+                streams[i] = { &vertexData[i], getFormatBytesPerBlock(kLayoutData[location].format) };
+                if (location == VERTEX_POSITION_LOC)
+                {
+                    positionStream = i;
+                }
+            }
+            MeshOptimizer::optimize({ &indices }, streams, vertexCount, positionStream, &mOptimizerStatsBefore, &mOptimizerStatsAfter);
+        }
+
+        std::vector<Buffer::SharedPtr> pVBs(pLayout->getBufferCount());
+        for (uint32_t i = 0; i < pLayout->getBufferCount(); i++)
+        {
+            const VertexBufferLayout* pVbLayout = pLayout->getBufferLayout(i).get();
+            const uint32_t location = pVbLayout->getElementShaderLocation(0);
+            const ResourceFormat srcFormat = kLayoutData[location].format;
+            mVertexBytesBeforePacking += vertexData[i].size();
+            if (pVbLayout->getElementFormat(0) != srcFormat)
+            {
+                std::vector<uint8_t> packed(pVbLayout->getStride() * vertexCount);
+                packVertexAttributes(location, pVbLayout->getElementFormat(0), vertexData[i].data(), getFormatBytesPerBlock(srcFormat), getFormatChannelCount(srcFormat), packed.data(), pVbLayout->getStride(), vertexCount, boundingBox);
+                vertexData[i].swap(packed);
+            }
+            mVertexBytesAfterPacking += vertexData[i].size();
+            pVBs[i] = createBuffer(vertexData[i].data(), vertexData[i].size(), Buffer::BindFlags::Vertex);
+        }
+        auto pIB = createBuffer(indices.data(), sizeof(uint32_t) * indices.size(), Buffer::BindFlags::Index);
+
         auto pMaterial = mAiMaterialToFalcor[pAiMesh->mMaterialIndex];
         assert(pMaterial);
 
-        Mesh::SharedPtr pMesh = Mesh::create(pVBs, vertexCount, pIB, indexCount, pLayout, topology, pMaterial, boundingBox, pAiMesh->HasBones());
+        Mesh::SharedPtr pMesh = Mesh::create(pVBs, vertexCount, pIB, (uint32_t)indices.size(), pLayout, topology, pMaterial, boundingBox, pAiMesh->HasBones());
 
         if (generateTangentSpace)
         {
@@ -829,16 +997,13 @@ namespace Falcor
         return pMesh;
     }
 
-    Buffer::SharedPtr AssimpModelImporter::createIndexBuffer(const aiMesh* pAiMesh)
+    Buffer::SharedPtr AssimpModelImporter::createBuffer(const void* pData, size_t size, Buffer::BindFlags bindFlags)
     {
-        std::vector<uint32_t> indices = createIndexBufferData(pAiMesh);
-        const uint32_t size = (uint32_t)(sizeof(uint32_t) * indices.size());
-        Buffer::BindFlags bindFlags = Buffer::BindFlags::Index;
         if (is_set(mFlags, Model::LoadFlags::BuffersAsShaderResource))
         {
             bindFlags |= Buffer::BindFlags::ShaderResource;
         }
-        return Buffer::create(size, bindFlags, Buffer::CpuAccess::None, indices.data());;
+        return Buffer::create(size, bindFlags, Buffer::CpuAccess::None, pData);
     }
 
 
@@ -898,8 +1063,16 @@ namespace Falcor
         {
             if (isElementUsed(pAiMesh, location))
             {
+                // Positions are packed separately from the other attributes
+                ResourceFormat format = kLayoutData[location].format;
+                const bool pack = is_set(mFlags, (location == VERTEX_POSITION_LOC) ? Model::LoadFlags::QuantizePositions : Model::LoadFlags::PackVertexAttributes);
+                if (pack && getPackedVertexFormat(location) != ResourceFormat::Unknown)
+                {
+                    format = getPackedVertexFormat(location);
+                }
+
                 VertexBufferLayout::SharedPtr pVbLayout = VertexBufferLayout::create();
-                pVbLayout->addElement(kLayoutData[location].name, 0, kLayoutData[location].format, 1, location);
+                pVbLayout->addElement(kLayoutData[location].name, 0, format, 1, location);
                 pLayout->addBufferLayout(bufferCount, pVbLayout);
                 bufferCount++;
             }
@@ -907,72 +1080,4 @@ namespace Falcor
 
         return pLayout;
     }
-
-    Buffer::SharedPtr AssimpModelImporter::createVertexBuffer(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights)
-    {
-        const uint32_t vertexStride = pLayout->getStride();
-        std::vector<uint8_t> initData(vertexStride * pAiMesh->mNumVertices, 0);
-
-        for (uint32_t vertexID = 0; vertexID < pAiMesh->mNumVertices; vertexID++)
-        {
-            uint8_t* pVertex = &initData[vertexStride * vertexID];
-
-            for (uint32_t elementID = 0; elementID < pLayout->getElementCount(); elementID++)
-            {
-                uint32_t offset = pLayout->getElementOffset(elementID);
-                uint32_t location = pLayout->getElementShaderLocation(elementID);
-                uint8_t* pDst = pVertex + offset;
-
-                uint8_t* pSrc = nullptr;
-                uint32_t size = 0;
-                switch (location)
-                {
-                case VERTEX_POSITION_LOC:
-                    pSrc = (uint8_t*)(&pAiMesh->mVertices[vertexID]);
-                    size = sizeof(pAiMesh->mVertices[0]);
-                    break;
-                case VERTEX_NORMAL_LOC:
-                    pSrc = (uint8_t*)(&pAiMesh->mNormals[vertexID]);
-                    size = sizeof(pAiMesh->mNormals[0]);
-                    break;
-                case VERTEX_BITANGENT_LOC:
-                    pSrc = (uint8_t*)(&pAiMesh->mBitangents[vertexID]);
-                    size = sizeof(pAiMesh->mBitangents[0]);
-                    break;
-                case VERTEX_DIFFUSE_COLOR_LOC:
-                    pSrc = (uint8_t*)(&pAiMesh->mColors[0][vertexID]);
-                    size = sizeof(pAiMesh->mColors[0][0]);
-                    break;
-                case VERTEX_TEXCOORD_LOC:
-                    pSrc = (uint8_t*)(&pAiMesh->mTextureCoords[0][vertexID]);
-                    size = sizeof(pAiMesh->mTextureCoords[0][vertexID]);
-                    break;
-                case VERTEX_LIGHTMAP_UV_LOC:
-                    pSrc = (uint8_t*)(&pAiMesh->mTextureCoords[1][vertexID]);
-                    size = sizeof(pAiMesh->mTextureCoords[1][vertexID]);
-                    break;
-                case VERTEX_BONE_WEIGHT_LOC:
-                    pSrc = (uint8_t*)(&pBoneWeights[vertexID]);
-                    size = sizeof(pBoneWeights[vertexID]);
-                    break;
-                case VERTEX_BONE_ID_LOC:
-                    pSrc = (uint8_t*)(&pBoneIds[vertexID * 4]);
-                    size = sizeof(uint8_t) * 4;
-                    break;
-                default:
-                    should_not_get_here();
-                    continue;
-                }
-
-                memcpy(pDst, pSrc, size);
-            }
-        }
-        Buffer::BindFlags bindFlags = Buffer::BindFlags::Vertex;
-        if (is_set(mFlags, Model::LoadFlags::BuffersAsShaderResource))
-        {
-            bindFlags |= Buffer::BindFlags::ShaderResource;
-        }
-
-        return Buffer::create(vertexStride * pAiMesh->mNumVertices, bindFlags, Buffer::CpuAccess::None, initData.data());;
-    }
 }
\ No newline at end of file
@@ -27,11 +27,15 @@
 ***************************************************************************/
 #pragma once
 #include <map>
+#include <memory>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include "Graphics/Model/Loaders/ModelImporter.h"
+#include "Graphics/TextureHelper.h"
 #include "../AnimationController.h"
 #include "../Mesh.h"
+#include "../MeshOptimizer.h"
 #include "../Model.h"
 
 struct aiScene;
@@ -40,6 +44,11 @@ struct aiAnimation;
 struct aiMesh;
 struct aiMaterial;
 
+namespace Assimp
+{
+    class Importer;
+}
+
 namespace Falcor
 {
     class Animation;
@@ -61,6 +70,53 @@ namespace Falcor
         */
         static bool import(Model& model, const std::string& filename, Model::LoadFlags flags);
 
+        /** A model file parsed by ASSIMP. Parsing doesn't use the device, so it can run on worker threads.
+        */
+        class ParsedFile
+        {
+        public:
+            using UniquePtr = std::unique_ptr<ParsedFile>;
+            ~ParsedFile();
+
+            /** Get the canonical paths of the texture files referenced by the model's materials
+            */
+            const std::vector<std::string>& getTextureFiles() const { return mTextureFiles; }
+
+        private:
+            friend class AssimpModelImporter;
+            ParsedFile() = default;
+
+            std::string mFilename;
+            std::string mFolder;
+            std::unique_ptr<Assimp::Importer> mpImporter;
+            const aiScene* mpScene = nullptr;
+            std::vector<std::string> mTextureFiles;
+        };
+
+        /** Textures shared between imports, so that a texture file referenced by several models is decoded and created only once.
+        */
+        struct TextureCache
+        {
+            std::unordered_map<std::string, TextureFileData::SharedConstPtr> fileData;     ///< Decoded texture files, keyed by canonical path
+            std::map<std::pair<std::string, bool>, Texture::SharedPtr> textures;           ///< Created textures, keyed by canonical path and whether the format is sRGB
+        };
+
+        /** Parse a model file with ASSIMP. This is the CPU-heavy part of the import and it is safe to call from any thread.
+            \param[in] filename Model's filename. Can include a full path or a relative path from a data directory
+            \param[in] flags Flags controlling model creation
+            \return The parsed file, or nullptr if parsing failed
+        */
+        static ParsedFile::UniquePtr parse(const std::string& filename, Model::LoadFlags flags);
+
+        /** Create the model's resources from a parsed file. Must be called from the render thread.
+            \param[out] model Model object to load into
+            \param[in] file The parsed model file. The same file can be imported into several models
+            \param[in] flags Flags controlling model creation. Should match the flags used for parsing
+            \param[in,out] pTextureCache Optional texture cache. Decoded files found in the cache are used instead of reading the file, and created textures are added to it
+            \return Whether import succeeded
+        */
+        static bool import(Model& model, const ParsedFile& file, Model::LoadFlags flags, TextureCache* pTextureCache);
+
     private:
 
         using IdToMesh = std::unordered_map<uint32_t, Mesh::SharedPtr>;
@@ -69,7 +125,7 @@ namespace Falcor
         AssimpModelImporter(const AssimpModelImporter&) = delete;
         void operator=(const AssimpModelImporter&) = delete;
 
-        bool initModel(const std::string& filename);
+        bool initModel(const ParsedFile& file);
         bool createDrawList(const aiScene* pScene);
         bool parseAiSceneNode(const aiNode* pCurrent, const aiScene* pScene, IdToMesh& aiToFalcorMesh);
         bool createAllMaterials(const aiScene* pScene, const std::string& modelFolder, bool isObjFile, bool useSrgb);
@@ -83,8 +139,8 @@ namespace Falcor
 
         Mesh::SharedPtr createMesh(const aiMesh* pAiMesh);
         VertexLayout::SharedPtr createVertexLayout(const aiMesh* pAiMesh);
-        Buffer::SharedPtr createIndexBuffer(const aiMesh* pAiMesh);
-        Buffer::SharedPtr createVertexBuffer(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights);
+        Buffer::SharedPtr createBuffer(const void* pData, size_t size, Buffer::BindFlags bindFlags);
+        Texture::SharedPtr loadTexture(const std::string& fullpath, bool isSrgb);
         void loadTextures(const aiMaterial* pAiMaterial, const std::string& folder, BasicMaterial* pMaterial, bool isObjFile, bool useSrgb);
         Material::SharedPtr createMaterial(const aiMaterial* pAiMaterial, const std::string& folder, bool isObjFile, bool useSrgb);
 
@@ -101,6 +157,11 @@ namespace Falcor
 
         std::vector<Bone> mBones;
         Model::LoadFlags mFlags;
+        MeshOptimizer::Stats mOptimizerStatsBefore;
+        MeshOptimizer::Stats mOptimizerStatsAfter;
+        uint64_t mVertexBytesBeforePacking = 0;
+        uint64_t mVertexBytesAfterPacking = 0;
         std::map<const std::string, Texture::SharedPtr> mTextureCache;
+        TextureCache* mpSharedTextureCache = nullptr;
     };
 }
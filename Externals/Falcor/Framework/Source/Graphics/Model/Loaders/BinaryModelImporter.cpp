@@ -30,6 +30,9 @@
 #include "BinaryModelSpec.h"
 #include "../Model.h"
 #include "../Mesh.h"
+#include "../MeshOptimizer.h"
+#include "../TangentSpace.h"
+#include "../VertexPacking.h"
 #include "Utils/Platform/OS.h"
 #include "API/VertexLayout.h"
 #include "Data/VertexAttrib.h"
@@ -42,7 +45,6 @@
 #include "glm/geometric.hpp"
 #include "API/Device.h"
 #include <numeric>
-#include <cstring>
 
 namespace Falcor
 {
@@ -55,125 +57,6 @@ namespace Falcor
         std::string name;
     };
 
-    bool isSpecialFloat(float f)
-    {
-        uint32_t d = *(uint32_t*)&f;
-        // Check the exponent
-        d = (d >> 23) & 0xff;
-        return d == 0xff;
-    }
-
-    static vec3 projectNormalToBitangent(const vec3& normal)
-    {
-        vec3 bitangent;
-        if (abs(normal.x) > abs(normal.y))
-        {
-            bitangent = v3(normal.z, 0.f, -normal.x) / length(v2(normal.x, normal.z));
-        }
-        else
-        {
-            bitangent = v3(0.f, normal.z, -normal.y) / length(v2(normal.y, normal.z));
-        }
-        return normalize(bitangent);
-    }
-
-    static bool isInvalidVec(const vec3& v)
-    {
-        return isSpecialFloat(v.x) || isSpecialFloat(v.y) || isSpecialFloat(v.z);
-    }
-
-    template<typename posType>
-    void generateSubmeshTangentData(
-        const std::vector<uint32_t>& indices,
-        uint32_t vertexCount,
-        const posType* vertexPosData,
-        const glm::vec3* vertexNormalData,
-        const glm::vec2* texCrdData,
-        uint32_t texCrdCount,
-        glm::vec3* bitangentData)
-    {
-        std::memset(bitangentData, 0, vertexCount * sizeof(vec3));
-
-        // calculate the tangent and bitangent for every face
-        size_t primCount = indices.size() / 3;
-        for(size_t primID = 0; primID < primCount; primID++)
-        {
-            struct Data
-            {
-                posType position;
-                glm::vec3 normal;
-                glm::vec2 uv;
-            };
-            Data V[3];
-
-            // Get the data
-            for(uint32_t i = 0; i < 3; i++)
-            {
-                uint32_t index = indices[primID * 3 + i];
-                V[i].position = vertexPosData[index];
-                V[i].normal = vertexNormalData[index];
-                V[i].uv = texCrdData ? texCrdData[index * texCrdCount] : vec2(0);
-            }
-
-            // Position delta
-            posType posDelta[2];
-            posDelta[0] = V[1].position - V[0].position;
-            posDelta[1] = V[2].position - V[0].position;
-
-            // Texture offset
-            glm::vec2 s = V[1].uv - V[0].uv;
-            glm::vec2 t = V[2].uv - V[0].uv;
-
-            glm::vec3 tangent;
-            glm::vec3 bitangent;
-
-            // when t1, t2, t3 in same position in UV space, just use default UV direction.
-            if((s == glm::vec2(0, 0)) || (t == glm::vec2(0, 0)))
-            {
-                const glm::vec3 &normal = V[0].normal;
-                bitangent = projectNormalToBitangent(normal);
-                tangent = cross(bitangent, normal);
-            }
-            else
-            {
-                float dirCorrection = 1.0f / (s.x * t.y - s.y * t.x);
-
-                // tangent points in the direction where to positive X axis of the texture coord's would point in model space
-                // bitangent's points along the positive Y axis of the texture coord's, respectively
-                tangent   = (posDelta[0] * t.y - posDelta[1] * t.x) * dirCorrection;
-                bitangent = (posDelta[1] * s.x - posDelta[0] * s.y) * dirCorrection;
-            }
-
-            // store for every vertex of that face
-            for(uint32_t i = 0; i < 3; i++)
-            {
-                // project tangent and bitangent into the plane formed by the vertex' normal
-                glm::vec3 localTangent = tangent - V[i].normal * (glm::dot(tangent, V[i].normal));
-                localTangent = glm::normalize(localTangent);
-                glm::vec3 localBitangent = bitangent - V[i].normal * (glm::dot(bitangent, V[i].normal));
-                localBitangent = glm::normalize(localBitangent);
-                localBitangent = localBitangent - localTangent * (glm::dot(localBitangent, localTangent));
-                localBitangent = glm::normalize(localBitangent);
-
-                if (isInvalidVec(bitangent) == false)
-                {
-                    // and write it into the mesh
-                    uint32_t index = indices[primID * 3 + i];
-                    bitangentData[index] += normalize(localBitangent);
-                }
-            }
-        }
-
-        for (uint32_t v = 0; v < vertexCount; v++)
-        {
-            bitangentData[v] = normalize(bitangentData[v]);
-            if (isInvalidVec(bitangentData[v]))
-            {
-                bitangentData[v] = projectNormalToBitangent(vertexNormalData[v]);
-            }
-        }
-    }
-
     static BasicMaterial::MapType getFalcorMapType(TextureType map)
     {
         switch(map)
@@ -625,6 +508,7 @@ namespace Falcor
 
         // create objects
         bool shouldGenerateTangents = is_set(flags, Model::LoadFlags::DontGenerateTangentSpace) == false;
+        bool packAttributes = is_set(flags, Model::LoadFlags::PackVertexAttributes);
 
         std::vector<TextureData> texData;
 
@@ -653,6 +537,10 @@ namespace Falcor
             bool operator==(const TexSignature& other) const { return pData == other.pData || format == other.format; }
         };
         std::map<TexSignature, Texture::SharedPtr> textures;
+        MeshOptimizer::Stats optimizerStatsBefore;
+        MeshOptimizer::Stats optimizerStatsAfter;
+        uint64_t vertexBytesBeforePacking = 0;
+        uint64_t vertexBytesAfterPacking = 0;
         bool loadTexAsSrgb = !is_set(flags, Model::LoadFlags::AssumeLinearSpaceTextures);
 
         // Load the meshes
@@ -689,6 +577,7 @@ namespace Falcor
                 std::vector<uint8_t> vec;
                 bool shouldSkip = false;
                 uint32_t elementSize = 0;
+                ResourceFormat format = ResourceFormat::Unknown;    // Format of 'vec'. The layout has the packed format if the attribute is packed
             };
 
             std::vector<BufferData> buffers;
@@ -740,9 +629,18 @@ namespace Falcor
                     }
 
                     buffers[i].elementSize = getFormatBytesPerBlock(falcorFormat);
+                    buffers[i].format = falcorFormat;
                     if(shaderLocation != kUnusedShaderElement)
                     {
-                        pBufferLayout->addElement(falcorName, 0, falcorFormat, 1, shaderLocation);
+                        // Only float attributes are packed. Positions are never quantized, submeshes share the vertex buffers but have their own bounding boxes.
+                        ResourceFormat layoutFormat = falcorFormat;
+                        ResourceFormat packedFormat = getPackedVertexFormat(shaderLocation);
+                        bool isFloat = getFormatType(falcorFormat) == FormatType::Float && buffers[i].elementSize == getFormatChannelCount(falcorFormat) * sizeof(float);
+                        if(packAttributes && shaderLocation != VERTEX_POSITION_LOC && packedFormat != ResourceFormat::Unknown && isFloat)
+                        {
+                            layoutFormat = packedFormat;
+                        }
+                        pBufferLayout->addElement(falcorName, 0, layoutFormat, 1, shaderLocation);
                         buffers[i].vec.resize(buffers[i].elementSize * numVertices);
                     }
                     else
@@ -772,8 +670,10 @@ namespace Falcor
                    
                     auto pBitangentLayout = VertexBufferLayout::create();
                     pLayout->addBufferLayout(bitangentBufferIndex, pBitangentLayout);
-                    pBitangentLayout->addElement(VERTEX_BITANGENT_NAME, 0, ResourceFormat::RGB32Float, 1, VERTEX_BITANGENT_LOC);
+                    pBitangentLayout->addElement(VERTEX_BITANGENT_NAME, 0, packAttributes ? getPackedVertexFormat(VERTEX_BITANGENT_LOC) : ResourceFormat::RGB32Float, 1, VERTEX_BITANGENT_LOC);
                     buffers[bitangentBufferIndex].vec.resize(sizeof(glm::vec3) * numVertices);
+                    buffers[bitangentBufferIndex].elementSize = sizeof(glm::vec3);
+                    buffers[bitangentBufferIndex].format = ResourceFormat::RGB32Float;
                 }
             }
             
@@ -789,21 +689,13 @@ namespace Falcor
                     }
                     else
                     {
-                        uint32_t stride = pLayout->getBufferLayout(attributes)->getStride();
+                        uint32_t stride = buffers[attributes].elementSize;
                         uint8_t* pDest = buffers[attributes].vec.data() + stride * i;
                         mStream.read(pDest, stride);
                     }
                 }
             }
 
-            for (int32_t i = 0; i < numAttribs; ++i)
-            {
-                if(buffers[i].shouldSkip == false)
-                {
-                    pVBs[i] = Buffer::create(buffers[i].vec.size(), Buffer::BindFlags::Vertex, Buffer::CpuAccess::None, buffers[i].vec.data());
-                }
-            }
-
             if(version <= 5)
             {
                 importTextures(texData, numTextures, mStream, mModelName);
@@ -811,7 +703,14 @@ namespace Falcor
             }
 
             // Array of Submesh.
-            // Falcor doesn't have a concept of submeshes, just create a new mesh for each submesh
+            // Falcor doesn't have a concept of submeshes, just create a new mesh for each submesh. The submeshes are read first so that they can be optimized together, they share the vertex buffers.
+            struct SubmeshData
+            {
+                Material::SharedPtr pMaterial;
+                std::vector<uint32_t> indices;
+            };
+            std::vector<SubmeshData> submeshes(numSubmeshes);
+
             for(int submesh = 0; submesh < numSubmeshes; submesh++)
             {
                 // create the material
@@ -877,7 +776,7 @@ namespace Falcor
                 }
 
                 // Create material and check if it already exists
-                auto pMaterial = checkForExistingMaterial(basicMaterial.convertToMaterial());
+                submeshes[submesh].pMaterial = checkForExistingMaterial(basicMaterial.convertToMaterial());
 
                 int32_t numTriangles;
                 mStream >> numTriangles;
@@ -888,37 +787,101 @@ namespace Falcor
                     return false;
                 }
 
-                // create the index buffer
-                uint32_t numIndices = numTriangles * 3;
-                std::vector<uint32_t> indices(numIndices);
-                uint32_t ibSize = 3 * numTriangles * sizeof(uint32_t);
-                mStream.read(&indices[0], ibSize);
+                // Read the indices
+                submeshes[submesh].indices.resize(numTriangles * 3);
+                mStream.read(submeshes[submesh].indices.data(), 3 * numTriangles * sizeof(uint32_t));
+            }
 
-                auto pIB = Buffer::create(ibSize, Buffer::BindFlags::Index, Buffer::CpuAccess::None, indices.data());
+            uint32_t vertexCount = (uint32_t)numVertices;
+            ResourceFormat posFormat = pLayout->getBufferLayout(positionBufferIndex)->getElementFormat(0);
+            if(is_set(flags, Model::LoadFlags::OptimizeMeshes) && (posFormat == ResourceFormat::RGB32Float || posFormat == ResourceFormat::RGBA32Float))
+            {
+                std::vector<std::vector<uint32_t>*> indexLists;
+                for(auto& submesh : submeshes)
+                {
+                    indexLists.push_back(&submesh.indices);
+                }
 
-                // Generate tangent space data if needed
-                if(genTangentForMesh)
+                std::vector<MeshOptimizer::VertexStream> streams;
+                uint32_t positionStream = 0;
+                for(int32_t i = 0; i < numAttribs; ++i)
                 {
-                    uint32_t texCrdCount = 0;
-                    glm::vec2* texCrd = nullptr;
-                    if(texCoordBufferIndex != kInvalidBufferIndex)
+                    if(buffers[i].shouldSkip == false)
                     {
-                        texCrdCount = pLayout->getBufferLayout(texCoordBufferIndex)->getStride() / sizeof(glm::vec2);
-                        texCrd = (glm::vec2*)buffers[texCoordBufferIndex].vec.data();
+                        if((uint32_t)i == positionBufferIndex)
+                        {
+                            positionStream = (uint32_t)streams.size();
+                        }
+                        streams.push_back({ &buffers[i].vec, buffers[i].elementSize });
                     }
+                }
 
-                    ResourceFormat posFormat = pLayout->getBufferLayout(positionBufferIndex)->getElementFormat(0);
+                MeshOptimizer::optimize(indexLists, streams, vertexCount, positionStream, &optimizerStatsBefore, &optimizerStatsAfter);
+                if(genTangentForMesh)
+                {
+                    buffers[bitangentBufferIndex].vec.resize(sizeof(glm::vec3) * vertexCount);
+                }
+            }
+
+            // The attributes are kept as read from the file until here, tangent space generation and the bounding boxes need float data
+            auto createVertexBuffer = [&](uint32_t i)
+            {
+                const VertexBufferLayout* pBufferLayout = pLayout->getBufferLayout(i).get();
+                const ResourceFormat layoutFormat = pBufferLayout->getElementFormat(0);
+                vertexBytesBeforePacking += buffers[i].vec.size();
+                if(layoutFormat == buffers[i].format)
+                {
+                    vertexBytesAfterPacking += buffers[i].vec.size();
+                    return Buffer::create(buffers[i].vec.size(), Buffer::BindFlags::Vertex, Buffer::CpuAccess::None, buffers[i].vec.data());
+                }
+
+                std::vector<uint8_t> packed(pBufferLayout->getStride() * vertexCount);
+                packVertexAttributes(pBufferLayout->getElementShaderLocation(0), layoutFormat, buffers[i].vec.data(), buffers[i].elementSize, getFormatChannelCount(buffers[i].format),
+                    packed.data(), pBufferLayout->getStride(), vertexCount, BoundingBox());
+                vertexBytesAfterPacking += packed.size();
+                return Buffer::create(packed.size(), Buffer::BindFlags::Vertex, Buffer::CpuAccess::None, packed.data());
+            };
 
-                    if (posFormat == ResourceFormat::RGB32Float)
+            for (int32_t i = 0; i < numAttribs; ++i)
+            {
+                if(buffers[i].shouldSkip == false)
+                {
+                    pVBs[i] = createVertexBuffer(i);
+                }
+            }
+
+            for(int submesh = 0; submesh < numSubmeshes; submesh++)
+            {
+                const auto& pMaterial = submeshes[submesh].pMaterial;
+                const std::vector<uint32_t>& indices = submeshes[submesh].indices;
+                uint32_t numIndices = (uint32_t)indices.size();
+
+                // create the index buffer
+                auto pIB = Buffer::create(numIndices * sizeof(uint32_t), Buffer::BindFlags::Index, Buffer::CpuAccess::None, indices.data());
+
+                // Generate tangent space data if needed
+                if(genTangentForMesh)
+                {
+                    const uint8_t* pTexCrd = nullptr;
+                    uint32_t texCrdStride = 0;
+                    if(texCoordBufferIndex != kInvalidBufferIndex)
                     {
-                        generateSubmeshTangentData<glm::vec3>(indices, numVertices, (glm::vec3*)buffers[positionBufferIndex].vec.data(), (glm::vec3*)buffers[normalBufferIndex].vec.data(), texCrd, texCrdCount, (glm::vec3*)buffers[bitangentBufferIndex].vec.data());
+                        pTexCrd = buffers[texCoordBufferIndex].vec.data();
+                        texCrdStride = buffers[texCoordBufferIndex].elementSize;
                     }
-                    else if (posFormat == ResourceFormat::RGBA32Float)
+
+                    // The generator only reads xyz, so both float position formats work
+                    if (posFormat == ResourceFormat::RGB32Float || posFormat == ResourceFormat::RGBA32Float)
                     {
-                        generateSubmeshTangentData<glm::vec4>(indices, numVertices, (glm::vec4*)buffers[positionBufferIndex].vec.data(), (glm::vec3*)buffers[normalBufferIndex].vec.data(), texCrd, texCrdCount, (glm::vec3*)buffers[bitangentBufferIndex].vec.data());
+                        uint32_t positionStride = pLayout->getBufferLayout(positionBufferIndex)->getStride();
+                        generateTangentSpace(indices.data(), numIndices, vertexCount,
+                            buffers[positionBufferIndex].vec.data(), positionStride,
+                            buffers[normalBufferIndex].vec.data(), sizeof(glm::vec3),
+                            pTexCrd, texCrdStride,
+                            buffers[bitangentBufferIndex].vec.data(), sizeof(glm::vec3));
                     }
 
-                    pVBs[bitangentBufferIndex] = Buffer::create(buffers[bitangentBufferIndex].vec.size(), Buffer::BindFlags::Vertex, Buffer::CpuAccess::None, buffers[bitangentBufferIndex].vec.data());
+                    pVBs[bitangentBufferIndex] = createVertexBuffer(bitangentBufferIndex);
                 }
                 
 
@@ -939,7 +902,7 @@ namespace Falcor
                 BoundingBox box = BoundingBox::fromMinMax(min, max);
 
                 // create the mesh
-                auto pMesh = Mesh::create(pVBs, numVertices, pIB, numIndices, pLayout, Vao::Topology::TriangleList, pMaterial, box, false);
+                auto pMesh = Mesh::create(pVBs, vertexCount, pIB, numIndices, pLayout, Vao::Topology::TriangleList, pMaterial, box, false);
 
                 if (version >= 6)
                 {
@@ -975,7 +938,18 @@ namespace Falcor
                 }
             }
         }
-        
+
+        if(is_set(flags, Model::LoadFlags::OptimizeMeshes))
+        {
+            logInfo("BinaryModelImporter: Optimized " + std::to_string(optimizerStatsAfter.triangleCount) + " triangles. ACMR " + std::to_string(optimizerStatsBefore.getAcmr()) + " -> " + std::to_string(optimizerStatsAfter.getAcmr()) +
+                ", ATVR " + std::to_string(optimizerStatsBefore.getAtvr()) + " -> " + std::to_string(optimizerStatsAfter.getAtvr()));
+        }
+
+        if(packAttributes)
+        {
+            logInfo("BinaryModelImporter: Packed vertex buffers. " + std::to_string(vertexBytesBeforePacking) + " bytes -> " + std::to_string(vertexBytesAfterPacking) + " bytes");
+        }
+
         return true;
     }
 }
@@ -130,6 +130,14 @@ namespace Falcor
         return pModel;
     }
 
+    Model::SharedPtr SimpleModelImporter::createFromMesh( const Mesh::SharedPtr& pMesh )
+    {
+        Model::SharedPtr pModel = Model::create();
+        pModel->addMeshInstance(pMesh, glm::mat4());
+        pModel->calculateModelProperties();
+        return pModel;
+    }
+
     ResourceFormat SimpleModelImporter::getResourceFormat( AttribFormat format, uint32_t components )
     {    
         ResourceFormat byteFormats[4] = { ResourceFormat::R8Unorm, ResourceFormat::RG8Unorm, ResourceFormat::RGBA8Unorm, ResourceFormat::RGBA8Unorm };
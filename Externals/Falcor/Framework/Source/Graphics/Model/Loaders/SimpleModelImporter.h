@@ -87,6 +87,9 @@ namespace Falcor
                                         Texture::SharedPtr diffuseTexture = nullptr,
                                         Vao::Topology geomTopology = Vao::Topology::TriangleList );
 
+        // Create a model holding a single instance of an existing mesh. Used to wrap meshes whose buffers are shared between models
+        static Model::SharedPtr createFromMesh( const Mesh::SharedPtr& pMesh );
+
     private:
         static ResourceFormat    getResourceFormat( AttribFormat format, uint32_t components );
         static int32_t           getFormatByteSize( AttribFormat format );
@@ -0,0 +1,207 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Graphics/Model/MeshBvh.h"
+#include "Graphics/Model/VertexPacking.h"
+#include "API/Buffer.h"
+#include "API/VertexLayout.h"
+#include "Data/VertexAttrib.h"
+
+namespace Falcor
+{
+    // Leaves hold a few triangles, intersecting them is cheaper than descending further
+    static const uint32_t kMaxTrianglesPerLeaf = 4;
+
+    MeshBvh::SharedPtr MeshBvh::create(const Mesh* pMesh)
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+        if (readMeshData(pMesh, positions, indices) == false)
+        {
+            return nullptr;
+        }
+        return create(std::move(positions), std::move(indices));
+    }
+
+    MeshBvh::SharedPtr MeshBvh::create(std::vector<glm::vec3> positions, std::vector<uint32_t> indices)
+    {
+        return SharedPtr(new MeshBvh(std::move(positions), std::move(indices)));
+    }
+
+    bool MeshBvh::readMeshData(const Mesh* pMesh, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices)
+    {
+        const Vao* pVao = pMesh->getVao().get();
+        if (pVao->getPrimitiveTopology() != Vao::Topology::TriangleList)
+        {
+            logWarning("MeshBvh only supports triangle lists.");
+            return false;
+        }
+
+        const uint32_t vertexCount = pMesh->getVertexCount();
+        bool foundPositions = false;
+        for (uint32_t vbIdx = 0; vbIdx < pVao->getVertexBuffersCount() && !foundPositions; ++vbIdx)
+        {
+            const VertexBufferLayout* pLayout = pVao->getVertexLayout()->getBufferLayout(vbIdx).get();
+            for (uint32_t elemIdx = 0; elemIdx < pLayout->getElementCount(); ++elemIdx)
+            {
+                const ResourceFormat format = pLayout->getElementFormat(elemIdx);
+                if (pLayout->getElementName(elemIdx) != VERTEX_POSITION_NAME)
+                {
+                    continue;
+                }
+                const bool isFloat = (getFormatType(format) == FormatType::Float) && (getFormatBytesPerBlock(format) >= sizeof(glm::vec3));
+                if (isFloat == false && format != getPackedVertexFormat(VERTEX_POSITION_LOC))
+                {
+                    logWarning("MeshBvh requires 32-bit float or quantized positions.");
+                    return false;
+                }
+
+                Buffer* pVB = pVao->getVertexBuffer(vbIdx).get();
+                const uint8_t* pSrc = (const uint8_t*)pVB->map(Buffer::MapType::Read) + pLayout->getElementOffset(elemIdx);
+                const uint32_t stride = pLayout->getStride();
+                positions.resize(vertexCount);
+                for (uint32_t i = 0; i < vertexCount; ++i, pSrc += stride)
+                {
+                    if (isFloat)
+                    {
+                        std::memcpy(&positions[i], pSrc, sizeof(glm::vec3));
+                    }
+                    else
+                    {
+                        glm::vec4 value;
+                        unpackVertexAttribute(pSrc, format, VERTEX_POSITION_LOC, pMesh->getBoundingBox(), value);
+                        positions[i] = glm::vec3(value);
+                    }
+                }
+                pVB->unmap();
+                foundPositions = true;
+                break;
+            }
+        }
+
+        if (!foundPositions)
+        {
+            logWarning("MeshBvh requires vertex positions.");
+            return false;
+        }
+
+        const uint32_t indexCount = pMesh->getPrimitiveCount() * 3;
+        indices.resize(indexCount);
+        Buffer* pIB = pVao->getIndexBuffer().get();
+        if (pIB == nullptr)
+        {
+            for (uint32_t i = 0; i < indexCount; ++i)
+            {
+                indices[i] = i;
+            }
+            return true;
+        }
+
+        const void* pData = pIB->map(Buffer::MapType::Read);
+        if (pVao->getIndexBufferFormat() == ResourceFormat::R16Uint)
+        {
+            const uint16_t* pIndices = (const uint16_t*)pData;
+            std::copy(pIndices, pIndices + indexCount, indices.begin());
+        }
+        else
+        {
+            assert(pVao->getIndexBufferFormat() == ResourceFormat::R32Uint);
+            std::memcpy(indices.data(), pData, indexCount * sizeof(uint32_t));
+        }
+        pIB->unmap();
+        return true;
+    }
+
+    MeshBvh::MeshBvh(std::vector<glm::vec3> positions, std::vector<uint32_t> indices)
+        : mPositions(std::move(positions)), mIndices(std::move(indices))
+    {
+        glm::vec3 minPos(std::numeric_limits<float>::max());
+        glm::vec3 maxPos(-std::numeric_limits<float>::max());
+
+        std::vector<BoundingBox> triangleBounds(getTriangleCount());
+        for (uint32_t i = 0; i < getTriangleCount(); i++)
+        {
+            const glm::vec3& p0 = mPositions[mIndices[i * 3 + 0]];
+            const glm::vec3& p1 = mPositions[mIndices[i * 3 + 1]];
+            const glm::vec3& p2 = mPositions[mIndices[i * 3 + 2]];
+            const glm::vec3 triMin = glm::min(p0, glm::min(p1, p2));
+            const glm::vec3 triMax = glm::max(p0, glm::max(p1, p2));
+            triangleBounds[i] = BoundingBox::fromMinMax(triMin, triMax);
+            minPos = glm::min(minPos, triMin);
+            maxPos = glm::max(maxPos, triMax);
+        }
+
+        mBoundingBox = getTriangleCount() ? BoundingBox::fromMinMax(minPos, maxPos) : BoundingBox::fromMinMax(glm::vec3(0), glm::vec3(0));
+        mBvh.build(triangleBounds, kMaxTrianglesPerLeaf);
+    }
+
+    bool MeshBvh::intersect(Ray& ray, Hit& hit) const
+    {
+        return mBvh.intersect(ray, [this, &hit](uint32_t triangle, Ray& r)
+        {
+            // Moller-Trumbore
+            const glm::vec3& p0 = mPositions[mIndices[triangle * 3 + 0]];
+            const glm::vec3 e1 = mPositions[mIndices[triangle * 3 + 1]] - p0;
+            const glm::vec3 e2 = mPositions[mIndices[triangle * 3 + 2]] - p0;
+
+            const glm::vec3 p = glm::cross(r.direction, e2);
+            const float det = glm::dot(e1, p);
+            if (det == 0.0f)
+            {
+                return false;
+            }
+
+            const float invDet = 1.0f / det;
+            const glm::vec3 s = r.origin - p0;
+            const float u = glm::dot(s, p) * invDet;
+            if (u < 0.0f || u > 1.0f)
+            {
+                return false;
+            }
+
+            const glm::vec3 q = glm::cross(s, e1);
+            const float v = glm::dot(r.direction, q) * invDet;
+            if (v < 0.0f || u + v > 1.0f)
+            {
+                return false;
+            }
+
+            const float t = glm::dot(e2, q) * invDet;
+            if (t < r.tMin || t > r.tMax)
+            {
+                return false;
+            }
+
+            r.tMax = t;
+            hit.t = t;
+            hit.primitiveID = triangle;
+            hit.barycentrics = glm::vec2(u, v);
+            return true;
+        });
+    }
+}
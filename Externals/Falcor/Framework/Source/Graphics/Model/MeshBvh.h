@@ -0,0 +1,88 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Graphics/Model/Mesh.h"
+#include "Utils/Math/Bvh.h"
+
+namespace Falcor
+{
+    /** Triangle-level BVH for a single mesh, built on the CPU from the mesh's positions and indices in object space.
+        Skinned meshes are represented in their bind pose.
+    */
+    class MeshBvh
+    {
+    public:
+        using SharedPtr = std::shared_ptr<MeshBvh>;
+        using SharedConstPtr = std::shared_ptr<const MeshBvh>;
+
+        struct Hit
+        {
+            float t = 0.0f;                 ///< Hit distance along the ray
+            uint32_t primitiveID = 0;       ///< Triangle index
+            glm::vec2 barycentrics;         ///< Barycentric coordinates of the second and third triangle vertex
+        };
+
+        /** Create a hierarchy for a mesh. Reads the vertex and index buffers back from the GPU.
+            \param[in] pMesh Triangle list mesh
+            \return New object, or nullptr if the mesh has no positions or isn't a triangle list
+        */
+        static SharedPtr create(const Mesh* pMesh);
+
+        /** Create a hierarchy from triangle data.
+            \param[in] positions Vertex positions
+            \param[in] indices Three indices per triangle
+        */
+        static SharedPtr create(std::vector<glm::vec3> positions, std::vector<uint32_t> indices);
+
+        /** Read the positions and triangle indices of a mesh. Must be called from the thread owning the render context, the hierarchy itself can then be built on any thread.
+            \return false if the mesh has no positions or isn't a triangle list
+        */
+        static bool readMeshData(const Mesh* pMesh, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices);
+
+        /** Find the closest triangle hit along a ray. Triangles are double sided.
+            \param[in,out] ray Ray in object space. tMax is shortened to the hit distance.
+            \param[out] hit Hit information, only written when a hit is found
+            \return Whether a triangle was hit
+        */
+        bool intersect(Ray& ray, Hit& hit) const;
+
+        /** Get the object space bounds of the mesh
+        */
+        const BoundingBox& getBoundingBox() const { return mBoundingBox; }
+
+        uint32_t getTriangleCount() const { return (uint32_t)(mIndices.size() / 3); }
+
+    private:
+        MeshBvh(std::vector<glm::vec3> positions, std::vector<uint32_t> indices);
+
+        std::vector<glm::vec3> mPositions;
+        std::vector<uint32_t> mIndices;
+        BoundingBox mBoundingBox;
+        Bvh mBvh;
+    };
+}
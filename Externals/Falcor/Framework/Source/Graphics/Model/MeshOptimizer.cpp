@@ -0,0 +1,476 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MeshOptimizer.h"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace Falcor
+{
+    // Must be defined even though it's a const uint because value is passed as reference to functions
+    const uint32_t MeshOptimizer::kCacheSize;
+
+    static const uint32_t kInvalidVertex = uint32_t(-1);
+
+    // FIFO cache simulation. A vertex is in the cache if fewer than kCacheSize misses happened since it was loaded.
+    class FifoCache
+    {
+    public:
+        FifoCache(uint32_t vertexCount) : mTimestamps(vertexCount, 0) {}
+
+        /** Access a vertex, returns true on a miss
+        */
+        bool access(uint32_t vertex)
+        {
+            if (mTime - mTimestamps[vertex] > MeshOptimizer::kCacheSize)
+            {
+                mTimestamps[vertex] = mTime++;
+                return true;
+            }
+            return false;
+        }
+
+        uint32_t accessTriangle(const uint32_t* pTriangle)
+        {
+            return uint32_t(access(pTriangle[0])) + uint32_t(access(pTriangle[1])) + uint32_t(access(pTriangle[2]));
+        }
+
+        /** Evict everything
+        */
+        void flush() { mTime += MeshOptimizer::kCacheSize + 1; }
+
+    private:
+        std::vector<uint32_t> mTimestamps;
+        uint32_t mTime = MeshOptimizer::kCacheSize + 1;
+    };
+
+    static const glm::vec3& getPosition(const uint8_t* pPositions, uint32_t stride, uint32_t vertex)
+    {
+        return *(const glm::vec3*)(pPositions + size_t(stride) * vertex);
+    }
+
+    MeshOptimizer::Stats MeshOptimizer::analyzeVertexCache(const uint32_t* pIndices, size_t indexCount, uint32_t vertexCount)
+    {
+        Stats stats;
+        stats.triangleCount = indexCount / 3;
+        stats.vertexCount = vertexCount;
+
+        FifoCache cache(vertexCount);
+        for (size_t i = 0; i < stats.triangleCount * 3; i += 3)
+        {
+            stats.cacheMisses += cache.accessTriangle(pIndices + i);
+        }
+        return stats;
+    }
+
+    uint32_t MeshOptimizer::removeDuplicateVertices(const std::vector<std::vector<uint32_t>*>& indexLists, const std::vector<VertexStream>& streams, uint32_t vertexCount)
+    {
+        auto hashVertex = [&](uint32_t vertex)
+        {
+            // FNV-1a over the vertex's bytes in every stream
+            uint32_t hash = 2166136261u;
+            for (const auto& stream : streams)
+            {
+                const uint8_t* pData = stream.pData->data() + size_t(stream.stride) * vertex;
+                for (uint32_t b = 0; b < stream.stride; b++)
+                {
+                    hash = (hash ^ pData[b]) * 16777619u;
+                }
+            }
+            return hash;
+        };
+
+        auto isEqual = [&](uint32_t a, uint32_t b)
+        {
+            for (const auto& stream : streams)
+            {
+                const uint8_t* pData = stream.pData->data();
+                if (memcmp(pData + size_t(stream.stride) * a, pData + size_t(stream.stride) * b, stream.stride) != 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        // Open addressing table holding the first vertex of every unique set of attributes
+        size_t tableSize = 1;
+        while (tableSize < size_t(vertexCount) * 2)
+        {
+            tableSize *= 2;
+        }
+        std::vector<uint32_t> table(tableSize, kInvalidVertex);
+
+        std::vector<uint32_t> remap(vertexCount);
+        uint32_t uniqueCount = 0;
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            size_t slot = hashVertex(v) & (tableSize - 1);
+            while (table[slot] != kInvalidVertex && isEqual(table[slot], v) == false)
+            {
+                slot = (slot + 1) & (tableSize - 1);
+            }
+
+            if (table[slot] == kInvalidVertex)
+            {
+                table[slot] = v;
+                remap[v] = uniqueCount++;
+            }
+            else
+            {
+                remap[v] = remap[table[slot]];
+            }
+        }
+
+        if (uniqueCount == vertexCount)
+        {
+            return vertexCount;
+        }
+
+        // Unique vertices keep their relative order, so compacting in place only ever moves data towards the front
+        uint32_t next = 0;
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            if (remap[v] == next)
+            {
+                for (const auto& stream : streams)
+                {
+                    uint8_t* pData = stream.pData->data();
+                    memmove(pData + size_t(stream.stride) * next, pData + size_t(stream.stride) * v, stream.stride);
+                }
+                next++;
+            }
+        }
+
+        for (const auto& stream : streams)
+        {
+            stream.pData->resize(size_t(stream.stride) * uniqueCount);
+        }
+
+        for (auto pIndices : indexLists)
+        {
+            for (uint32_t& index : *pIndices)
+            {
+                index = remap[index];
+            }
+        }
+        return uniqueCount;
+    }
+
+    void MeshOptimizer::optimizeVertexCache(uint32_t* pIndices, size_t indexCount, uint32_t vertexCount)
+    {
+        // Tipsify, from Sander et al. 2007, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+        const size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0)
+        {
+            return;
+        }
+
+        // Vertex to triangle adjacency
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+        {
+            offsets[pIndices[i] + 1]++;
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        std::vector<uint32_t> adjacency(triangleCount * 3);
+        std::vector<uint32_t> fillPos(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+        {
+            adjacency[fillPos[pIndices[i]]++] = uint32_t(i / 3);
+        }
+
+        std::vector<uint32_t> liveCount(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            liveCount[v] = offsets[v + 1] - offsets[v];
+        }
+
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        std::vector<uint8_t> emitted(triangleCount, 0);
+        std::vector<uint32_t> deadEnd;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> output;
+        output.reserve(triangleCount * 3);
+
+        uint32_t time = kCacheSize + 1;
+        uint32_t cursor = 0;
+        uint32_t fanning = pIndices[0];
+        while (fanning != kInvalidVertex)
+        {
+            // Emit every remaining triangle around the fanning vertex
+            candidates.clear();
+            for (uint32_t a = offsets[fanning]; a < offsets[fanning + 1]; a++)
+            {
+                uint32_t triangle = adjacency[a];
+                if (emitted[triangle])
+                {
+                    continue;
+                }
+
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    uint32_t v = pIndices[triangle * 3 + c];
+                    output.push_back(v);
+                    deadEnd.push_back(v);
+                    candidates.push_back(v);
+                    liveCount[v]--;
+                    if (time - cacheTime[v] > kCacheSize)
+                    {
+                        cacheTime[v] = time++;
+                    }
+                }
+                emitted[triangle] = 1;
+            }
+
+            // Next fanning vertex is the oldest candidate which stays in the cache while its remaining triangles are emitted
+            uint32_t next = kInvalidVertex;
+            int64_t bestPriority = -1;
+            for (uint32_t v : candidates)
+            {
+                if (liveCount[v] > 0)
+                {
+                    int64_t priority = 0;
+                    if (time - cacheTime[v] + 2 * liveCount[v] <= kCacheSize)
+                    {
+                        priority = time - cacheTime[v];
+                    }
+                    if (priority > bestPriority)
+                    {
+                        bestPriority = priority;
+                        next = v;
+                    }
+                }
+            }
+
+            // Dead end. Fall back to recently used vertices, then to the next vertex in input order.
+            while (next == kInvalidVertex && deadEnd.empty() == false)
+            {
+                uint32_t v = deadEnd.back();
+                deadEnd.pop_back();
+                if (liveCount[v] > 0)
+                {
+                    next = v;
+                }
+            }
+
+            while (next == kInvalidVertex && cursor < vertexCount)
+            {
+                if (liveCount[cursor] > 0)
+                {
+                    next = cursor;
+                }
+                else
+                {
+                    cursor++;
+                }
+            }
+            fanning = next;
+        }
+
+        assert(output.size() == triangleCount * 3);
+        memcpy(pIndices, output.data(), output.size() * sizeof(uint32_t));
+    }
+
+    void MeshOptimizer::optimizeOverdraw(uint32_t* pIndices, size_t indexCount, const uint8_t* pPositions, uint32_t positionStride, uint32_t vertexCount, float threshold)
+    {
+        const size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0)
+        {
+            return;
+        }
+
+        // Hard boundaries where the cache is cold, a triangle which misses with all 3 vertices
+        std::vector<uint32_t> hardClusters;
+        {
+            FifoCache cache(vertexCount);
+            for (size_t t = 0; t < triangleCount; t++)
+            {
+                if (cache.accessTriangle(pIndices + t * 3) == 3)
+                {
+                    hardClusters.push_back(uint32_t(t));
+                }
+            }
+            // The first triangle always misses 3 times
+            assert(hardClusters.empty() == false && hardClusters[0] == 0);
+        }
+
+        // Split each hard cluster into soft clusters whose ACMR, starting with a cold cache, is within the threshold of the hard cluster's
+        std::vector<uint32_t> clusters;
+        FifoCache cache(vertexCount);
+        for (size_t h = 0; h < hardClusters.size(); h++)
+        {
+            const uint32_t start = hardClusters[h];
+            const uint32_t end = (h + 1 < hardClusters.size()) ? hardClusters[h + 1] : uint32_t(triangleCount);
+
+            cache.flush();
+            uint32_t hardMisses = 0;
+            for (uint32_t t = start; t < end; t++)
+            {
+                hardMisses += cache.accessTriangle(pIndices + t * 3);
+            }
+            const float clusterThreshold = threshold * float(hardMisses) / float(end - start);
+
+            cache.flush();
+            clusters.push_back(start);
+            uint32_t clusterStart = start;
+            uint32_t misses = 0;
+            for (uint32_t t = start; t < end; t++)
+            {
+                misses += cache.accessTriangle(pIndices + t * 3);
+                if (t + 1 < end && float(misses) / float(t - clusterStart + 1) <= clusterThreshold)
+                {
+                    clusters.push_back(t + 1);
+                    clusterStart = t + 1;
+                    misses = 0;
+                    cache.flush();
+                }
+            }
+        }
+
+        // Sort key is how much the cluster faces away from the mesh center. Clusters on the outside facing outwards are drawn first and occlude the rest.
+        std::vector<glm::vec3> centroids(clusters.size(), glm::vec3(0));
+        std::vector<glm::vec3> normals(clusters.size(), glm::vec3(0));
+        std::vector<float> areas(clusters.size(), 0.0f);
+        glm::vec3 meshCentroid(0);
+        float meshArea = 0;
+        for (size_t c = 0; c < clusters.size(); c++)
+        {
+            const uint32_t end = (c + 1 < clusters.size()) ? clusters[c + 1] : uint32_t(triangleCount);
+            for (uint32_t t = clusters[c]; t < end; t++)
+            {
+                const glm::vec3& p0 = getPosition(pPositions, positionStride, pIndices[t * 3 + 0]);
+                const glm::vec3& p1 = getPosition(pPositions, positionStride, pIndices[t * 3 + 1]);
+                const glm::vec3& p2 = getPosition(pPositions, positionStride, pIndices[t * 3 + 2]);
+
+                // The cross product's length is twice the area, which cancels out in the averages
+                glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                float area = glm::length(normal);
+                centroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+                normals[c] += normal;
+                areas[c] += area;
+            }
+            meshCentroid += centroids[c];
+            meshArea += areas[c];
+        }
+        meshCentroid = (meshArea > 0) ? meshCentroid / meshArea : meshCentroid;
+
+        std::vector<float> sortKeys(clusters.size());
+        for (size_t c = 0; c < clusters.size(); c++)
+        {
+            glm::vec3 centroid = (areas[c] > 0) ? centroids[c] / areas[c] : centroids[c];
+            float normalLength = glm::length(normals[c]);
+            glm::vec3 normal = (normalLength > 0) ? normals[c] / normalLength : glm::vec3(0);
+            sortKeys[c] = glm::dot(centroid - meshCentroid, normal);
+        }
+
+        std::vector<uint32_t> order(clusters.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+        std::vector<uint32_t> output;
+        output.reserve(triangleCount * 3);
+        for (uint32_t c : order)
+        {
+            const uint32_t end = (c + 1 < clusters.size()) ? clusters[c + 1] : uint32_t(triangleCount);
+            output.insert(output.end(), pIndices + clusters[c] * 3, pIndices + end * 3);
+        }
+        memcpy(pIndices, output.data(), output.size() * sizeof(uint32_t));
+    }
+
+    uint32_t MeshOptimizer::optimizeVertexFetch(const std::vector<std::vector<uint32_t>*>& indexLists, const std::vector<VertexStream>& streams, uint32_t vertexCount)
+    {
+        std::vector<uint32_t> remap(vertexCount, kInvalidVertex);
+        uint32_t next = 0;
+        for (auto pIndices : indexLists)
+        {
+            for (uint32_t& index : *pIndices)
+            {
+                if (remap[index] == kInvalidVertex)
+                {
+                    remap[index] = next++;
+                }
+                index = remap[index];
+            }
+        }
+
+        for (const auto& stream : streams)
+        {
+            std::vector<uint8_t> data(size_t(stream.stride) * next);
+            const uint8_t* pSrc = stream.pData->data();
+            for (uint32_t v = 0; v < vertexCount; v++)
+            {
+                if (remap[v] != kInvalidVertex)
+                {
+                    memcpy(data.data() + size_t(stream.stride) * remap[v], pSrc + size_t(stream.stride) * v, stream.stride);
+                }
+            }
+            stream.pData->swap(data);
+        }
+        return next;
+    }
+
+    void MeshOptimizer::optimize(const std::vector<std::vector<uint32_t>*>& indexLists, const std::vector<VertexStream>& streams, uint32_t& vertexCount, uint32_t positionStream, Stats* pBefore, Stats* pAfter)
+    {
+        auto analyze = [&](Stats* pStats)
+        {
+            Stats stats;
+            for (auto pIndices : indexLists)
+            {
+                stats += analyzeVertexCache(pIndices->data(), pIndices->size(), vertexCount);
+            }
+            // Every list was counted with all the vertices, but they are shared
+            stats.vertexCount = vertexCount;
+            *pStats += stats;
+        };
+
+        if (pBefore)
+        {
+            analyze(pBefore);
+        }
+
+        vertexCount = removeDuplicateVertices(indexLists, streams, vertexCount);
+
+        const VertexStream& positions = streams[positionStream];
+        for (auto pIndices : indexLists)
+        {
+            optimizeVertexCache(pIndices->data(), pIndices->size(), vertexCount);
+            optimizeOverdraw(pIndices->data(), pIndices->size(), positions.pData->data(), positions.stride, vertexCount);
+        }
+
+        vertexCount = optimizeVertexFetch(indexLists, streams, vertexCount);
+
+        if (pAfter)
+        {
+            analyze(pAfter);
+        }
+    }
+}
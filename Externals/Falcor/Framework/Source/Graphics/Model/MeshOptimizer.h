@@ -0,0 +1,123 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+    /** Import-time optimization of indexed triangle lists. Used by the model importers when Model::LoadFlags::OptimizeMeshes is set.
+        The stages run in this order:
+        - Duplicate vertices are merged. Vertices are compared byte-wise across all their attribute streams.
+        - Triangles are reordered for the post-transform vertex cache (Tipsify).
+        - The cache-ordered triangles are split into clusters which are sorted so that outward facing clusters are drawn first, reducing overdraw.
+        - Vertices are reordered in the order the index buffer first uses them, which makes vertex fetch sequential. Unused vertices are dropped.
+    */
+    class MeshOptimizer
+    {
+    public:
+        /** One vertex attribute stream. Attributes are stored as fixed size elements 'stride' bytes apart.
+        */
+        struct VertexStream
+        {
+            std::vector<uint8_t>* pData;
+            uint32_t stride;
+        };
+
+        /** Vertex cache statistics of a triangle list, simulated with a FIFO cache of kCacheSize entries
+        */
+        struct Stats
+        {
+            uint64_t triangleCount = 0;
+            uint64_t vertexCount = 0;
+            uint64_t cacheMisses = 0;
+
+            /** Average cache miss ratio. Number of transformed vertices per triangle, between 0.5 and 3.
+            */
+            float getAcmr() const { return triangleCount ? float(cacheMisses) / float(triangleCount) : 0.0f; }
+
+            /** Average transformed vertex ratio. Number of times each vertex is transformed, 1 is optimal.
+            */
+            float getAtvr() const { return vertexCount ? float(cacheMisses) / float(vertexCount) : 0.0f; }
+
+            Stats& operator+=(const Stats& other)
+            {
+                triangleCount += other.triangleCount;
+                vertexCount += other.vertexCount;
+                cacheMisses += other.cacheMisses;
+                return *this;
+            }
+        };
+
+        /** Cache size used by the statistics and the cache optimization
+        */
+        static const uint32_t kCacheSize = 16;
+
+        /** Run all the optimization stages on a mesh
+            \param[in,out] indexLists Triangle lists drawing from the same vertices. Each list is reordered on its own, the vertex stages are shared.
+            \param[in,out] streams The vertex attribute streams. Resized when the vertex count changes
+            \param[in,out] vertexCount Number of vertices
+            \param[in] positionStream Index of the stream holding the positions as floats at offset 0
+            \param[out] pBefore Optional. Statistics of the input are added to it
+            \param[out] pAfter Optional. Statistics of the output are added to it
+        */
+        static void optimize(const std::vector<std::vector<uint32_t>*>& indexLists, const std::vector<VertexStream>& streams, uint32_t& vertexCount, uint32_t positionStream, Stats* pBefore = nullptr, Stats* pAfter = nullptr);
+
+        /** Simulate the vertex cache for a triangle list
+        */
+        static Stats analyzeVertexCache(const uint32_t* pIndices, size_t indexCount, uint32_t vertexCount);
+
+        /** Merge vertices with identical attributes. Indices are remapped and the streams compacted.
+            \return The new vertex count
+        */
+        static uint32_t removeDuplicateVertices(const std::vector<std::vector<uint32_t>*>& indexLists, const std::vector<VertexStream>& streams, uint32_t vertexCount);
+
+        /** Reorder triangles for the post-transform vertex cache
+            \param[in,out] pIndices Triangle list indices
+            \param[in] indexCount Number of indices
+            \param[in] vertexCount Number of vertices
+        */
+        static void optimizeVertexCache(uint32_t* pIndices, size_t indexCount, uint32_t vertexCount);
+
+        /** Reorder clusters of a cache-optimized triangle list to reduce overdraw.
+            The list is split where the simulated cache runs cold, and those clusters are split further as long as their cache efficiency stays within 'threshold' of the original.
+            \param[in,out] pIndices Triangle list indices, already optimized with optimizeVertexCache()
+            \param[in] indexCount Number of indices
+            \param[in] pPositions Vertex positions, 3 floats each
+            \param[in] positionStride Bytes between consecutive positions
+            \param[in] vertexCount Number of vertices
+            \param[in] threshold Allowed ACMR increase factor
+        */
+        static void optimizeOverdraw(uint32_t* pIndices, size_t indexCount, const uint8_t* pPositions, uint32_t positionStride, uint32_t vertexCount, float threshold = 1.05f);
+
+        /** Reorder vertices in the order the triangle lists reference them, dropping unused vertices
+            \return The new vertex count
+        */
+        static uint32_t optimizeVertexFetch(const std::vector<std::vector<uint32_t>*>& indexLists, const std::vector<VertexStream>& streams, uint32_t vertexCount);
+    };
+}
@@ -41,7 +41,9 @@
 #include "Utils/StringUtils.h"
 #include "Graphics/Camera/Camera.h"
 #include "API/VAO.h"
+#include "Utils/ParallelFor.h"
 #include <set>
+#include <unordered_map>
 
 namespace Falcor
 {
@@ -102,17 +104,7 @@ namespace Falcor
 
         if(res)
         {
-            pModel->calculateModelProperties();
-            pModel->setRelativeFilename(filename);
-
-            std::string fullpath;
-            findFileInDataDirectories(filename, fullpath);
-            pModel->setAbsoluteFilename(fullpath);
-
-            std::string name = getFilenameFromPath(filename);
-            size_t extPos = name.find_last_of('.');
-            name = (extPos == std::string::npos) ? name : name.substr(0, extPos);
-            pModel->setName(name);
+            pModel->initFileProperties(filename);
         }
         else
         {
@@ -122,6 +114,118 @@ namespace Falcor
         return pModel;
     }
 
+    std::vector<Model::SharedPtr> Model::createFromFiles(const std::vector<std::string>& filenames, LoadFlags flags)
+    {
+        // Map the filenames to unique files
+        std::vector<std::string> uniqueFiles;
+        std::vector<uint32_t> fileIndex(filenames.size());
+        std::vector<uint32_t> fileUseCount;
+        std::unordered_map<std::string, uint32_t> pathToFile;
+        for (size_t i = 0; i < filenames.size(); i++)
+        {
+            std::string fullpath;
+            std::string key = findFileInDataDirectories(filenames[i], fullpath) ? canonicalizeFilename(fullpath) : filenames[i];
+            auto it = pathToFile.find(key);
+            if (it == pathToFile.end())
+            {
+                it = pathToFile.emplace(key, (uint32_t)uniqueFiles.size()).first;
+                uniqueFiles.push_back(filenames[i]);
+                fileUseCount.push_back(0);
+            }
+            fileIndex[i] = it->second;
+            fileUseCount[it->second]++;
+        }
+
+        // Parse the files on worker threads. Binary models are skipped, their importer creates GPU resources while reading the file
+        std::vector<AssimpModelImporter::ParsedFile::UniquePtr> parsedFiles(uniqueFiles.size());
+        parallelFor(0, uniqueFiles.size(), [&](size_t i)
+        {
+            PROFILE_CPU(parseModelFile);
+            if (hasSuffix(uniqueFiles[i], ".bin", false) == false)
+            {
+                parsedFiles[i] = AssimpModelImporter::parse(uniqueFiles[i], flags);
+            }
+        });
+
+        // Decode the textures of all models on worker threads
+        AssimpModelImporter::TextureCache textureCache;
+        std::vector<std::string> textureFiles;
+        for (const auto& pFile : parsedFiles)
+        {
+            if (pFile == nullptr)
+            {
+                continue;
+            }
+
+            for (const auto& texFile : pFile->getTextureFiles())
+            {
+                if (textureCache.fileData.emplace(texFile, nullptr).second)
+                {
+                    textureFiles.push_back(texFile);
+                }
+            }
+        }
+
+        std::vector<TextureFileData::SharedConstPtr> textureData(textureFiles.size());
+        parallelFor(0, textureFiles.size(), [&](size_t i)
+        {
+            PROFILE_CPU(decodeTextureFile);
+            textureData[i] = TextureFileData::create(textureFiles[i]);
+        });
+
+        for (size_t i = 0; i < textureFiles.size(); i++)
+        {
+            textureCache.fileData[textureFiles[i]] = textureData[i];
+        }
+        textureData.clear();
+
+        // Create the GPU resources on this thread
+        std::vector<SharedPtr> models(filenames.size());
+        for (size_t i = 0; i < filenames.size(); i++)
+        {
+            const uint32_t file = fileIndex[i];
+            SharedPtr pModel = SharedPtr(new Model());
+            bool res;
+            if (hasSuffix(filenames[i], ".bin", false))
+            {
+                res = BinaryModelImporter::import(*pModel, filenames[i], flags);
+            }
+            else
+            {
+                res = parsedFiles[file] && AssimpModelImporter::import(*pModel, *parsedFiles[file], flags, &textureCache);
+            }
+
+            // Release the parsed scene as soon as the last model using it was created
+            if (--fileUseCount[file] == 0)
+            {
+                parsedFiles[file] = nullptr;
+            }
+
+            if (res)
+            {
+                pModel->initFileProperties(filenames[i]);
+                models[i] = pModel;
+            }
+        }
+
+        return models;
+    }
+
+    void Model::initFileProperties(const std::string& filename)
+    {
+        calculateModelProperties();
+        setRelativeFilename(filename);
+
+        std::string fullpath;
+        findFileInDataDirectories(filename, fullpath);
+        setAbsoluteFilename(fullpath);
+
+        std::string name = getFilenameFromPath(filename);
+        size_t extPos = name.find_last_of('.');
+        name = (extPos == std::string::npos) ? name : name.substr(0, extPos);
+        setName(name);
+    }
+
     Model::SharedPtr Model::create()
     {
         return SharedPtr(new Model());
@@ -41,6 +41,7 @@ namespace Falcor
     class AssimpModelImporter;
     class BinaryModelImporter;
     class SimpleModelImporter;
+    class ScenePackage;
     class BinaryModelExporter;
     class Buffer;
     class Camera;
@@ -65,12 +66,23 @@ namespace Falcor
             AssumeLinearSpaceTextures   = 0x4,    ///< By default, textures representing colors (diffuse/specular) are interpreted as sRGB data. Use this flag to force linear space for color textures.
             DontMergeMeshes             = 0x8,    ///< Preserve the original list of meshes in the scene, don't merge meshes with the same material
             BuffersAsShaderResource     = 0x10,   ///< Generate the VBs and IB with the shader-resource-view bind flag
+            OptimizeMeshes              = 0x20,   ///< Merge duplicate vertices and reorder triangles and vertices for the vertex cache, overdraw and vertex fetch
+            PackVertexAttributes        = 0x40,   ///< Store normals and bitangents octahedral-encoded in RG16Snorm, texture coordinates in RG16Float and colors in RGBA8Unorm
+            QuantizePositions           = 0x80,   ///< Store positions in RGBA16Unorm relative to the mesh bounding box. Only supported by the Assimp importer, the binary format shares vertex buffers between meshes with different bounds
         };
 
         /** Create a new model from file
         */
         static SharedPtr createFromFile(const char* filename, LoadFlags flags = LoadFlags::None);
 
+        /** Create new models from a list of files. Model files are parsed and their textures decoded on worker threads, and only the GPU resources are created on the calling thread.
+            Files and textures referenced more than once are only loaded once, but every filename still gets its own model object.
+            \param[in] filenames Model filenames. Can include a full path or a relative path from a data directory
+            \param[in] flags Flags controlling model creation
+            \return One model per filename, in the same order. Entries are nullptr for files which failed to load
+        */
+        static std::vector<SharedPtr> createFromFiles(const std::vector<std::string>& filenames, LoadFlags flags = LoadFlags::None);
+
         static SharedPtr create();
 
         static const char* kSupportedFileFormatsStr;
@@ -245,6 +257,7 @@ namespace Falcor
 
     protected:
         friend class SimpleModelImporter;
+        friend class ScenePackage;
 
         Model();
         Model(const Model& other);
@@ -275,6 +288,7 @@ namespace Falcor
         static uint32_t sModelCounter;
 
         void calculateModelProperties();
+        void initFileProperties(const std::string& filename);
     };
 
     enum_class_operators(Model::LoadFlags);
@@ -34,12 +34,22 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtx/euler_angles.hpp"
 #include "Utils/Math/FalcorMath.h"
+#include <atomic>
 
 namespace Falcor
 {
     class SceneRenderer;
     class Model;
 
+    /** Get a new transform version. All object instances draw from one counter, so a version is never seen twice, even when a deleted
+        instance is replaced by a new one at the same address.
+    */
+    inline uint64_t getNextTransformVersion()
+    {
+        static std::atomic<uint64_t> sVersion(0);
+        return ++sVersion;
+    }
+
     /** Handles transformations for Mesh and Model instances. Primary transform is stored in the "Base" transform. An additional "Movable"
         transform is applied after the Base transform can be set through the IMovableObject interface. This is currently used by paths.
     */
@@ -215,6 +225,16 @@ namespace Falcor
             return mBoundingBox;
         }
 
+        /** Gets a version which changes every time the transform matrix and bounding box are recomputed.
+            Versions are unique across all instances, caches of derived data can compare it against the value they last saw instead of comparing matrices.
+            \return Transform version, never 0
+        */
+        uint64_t getTransformVersion() const
+        {
+            updateInstanceProperties();
+            return mTransformVersion;
+        }
+
         /** IMovableObject interface
         */
         virtual void move(const glm::vec3& position, const glm::vec3& target, const glm::vec3& up) override
@@ -258,6 +278,7 @@ namespace Falcor
                 mPrevFinalTransformMatrix = mPrevMovable.matrix * mBase.matrix;
 
                 mBoundingBox = mpObject->getBoundingBox().transform(mFinalTransformMatrix);
+                mTransformVersion = getNextTransformVersion();
             }
         }
 
@@ -334,5 +355,6 @@ namespace Falcor
         mutable glm::mat4 mFinalTransformMatrix;
         mutable glm::mat4 mPrevFinalTransformMatrix;
         mutable BoundingBox mBoundingBox;
+        mutable uint64_t mTransformVersion = 0;
     };
 }
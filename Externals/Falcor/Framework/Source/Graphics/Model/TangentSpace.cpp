@@ -0,0 +1,270 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TangentSpace.h"
+#include "Utils/ParallelFor.h"
+#include "glm/geometric.hpp"
+#include <cmath>
+#include <immintrin.h>
+#include <vector>
+
+namespace Falcor
+{
+    // Number of faces, vertices and 4-vertex groups handed to a worker at a time
+    static const size_t kFacesPerTask = 4096;
+    static const size_t kVerticesPerTask = 4096;
+    static const size_t kGroupsPerTask = 1024;
+
+    // Squared length below which a vector is considered degenerate
+    static const float kMinLengthSq = 1e-20f;
+
+    struct FaceFrame
+    {
+        glm::vec3 tangent;
+        glm::vec3 bitangent;
+    };
+
+    template<typename T>
+    static const T& getElement(const void* pData, uint32_t stride, uint32_t index)
+    {
+        return *(const T*)((const uint8_t*)pData + size_t(stride) * index);
+    }
+
+    static bool isFinite(const glm::vec3& v)
+    {
+        return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+    }
+
+    static glm::vec3 projectNormalToBitangent(const glm::vec3& normal)
+    {
+        glm::vec3 bitangent;
+        if (abs(normal.x) > abs(normal.y))
+        {
+            bitangent = glm::vec3(normal.z, 0.f, -normal.x) / length(glm::vec2(normal.x, normal.z));
+        }
+        else
+        {
+            bitangent = glm::vec3(0.f, normal.z, -normal.y) / length(glm::vec2(normal.y, normal.z));
+        }
+        return normalize(bitangent);
+    }
+
+    // Every face contributes a unit tangent and bitangent, so large faces don't dominate the vertex frame
+    static FaceFrame computeFaceFrame(const uint32_t* pFaceIndices, const void* pPositions, uint32_t positionStride, const void* pNormals, uint32_t normalStride, const void* pTexCrd, uint32_t texCrdStride)
+    {
+        glm::vec3 position[3];
+        glm::vec2 uv[3];
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            position[i] = getElement<glm::vec3>(pPositions, positionStride, pFaceIndices[i]);
+            uv[i] = pTexCrd ? getElement<glm::vec2>(pTexCrd, texCrdStride, pFaceIndices[i]) : glm::vec2(0);
+        }
+
+        glm::vec3 posDelta[2] = { position[1] - position[0], position[2] - position[0] };
+        glm::vec2 s = uv[1] - uv[0];
+        glm::vec2 t = uv[2] - uv[0];
+
+        FaceFrame frame;
+        // when t1, t2, t3 in same position in UV space, just use default UV direction.
+        if ((s == glm::vec2(0, 0)) || (t == glm::vec2(0, 0)))
+        {
+            const glm::vec3& normal = getElement<glm::vec3>(pNormals, normalStride, pFaceIndices[0]);
+            frame.bitangent = projectNormalToBitangent(normal);
+            frame.tangent = cross(frame.bitangent, normal);
+        }
+        else
+        {
+            float dirCorrection = 1.0f / (s.x * t.y - s.y * t.x);
+
+            // tangent points in the direction where to positive X axis of the texture coord's would point in model space
+            // bitangent's points along the positive Y axis of the texture coord's, respectively
+            frame.tangent = normalize((posDelta[0] * t.y - posDelta[1] * s.y) * dirCorrection);
+            frame.bitangent = normalize((posDelta[1] * s.x - posDelta[0] * t.x) * dirCorrection);
+        }
+
+        // Faces with a degenerate UV mapping or position don't contribute
+        if (isFinite(frame.tangent) == false || isFinite(frame.bitangent) == false)
+        {
+            frame.tangent = glm::vec3(0);
+            frame.bitangent = glm::vec3(0);
+        }
+        return frame;
+    }
+
+    static inline __m128 dot3(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+    {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_mul_ps(az, bz));
+    }
+
+    /** Gram-Schmidt for 4 vertices in structure-of-arrays form. The tangent is projected onto the plane of the normal, then the bitangent is made orthogonal to both.
+        Returns a mask of the lanes whose bitangent degenerated and needs the fallback.
+    */
+    static uint32_t orthogonalize4(__m128 nx, __m128 ny, __m128 nz, __m128 tx, __m128 ty, __m128 tz, __m128& bx, __m128& by, __m128& bz)
+    {
+        const __m128 minLengthSq = _mm_set1_ps(kMinLengthSq);
+
+        // T = normalize(T - N * dot(N, T)). Lanes without a tangent get a zero vector and skip the next step.
+        __m128 d = dot3(nx, ny, nz, tx, ty, tz);
+        tx = _mm_sub_ps(tx, _mm_mul_ps(nx, d));
+        ty = _mm_sub_ps(ty, _mm_mul_ps(ny, d));
+        tz = _mm_sub_ps(tz, _mm_mul_ps(nz, d));
+        __m128 lengthSq = dot3(tx, ty, tz, tx, ty, tz);
+        __m128 valid = _mm_cmpgt_ps(lengthSq, minLengthSq);
+        __m128 invLength = _mm_and_ps(valid, _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(lengthSq, minLengthSq))));
+        tx = _mm_mul_ps(tx, invLength);
+        ty = _mm_mul_ps(ty, invLength);
+        tz = _mm_mul_ps(tz, invLength);
+
+        // B = normalize(B - N * dot(N, B) - T * dot(T, B))
+        d = dot3(nx, ny, nz, bx, by, bz);
+        bx = _mm_sub_ps(bx, _mm_mul_ps(nx, d));
+        by = _mm_sub_ps(by, _mm_mul_ps(ny, d));
+        bz = _mm_sub_ps(bz, _mm_mul_ps(nz, d));
+        d = dot3(tx, ty, tz, bx, by, bz);
+        bx = _mm_sub_ps(bx, _mm_mul_ps(tx, d));
+        by = _mm_sub_ps(by, _mm_mul_ps(ty, d));
+        bz = _mm_sub_ps(bz, _mm_mul_ps(tz, d));
+        lengthSq = dot3(bx, by, bz, bx, by, bz);
+        valid = _mm_cmpgt_ps(lengthSq, minLengthSq);
+        invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(lengthSq, minLengthSq)));
+        bx = _mm_mul_ps(bx, invLength);
+        by = _mm_mul_ps(by, invLength);
+        bz = _mm_mul_ps(bz, invLength);
+
+        // NaN inputs fail the compare as well
+        return (~(uint32_t)_mm_movemask_ps(valid)) & 0xf;
+    }
+
+    void generateTangentSpace(
+        const uint32_t* pIndices,
+        uint32_t indexCount,
+        uint32_t vertexCount,
+        const void* pPositions,
+        uint32_t positionStride,
+        const void* pNormals,
+        uint32_t normalStride,
+        const void* pTexCrd,
+        uint32_t texCrdStride,
+        void* pBitangents,
+        uint32_t bitangentStride)
+    {
+        const size_t faceCount = indexCount / 3;
+
+        // Face frames
+        std::vector<FaceFrame> faces(faceCount);
+        parallelFor(0, faceCount, [&](size_t face)
+        {
+            faces[face] = computeFaceFrame(pIndices + face * 3, pPositions, positionStride, pNormals, normalStride, pTexCrd, texCrdStride);
+        }, kFacesPerTask);
+
+        // Vertex -> face adjacency in CSR form, built with a counting sort over the indices. The faces of vertex v are
+        // vertexFaces[faceOffsets[v]] .. vertexFaces[faceOffsets[v + 1] - 1], in ascending order. Out of range indices are skipped.
+        std::vector<uint32_t> faceOffsets(size_t(vertexCount) + 1, 0);
+        for (size_t i = 0; i < faceCount * 3; i++)
+        {
+            if (pIndices[i] < vertexCount)
+            {
+                faceOffsets[pIndices[i] + 1]++;
+            }
+        }
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            faceOffsets[v + 1] += faceOffsets[v];
+        }
+
+        std::vector<uint32_t> vertexFaces(faceOffsets[vertexCount]);
+        std::vector<uint32_t> cursor(faceOffsets.begin(), faceOffsets.end() - 1);
+        for (size_t i = 0; i < faceCount * 3; i++)
+        {
+            if (pIndices[i] < vertexCount)
+            {
+                vertexFaces[cursor[pIndices[i]]++] = uint32_t(i / 3);
+            }
+        }
+
+        // Sum the frames per vertex. Every vertex adds its faces in index buffer order, so the result doesn't depend on the number of workers.
+        std::vector<glm::vec3> tangentSum(vertexCount);
+        std::vector<glm::vec3> bitangentSum(vertexCount);
+        parallelFor(0, vertexCount, [&](size_t vertex)
+        {
+            glm::vec3 tangent(0);
+            glm::vec3 bitangent(0);
+            for (uint32_t k = faceOffsets[vertex]; k < faceOffsets[vertex + 1]; k++)
+            {
+                const FaceFrame& frame = faces[vertexFaces[k]];
+                tangent += frame.tangent;
+                bitangent += frame.bitangent;
+            }
+            tangentSum[vertex] = tangent;
+            bitangentSum[vertex] = bitangent;
+        }, kVerticesPerTask);
+
+        // Orthogonalize against the vertex normal, 4 vertices at a time. The last group is padded with zero lanes which aren't written back.
+        const size_t groupCount = (vertexCount + 3) / 4;
+        parallelFor(0, groupCount, [&](size_t group)
+        {
+            const uint32_t first = uint32_t(group * 4);
+            const uint32_t laneCount = std::min(4u, vertexCount - first);
+
+            alignas(16) float n[3][4] = {};
+            alignas(16) float t[3][4] = {};
+            alignas(16) float b[3][4] = {};
+            for (uint32_t lane = 0; lane < laneCount; lane++)
+            {
+                const glm::vec3& normal = getElement<glm::vec3>(pNormals, normalStride, first + lane);
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    n[c][lane] = normal[c];
+                    t[c][lane] = tangentSum[first + lane][c];
+                    b[c][lane] = bitangentSum[first + lane][c];
+                }
+            }
+
+            __m128 bx = _mm_load_ps(b[0]);
+            __m128 by = _mm_load_ps(b[1]);
+            __m128 bz = _mm_load_ps(b[2]);
+            uint32_t fallbackMask = orthogonalize4(_mm_load_ps(n[0]), _mm_load_ps(n[1]), _mm_load_ps(n[2]), _mm_load_ps(t[0]), _mm_load_ps(t[1]), _mm_load_ps(t[2]), bx, by, bz);
+            _mm_store_ps(b[0], bx);
+            _mm_store_ps(b[1], by);
+            _mm_store_ps(b[2], bz);
+
+            for (uint32_t lane = 0; lane < laneCount; lane++)
+            {
+                glm::vec3& bitangent = *(glm::vec3*)((uint8_t*)pBitangents + size_t(bitangentStride) * (first + lane));
+                if (fallbackMask & (1 << lane))
+                {
+                    bitangent = projectNormalToBitangent(glm::vec3(n[0][lane], n[1][lane], n[2][lane]));
+                }
+                else
+                {
+                    bitangent = glm::vec3(b[0][lane], b[1][lane], b[2][lane]);
+                }
+            }
+        }, kGroupsPerTask);
+    }
+}
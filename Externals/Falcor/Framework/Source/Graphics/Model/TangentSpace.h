@@ -0,0 +1,62 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <cstdint>
+
+namespace Falcor
+{
+    /** Generate per-vertex bitangents for an indexed triangle list. Meshes only store the bitangent, the tangent is reconstructed from it and the normal in the shader.
+        Face frames are computed from the texture coordinates in parallel, then summed per vertex in face order, so the result doesn't depend on the number of threads.
+        The summed frame of every vertex is made orthogonal to the vertex normal with Gram-Schmidt, 4 vertices at a time.
+        Vertices without usable texture coordinates get a bitangent derived from the normal alone.
+        All vertex attributes are read from strided arrays of floats, so interleaved vertex data can be used directly.
+        \param[in] pIndices Triangle list indices
+        \param[in] indexCount Number of indices
+        \param[in] vertexCount Number of vertices
+        \param[in] pPositions Vertex positions. Only xyz is read
+        \param[in] positionStride Bytes between consecutive positions
+        \param[in] pNormals Vertex normals. Expected to be normalized
+        \param[in] normalStride Bytes between consecutive normals
+        \param[in] pTexCrd Texture coordinates. Only xy is read. Can be nullptr, in which case every bitangent is derived from the normal
+        \param[in] texCrdStride Bytes between consecutive texture coordinates
+        \param[out] pBitangents Where to write the bitangents (xyz)
+        \param[in] bitangentStride Bytes between consecutive bitangents
+    */
+    void generateTangentSpace(
+        const uint32_t* pIndices,
+        uint32_t indexCount,
+        uint32_t vertexCount,
+        const void* pPositions,
+        uint32_t positionStride,
+        const void* pNormals,
+        uint32_t normalStride,
+        const void* pTexCrd,
+        uint32_t texCrdStride,
+        void* pBitangents,
+        uint32_t bitangentStride);
+}
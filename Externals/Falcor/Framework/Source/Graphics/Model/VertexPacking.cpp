@@ -0,0 +1,236 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "VertexPacking.h"
+#include "Data/VertexAttrib.h"
+#include "API/VertexLayout.h"
+#include "glm/gtc/packing.hpp"
+#include "glm/geometric.hpp"
+#include <cstring>
+
+namespace Falcor
+{
+    static glm::vec2 signNotZero(const glm::vec2& v)
+    {
+        return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    glm::vec2 encodeOctahedral(const glm::vec3& n)
+    {
+        float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        if (l1 == 0.0f)
+        {
+            return glm::vec2(0.0f);
+        }
+
+        // Project onto the octahedron, then fold the lower hemisphere over the diagonals
+        glm::vec2 p = glm::vec2(n.x, n.y) / l1;
+        if (n.z < 0.0f)
+        {
+            p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * signNotZero(p);
+        }
+        return p;
+    }
+
+    glm::vec3 decodeOctahedral(const glm::vec2& e)
+    {
+        glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+        if (n.z < 0.0f)
+        {
+            glm::vec2 xy = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * signNotZero(glm::vec2(n.x, n.y));
+            n.x = xy.x;
+            n.y = xy.y;
+        }
+        return glm::normalize(n);
+    }
+
+    ResourceFormat getPackedVertexFormat(uint32_t shaderLocation)
+    {
+        switch (shaderLocation)
+        {
+        case VERTEX_POSITION_LOC:
+            return ResourceFormat::RGBA16Unorm;
+        case VERTEX_NORMAL_LOC:
+        case VERTEX_BITANGENT_LOC:
+            return ResourceFormat::RG16Snorm;
+        case VERTEX_TEXCOORD_LOC:
+        case VERTEX_LIGHTMAP_UV_LOC:
+            return ResourceFormat::RG16Float;
+        case VERTEX_DIFFUSE_COLOR_LOC:
+            return ResourceFormat::RGBA8Unorm;
+        default:
+            return ResourceFormat::Unknown;
+        }
+    }
+
+    void packVertexAttributes(uint32_t shaderLocation, ResourceFormat format, const void* pSrc, uint32_t srcStride, uint32_t srcComponents, void* pDst, uint32_t dstStride, uint32_t count, const BoundingBox& positionBox)
+    {
+        const glm::vec3 boxMin = positionBox.getMinPos();
+        const glm::vec3 boxSize = positionBox.getSize();
+        const glm::vec3 invBoxSize(boxSize.x > 0 ? 1.0f / boxSize.x : 0.0f, boxSize.y > 0 ? 1.0f / boxSize.y : 0.0f, boxSize.z > 0 ? 1.0f / boxSize.z : 0.0f);
+        srcComponents = std::min(srcComponents, 4u);
+
+        const uint8_t* pSrcBytes = (const uint8_t*)pSrc;
+        uint8_t* pDstBytes = (uint8_t*)pDst;
+        for (uint32_t i = 0; i < count; i++, pSrcBytes += srcStride, pDstBytes += dstStride)
+        {
+            glm::vec4 v(0, 0, 0, 1);
+            std::memcpy(&v, pSrcBytes, srcComponents * sizeof(float));
+
+            switch (format)
+            {
+            case ResourceFormat::RG16Snorm:
+            {
+                uint32_t packed = glm::packSnorm2x16(encodeOctahedral(glm::vec3(v)));
+                std::memcpy(pDstBytes, &packed, sizeof(packed));
+                break;
+            }
+            case ResourceFormat::RG16Float:
+            {
+                uint32_t packed = glm::packHalf2x16(glm::vec2(v));
+                std::memcpy(pDstBytes, &packed, sizeof(packed));
+                break;
+            }
+            case ResourceFormat::RGBA8Unorm:
+            {
+                uint32_t packed = glm::packUnorm4x8(v);
+                std::memcpy(pDstBytes, &packed, sizeof(packed));
+                break;
+            }
+            case ResourceFormat::RGBA16Unorm:
+            {
+                assert(shaderLocation == VERTEX_POSITION_LOC);
+                glm::vec3 q = (glm::vec3(v) - boxMin) * invBoxSize;
+                uint64_t packed = glm::packUnorm4x16(glm::vec4(q, 1.0f));
+                std::memcpy(pDstBytes, &packed, sizeof(packed));
+                break;
+            }
+            default:
+                should_not_get_here();
+                return;
+            }
+        }
+    }
+
+    bool unpackVertexAttribute(const void* pSrc, ResourceFormat format, uint32_t shaderLocation, const BoundingBox& positionBox, glm::vec4& value)
+    {
+        value = glm::vec4(0, 0, 0, 1);
+        switch (format)
+        {
+        case ResourceFormat::RG16Snorm:
+        {
+            uint32_t packed;
+            std::memcpy(&packed, pSrc, sizeof(packed));
+            glm::vec2 e = glm::unpackSnorm2x16(packed);
+            if (shaderLocation == VERTEX_NORMAL_LOC || shaderLocation == VERTEX_BITANGENT_LOC)
+            {
+                value = glm::vec4(decodeOctahedral(e), 0.0f);
+            }
+            else
+            {
+                value = glm::vec4(e, 0.0f, 1.0f);
+            }
+            return true;
+        }
+        case ResourceFormat::RG16Float:
+        {
+            uint32_t packed;
+            std::memcpy(&packed, pSrc, sizeof(packed));
+            value = glm::vec4(glm::unpackHalf2x16(packed), 0.0f, 1.0f);
+            return true;
+        }
+        case ResourceFormat::RGBA8Unorm:
+        {
+            uint32_t packed;
+            std::memcpy(&packed, pSrc, sizeof(packed));
+            value = glm::unpackUnorm4x8(packed);
+            return true;
+        }
+        case ResourceFormat::RGBA16Unorm:
+        {
+            uint64_t packed;
+            std::memcpy(&packed, pSrc, sizeof(packed));
+            value = glm::unpackUnorm4x16(packed);
+            if (shaderLocation == VERTEX_POSITION_LOC)
+            {
+                value = glm::vec4(positionBox.getMinPos() + glm::vec3(value) * positionBox.getSize(), 1.0f);
+            }
+            return true;
+        }
+        default:
+        {
+            const uint32_t channelCount = getFormatChannelCount(format);
+            if (getFormatType(format) != FormatType::Float || getFormatBytesPerBlock(format) != channelCount * sizeof(float))
+            {
+                return false;
+            }
+            std::memcpy(&value, pSrc, std::min(channelCount, 4u) * sizeof(float));
+            return true;
+        }
+        }
+    }
+
+    bool readVertexAttribute(const uint8_t* pVBData, const VertexBufferLayout* pLayout, uint32_t elemIdx, uint32_t vertexCount, const BoundingBox& positionBox, uint32_t componentCount, float* pDst)
+    {
+        const ResourceFormat format = pLayout->getElementFormat(elemIdx);
+        const uint32_t channelCount = getFormatChannelCount(format);
+        const bool isFloat = (getFormatType(format) == FormatType::Float) && (getFormatBytesPerBlock(format) == channelCount * sizeof(float));
+        if (isFloat && channelCount < componentCount)
+        {
+            logWarning("Vertex attribute " + pLayout->getElementName(elemIdx) + " has fewer components than requested, it is ignored.");
+            return false;
+        }
+
+        const uint32_t stride = pLayout->getStride();
+        const uint32_t dstStride = componentCount * sizeof(float);
+        const uint8_t* pSrc = pVBData + pLayout->getElementOffset(elemIdx);
+        if (isFloat && stride == dstStride)
+        {
+            std::memcpy(pDst, pSrc, size_t(vertexCount) * dstStride);
+            return true;
+        }
+
+        for (uint32_t vertIdx = 0; vertIdx < vertexCount; ++vertIdx, pSrc += stride, pDst += componentCount)
+        {
+            if (isFloat)
+            {
+                std::memcpy(pDst, pSrc, dstStride);
+                continue;
+            }
+
+            glm::vec4 value;
+            if (unpackVertexAttribute(pSrc, format, pLayout->getElementShaderLocation(elemIdx), positionBox, value) == false)
+            {
+                logWarning("Vertex attribute " + pLayout->getElementName(elemIdx) + " has an unsupported format, it is ignored.");
+                return false;
+            }
+            std::memcpy(pDst, &value, std::min(componentCount, 4u) * sizeof(float));
+        }
+        return true;
+    }
+}
@@ -0,0 +1,106 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "API/Formats.h"
+#include "Utils/AABB.h"
+#include <vector>
+
+namespace Falcor
+{
+    class VertexBufferLayout;
+
+    /** Get the compact format of a vertex attribute, used by the model importers with Model::LoadFlags::PackVertexAttributes and Model::LoadFlags::QuantizePositions.
+        - Normals and bitangents are octahedral-encoded in RG16Snorm
+        - Texture coordinates are stored in RG16Float
+        - Colors are stored in RGBA8Unorm, clamped to [0, 1]
+        - Positions are stored in RGBA16Unorm relative to the mesh bounding box. Shaders read the box from InternalPerMeshCB.
+        DefaultVS.slang decodes all of them, the formats are detected by VertexLayout::addVertexAttribDclToProg().
+        \param[in] shaderLocation The attribute's location, one of the VERTEX_*_LOC values
+        \return The packed format, or ResourceFormat::Unknown if the attribute isn't packed
+    */
+    ResourceFormat getPackedVertexFormat(uint32_t shaderLocation);
+
+    /** Pack vertex attributes stored as floats
+        \param[in] shaderLocation The attribute's location
+        \param[in] format The packed format, as returned from getPackedVertexFormat()
+        \param[in] pSrc Source attributes
+        \param[in] srcStride Bytes between consecutive source attributes
+        \param[in] srcComponents Number of floats in each source attribute
+        \param[out] pDst Where to write the packed attributes
+        \param[in] dstStride Bytes between consecutive packed attributes
+        \param[in] count Number of attributes
+        \param[in] positionBox Box the positions are quantized against. Only used for positions
+    */
+    void packVertexAttributes(uint32_t shaderLocation, ResourceFormat format, const void* pSrc, uint32_t srcStride, uint32_t srcComponents, void* pDst, uint32_t dstStride, uint32_t count, const BoundingBox& positionBox);
+
+    /** Decode a single vertex attribute. Handles 32-bit float formats and the packed formats.
+        Missing components are filled like the input assembler does, with (0, 0, 0, 1).
+        \param[in] pSrc The attribute
+        \param[in] format The attribute's format
+        \param[in] shaderLocation The attribute's location
+        \param[in] positionBox Box the positions were quantized against. Only used for quantized positions
+        \param[out] value The decoded attribute
+        \return false if the format isn't supported
+    */
+    bool unpackVertexAttribute(const void* pSrc, ResourceFormat format, uint32_t shaderLocation, const BoundingBox& positionBox, glm::vec4& value);
+
+    /** Copy one attribute of every vertex in a buffer into tightly packed floats. Packed attributes are decoded with unpackVertexAttribute().
+        \param[in] pVBData Mapped vertex buffer
+        \param[in] pLayout The buffer's layout
+        \param[in] elemIdx Index of the attribute in the layout
+        \param[in] vertexCount Number of vertices
+        \param[in] positionBox Box the positions were quantized against. Only used for quantized positions
+        \param[in] componentCount Number of floats written per vertex
+        \param[out] pDst Where to write the attributes, vertexCount * componentCount floats
+        \return false if the format isn't supported or has fewer components than requested. A warning is logged in that case
+    */
+    bool readVertexAttribute(const uint8_t* pVBData, const VertexBufferLayout* pLayout, uint32_t elemIdx, uint32_t vertexCount, const BoundingBox& positionBox, uint32_t componentCount, float* pDst);
+
+    /** Append one attribute of every vertex in a buffer to an array of float vectors, see above. dst is left unchanged on failure.
+    */
+    template<typename VecType>
+    bool readVertexAttribute(const uint8_t* pVBData, const VertexBufferLayout* pLayout, uint32_t elemIdx, uint32_t vertexCount, const BoundingBox& positionBox, std::vector<VecType>& dst)
+    {
+        const size_t base = dst.size();
+        dst.resize(base + vertexCount);
+        if (readVertexAttribute(pVBData, pLayout, elemIdx, vertexCount, positionBox, uint32_t(sizeof(VecType) / sizeof(float)), (float*)(dst.data() + base)) == false)
+        {
+            dst.resize(base);
+            return false;
+        }
+        return true;
+    }
+
+    /** Octahedral encoding of a unit vector into [-1, 1]^2
+    */
+    glm::vec2 encodeOctahedral(const glm::vec3& n);
+
+    /** Decode an octahedral-encoded unit vector
+    */
+    glm::vec3 decodeOctahedral(const glm::vec2& e);
+}
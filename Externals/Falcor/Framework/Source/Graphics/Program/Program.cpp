@@ -38,6 +38,7 @@
 #include "API/Sampler.h"
 #include "API/RenderContext.h"
 #include "Utils/StringUtils.h"
+#include "Utils/ParallelFor.h"
 
 namespace Falcor
 {
@@ -292,6 +293,20 @@ namespace Falcor
     {
         mFileTimeMap.clear();
 
+        Shader::Blob shaderBlob[kShaderCount];
+        ProgramReflection::SharedPtr pReflector;
+        if (preprocess(mDefineList, shaderBlob, pReflector, log) == false)
+        {
+            return nullptr;
+        }
+
+        // Now that we've preprocessed things, dispatch to the actual program creation logic,
+        // which may vary in subclasses of `Program`
+        return createProgramVersion(log, shaderBlob, pReflector);
+    }
+
+    bool Program::preprocess(const DefineList& defines, Shader::Blob shaderBlob[kShaderCount], ProgramReflection::SharedPtr& pReflector, std::string& log) const
+    {
         // Run all of the shaders through Slang, so that we can get final code,
         // reflection data, etc.
         //
@@ -318,7 +333,7 @@ namespace Falcor
 
         // Pass any `#define` flags along to Slang, since we aren't doing our
         // own preprocessing any more.
-        for(auto shaderDefine : mDefineList)
+        for(auto shaderDefine : defines)
         {
             spAddPreprocessorDefine(slangRequest, shaderDefine.first.c_str(), shaderDefine.second.c_str());
         }
@@ -423,12 +438,11 @@ namespace Falcor
         if(anySlangErrors)
         {
             spDestroyCompileRequest(slangRequest);
-            return nullptr;
+            return false;
         }
 
         // Extract the generated code for each stage
         int entryPointCounter = 0;
-        Shader::Blob shaderBlob[kShaderCount];
 
         for (uint32_t i = 0; i < kShaderCount; i++)
         {
@@ -453,7 +467,7 @@ namespace Falcor
         }
 
         // Extract the reflection data
-        mPreprocessedReflector = ProgramReflection::create(slang::ShaderReflection::get(slangRequest), log);
+        pReflector = ProgramReflection::create(slang::ShaderReflection::get(slangRequest), log);
 
         // Extract list of files referenced, for dependency-tracking purposes
         int depFileCount = spGetDependencyFileCount(slangRequest);
@@ -464,13 +478,10 @@ namespace Falcor
         }
 
         spDestroyCompileRequest(slangRequest);
-
-        // Now that we've preprocessed things, dispatch to the actual program creation logic,
-        // which may vary in subclasses of `Program`
-        return createProgramVersion(log, shaderBlob);
+        return true;
     }
 
-    ProgramVersion::SharedPtr Program::createProgramVersion(std::string& log, const Shader::Blob shaderBlob[kShaderCount]) const
+    ProgramVersion::SharedPtr Program::createProgramVersion(std::string& log, const Shader::Blob shaderBlob[kShaderCount], const ProgramReflection::SharedPtr& pReflector) const
     {
         // create the shaders
         Shader::SharedPtr shaders[kShaderCount] = {};
@@ -486,13 +497,13 @@ namespace Falcor
         if (shaders[(uint32_t)ShaderType::Compute])
         {
             return ProgramVersion::create(
-                mPreprocessedReflector,
+                pReflector,
                 shaders[(uint32_t)ShaderType::Compute], log, getProgramDescString());
         }
         else
         {
             return ProgramVersion::create(
-                mPreprocessedReflector,
+                pReflector,
                 shaders[(uint32_t)ShaderType::Vertex],
                 shaders[(uint32_t)ShaderType::Pixel],
                 shaders[(uint32_t)ShaderType::Geometry],
@@ -532,6 +543,65 @@ namespace Falcor
         }
     }
 
+    void Program::precompile(const std::vector<DefineList>& permutations)
+    {
+        struct PendingVersion
+        {
+            DefineList defines;
+            Shader::Blob shaderBlob[kShaderCount];
+            ProgramReflection::SharedPtr pReflector;
+            ProgramVersion::SharedPtr pVersion;
+            std::string log;
+        };
+
+        // Slang isn't thread-safe, run it for every version first
+        std::vector<std::unique_ptr<PendingVersion>> pending;
+        for (const DefineList& defines : permutations)
+        {
+            if (mProgramVersions.find(defines) != mProgramVersions.end())
+            {
+                continue;
+            }
+
+            bool duplicate = false;
+            for (const auto& pVersion : pending)
+            {
+                duplicate = duplicate || (pVersion->defines == defines);
+            }
+            if (duplicate)
+            {
+                continue;
+            }
+
+            std::unique_ptr<PendingVersion> pVersion(new PendingVersion);
+            pVersion->defines = defines;
+            if (preprocess(defines, pVersion->shaderBlob, pVersion->pReflector, pVersion->log) == false)
+            {
+                logWarning("Program::precompile() failed to preprocess a version of " + getProgramDescString() + "\n" + pVersion->log);
+                continue;
+            }
+            pending.push_back(std::move(pVersion));
+        }
+
+        parallelFor(0, pending.size(), [&](size_t i)
+        {
+            PendingVersion& version = *pending[i];
+            version.pVersion = createProgramVersion(version.log, version.shaderBlob, version.pReflector);
+        });
+
+        for (const auto& pVersion : pending)
+        {
+            if (pVersion->pVersion)
+            {
+                mProgramVersions[pVersion->defines] = pVersion->pVersion;
+            }
+            else
+            {
+                logWarning("Program::precompile() failed to compile a version of " + getProgramDescString() + "\n" + pVersion->log);
+            }
+        }
+    }
+
     void Program::reset()
     {
         mpActiveProgram = nullptr;
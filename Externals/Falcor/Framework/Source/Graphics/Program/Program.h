@@ -217,6 +217,13 @@ namespace Falcor
         */
         void replaceAllDefines(const DefineList& dl) { mDefineList = dl; }
 
+        /** Compile program versions ahead of their first use, so switching to them later doesn't stall.
+            Slang runs on the calling thread one version at a time, the downstream compilation of all the versions runs in parallel on the JobSystem workers. Compiled shaders also go to the ShaderCache.
+            Versions which were already compiled are skipped. Versions which fail to compile are skipped with a warning, the usual error is reported when they become active.
+            \param[in] permutations The define lists of the versions to compile. The active define list is unchanged.
+        */
+        void precompile(const std::vector<DefineList>& permutations);
+
     protected:
         Program();
 
@@ -224,16 +231,12 @@ namespace Falcor
 
         bool link() const;
         ProgramVersion::SharedPtr preprocessAndCreateProgramVersion(std::string& log) const;
-        virtual ProgramVersion::SharedPtr createProgramVersion(std::string& log, const Shader::Blob shaderBlob[kShaderCount]) const;
+        bool preprocess(const DefineList& defines, Shader::Blob shaderBlob[kShaderCount], ProgramReflection::SharedPtr& pReflector, std::string& log) const;
+        virtual ProgramVersion::SharedPtr createProgramVersion(std::string& log, const Shader::Blob shaderBlob[kShaderCount], const ProgramReflection::SharedPtr& pReflector) const;
 
         // The description used to create this program
         Desc mDesc;
 
-        // Shader strings after being preprocessed for a particular version
-
-        // Reflector for a particular version
-        mutable ProgramReflection::SharedPtr mPreprocessedReflector;
-
         DefineList mDefineList;
 
         // We are doing lazy compilation, so these are mutable
@@ -0,0 +1,249 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Graphics/Program/ShaderCache.h"
+#include "Utils/Platform/OS.h"
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace Falcor
+{
+    namespace
+    {
+        // Bump when the entry layout or the key contents change
+        const uint32_t kCacheVersion = 2;
+        const char kEntryMagic[4] = { 'F', 'S', 'C', 'E' };
+
+        struct EntryHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint64_t size;
+        };
+
+        // The two halves of the key come from different hash functions with different seeds, so a collision in one doesn't imply one in the other
+        const uint64_t kSeeds[2] = { 0x8445D61A4E774912ull, 0x3C6EF372FE94F82Bull };
+        const uint64_t kMurmur2Mul = 0xC6A4A7935BD1E995ull;
+        const uint64_t kMurmur3C1 = 0x87C37B91114253D5ull;
+        const uint64_t kMurmur3C2 = 0x4CF5AD432745937Full;
+
+        uint64_t rotl64(uint64_t x, int r)
+        {
+            return (x << r) | (x >> (64 - r));
+        }
+
+        // MurmurHash3 finalizer
+        uint64_t fmix64(uint64_t k)
+        {
+            k ^= k >> 33;
+            k *= 0xFF51AFD7ED558CCDull;
+            k ^= k >> 33;
+            k *= 0xC4CEB9FE1A85EC53ull;
+            k ^= k >> 33;
+            return k;
+        }
+
+        struct CacheState
+        {
+            std::mutex mutex;
+            std::string directory;
+            bool initialized = false;
+        };
+
+        CacheState& getCacheState()
+        {
+            static CacheState state;
+            return state;
+        }
+    }
+
+    ShaderCache::Key::Key()
+    {
+        mHash[0] = kSeeds[0];
+        mHash[1] = kSeeds[1];
+        add(&kCacheVersion, sizeof(kCacheVersion));
+    }
+
+    void ShaderCache::Key::addBlock(uint64_t block)
+    {
+        // MurmurHash64A
+        uint64_t k = block * kMurmur2Mul;
+        k ^= k >> 47;
+        k *= kMurmur2Mul;
+        mHash[0] = (mHash[0] ^ k) * kMurmur2Mul;
+
+        // First lane of MurmurHash3 x64 128
+        k = rotl64(block * kMurmur3C1, 31) * kMurmur3C2;
+        mHash[1] ^= k;
+        mHash[1] = rotl64(mHash[1], 27) * 5 + 0x52DCE729;
+    }
+
+    ShaderCache::Key& ShaderCache::Key::add(const void* pData, size_t size)
+    {
+        const uint8_t* pBytes = (const uint8_t*)pData;
+        mLength += size;
+        for (size_t i = 0; i < size; i++)
+        {
+            mTail |= uint64_t(pBytes[i]) << (8 * mTailSize);
+            if (++mTailSize == 8)
+            {
+                addBlock(mTail);
+                mTail = 0;
+                mTailSize = 0;
+            }
+        }
+        return *this;
+    }
+
+    ShaderCache::Key& ShaderCache::Key::add(const std::string& str)
+    {
+        const uint64_t length = str.size();
+        add(&length, sizeof(length));
+        return add(str.data(), str.size());
+    }
+
+    std::string ShaderCache::Key::toString() const
+    {
+        // Finalize copies, so more data can still be added
+        uint64_t h0 = mHash[0];
+        if (mTailSize)
+        {
+            h0 = (h0 ^ mTail) * kMurmur2Mul;
+        }
+        h0 ^= mLength;
+        h0 = fmix64(h0);
+
+        uint64_t h1 = mHash[1];
+        if (mTailSize)
+        {
+            h1 ^= rotl64(mTail * kMurmur3C1, 31) * kMurmur3C2;
+        }
+        h1 ^= mLength;
+        h1 = fmix64(h1);
+
+        char str[33];
+        std::snprintf(str, sizeof(str), "%016llx%016llx", (unsigned long long)h0, (unsigned long long)h1);
+        return str;
+    }
+
+    void ShaderCache::setDirectory(const std::string& directory)
+    {
+        CacheState& state = getCacheState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.initialized = true;
+        state.directory = directory;
+        if (directory.size() && isDirectoryExists(directory) == false && createDirectory(directory) == false)
+        {
+            logWarning("ShaderCache: can't create the cache directory " + directory + ", the cache is disabled");
+            state.directory.clear();
+        }
+    }
+
+    std::string ShaderCache::getDirectory()
+    {
+#if _ENABLE_SHADER_CACHE
+        CacheState& state = getCacheState();
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (state.initialized)
+            {
+                return state.directory;
+            }
+        }
+        setDirectory(getExecutableDirectory() + "/ShaderCache");
+        return getDirectory();
+#else
+        return "";
+#endif
+    }
+
+    bool ShaderCache::load(const Key& key, std::vector<uint8_t>& data)
+    {
+        const std::string directory = getDirectory();
+        if (directory.empty())
+        {
+            return false;
+        }
+
+        FILE* pFile = std::fopen((directory + "/" + key.toString() + ".bin").c_str(), "rb");
+        if (pFile == nullptr)
+        {
+            return false;
+        }
+
+        EntryHeader header;
+        bool valid = std::fread(&header, sizeof(header), 1, pFile) == 1;
+        valid = valid && std::memcmp(header.magic, kEntryMagic, sizeof(kEntryMagic)) == 0 && header.version == kCacheVersion;
+        if (valid)
+        {
+            data.resize((size_t)header.size);
+            valid = std::fread(data.data(), 1, data.size(), pFile) == data.size();
+        }
+        std::fclose(pFile);
+
+        if (valid == false)
+        {
+            logWarning("ShaderCache: ignoring corrupted entry " + key.toString());
+            data.clear();
+        }
+        return valid;
+    }
+
+    void ShaderCache::store(const Key& key, const void* pData, size_t size)
+    {
+        const std::string directory = getDirectory();
+        if (directory.empty())
+        {
+            return;
+        }
+
+        const std::string filename = directory + "/" + key.toString() + ".bin";
+        const std::string tempFilename = filename + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+        FILE* pFile = std::fopen(tempFilename.c_str(), "wb");
+        if (pFile == nullptr)
+        {
+            return;
+        }
+
+        EntryHeader header;
+        std::memcpy(header.magic, kEntryMagic, sizeof(kEntryMagic));
+        header.version = kCacheVersion;
+        header.size = size;
+        bool written = std::fwrite(&header, sizeof(header), 1, pFile) == 1;
+        written = written && std::fwrite(pData, 1, size, pFile) == size;
+        written = (std::fclose(pFile) == 0) && written;
+
+        // Another thread or process may have stored the same entry in the meantime, in which case the rename fails and ours is redundant
+        if (written == false || std::rename(tempFilename.c_str(), filename.c_str()) != 0)
+        {
+            std::remove(tempFilename.c_str());
+        }
+    }
+}
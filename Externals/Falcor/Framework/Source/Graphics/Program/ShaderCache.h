@@ -0,0 +1,94 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Falcor
+{
+    /** Persistent on-disk cache of compiled shader code.
+        Entries are addressed by a 128-bit hash of everything that affects the compiler's output. Shader::compile() hashes the code generated by Slang, which already has its includes and defines resolved, together with the entry point, target profile, compiler flags and compiler version.
+        A warm run therefore skips the downstream compiler, and editing a shader or any file it includes naturally produces a new entry. Stale entries are never removed, delete the directory to reclaim the space.
+        The cache is safe to use from multiple threads. Define _ENABLE_SHADER_CACHE to 0 in FalcorConfig.h to disable it.
+    */
+    class ShaderCache
+    {
+    public:
+        /** Incrementally built cache key
+        */
+        class Key
+        {
+        public:
+            Key();
+
+            /** Hash a block of data into the key
+            */
+            Key& add(const void* pData, size_t size);
+
+            /** Hash a string into the key, including its length so consecutive strings can't alias
+            */
+            Key& add(const std::string& str);
+
+            /** Get the key as a hex string, used as the entry's filename
+            */
+            std::string toString() const;
+
+        private:
+            void addBlock(uint64_t block);
+
+            uint64_t mHash[2];      // Two unrelated 64-bit hashes, MurmurHash64A and one lane of MurmurHash3 x64
+            uint64_t mTail = 0;     // Bytes not yet hashed, hashing works on 8-byte blocks
+            uint32_t mTailSize = 0;
+            uint64_t mLength = 0;
+        };
+
+        /** Set the cache directory. By default the cache is stored in a 'ShaderCache' directory next to the executable.
+            \param[in] directory The directory, which is created if it doesn't exist. An empty string disables the cache.
+        */
+        static void setDirectory(const std::string& directory);
+
+        /** Get the cache directory, or an empty string if the cache is disabled
+        */
+        static std::string getDirectory();
+
+        /** Look up an entry
+            \param[in] key The entry's key
+            \param[out] data The cached code
+            \return true if the entry was found
+        */
+        static bool load(const Key& key, std::vector<uint8_t>& data);
+
+        /** Add an entry. The file is written under a temporary name and renamed, so concurrent readers never see a partial entry.
+            \param[in] key The entry's key
+            \param[in] pData The code to store
+            \param[in] size Size of the code in bytes
+        */
+        static void store(const Key& key, const void* pData, size_t size);
+    };
+}
@@ -28,6 +28,7 @@
 #include "Framework.h"
 #include "Scene.h"
 #include "SceneImporter.h"
+#include "ScenePackage.h"
 #include "glm/gtx/euler_angles.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
@@ -41,6 +42,11 @@ namespace Falcor
 
     Scene::SharedPtr Scene::loadFromFile(const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags)
     {
+        if (hasSuffix(filename, ScenePackage::kFileExtension, false))
+        {
+            return ScenePackage::loadScene(filename, sceneLoadFlags);
+        }
+
         Scene::SharedPtr pScene = create();
         if (SceneImporter::loadScene(*pScene, filename, modelLoadFlags, sceneLoadFlags) == false)
         {
@@ -0,0 +1,252 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Graphics/Scene/SceneBvh.h"
+#include "Utils/ParallelFor.h"
+
+namespace Falcor
+{
+    // A refitted top level is rebuilt once its SAH cost grew by this factor since the last build
+    static const float kRebuildCostRatio = 1.5f;
+
+    template<typename Func>
+    static void forEachMeshInstance(const Scene* pScene, Func func)
+    {
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            for (uint32_t instanceID = 0; instanceID < pScene->getModelInstanceCount(modelID); instanceID++)
+            {
+                const Scene::ModelInstance::SharedPtr& pModelInstance = pScene->getModelInstance(modelID, instanceID);
+                const Model* pModel = pModelInstance->getObject().get();
+                for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+                {
+                    for (uint32_t meshInstanceID = 0; meshInstanceID < pModel->getMeshInstanceCount(meshID); meshInstanceID++)
+                    {
+                        func(pModelInstance, pModel->getMeshInstance(meshID, meshInstanceID));
+                    }
+                }
+            }
+        }
+    }
+
+    static bool boxesOverlap(const BoundingBox& a, const BoundingBox& b)
+    {
+        const glm::vec3 d = glm::abs(a.center - b.center);
+        const glm::vec3 e = a.extent + b.extent;
+        return d.x <= e.x && d.y <= e.y && d.z <= e.z;
+    }
+
+    SceneBvh::SharedPtr SceneBvh::create(const Scene::SharedPtr& pScene)
+    {
+        return SharedPtr(new SceneBvh(pScene));
+    }
+
+    SceneBvh::SceneBvh(const Scene::SharedPtr& pScene) : mpScene(pScene)
+    {
+        rebuild();
+    }
+
+    void SceneBvh::rebuild()
+    {
+        mEntries.clear();
+        forEachMeshInstance(mpScene.get(), [this](const Scene::ModelInstance::SharedPtr& pModelInstance, const Model::MeshInstance::SharedPtr& pMeshInstance)
+        {
+            Entry entry;
+            entry.instance.pModelInstance = pModelInstance;
+            entry.instance.pMeshInstance = pMeshInstance;
+            mEntries.push_back(entry);
+        });
+
+        // Mesh data has to be read back on this thread, the mesh level hierarchies are then built in parallel
+        struct PendingMesh
+        {
+            const Mesh* pMesh;
+            std::vector<glm::vec3> positions;
+            std::vector<uint32_t> indices;
+            MeshBvh::SharedPtr pBlas;
+        };
+        std::vector<PendingMesh> pendingMeshes;
+
+        std::unordered_map<const Mesh*, MeshBvh::SharedConstPtr> blasCache;
+        for (const Entry& entry : mEntries)
+        {
+            const Mesh* pMesh = entry.instance.pMeshInstance->getObject().get();
+            if (blasCache.count(pMesh))
+            {
+                continue;
+            }
+
+            auto it = mBlasCache.find(pMesh);
+            if (it != mBlasCache.end())
+            {
+                blasCache[pMesh] = it->second;
+                continue;
+            }
+
+            PendingMesh pending;
+            pending.pMesh = pMesh;
+            if (MeshBvh::readMeshData(pMesh, pending.positions, pending.indices))
+            {
+                pendingMeshes.push_back(std::move(pending));
+            }
+            blasCache[pMesh] = nullptr;
+        }
+
+        parallelFor(0, pendingMeshes.size(), [&pendingMeshes](size_t i)
+        {
+            PendingMesh& pending = pendingMeshes[i];
+            pending.pBlas = MeshBvh::create(std::move(pending.positions), std::move(pending.indices));
+        });
+
+        for (PendingMesh& pending : pendingMeshes)
+        {
+            blasCache[pending.pMesh] = pending.pBlas;
+        }
+
+        // Meshes which are no longer in the scene are dropped from the cache
+        mBlasCache.swap(blasCache);
+
+        mInstanceBounds.resize(mEntries.size());
+        for (size_t i = 0; i < mEntries.size(); i++)
+        {
+            Entry& entry = mEntries[i];
+            entry.pBlas = mBlasCache[entry.instance.pMeshInstance->getObject().get()];
+            entry.worldMat = entry.instance.pModelInstance->getTransformMatrix() * entry.instance.pMeshInstance->getTransformMatrix();
+            entry.invWorldMat = glm::inverse(entry.worldMat);
+            mInstanceBounds[i] = entry.pBlas ? entry.pBlas->getBoundingBox().transform(entry.worldMat) : entry.instance.pMeshInstance->getBoundingBox().transform(entry.instance.pModelInstance->getTransformMatrix());
+        }
+
+        mTlas.build(mInstanceBounds, 1);
+        mBuildSahCost = mTlas.getSahCost();
+    }
+
+    void SceneBvh::update()
+    {
+        size_t entryIndex = 0;
+        bool structureChanged = false;
+        forEachMeshInstance(mpScene.get(), [&](const Scene::ModelInstance::SharedPtr& pModelInstance, const Model::MeshInstance::SharedPtr& pMeshInstance)
+        {
+            if (entryIndex >= mEntries.size() || mEntries[entryIndex].instance.pModelInstance != pModelInstance || mEntries[entryIndex].instance.pMeshInstance != pMeshInstance)
+            {
+                structureChanged = true;
+            }
+            entryIndex++;
+        });
+
+        if (structureChanged || entryIndex != mEntries.size())
+        {
+            rebuild();
+            return;
+        }
+
+        bool moved = false;
+        for (size_t i = 0; i < mEntries.size(); i++)
+        {
+            Entry& entry = mEntries[i];
+            const glm::mat4 worldMat = entry.instance.pModelInstance->getTransformMatrix() * entry.instance.pMeshInstance->getTransformMatrix();
+            if (worldMat != entry.worldMat)
+            {
+                entry.worldMat = worldMat;
+                entry.invWorldMat = glm::inverse(worldMat);
+                mInstanceBounds[i] = entry.pBlas ? entry.pBlas->getBoundingBox().transform(worldMat) : entry.instance.pMeshInstance->getBoundingBox().transform(entry.instance.pModelInstance->getTransformMatrix());
+                moved = true;
+            }
+        }
+
+        if (moved)
+        {
+            mTlas.refit(mInstanceBounds);
+            if (mTlas.getSahCost() > kRebuildCostRatio * mBuildSahCost)
+            {
+                mTlas.build(mInstanceBounds, 1);
+                mBuildSahCost = mTlas.getSahCost();
+            }
+        }
+    }
+
+    bool SceneBvh::isVisible(uint32_t entryIndex) const
+    {
+        const Instance& instance = mEntries[entryIndex].instance;
+        return instance.pModelInstance->isVisible() && instance.pMeshInstance->isVisible();
+    }
+
+    bool SceneBvh::raycast(const Ray& ray, Hit& hit) const
+    {
+        Ray worldRay = ray;
+        return mTlas.intersect(worldRay, [this, &hit](uint32_t entryIndex, Ray& r)
+        {
+            const Entry& entry = mEntries[entryIndex];
+            if (entry.pBlas == nullptr || isVisible(entryIndex) == false)
+            {
+                return false;
+            }
+
+            // Affine transforms keep the ray parameterization, so hit distances carry over between the spaces
+            Ray objectRay = r;
+            objectRay.origin = glm::vec3(entry.invWorldMat * glm::vec4(r.origin, 1.0f));
+            objectRay.direction = glm::vec3(entry.invWorldMat * glm::vec4(r.direction, 0.0f));
+
+            MeshBvh::Hit meshHit;
+            if (entry.pBlas->intersect(objectRay, meshHit) == false)
+            {
+                return false;
+            }
+
+            r.tMax = meshHit.t;
+            hit.instance = entry.instance;
+            hit.t = meshHit.t;
+            hit.primitiveID = meshHit.primitiveID;
+            hit.barycentrics = meshHit.barycentrics;
+            return true;
+        });
+    }
+
+    void SceneBvh::queryAabb(const BoundingBox& box, std::vector<Instance>& instances) const
+    {
+        mTlas.query([&box](const BoundingBox& nodeBox) { return boxesOverlap(nodeBox, box); },
+            [&](uint32_t entryIndex)
+        {
+            if (isVisible(entryIndex) && boxesOverlap(mInstanceBounds[entryIndex], box))
+            {
+                instances.push_back(mEntries[entryIndex].instance);
+            }
+        });
+    }
+
+    void SceneBvh::queryFrustum(const Camera* pCamera, std::vector<Instance>& instances) const
+    {
+        mTlas.query([pCamera](const BoundingBox& nodeBox) { return pCamera->isObjectCulled(nodeBox) == false; },
+            [&](uint32_t entryIndex)
+        {
+            if (isVisible(entryIndex) && pCamera->isObjectCulled(mInstanceBounds[entryIndex]) == false)
+            {
+                instances.push_back(mEntries[entryIndex].instance);
+            }
+        });
+    }
+}
@@ -0,0 +1,107 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Graphics/Scene/Scene.h"
+#include "Graphics/Model/MeshBvh.h"
+#include <unordered_map>
+
+namespace Falcor
+{
+    /** Two-level CPU BVH over a scene. The bottom level is a MeshBvh per mesh, the top level holds one entry per mesh instance of every model instance.
+        Call update() before querying after the scene changed. Moved instances only refit the top level, adding or removing instances rebuilds it.
+        Queries skip invisible model and mesh instances, like SceneRenderer.
+    */
+    class SceneBvh
+    {
+    public:
+        using SharedPtr = std::shared_ptr<SceneBvh>;
+        using SharedConstPtr = std::shared_ptr<const SceneBvh>;
+
+        struct Instance
+        {
+            Scene::ModelInstance::SharedPtr pModelInstance;
+            Model::MeshInstance::SharedPtr pMeshInstance;
+        };
+
+        struct Hit
+        {
+            Instance instance;
+            float t = 0.0f;                 ///< Hit distance along the ray
+            uint32_t primitiveID = 0;       ///< Triangle index within the mesh
+            glm::vec2 barycentrics;         ///< Barycentric coordinates of the second and third triangle vertex
+        };
+
+        /** Create a hierarchy for a scene. The mesh level hierarchies are built in parallel.
+        */
+        static SharedPtr create(const Scene::SharedPtr& pScene);
+
+        /** Bring the hierarchy up to date with the scene.
+        */
+        void update();
+
+        /** Find the closest hit along a world space ray.
+            \param[in] ray World space ray
+            \param[out] hit Hit information, only written when a hit is found
+            \return Whether anything was hit
+        */
+        bool raycast(const Ray& ray, Hit& hit) const;
+
+        /** Find the instances whose world space bounds overlap a box.
+        */
+        void queryAabb(const BoundingBox& box, std::vector<Instance>& instances) const;
+
+        /** Find the instances whose world space bounds are not culled by a camera frustum.
+        */
+        void queryFrustum(const Camera* pCamera, std::vector<Instance>& instances) const;
+
+        /** Get the world space bounds of the instances visited by queries
+        */
+        const std::vector<BoundingBox>& getInstanceBounds() const { return mInstanceBounds; }
+
+    private:
+        SceneBvh(const Scene::SharedPtr& pScene);
+
+        void rebuild();
+        bool isVisible(uint32_t entryIndex) const;
+
+        struct Entry
+        {
+            Instance instance;
+            MeshBvh::SharedConstPtr pBlas;
+            glm::mat4 worldMat;
+            glm::mat4 invWorldMat;
+        };
+
+        Scene::SharedPtr mpScene;
+        std::vector<Entry> mEntries;
+        std::vector<BoundingBox> mInstanceBounds;
+        std::unordered_map<const Mesh*, MeshBvh::SharedConstPtr> mBlasCache;
+        Bvh mTlas;
+        float mBuildSahCost = 0.0f;
+    };
+}
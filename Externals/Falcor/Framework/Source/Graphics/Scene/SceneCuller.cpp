@@ -0,0 +1,233 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Graphics/Scene/SceneCuller.h"
+#include "Graphics/Camera/Camera.h"
+#include "Utils/ParallelFor.h"
+#include <immintrin.h>
+
+namespace Falcor
+{
+    // Number of 8-entry blocks handed to a worker at a time. Scenes smaller than this are culled on the calling thread.
+    static const size_t kBlocksPerTask = 1024;
+
+    struct CullPlanes
+    {
+        // Plane normal, absolute value of the normal and the negated distance, each broadcast to every lane
+        float normal[6][3];
+        float absNormal[6][3];
+        float negW[6];
+    };
+
+    // Same test as Camera::isObjectCulled(), the box corner furthest along the plane normal has to be on the inner side of every plane
+#ifdef __AVX__
+    static uint32_t cullBlock(const float* pCX, const float* pCY, const float* pCZ, const float* pEX, const float* pEY, const float* pEZ, const CullPlanes& planes)
+    {
+        const __m256 cx = _mm256_loadu_ps(pCX);
+        const __m256 cy = _mm256_loadu_ps(pCY);
+        const __m256 cz = _mm256_loadu_ps(pCZ);
+        const __m256 ex = _mm256_loadu_ps(pEX);
+        const __m256 ey = _mm256_loadu_ps(pEY);
+        const __m256 ez = _mm256_loadu_ps(pEZ);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (uint32_t p = 0; p < 6; p++)
+        {
+            __m256 d = _mm256_mul_ps(cx, _mm256_set1_ps(planes.normal[p][0]));
+            d = _mm256_add_ps(d, _mm256_mul_ps(cy, _mm256_set1_ps(planes.normal[p][1])));
+            d = _mm256_add_ps(d, _mm256_mul_ps(cz, _mm256_set1_ps(planes.normal[p][2])));
+            d = _mm256_add_ps(d, _mm256_mul_ps(ex, _mm256_set1_ps(planes.absNormal[p][0])));
+            d = _mm256_add_ps(d, _mm256_mul_ps(ey, _mm256_set1_ps(planes.absNormal[p][1])));
+            d = _mm256_add_ps(d, _mm256_mul_ps(ez, _mm256_set1_ps(planes.absNormal[p][2])));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, _mm256_set1_ps(planes.negW[p]), _CMP_GT_OQ));
+        }
+        return (uint32_t)_mm256_movemask_ps(inside);
+    }
+#else
+    static uint32_t cullHalfBlock(const float* pCX, const float* pCY, const float* pCZ, const float* pEX, const float* pEY, const float* pEZ, const CullPlanes& planes)
+    {
+        const __m128 cx = _mm_loadu_ps(pCX);
+        const __m128 cy = _mm_loadu_ps(pCY);
+        const __m128 cz = _mm_loadu_ps(pCZ);
+        const __m128 ex = _mm_loadu_ps(pEX);
+        const __m128 ey = _mm_loadu_ps(pEY);
+        const __m128 ez = _mm_loadu_ps(pEZ);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (uint32_t p = 0; p < 6; p++)
+        {
+            __m128 d = _mm_mul_ps(cx, _mm_set1_ps(planes.normal[p][0]));
+            d = _mm_add_ps(d, _mm_mul_ps(cy, _mm_set1_ps(planes.normal[p][1])));
+            d = _mm_add_ps(d, _mm_mul_ps(cz, _mm_set1_ps(planes.normal[p][2])));
+            d = _mm_add_ps(d, _mm_mul_ps(ex, _mm_set1_ps(planes.absNormal[p][0])));
+            d = _mm_add_ps(d, _mm_mul_ps(ey, _mm_set1_ps(planes.absNormal[p][1])));
+            d = _mm_add_ps(d, _mm_mul_ps(ez, _mm_set1_ps(planes.absNormal[p][2])));
+            inside = _mm_and_ps(inside, _mm_cmpgt_ps(d, _mm_set1_ps(planes.negW[p])));
+        }
+        return (uint32_t)_mm_movemask_ps(inside);
+    }
+
+    static uint32_t cullBlock(const float* pCX, const float* pCY, const float* pCZ, const float* pEX, const float* pEY, const float* pEZ, const CullPlanes& planes)
+    {
+        const uint32_t lo = cullHalfBlock(pCX, pCY, pCZ, pEX, pEY, pEZ, planes);
+        const uint32_t hi = cullHalfBlock(pCX + 4, pCY + 4, pCZ + 4, pEX + 4, pEY + 4, pEZ + 4, planes);
+        return lo | (hi << 4);
+    }
+#endif
+
+    SceneCuller::SharedPtr SceneCuller::create(const Scene::SharedPtr& pScene)
+    {
+        return SharedPtr(new SceneCuller(pScene));
+    }
+
+    void SceneCuller::updateLayout()
+    {
+        const Scene* pScene = mpScene.get();
+        mModelInstanceOffsets.resize(pScene->getModelCount());
+        mEnabledMasks.clear();
+
+        uint32_t entryIndex = 0;
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            mModelInstanceOffsets[modelID].resize(pScene->getModelInstanceCount(modelID));
+            for (uint32_t instanceID = 0; instanceID < pScene->getModelInstanceCount(modelID); instanceID++)
+            {
+                mModelInstanceOffsets[modelID][instanceID] = entryIndex;
+
+                // Reading the versions here also brings the lazily computed transforms up to date, so the parallel pass below only reads them
+                const Scene::ModelInstance* pModelInstance = pScene->getModelInstance(modelID, instanceID).get();
+                const Model* pModel = pModelInstance->getObject().get();
+                const uint64_t modelInstanceVersion = pModelInstance->getTransformVersion();
+                for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+                {
+                    for (uint32_t meshInstanceID = 0; meshInstanceID < pModel->getMeshInstanceCount(meshID); meshInstanceID++)
+                    {
+                        const Model::MeshInstance* pMeshInstance = pModel->getMeshInstance(meshID, meshInstanceID).get();
+                        if (entryIndex == mEntries.size())
+                        {
+                            mEntries.push_back(Entry());
+                            mVersions.push_back(Versions());
+                            mCurrentVersions.push_back(Versions());
+                        }
+
+                        // A different instance in this slot invalidates the cached bounds. Versions are unique across instances, so this also holds
+                        // when a new instance was allocated at the address of a deleted one
+                        Entry& entry = mEntries[entryIndex];
+                        if (entry.pModelInstance != pModelInstance || entry.pMeshInstance != pMeshInstance)
+                        {
+                            entry.pModelInstance = pModelInstance;
+                            entry.pMeshInstance = pMeshInstance;
+                            mVersions[entryIndex] = Versions();
+                        }
+
+                        mCurrentVersions[entryIndex].modelInstance = modelInstanceVersion;
+                        mCurrentVersions[entryIndex].meshInstance = pMeshInstance->getTransformVersion();
+
+                        if (entryIndex % 8 == 0)
+                        {
+                            mEnabledMasks.push_back(0);
+                        }
+                        if (pModelInstance->isVisible() && pMeshInstance->isVisible())
+                        {
+                            mEnabledMasks[entryIndex / 8] |= 1 << (entryIndex % 8);
+                        }
+                        entryIndex++;
+                    }
+                }
+            }
+        }
+
+        mEntries.resize(entryIndex);
+        mVersions.resize(entryIndex);
+        mCurrentVersions.resize(entryIndex);
+
+        // Padding entries are disabled by the mask, their bounds only need to be readable
+        const size_t paddedCount = mEnabledMasks.size() * 8;
+        for (std::vector<float>* pArray : { &mCenterX, &mCenterY, &mCenterZ, &mExtentX, &mExtentY, &mExtentZ })
+        {
+            pArray->resize(paddedCount, 0.0f);
+        }
+        mVisibleMasks.resize(mEnabledMasks.size());
+    }
+
+    void SceneCuller::updateBounds()
+    {
+        parallelFor(0, mEntries.size(), [this](size_t i)
+        {
+            const Versions& current = mCurrentVersions[i];
+            if (current.modelInstance != mVersions[i].modelInstance || current.meshInstance != mVersions[i].meshInstance)
+            {
+                const Entry& entry = mEntries[i];
+                const BoundingBox box = entry.pMeshInstance->getBoundingBox().transform(entry.pModelInstance->getTransformMatrix());
+                mCenterX[i] = box.center.x;
+                mCenterY[i] = box.center.y;
+                mCenterZ[i] = box.center.z;
+                mExtentX[i] = box.extent.x;
+                mExtentY[i] = box.extent.y;
+                mExtentZ[i] = box.extent.z;
+                mVersions[i] = current;
+            }
+        }, kBlocksPerTask * 8);
+    }
+
+    void SceneCuller::cull(const Camera* pCamera)
+    {
+        updateLayout();
+        updateBounds();
+
+        CullPlanes planes;
+        for (uint32_t p = 0; p < 6; p++)
+        {
+            const glm::vec4 plane = pCamera->getFrustumPlane(p);
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                planes.normal[p][c] = plane[c];
+                planes.absNormal[p][c] = std::abs(plane[c]);
+            }
+            planes.negW[p] = -plane.w;
+        }
+
+        parallelFor(0, mVisibleMasks.size(), [this, &planes](size_t block)
+        {
+            const size_t i = block * 8;
+            const uint32_t inside = cullBlock(&mCenterX[i], &mCenterY[i], &mCenterZ[i], &mExtentX[i], &mExtentY[i], &mExtentZ[i], planes);
+            mVisibleMasks[block] = (uint8_t)(inside & mEnabledMasks[block]);
+        }, kBlocksPerTask);
+
+        mVisibleEntries.clear();
+        for (size_t block = 0; block < mVisibleMasks.size(); block++)
+        {
+            for (uint32_t mask = mVisibleMasks[block]; mask != 0; mask &= mask - 1)
+            {
+                unsigned long bit;
+                _BitScanForward(&bit, mask);
+                mVisibleEntries.push_back((uint32_t)(block * 8 + bit));
+            }
+        }
+    }
+}
@@ -0,0 +1,106 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Graphics/Scene/Scene.h"
+#include <vector>
+
+namespace Falcor
+{
+    class Camera;
+
+    /** Frustum culling stage for mesh instances, run once per frame before draw submission.
+        World space bounds of every mesh instance of every model instance are cached in structure-of-arrays form and only recomputed when the
+        model or mesh instance transform changed. The plane tests run 8 boxes at a time and are spread across threads for large scenes.
+        Entries are ordered like SceneRenderer traverses the scene: models, model instances, meshes, mesh instances.
+    */
+    class SceneCuller
+    {
+    public:
+        using SharedPtr = std::shared_ptr<SceneCuller>;
+        using SharedConstPtr = std::shared_ptr<const SceneCuller>;
+
+        struct Entry
+        {
+            const Scene::ModelInstance* pModelInstance = nullptr;
+            const Model::MeshInstance* pMeshInstance = nullptr;
+        };
+
+        /** Create a culler for a scene
+        */
+        static SharedPtr create(const Scene::SharedPtr& pScene);
+
+        /** Bring the cached bounds up to date with the scene and test them against a camera frustum.
+            Invisible model and mesh instances are reported as culled.
+        */
+        void cull(const Camera* pCamera);
+
+        /** Get the index of the first entry of a model instance. Valid until the next call to cull().
+        */
+        uint32_t getFirstEntry(uint32_t modelID, uint32_t instanceID) const { return mModelInstanceOffsets[modelID][instanceID]; }
+
+        /** Check if an entry passed the last cull
+        */
+        bool isEntryVisible(uint32_t entryIndex) const { return ((mVisibleMasks[entryIndex >> 3] >> (entryIndex & 7)) & 1) != 0; }
+
+        /** Get the indices of the entries which passed the last cull, in ascending order
+        */
+        const std::vector<uint32_t>& getVisibleEntries() const { return mVisibleEntries; }
+
+        uint32_t getEntryCount() const { return (uint32_t)mEntries.size(); }
+        const Entry& getEntry(uint32_t entryIndex) const { return mEntries[entryIndex]; }
+
+    private:
+        SceneCuller(const Scene::SharedPtr& pScene) : mpScene(pScene) {}
+
+        void updateLayout();
+        void updateBounds();
+
+        Scene::SharedPtr mpScene;
+
+        std::vector<Entry> mEntries;
+        std::vector<std::vector<uint32_t>> mModelInstanceOffsets;
+
+        // Transform versions the cached bounds were computed from, and the versions read from the scene this frame
+        struct Versions
+        {
+            uint64_t modelInstance = 0;
+            uint64_t meshInstance = 0;
+        };
+        std::vector<Versions> mVersions;
+        std::vector<Versions> mCurrentVersions;
+
+        // World space bounds, padded to a multiple of 8 entries
+        std::vector<float> mCenterX, mCenterY, mCenterZ;
+        std::vector<float> mExtentX, mExtentY, mExtentZ;
+
+        // One bit per entry, 8 entries per byte
+        std::vector<uint8_t> mEnabledMasks;
+        std::vector<uint8_t> mVisibleMasks;
+        std::vector<uint32_t> mVisibleEntries;
+    };
+}
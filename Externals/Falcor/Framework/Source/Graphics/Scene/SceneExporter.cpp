@@ -49,6 +49,12 @@ namespace Falcor
         return exporter.save(exportOptions);
     }
 
+    std::string SceneExporter::saveSceneToString(const Scene::SharedPtr& pScene, uint32_t exportOptions)
+    {
+        SceneExporter exporter("", pScene);
+        return exporter.serialize(exportOptions);
+    }
+
     template<typename T>
     void addLiteral(rapidjson::Value& jval, rapidjson::Document::AllocatorType& jallocator, const std::string& key, const T& value)
     {
@@ -96,7 +102,7 @@ namespace Falcor
         jval.AddMember(jkey, jvec, jallocator);
     }
 
-    bool SceneExporter::save(uint32_t exportOptions)
+    std::string SceneExporter::serialize(uint32_t exportOptions)
     {
         mExportOptions = exportOptions;
 
@@ -123,7 +129,12 @@ namespace Falcor
         rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
         writer.SetIndent(' ', 4);
         mJDoc.Accept(writer);
-        std::string str(buffer.GetString(), buffer.GetSize());
+        return std::string(buffer.GetString(), buffer.GetSize());
+    }
+
+    bool SceneExporter::save(uint32_t exportOptions)
+    {
+        std::string str = serialize(exportOptions);
 
         // Output the file
         std::ofstream outputStream(mFilename.c_str());
@@ -56,6 +56,10 @@ namespace Falcor
 
         static bool saveScene(const std::string& filename, const Scene::SharedPtr& pScene, uint32_t exportOptions = ExportAll);
 
+        /** Serialize a scene into a JSON string instead of a file. Used to embed the scene description into other files, like scene packages.
+        */
+        static std::string saveSceneToString(const Scene::SharedPtr& pScene, uint32_t exportOptions = ExportAll);
+
         static const uint32_t kVersion = 2;
 
     private:
@@ -64,6 +68,7 @@ namespace Falcor
             : mpScene(pScene), mFilename(filename) {}
 
         bool save(uint32_t exportOptions);
+        std::string serialize(uint32_t exportOptions);
 
         void writeModels();
         void writeLights();
@@ -176,7 +176,7 @@ namespace Falcor
         return true;
     }
 
-    bool SceneImporter::createModel(const rapidjson::Value& jsonModel)
+    bool SceneImporter::getModelFile(const rapidjson::Value& jsonModel, std::string& file)
     {
         // Model must have at least a filename
         if(jsonModel.HasMember(SceneKeys::kFilename) == false)
@@ -189,19 +189,22 @@ namespace Falcor
             return error("Model filename must be a string");
         }
 
-        // Load the model
-        std::string file =  mDirectory + '/' + modelFile.GetString();
+        file =  mDirectory + '/' + modelFile.GetString();
         if (doesFileExist(file) == false)
         {
             file = modelFile.GetString();
         }
-        auto pModel = Model::createFromFile(file.c_str(), mModelLoadFlags);
+        return true;
+    }
+
+    bool SceneImporter::createModel(const rapidjson::Value& jsonModel, const std::string& file, const Model::SharedPtr& pModel)
+    {
         if(pModel == nullptr)
         {
             return error("Could not load model: " + file);
         }
 
-        pModel->setRelativeFilename(modelFile.GetString());
+        pModel->setRelativeFilename(jsonModel[SceneKeys::kFilename].GetString());
         pModel->setAbsoluteFilename(file);
 
         bool instanceAdded = false;
@@ -325,10 +328,22 @@ namespace Falcor
             return error("models section should be an array of objects.");
         }
 
-        // Loop over the array
+        // Resolve all the files first, so the models can be loaded in parallel
+        std::vector<std::string> files(jsonVal.Size());
+        for(uint32_t i = 0; i < jsonVal.Size(); i++)
+        {
+            if(getModelFile(jsonVal[i], files[i]) == false)
+            {
+                return false;
+            }
+        }
+
+        std::vector<Model::SharedPtr> models = Model::createFromFiles(files, mModelLoadFlags);
+
+        // Set up names, instances and material overrides in the order the models appear in the file
         for(uint32_t i = 0; i < jsonVal.Size(); i++)
         {
-            if(createModel(jsonVal[i]) == false)
+            if(createModel(jsonVal[i], files[i], models[i]) == false)
             {
                 return false;
             }
@@ -1180,43 +1195,70 @@ namespace Falcor
             std::stringstream strStream;
             strStream << fileStream.rdbuf();
             std::string jsonData = strStream.str();
-            rapidjson::StringStream JStream(jsonData.c_str());
 
             // Get the file directory
             auto last = fullpath.find_last_of("/\\");
             mDirectory = fullpath.substr(0, last);
 
-            // create the DOM
-            mJDoc.ParseStream(JStream);
+            return parse(jsonData);
+        }
+        else
+        {
+            return error("File not found.");
+        }
+    }
 
-            if(mJDoc.HasParseError())
-            {
-                size_t line;
-                line = std::count(jsonData.begin(), jsonData.begin() + mJDoc.GetErrorOffset(), '\n');
-                return error(std::string("JSON Parse error in line ") + std::to_string(line) + ". " + rapidjson::GetParseError_En(mJDoc.GetParseError()));
-            }
+    bool SceneImporter::loadSceneFromString(Scene& scene, const std::string& jsonData, const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags)
+    {
+        SceneImporter importer(scene);
+        importer.mFilename = filename;
+        importer.mDirectory = getDirectoryFromFile(filename);
+        importer.mModelLoadFlags = modelLoadFlags;
+        importer.mSceneLoadFlags = sceneLoadFlags;
 
-            if(topLevelLoop() == false)
+        // The scene may already contain models, let paths attach to their instances
+        for (uint32_t modelID = 0; modelID < scene.getModelCount(); modelID++)
+        {
+            for (uint32_t instanceID = 0; instanceID < scene.getModelInstanceCount(modelID); instanceID++)
             {
-                return false;
+                const auto& pInstance = scene.getModelInstance(modelID, instanceID);
+                importer.mInstanceMap[pInstance->getName()] = pInstance;
             }
+        }
 
-            if(is_set(mSceneLoadFlags, Scene::LoadFlags::GenerateAreaLights))
-            {
-                mScene.createAreaLights();
-            }
+        return importer.parse(jsonData);
+    }
 
-            if (is_set(mSceneLoadFlags, Scene::LoadFlags::StoreMaterialHistory) == false)
-            {
-                mScene.deleteMaterialHistory();
-            }
+    bool SceneImporter::parse(const std::string& jsonData)
+    {
+        rapidjson::StringStream JStream(jsonData.c_str());
 
-            return true;
+        // create the DOM
+        mJDoc.ParseStream(JStream);
+
+        if(mJDoc.HasParseError())
+        {
+            size_t line;
+            line = std::count(jsonData.begin(), jsonData.begin() + mJDoc.GetErrorOffset(), '\n');
+            return error(std::string("JSON Parse error in line ") + std::to_string(line) + ". " + rapidjson::GetParseError_En(mJDoc.GetParseError()));
         }
-        else
+
+        if(topLevelLoop() == false)
         {
-            return error("File not found.");
+            return false;
+        }
+
+        if(is_set(mSceneLoadFlags, Scene::LoadFlags::GenerateAreaLights))
+        {
+            mScene.createAreaLights();
         }
+
+        if (is_set(mSceneLoadFlags, Scene::LoadFlags::StoreMaterialHistory) == false)
+        {
+            mScene.deleteMaterialHistory();
+        }
+
+        return true;
     }
 
     bool SceneImporter::parseAmbientIntensity(const rapidjson::Value& jsonVal)
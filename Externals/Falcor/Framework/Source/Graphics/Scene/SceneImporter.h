@@ -41,10 +41,20 @@ namespace Falcor
     public:
         static bool loadScene(Scene& scene, const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags);
 
+        /** Load a scene description from a string, e.g. one embedded in another file. Objects already in the scene are kept, and paths can attach to their model instances.
+            \param[in] scene Scene to load into
+            \param[in] jsonData The scene description, in the same format as a scene file
+            \param[in] filename File the description was read from. Used in error messages, and relative paths are resolved against its directory
+            \param[in] modelLoadFlags Flags for models referenced by the description
+            \param[in] sceneLoadFlags Scene load flags
+        */
+        static bool loadSceneFromString(Scene& scene, const std::string& jsonData, const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags);
+
     private:
 
         SceneImporter(Scene& scene) : mScene(scene) {}
         bool load(const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags);
+        bool parse(const std::string& jsonData);
 
         bool parseVersion(const rapidjson::Value& jsonVal);
         bool parseModels(const rapidjson::Value& jsonVal);
@@ -64,7 +74,8 @@ namespace Falcor
 
         bool loadIncludeFile(const std::string& Include);
 
-        bool createModel(const rapidjson::Value& jsonModel);
+        bool getModelFile(const rapidjson::Value& jsonModel, std::string& file);
+        bool createModel(const rapidjson::Value& jsonModel, const std::string& file, const Model::SharedPtr& pModel);
         bool setMaterialOverrides(const rapidjson::Value& jsonVal, const Model::SharedPtr& pModel);
         bool createModelInstances(const rapidjson::Value& jsonVal, const Model::SharedPtr& pModel);
         bool createPointLight(const rapidjson::Value& jsonLight);
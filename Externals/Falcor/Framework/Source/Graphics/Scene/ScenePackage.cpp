@@ -0,0 +1,955 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ScenePackage.h"
+#include <algorithm>
+#include <fstream>
+#include <unordered_map>
+#include "API/Device.h"
+#include "Utils/Platform/OS.h"
+#include "SceneExporter.h"
+#include "SceneImporter.h"
+
+namespace Falcor
+{
+    const char* ScenePackage::kFileExtension = ".fscenepkg";
+    const char* ScenePackage::kFileFormatString = "Scene packages\0*.fscenepkg\0\0";
+
+    // Must be defined even though it's a const uint because value is passed as reference to functions
+    const uint32_t ScenePackage::kVersion;
+
+    namespace
+    {
+        const uint32_t kPackageMagic = 0x4B505346; // 'FSPK'
+        const uint32_t kNoIndex = uint32_t(-1);
+        const uint64_t kBlobAlignment = 64;
+        const uint64_t kStringAlignment = 4;
+        const uint64_t kSectionAlignment = 16;
+
+        /** The package starts with a header, followed by the data section which holds all the raw blobs (texels, vertices, indices and strings).
+            The record sections come last. Records are flat structs which reference blobs by their range in the data section and other records by their index.
+        */
+        enum class Section : uint32_t
+        {
+            Data,
+            Textures,
+            Materials,
+            VertexElements,
+            VertexBuffers,
+            Meshes,
+            MeshInstances,
+            Models,
+            ModelInstances,
+            SceneMaterials,
+            Count
+        };
+
+        struct DataRef
+        {
+            uint64_t offset;
+            uint64_t size;
+        };
+
+        struct PackageHeader
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t fileSize;
+            DataRef sceneDesc;                                  ///< Lights, cameras, paths and settings in scene file format. Relative to the data section
+            DataRef sections[(uint32_t)Section::Count];         ///< Absolute file ranges
+        };
+
+        struct TextureRecord
+        {
+            DataRef name;
+            DataRef relativeFilename;
+            DataRef absoluteFilename;
+            DataRef texels;                 ///< All mip levels, back to back
+            ResourceFormat format;
+            uint32_t width;
+            uint32_t height;
+            uint32_t mipLevels;
+        };
+
+        struct MaterialLayerRecord
+        {
+            glm::vec4 albedo;
+            glm::vec4 roughness;
+            glm::vec4 extraParam;
+            uint32_t type;
+            uint32_t ndf;
+            uint32_t blend;
+            uint32_t texture;
+            float pmf;
+        };
+
+        struct MaterialRecord
+        {
+            DataRef name;
+            MaterialLayerRecord layers[MatMaxLayers];
+            uint32_t layerCount;
+            uint32_t normalMap;
+            uint32_t alphaMap;
+            uint32_t ambientOcclusionMap;
+            uint32_t heightMap;
+            float alphaThreshold;
+            glm::vec2 heightModifiers;
+            uint32_t doubleSided;
+        };
+
+        struct VertexElementRecord
+        {
+            DataRef name;
+            uint32_t offset;
+            ResourceFormat format;
+            uint32_t arraySize;
+            uint32_t shaderLocation;
+        };
+
+        struct VertexBufferRecord
+        {
+            DataRef data;
+            uint32_t bindFlags;
+            uint32_t inputClass;
+            uint32_t instanceStepRate;
+            uint32_t firstElement;
+            uint32_t elementCount;
+        };
+
+        struct MeshRecord
+        {
+            DataRef indexData;
+            BoundingBox boundingBox;
+            uint32_t vertexCount;
+            uint32_t indexCount;
+            uint32_t indexBindFlags;
+            uint32_t topology;
+            uint32_t material;
+            uint32_t firstVertexBuffer;
+            uint32_t vertexBufferCount;
+            uint32_t hasBones;
+        };
+
+        struct MeshInstanceRecord
+        {
+            glm::mat4 transform;
+            uint32_t mesh;
+        };
+
+        struct ModelRecord
+        {
+            DataRef name;
+            DataRef relativeFilename;
+            DataRef absoluteFilename;
+            uint32_t firstMeshInstance;
+            uint32_t meshInstanceCount;
+        };
+
+        struct ModelInstanceRecord
+        {
+            DataRef name;
+            glm::vec3 translation;
+            glm::vec3 target;
+            glm::vec3 up;
+            glm::vec3 scaling;
+            uint32_t model;
+            uint32_t visible;
+        };
+
+        class PackageWriter
+        {
+        public:
+            bool open(const std::string& filename)
+            {
+                mStream.open(filename, std::ios::binary | std::ios::trunc);
+                if (mStream.fail())
+                {
+                    return false;
+                }
+
+                // Reserve space for the header. It's written once all the section ranges are known.
+                PackageHeader header = {};
+                mStream.write((const char*)&header, sizeof(header));
+                mDataStart = align(kBlobAlignment);
+                return mStream.good();
+            }
+
+            DataRef writeBlob(const void* pData, size_t size, uint64_t alignment = kBlobAlignment)
+            {
+                DataRef ref;
+                ref.offset = align(alignment) - mDataStart;
+                ref.size = size;
+                mStream.write((const char*)pData, size);
+                return ref;
+            }
+
+            DataRef writeString(const std::string& str)
+            {
+                return writeBlob(str.data(), str.size(), kStringAlignment);
+            }
+
+            template<typename RecordType>
+            uint32_t addRecord(Section section, const RecordType& record)
+            {
+                std::vector<uint8_t>& bytes = mSections[(uint32_t)section];
+                uint32_t index = getRecordCount<RecordType>(section);
+                const uint8_t* pBytes = (const uint8_t*)&record;
+                bytes.insert(bytes.end(), pBytes, pBytes + sizeof(RecordType));
+                return index;
+            }
+
+            template<typename RecordType>
+            uint32_t getRecordCount(Section section) const
+            {
+                return uint32_t(mSections[(uint32_t)section].size() / sizeof(RecordType));
+            }
+
+            bool finish(const DataRef& sceneDesc)
+            {
+                PackageHeader header = {};
+                header.magic = kPackageMagic;
+                header.version = ScenePackage::kVersion;
+                header.sceneDesc = sceneDesc;
+                header.sections[(uint32_t)Section::Data].offset = mDataStart;
+                header.sections[(uint32_t)Section::Data].size = (uint64_t)mStream.tellp() - mDataStart;
+
+                for (uint32_t i = (uint32_t)Section::Data + 1; i < (uint32_t)Section::Count; i++)
+                {
+                    header.sections[i].offset = align(kSectionAlignment);
+                    header.sections[i].size = mSections[i].size();
+                    mStream.write((const char*)mSections[i].data(), mSections[i].size());
+                }
+
+                header.fileSize = (uint64_t)mStream.tellp();
+                mStream.seekp(0);
+                mStream.write((const char*)&header, sizeof(header));
+                mStream.close();
+                return mStream.good();
+            }
+
+        private:
+            uint64_t align(uint64_t alignment)
+            {
+                static const char kPadding[kBlobAlignment] = {};
+                uint64_t pos = (uint64_t)mStream.tellp();
+                uint64_t padding = (alignment - pos % alignment) % alignment;
+                mStream.write(kPadding, padding);
+                return pos + padding;
+            }
+
+            std::ofstream mStream;
+            uint64_t mDataStart = 0;
+            std::vector<uint8_t> mSections[(uint32_t)Section::Count];
+        };
+
+        /** Converts scene objects into package records. Objects shared by several owners are only stored once.
+        */
+        class SceneBaker
+        {
+        public:
+            SceneBaker(PackageWriter& writer) : mWriter(writer) {}
+
+            uint32_t addTexture(const Texture::SharedPtr& pTexture)
+            {
+                if (pTexture == nullptr)
+                {
+                    return kNoIndex;
+                }
+
+                auto it = mTextures.find(pTexture.get());
+                if (it != mTextures.end())
+                {
+                    return it->second;
+                }
+
+                uint32_t index = kNoIndex;
+                if (pTexture->getType() != Resource::Type::Texture2D || pTexture->getArraySize() != 1)
+                {
+                    logWarning("ScenePackage: texture '" + pTexture->getName() + "' is not a 2D texture and is not stored in the package");
+                }
+                else
+                {
+                    // Store the mips back to back, which is the layout Texture::create2D() expects for its init data
+                    RenderContext* pContext = gpDevice->getRenderContext().get();
+                    std::vector<uint8> texels;
+                    for (uint32_t mip = 0; mip < pTexture->getMipCount(); mip++)
+                    {
+                        std::vector<uint8> mipData = pContext->readTextureSubresource(pTexture.get(), pTexture->getSubresourceIndex(0, mip));
+                        texels.insert(texels.end(), mipData.begin(), mipData.end());
+                    }
+
+                    TextureRecord record = {};
+                    record.texels = mWriter.writeBlob(texels.data(), texels.size());
+                    record.name = mWriter.writeString(pTexture->getName());
+                    record.relativeFilename = mWriter.writeString(pTexture->getRelativeSourceFilename());
+                    record.absoluteFilename = mWriter.writeString(pTexture->getAbsoluteSourceFilename());
+                    record.format = pTexture->getFormat();
+                    record.width = pTexture->getWidth();
+                    record.height = pTexture->getHeight();
+                    record.mipLevels = pTexture->getMipCount();
+                    index = mWriter.addRecord(Section::Textures, record);
+                }
+
+                mTextures[pTexture.get()] = index;
+                return index;
+            }
+
+            uint32_t addMaterial(const Material::SharedPtr& pMaterial)
+            {
+                if (pMaterial == nullptr)
+                {
+                    return kNoIndex;
+                }
+
+                auto it = mMaterials.find(pMaterial.get());
+                if (it != mMaterials.end())
+                {
+                    return it->second;
+                }
+
+                MaterialRecord record = {};
+                record.name = mWriter.writeString(pMaterial->getName());
+                record.layerCount = pMaterial->getNumLayers();
+                for (uint32_t i = 0; i < record.layerCount; i++)
+                {
+                    Material::Layer layer = pMaterial->getLayer(i);
+                    MaterialLayerRecord& layerRecord = record.layers[i];
+                    layerRecord.albedo = layer.albedo;
+                    layerRecord.roughness = layer.roughness;
+                    layerRecord.extraParam = layer.extraParam;
+                    layerRecord.type = (uint32_t)layer.type;
+                    layerRecord.ndf = (uint32_t)layer.ndf;
+                    layerRecord.blend = (uint32_t)layer.blend;
+                    layerRecord.texture = addTexture(layer.pTexture);
+                    layerRecord.pmf = layer.pmf;
+                }
+
+                record.normalMap = addTexture(pMaterial->getNormalMap());
+                record.alphaMap = addTexture(pMaterial->getAlphaMap());
+                record.ambientOcclusionMap = addTexture(pMaterial->getAmbientOcclusionMap());
+                record.heightMap = addTexture(pMaterial->getHeightMap());
+                record.alphaThreshold = pMaterial->getAlphaThreshold();
+                record.heightModifiers = pMaterial->getHeightModifiers();
+                record.doubleSided = pMaterial->isDoubleSided() ? 1 : 0;
+
+                uint32_t index = mWriter.addRecord(Section::Materials, record);
+                mMaterials[pMaterial.get()] = index;
+                return index;
+            }
+
+            uint32_t addMesh(const Mesh::SharedPtr& pMesh)
+            {
+                auto it = mMeshes.find(pMesh.get());
+                if (it != mMeshes.end())
+                {
+                    return it->second;
+                }
+
+                const Vao::SharedPtr& pVao = pMesh->getVao();
+                const VertexLayout::SharedPtr& pLayout = pVao->getVertexLayout();
+
+                MeshRecord record = {};
+                record.boundingBox = pMesh->getBoundingBox();
+                record.vertexCount = pMesh->getVertexCount();
+                record.indexCount = pMesh->getIndexCount();
+                record.topology = (uint32_t)pVao->getPrimitiveTopology();
+                record.material = addMaterial(pMesh->getMaterial());
+                record.hasBones = pMesh->hasBones() ? 1 : 0;
+
+                const Buffer::SharedPtr& pIndexBuffer = pVao->getIndexBuffer();
+                if (pIndexBuffer)
+                {
+                    record.indexData = addBuffer(pIndexBuffer);
+                    record.indexBindFlags = (uint32_t)pIndexBuffer->getBindFlags();
+                }
+
+                record.firstVertexBuffer = mWriter.getRecordCount<VertexBufferRecord>(Section::VertexBuffers);
+                record.vertexBufferCount = pVao->getVertexBuffersCount();
+                for (uint32_t i = 0; i < record.vertexBufferCount; i++)
+                {
+                    const Buffer::SharedPtr& pBuffer = pVao->getVertexBuffer(i);
+                    const VertexBufferLayout::SharedConstPtr& pBufferLayout = pLayout->getBufferLayout(i);
+
+                    VertexBufferRecord vbRecord = {};
+                    vbRecord.data = addBuffer(pBuffer);
+                    vbRecord.bindFlags = (uint32_t)pBuffer->getBindFlags();
+                    vbRecord.inputClass = (uint32_t)pBufferLayout->getInputClass();
+                    vbRecord.instanceStepRate = pBufferLayout->getInstanceStepRate();
+                    vbRecord.firstElement = mWriter.getRecordCount<VertexElementRecord>(Section::VertexElements);
+                    vbRecord.elementCount = pBufferLayout->getElementCount();
+
+                    for (uint32_t e = 0; e < vbRecord.elementCount; e++)
+                    {
+                        VertexElementRecord elemRecord = {};
+                        elemRecord.name = mWriter.writeString(pBufferLayout->getElementName(e));
+                        elemRecord.offset = pBufferLayout->getElementOffset(e);
+                        elemRecord.format = pBufferLayout->getElementFormat(e);
+                        elemRecord.arraySize = pBufferLayout->getElementArraySize(e);
+                        elemRecord.shaderLocation = pBufferLayout->getElementShaderLocation(e);
+                        mWriter.addRecord(Section::VertexElements, elemRecord);
+                    }
+                    mWriter.addRecord(Section::VertexBuffers, vbRecord);
+                }
+
+                uint32_t index = mWriter.addRecord(Section::Meshes, record);
+                mMeshes[pMesh.get()] = index;
+                return index;
+            }
+
+            uint32_t addModel(const Model::SharedPtr& pModel)
+            {
+                auto it = mModels.find(pModel.get());
+                if (it != mModels.end())
+                {
+                    return it->second;
+                }
+
+                // Meshes go first so that the model's mesh instances are contiguous
+                std::vector<MeshInstanceRecord> instances;
+                for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+                {
+                    for (uint32_t i = 0; i < pModel->getMeshInstanceCount(meshID); i++)
+                    {
+                        const Model::MeshInstance::SharedPtr& pInstance = pModel->getMeshInstance(meshID, i);
+                        MeshInstanceRecord instanceRecord = {};
+                        instanceRecord.transform = pInstance->getTransformMatrix();
+                        instanceRecord.mesh = addMesh(pInstance->getObject());
+                        instances.push_back(instanceRecord);
+                    }
+                }
+
+                ModelRecord record = {};
+                record.name = mWriter.writeString(pModel->getName());
+                record.relativeFilename = mWriter.writeString(pModel->getRelativeFilename());
+                record.absoluteFilename = mWriter.writeString(pModel->getAbsoluteFilename());
+                record.firstMeshInstance = mWriter.getRecordCount<MeshInstanceRecord>(Section::MeshInstances);
+                record.meshInstanceCount = (uint32_t)instances.size();
+                for (const auto& instance : instances)
+                {
+                    mWriter.addRecord(Section::MeshInstances, instance);
+                }
+
+                uint32_t index = mWriter.addRecord(Section::Models, record);
+                mModels[pModel.get()] = index;
+                return index;
+            }
+
+        private:
+            DataRef addBuffer(const Buffer::SharedPtr& pBuffer)
+            {
+                auto it = mBuffers.find(pBuffer.get());
+                if (it != mBuffers.end())
+                {
+                    return it->second;
+                }
+
+                const void* pData = pBuffer->map(Buffer::MapType::Read);
+                DataRef ref = mWriter.writeBlob(pData, pBuffer->getSize());
+                pBuffer->unmap();
+
+                mBuffers[pBuffer.get()] = ref;
+                return ref;
+            }
+
+            PackageWriter& mWriter;
+            std::unordered_map<const Texture*, uint32_t> mTextures;
+            std::unordered_map<const Material*, uint32_t> mMaterials;
+            std::unordered_map<const Mesh*, uint32_t> mMeshes;
+            std::unordered_map<const Model*, uint32_t> mModels;
+            std::unordered_map<const Buffer*, DataRef> mBuffers;
+        };
+
+        /** Gives typed access to a package mapped into memory
+        */
+        class PackageReader
+        {
+        public:
+            PackageReader(const uint8_t* pFile, size_t fileSize) : mpFile(pFile), mFileSize(fileSize) {}
+
+            bool validate(const std::string& filename)
+            {
+                if (mFileSize < sizeof(PackageHeader) || getHeader().magic != kPackageMagic)
+                {
+                    logError("ScenePackage: '" + filename + "' is not a scene package");
+                    return false;
+                }
+
+                const PackageHeader& header = getHeader();
+                if (header.version != ScenePackage::kVersion)
+                {
+                    logError("ScenePackage: '" + filename + "' has version " + std::to_string(header.version) + ", expected version " + std::to_string(ScenePackage::kVersion) + ". Bake the package again.");
+                    return false;
+                }
+
+                if (header.fileSize != mFileSize)
+                {
+                    logError("ScenePackage: '" + filename + "' is truncated");
+                    return false;
+                }
+
+                for (uint32_t i = 0; i < (uint32_t)Section::Count; i++)
+                {
+                    if (header.sections[i].offset > mFileSize || header.sections[i].size > mFileSize - header.sections[i].offset)
+                    {
+                        logError("ScenePackage: '" + filename + "' is corrupted");
+                        return false;
+                    }
+                }
+
+                if (validateRecords() == false)
+                {
+                    logError("ScenePackage: '" + filename + "' is corrupted");
+                    return false;
+                }
+                return true;
+            }
+
+            const PackageHeader& getHeader() const { return *(const PackageHeader*)mpFile; }
+
+            template<typename RecordType>
+            uint32_t getRecordCount(Section section) const
+            {
+                return uint32_t(getHeader().sections[(uint32_t)section].size / sizeof(RecordType));
+            }
+
+            template<typename RecordType>
+            const RecordType* getRecords(Section section) const
+            {
+                return (const RecordType*)(mpFile + getHeader().sections[(uint32_t)section].offset);
+            }
+
+            const void* getData(const DataRef& ref) const
+            {
+                const DataRef& dataSection = getHeader().sections[(uint32_t)Section::Data];
+                assert(isValidRef(ref));
+                return mpFile + dataSection.offset + ref.offset;
+            }
+
+            std::string getString(const DataRef& ref) const
+            {
+                return std::string((const char*)getData(ref), (size_t)ref.size);
+            }
+
+        private:
+            bool isValidRef(const DataRef& ref) const
+            {
+                const uint64_t dataSize = getHeader().sections[(uint32_t)Section::Data].size;
+                return ref.offset <= dataSize && ref.size <= dataSize - ref.offset;
+            }
+
+            static bool isValidIndex(uint32_t index, uint32_t count, bool allowNone)
+            {
+                return (index < count) || (allowNone && index == kNoIndex);
+            }
+
+            static bool isValidRange(uint32_t first, uint32_t count, uint32_t total)
+            {
+                return (uint64_t)first + count <= total;
+            }
+
+            // Size of the texels of a complete mip-chain, or 0 if the description isn't valid
+            static uint64_t getTexelDataSize(const TextureRecord& record)
+            {
+                if ((uint32_t)record.format == 0 || (uint32_t)record.format > (uint32_t)ResourceFormat::BC7UnormSrgb || record.width == 0 || record.height == 0)
+                {
+                    return 0;
+                }
+
+                uint32_t maxMipLevels = 1;
+                while ((std::max(record.width, record.height) >> maxMipLevels) > 0)
+                {
+                    maxMipLevels++;
+                }
+                if (record.mipLevels == 0 || record.mipLevels > maxMipLevels)
+                {
+                    return 0;
+                }
+
+                const uint32_t blockWidth = getFormatWidthCompressionRatio(record.format);
+                const uint32_t blockHeight = getFormatHeightCompressionRatio(record.format);
+                uint64_t size = 0;
+                for (uint32_t mip = 0; mip < record.mipLevels; mip++)
+                {
+                    const uint64_t width = std::max(record.width >> mip, 1u);
+                    const uint64_t height = std::max(record.height >> mip, 1u);
+                    size += ((width + blockWidth - 1) / blockWidth) * ((height + blockHeight - 1) / blockHeight) * getFormatBytesPerBlock(record.format);
+                }
+                return size;
+            }
+
+            /** Check every blob range and record index before anything is created from the package, so a damaged package fails to load instead of reading out of bounds
+            */
+            bool validateRecords() const
+            {
+                const uint32_t textureCount = getRecordCount<TextureRecord>(Section::Textures);
+                const uint32_t materialCount = getRecordCount<MaterialRecord>(Section::Materials);
+                const uint32_t elementCount = getRecordCount<VertexElementRecord>(Section::VertexElements);
+                const uint32_t vertexBufferCount = getRecordCount<VertexBufferRecord>(Section::VertexBuffers);
+                const uint32_t meshCount = getRecordCount<MeshRecord>(Section::Meshes);
+                const uint32_t meshInstanceCount = getRecordCount<MeshInstanceRecord>(Section::MeshInstances);
+                const uint32_t modelCount = getRecordCount<ModelRecord>(Section::Models);
+
+                if (isValidRef(getHeader().sceneDesc) == false)
+                {
+                    return false;
+                }
+
+                const TextureRecord* pTextures = getRecords<TextureRecord>(Section::Textures);
+                for (uint32_t i = 0; i < textureCount; i++)
+                {
+                    const TextureRecord& r = pTextures[i];
+                    if (!isValidRef(r.name) || !isValidRef(r.relativeFilename) || !isValidRef(r.absoluteFilename) || !isValidRef(r.texels))
+                    {
+                        return false;
+                    }
+
+                    const uint64_t texelDataSize = getTexelDataSize(r);
+                    if (texelDataSize == 0 || r.texels.size < texelDataSize)
+                    {
+                        return false;
+                    }
+                }
+
+                const MaterialRecord* pMaterials = getRecords<MaterialRecord>(Section::Materials);
+                for (uint32_t i = 0; i < materialCount; i++)
+                {
+                    const MaterialRecord& r = pMaterials[i];
+                    if (!isValidRef(r.name) || r.layerCount > MatMaxLayers)
+                    {
+                        return false;
+                    }
+
+                    for (uint32_t l = 0; l < r.layerCount; l++)
+                    {
+                        if (!isValidIndex(r.layers[l].texture, textureCount, true))
+                        {
+                            return false;
+                        }
+                    }
+
+                    if (!isValidIndex(r.normalMap, textureCount, true) || !isValidIndex(r.alphaMap, textureCount, true) ||
+                        !isValidIndex(r.ambientOcclusionMap, textureCount, true) || !isValidIndex(r.heightMap, textureCount, true))
+                    {
+                        return false;
+                    }
+                }
+
+                const VertexElementRecord* pElements = getRecords<VertexElementRecord>(Section::VertexElements);
+                for (uint32_t i = 0; i < elementCount; i++)
+                {
+                    if (!isValidRef(pElements[i].name))
+                    {
+                        return false;
+                    }
+                }
+
+                const VertexBufferRecord* pVertexBuffers = getRecords<VertexBufferRecord>(Section::VertexBuffers);
+                for (uint32_t i = 0; i < vertexBufferCount; i++)
+                {
+                    const VertexBufferRecord& r = pVertexBuffers[i];
+                    if (!isValidRef(r.data) || !isValidRange(r.firstElement, r.elementCount, elementCount))
+                    {
+                        return false;
+                    }
+                }
+
+                const MeshRecord* pMeshes = getRecords<MeshRecord>(Section::Meshes);
+                for (uint32_t i = 0; i < meshCount; i++)
+                {
+                    const MeshRecord& r = pMeshes[i];
+                    if (!isValidRef(r.indexData) || !isValidIndex(r.material, materialCount, true) || !isValidRange(r.firstVertexBuffer, r.vertexBufferCount, vertexBufferCount))
+                    {
+                        return false;
+                    }
+                }
+
+                const MeshInstanceRecord* pMeshInstances = getRecords<MeshInstanceRecord>(Section::MeshInstances);
+                for (uint32_t i = 0; i < meshInstanceCount; i++)
+                {
+                    if (!isValidIndex(pMeshInstances[i].mesh, meshCount, false))
+                    {
+                        return false;
+                    }
+                }
+
+                const ModelRecord* pModels = getRecords<ModelRecord>(Section::Models);
+                for (uint32_t i = 0; i < modelCount; i++)
+                {
+                    const ModelRecord& r = pModels[i];
+                    if (!isValidRef(r.name) || !isValidRef(r.relativeFilename) || !isValidRef(r.absoluteFilename) || !isValidRange(r.firstMeshInstance, r.meshInstanceCount, meshInstanceCount))
+                    {
+                        return false;
+                    }
+                }
+
+                const ModelInstanceRecord* pModelInstances = getRecords<ModelInstanceRecord>(Section::ModelInstances);
+                for (uint32_t i = 0; i < getRecordCount<ModelInstanceRecord>(Section::ModelInstances); i++)
+                {
+                    if (!isValidRef(pModelInstances[i].name) || !isValidIndex(pModelInstances[i].model, modelCount, false))
+                    {
+                        return false;
+                    }
+                }
+
+                const uint32_t* pSceneMaterials = getRecords<uint32_t>(Section::SceneMaterials);
+                for (uint32_t i = 0; i < getRecordCount<uint32_t>(Section::SceneMaterials); i++)
+                {
+                    if (!isValidIndex(pSceneMaterials[i], materialCount, true))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            const uint8_t* mpFile;
+            size_t mFileSize;
+        };
+
+        template<typename T>
+        const T& getIndexed(const std::vector<T>& vec, uint32_t index)
+        {
+            static const T kNull;
+            return (index == kNoIndex) ? kNull : vec[index];
+        }
+    }
+
+    bool ScenePackage::saveScene(const std::string& filename, const Scene::SharedPtr& pScene)
+    {
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const Model::SharedPtr& pModel = pScene->getModel(modelID);
+            if (pModel->hasBones() || pModel->hasAnimations())
+            {
+                logError("ScenePackage: can't bake model '" + pModel->getName() + "'. Models with skinning animations are not supported.");
+                return false;
+            }
+        }
+
+        PackageWriter writer;
+        if (writer.open(filename) == false)
+        {
+            logError("ScenePackage: can't open file '" + filename + "' for writing");
+            return false;
+        }
+
+        SceneBaker baker(writer);
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            uint32_t modelIndex = baker.addModel(pScene->getModel(modelID));
+            for (uint32_t i = 0; i < pScene->getModelInstanceCount(modelID); i++)
+            {
+                const Scene::ModelInstance::SharedPtr& pInstance = pScene->getModelInstance(modelID, i);
+                ModelInstanceRecord record = {};
+                record.name = writer.writeString(pInstance->getName());
+                record.translation = pInstance->getTranslation();
+                record.target = pInstance->getTarget();
+                record.up = pInstance->getUpVector();
+                record.scaling = pInstance->getScaling();
+                record.model = modelIndex;
+                record.visible = pInstance->isVisible() ? 1 : 0;
+                writer.addRecord(Section::ModelInstances, record);
+            }
+        }
+
+        for (uint32_t i = 0; i < pScene->getMaterialCount(); i++)
+        {
+            uint32_t materialIndex = baker.addMaterial(pScene->getMaterial(i));
+            writer.addRecord(Section::SceneMaterials, materialIndex);
+        }
+
+        // Everything which isn't geometry or materials goes through the regular scene serializer
+        const uint32_t descOptions = SceneExporter::ExportGlobalSettings | SceneExporter::ExportLights | SceneExporter::ExportCameras | SceneExporter::ExportPaths | SceneExporter::ExportUserDefined;
+        std::string sceneDesc = SceneExporter::saveSceneToString(pScene, descOptions);
+        DataRef sceneDescRef = writer.writeString(sceneDesc);
+
+        if (writer.finish(sceneDescRef) == false)
+        {
+            logError("ScenePackage: failed to write '" + filename + "'");
+            return false;
+        }
+        return true;
+    }
+
+    Scene::SharedPtr ScenePackage::loadScene(const std::string& filename, Scene::LoadFlags sceneLoadFlags)
+    {
+        std::string fullpath;
+        if (findFileInDataDirectories(filename, fullpath) == false)
+        {
+            logError("ScenePackage: can't find file '" + filename + "'");
+            return nullptr;
+        }
+
+        size_t fileSize = 0;
+        const uint8_t* pFile = (const uint8_t*)mapFileForReading(fullpath, fileSize);
+        if (pFile == nullptr)
+        {
+            logError("ScenePackage: can't open file '" + fullpath + "'");
+            return nullptr;
+        }
+
+        PackageReader reader(pFile, fileSize);
+        if (reader.validate(fullpath) == false)
+        {
+            unmapFile(pFile, fileSize);
+            return nullptr;
+        }
+
+        // The scene resets the global mesh and material IDs, so it has to exist before anything else is created
+        Scene::SharedPtr pScene = Scene::create();
+
+        // Textures. The init data holds the complete mip-chain, so nothing is generated at load time.
+        std::vector<Texture::SharedPtr> textures(reader.getRecordCount<TextureRecord>(Section::Textures));
+        const TextureRecord* pTextureRecords = reader.getRecords<TextureRecord>(Section::Textures);
+        for (size_t i = 0; i < textures.size(); i++)
+        {
+            const TextureRecord& record = pTextureRecords[i];
+            Texture::SharedPtr pTexture = Texture::create2D(record.width, record.height, record.format, 1, record.mipLevels, reader.getData(record.texels));
+            pTexture->setName(reader.getString(record.name));
+            pTexture->setRelativeSourceFilename(reader.getString(record.relativeFilename));
+            pTexture->setAbsoluteSourceFilename(reader.getString(record.absoluteFilename));
+            textures[i] = pTexture;
+        }
+
+        // Materials
+        std::vector<Material::SharedPtr> materials(reader.getRecordCount<MaterialRecord>(Section::Materials));
+        const MaterialRecord* pMaterialRecords = reader.getRecords<MaterialRecord>(Section::Materials);
+        for (size_t i = 0; i < materials.size(); i++)
+        {
+            const MaterialRecord& record = pMaterialRecords[i];
+            Material::SharedPtr pMaterial = Material::create(reader.getString(record.name));
+            for (uint32_t l = 0; l < record.layerCount; l++)
+            {
+                const MaterialLayerRecord& layerRecord = record.layers[l];
+                Material::Layer layer;
+                layer.type = (Material::Layer::Type)layerRecord.type;
+                layer.ndf = (Material::Layer::NDF)layerRecord.ndf;
+                layer.blend = (Material::Layer::Blend)layerRecord.blend;
+                layer.albedo = layerRecord.albedo;
+                layer.roughness = layerRecord.roughness;
+                layer.extraParam = layerRecord.extraParam;
+                layer.pTexture = getIndexed(textures, layerRecord.texture);
+                layer.pmf = layerRecord.pmf;
+                pMaterial->addLayer(layer);
+            }
+
+            Texture::SharedPtr pNormalMap = getIndexed(textures, record.normalMap);
+            pMaterial->setNormalMap(pNormalMap);
+            pMaterial->setAlphaMap(getIndexed(textures, record.alphaMap));
+            pMaterial->setAmbientOcclusionMap(getIndexed(textures, record.ambientOcclusionMap));
+            pMaterial->setHeightMap(getIndexed(textures, record.heightMap));
+            pMaterial->setAlphaThreshold(record.alphaThreshold);
+            pMaterial->setHeightModifiers(record.heightModifiers);
+            pMaterial->setDoubleSided(record.doubleSided != 0);
+            materials[i] = pMaterial;
+        }
+
+        // Meshes. Buffers shared by several meshes are only created once.
+        std::unordered_map<uint64_t, Buffer::SharedPtr> buffers;
+        auto createBuffer = [&](const DataRef& data, uint32_t bindFlags)
+        {
+            Buffer::SharedPtr& pBuffer = buffers[data.offset];
+            if (pBuffer == nullptr)
+            {
+                pBuffer = Buffer::create(data.size, (Resource::BindFlags)bindFlags, Buffer::CpuAccess::None, reader.getData(data));
+            }
+            return pBuffer;
+        };
+
+        std::vector<Mesh::SharedPtr> meshes(reader.getRecordCount<MeshRecord>(Section::Meshes));
+        const MeshRecord* pMeshRecords = reader.getRecords<MeshRecord>(Section::Meshes);
+        const VertexBufferRecord* pVertexBufferRecords = reader.getRecords<VertexBufferRecord>(Section::VertexBuffers);
+        const VertexElementRecord* pElementRecords = reader.getRecords<VertexElementRecord>(Section::VertexElements);
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            const MeshRecord& record = pMeshRecords[i];
+            VertexLayout::SharedPtr pLayout = VertexLayout::create();
+            Vao::BufferVec vertexBuffers;
+            for (uint32_t b = 0; b < record.vertexBufferCount; b++)
+            {
+                const VertexBufferRecord& vbRecord = pVertexBufferRecords[record.firstVertexBuffer + b];
+                VertexBufferLayout::SharedPtr pBufferLayout = VertexBufferLayout::create();
+                for (uint32_t e = 0; e < vbRecord.elementCount; e++)
+                {
+                    const VertexElementRecord& elemRecord = pElementRecords[vbRecord.firstElement + e];
+                    pBufferLayout->addElement(reader.getString(elemRecord.name), elemRecord.offset, elemRecord.format, elemRecord.arraySize, elemRecord.shaderLocation);
+                }
+                pBufferLayout->setInputClass((VertexBufferLayout::InputClass)vbRecord.inputClass, vbRecord.instanceStepRate);
+                pLayout->addBufferLayout(b, pBufferLayout);
+                vertexBuffers.push_back(createBuffer(vbRecord.data, vbRecord.bindFlags));
+            }
+
+            Buffer::SharedPtr pIndexBuffer = (record.indexData.size > 0) ? createBuffer(record.indexData, record.indexBindFlags) : nullptr;
+            meshes[i] = Mesh::create(vertexBuffers, record.vertexCount, pIndexBuffer, record.indexCount, pLayout, (Vao::Topology)record.topology, getIndexed(materials, record.material), record.boundingBox, record.hasBones != 0);
+        }
+
+        // Models
+        std::vector<Model::SharedPtr> models(reader.getRecordCount<ModelRecord>(Section::Models));
+        const ModelRecord* pModelRecords = reader.getRecords<ModelRecord>(Section::Models);
+        const MeshInstanceRecord* pMeshInstanceRecords = reader.getRecords<MeshInstanceRecord>(Section::MeshInstances);
+        for (size_t i = 0; i < models.size(); i++)
+        {
+            const ModelRecord& record = pModelRecords[i];
+            Model::SharedPtr pModel = Model::create();
+            for (uint32_t m = 0; m < record.meshInstanceCount; m++)
+            {
+                const MeshInstanceRecord& instanceRecord = pMeshInstanceRecords[record.firstMeshInstance + m];
+                pModel->addMeshInstance(meshes[instanceRecord.mesh], instanceRecord.transform);
+            }
+            pModel->calculateModelProperties();
+            pModel->setName(reader.getString(record.name));
+            pModel->setRelativeFilename(reader.getString(record.relativeFilename));
+            pModel->setAbsoluteFilename(reader.getString(record.absoluteFilename));
+            models[i] = pModel;
+        }
+
+        const ModelInstanceRecord* pModelInstanceRecords = reader.getRecords<ModelInstanceRecord>(Section::ModelInstances);
+        for (uint32_t i = 0; i < reader.getRecordCount<ModelInstanceRecord>(Section::ModelInstances); i++)
+        {
+            const ModelInstanceRecord& record = pModelInstanceRecords[i];
+            auto pInstance = Scene::ModelInstance::create(models[record.model], record.translation, record.target, record.up, record.scaling, reader.getString(record.name));
+            pInstance->setVisible(record.visible != 0);
+            pScene->addModelInstance(pInstance);
+        }
+
+        const uint32_t* pSceneMaterials = reader.getRecords<uint32_t>(Section::SceneMaterials);
+        for (uint32_t i = 0; i < reader.getRecordCount<uint32_t>(Section::SceneMaterials); i++)
+        {
+            pScene->addMaterial(getIndexed(materials, pSceneMaterials[i]));
+        }
+
+        std::string sceneDesc = reader.getString(reader.getHeader().sceneDesc);
+        unmapFile(pFile, fileSize);
+
+        if (SceneImporter::loadSceneFromString(*pScene, sceneDesc, fullpath, Model::LoadFlags::None, sceneLoadFlags) == false)
+        {
+            return nullptr;
+        }
+        return pScene;
+    }
+}
@@ -0,0 +1,64 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include "Scene.h"
+
+namespace Falcor
+{
+    /** Baked scene package. A single binary file holding a fully processed scene, so that loading it doesn't parse any model or image file.
+        The package contains the vertex and index buffers of every mesh as they are laid out on the GPU, the materials, and every material texture with its complete mip-chain.
+        Lights, cameras, paths and global settings are stored as an embedded scene description.
+        Loading maps the file into memory and uploads the contents straight from the mapping.
+        User variables with paths (environment maps, sky boxes) are kept as they are, so packages should be saved next to the scene file they were baked from.
+    */
+    class ScenePackage
+    {
+    public:
+        static const char* kFileExtension;
+        static const char* kFileFormatString;
+
+        /** Package version. Packages with a different version are rejected and have to be baked again.
+        */
+        static const uint32_t kVersion = 1;
+
+        /** Bake a scene into a package. GPU resources are read back, so this must run on the render thread.
+            \param[in] filename Package filename
+            \param[in] pScene The scene to bake. Models with skinning animations are not supported.
+            \return Whether the package was written successfully
+        */
+        static bool saveScene(const std::string& filename, const Scene::SharedPtr& pScene);
+
+        /** Load a scene from a package
+            \param[in] filename Package filename. Can include a full path or a relative path from a data directory
+            \param[in] sceneLoadFlags Scene load flags
+            \return A new scene, or nullptr if the package couldn't be loaded
+        */
+        static Scene::SharedPtr loadScene(const std::string& filename, Scene::LoadFlags sceneLoadFlags);
+    };
+}
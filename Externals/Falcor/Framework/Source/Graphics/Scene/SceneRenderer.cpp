@@ -49,6 +49,9 @@ namespace Falcor
     size_t SceneRenderer::sWorldInvTransposeMatOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sMeshIdOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sDrawIDOffset = ConstantBuffer::kInvalidOffset;
+    size_t SceneRenderer::sFirstInstanceOffset = ConstantBuffer::kInvalidOffset;
+    size_t SceneRenderer::sPositionScaleOffset = ConstantBuffer::kInvalidOffset;
+    size_t SceneRenderer::sPositionBiasOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sLightCountOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sLightArrayOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sAmbientLightOffset = ConstantBuffer::kInvalidOffset;
@@ -57,6 +60,9 @@ namespace Falcor
     const char* SceneRenderer::kPerFrameCbName = "InternalPerFrameCB";
     const char* SceneRenderer::kPerMeshCbName = "InternalPerMeshCB";
     const char* SceneRenderer::kBoneCbName = "InternalBoneCB";
+    const char* SceneRenderer::kInstanceDataBufferName = "gMeshInstanceData";
+
+    static_assert(sizeof(MeshInstanceData) == MESH_INSTANCE_DATA_SIZE, "MeshInstanceData size doesn't match the shader declaration");
 
     SceneRenderer::SharedPtr SceneRenderer::create(const Scene::SharedPtr& pScene)
     {
@@ -68,6 +74,21 @@ namespace Falcor
         setCameraControllerType(CameraControllerType::SixDof);
     }
 
+    static void getMeshInstanceTransforms(const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance, glm::mat4& worldMat, glm::mat4& prevWorldMat, glm::mat3x4& worldInvTransposeMat)
+    {
+        worldMat = pModelInstance->getTransformMatrix();
+        prevWorldMat = pModelInstance->getPrevTransformMatrix();
+
+        // Skinned meshes are already transformed by the bone matrices
+        if (pMeshInstance->getObject()->hasBones() == false)
+        {
+            worldMat = worldMat * pMeshInstance->getTransformMatrix();
+            prevWorldMat = prevWorldMat * pMeshInstance->getPrevTransformMatrix();
+        }
+
+        worldInvTransposeMat = transpose(inverse(glm::mat3(worldMat)));
+    }
+
     void SceneRenderer::updateVariableOffsets(const ProgramReflection* pReflector)
     {
         const ParameterBlockReflection* pBlock = pReflector->getDefaultParameterBlock().get();
@@ -90,6 +111,12 @@ namespace Falcor
                 sMeshIdOffset = pType->findMember("gMeshId")->getOffset();
                 sDrawIDOffset = pType->findMember("gDrawId[0]")->getOffset();
                 sPrevWorldMatOffset = pType->findMember("gPrevWorldMat[0]")->getOffset();
+                const auto& pFirstInstanceOffset = pType->findMember("gFirstInstance");
+                sFirstInstanceOffset = pFirstInstanceOffset ? pFirstInstanceOffset->getOffset() : ConstantBuffer::kInvalidOffset;
+                const auto& pPositionScale = pType->findMember("gPositionScale");
+                sPositionScaleOffset = pPositionScale ? pPositionScale->getOffset() : ConstantBuffer::kInvalidOffset;
+                const auto& pPositionBias = pType->findMember("gPositionBias");
+                sPositionBiasOffset = pPositionBias ? pPositionBias->getOffset() : ConstantBuffer::kInvalidOffset;
             }
         }
 
@@ -123,18 +150,18 @@ namespace Falcor
                 currentData.pCamera->setIntoConstantBuffer(pCB, sCameraDataOffset);
             }
 
-            // Set lights
+            // Set lights. The array in the constant buffer is limited to MAX_LIGHT_SOURCES, scenes with more lights need to bind them in a buffer of their own.
+            const uint32_t lightCount = std::min<uint32_t>(mpScene->getLightCount(), MAX_LIGHT_SOURCES);
             if (sLightArrayOffset != ConstantBuffer::kInvalidOffset)
             {
-                assert(mpScene->getLightCount() <= MAX_LIGHT_SOURCES);  // Max array size in the shader
-                for (uint_t i = 0; i < mpScene->getLightCount(); i++)
+                for (uint_t i = 0; i < lightCount; i++)
                 {
                     mpScene->getLight(i)->setIntoConstantBuffer(pCB, i * Light::getShaderStructSize() + sLightArrayOffset);
                 }
             }
             if (sLightCountOffset != ConstantBuffer::kInvalidOffset)
             {
-                pCB->setVariable(sLightCountOffset, mpScene->getLightCount());
+                pCB->setVariable(sLightCountOffset, lightCount);
             }
             if (sAmbientLightOffset != ConstantBuffer::kInvalidOffset)
             {
@@ -167,6 +194,17 @@ namespace Falcor
         return true;
     }
 
+    void SceneRenderer::setPositionDecodeData(ConstantBuffer* pCB, const Mesh* pMesh)
+    {
+        // Quantized positions are relative to the mesh bounding box. The constants are set for every mesh, they are unused otherwise.
+        if (sPositionScaleOffset != ConstantBuffer::kInvalidOffset && sPositionBiasOffset != ConstantBuffer::kInvalidOffset)
+        {
+            const BoundingBox& box = pMesh->getBoundingBox();
+            pCB->setVariable(sPositionScaleOffset, box.getSize());
+            pCB->setVariable(sPositionBiasOffset, box.getMinPos());
+        }
+    }
+
     bool SceneRenderer::setPerModelInstanceData(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, uint32_t instanceID)
     {
         return true;
@@ -186,16 +224,10 @@ namespace Falcor
 
             assert(drawInstanceID == 0); // We don't support instanced skinned models
 
-            glm::mat4 worldMat = pModelInstance->getTransformMatrix();
-            glm::mat4 prevWorldMat = pModelInstance->getPrevTransformMatrix();
-
-            if (pMesh->hasBones() == false)
-            {
-                worldMat = worldMat * pMeshInstance->getTransformMatrix();
-                prevWorldMat = prevWorldMat * pMeshInstance->getPrevTransformMatrix();
-            }
-
-            glm::mat3x4 worldInvTransposeMat = transpose(inverse(glm::mat3(worldMat)));
+            glm::mat4 worldMat;
+            glm::mat4 prevWorldMat;
+            glm::mat3x4 worldInvTransposeMat;
+            getMeshInstanceTransforms(pModelInstance, pMeshInstance, worldMat, prevWorldMat, worldInvTransposeMat);
 
             assert(drawInstanceID < sWorldMatArraySize);
             pCB->setBlob(&worldMat, sWorldMatOffset + drawInstanceID * sizeof(glm::mat4), sizeof(glm::mat4));
@@ -204,6 +236,7 @@ namespace Falcor
 
             // Set mesh id
             pCB->setVariable(sMeshIdOffset, pMesh->getId());
+            setPositionDecodeData(pCB, pMesh);
         }
 
         return true;
@@ -271,9 +304,8 @@ namespace Falcor
             for (uint32_t instanceID = 0; instanceID < instanceCount; instanceID++)
             {
                 const Model::MeshInstance* pMeshInstance = pModel->getMeshInstance(meshID, instanceID).get();
-                BoundingBox box = pMeshInstance->getBoundingBox().transform(pModelInstance->getTransformMatrix());
 
-                if ((mCullEnabled == false) || (currentData.pCamera->isObjectCulled(box) == false))
+                if ((mCullEnabled == false) || mpCuller->isEntryVisible(currentData.cullEntry + instanceID))
                 {
                     if (pMeshInstance->isVisible())
                     {
@@ -304,6 +336,8 @@ namespace Falcor
                 pProgram->removeDefine("_VERTEX_BLENDING");
             }
         }
+
+        currentData.cullEntry += pModel->getMeshInstanceCount(meshID);
     }
 
     void SceneRenderer::renderModelInstance(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance)
@@ -331,6 +365,22 @@ namespace Falcor
     {
         setPerFrameData(currentData);
 
+        // Cull all mesh instances up front, the draw loop below only looks up the results
+        if (mCullEnabled)
+        {
+            if (mpCuller == nullptr)
+            {
+                mpCuller = SceneCuller::create(mpScene);
+            }
+            mpCuller->cull(currentData.pCamera);
+        }
+
+        if (mInstanceDataBufferEnabled && currentData.pVars->getReflection()->getResource(kInstanceDataBufferName))
+        {
+            renderSceneFromInstanceBuffer(currentData);
+            return;
+        }
+
         for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
         {
             currentData.pModel = mpScene->getModel(modelID).get();
@@ -344,6 +394,7 @@ namespace Falcor
                     {
                         if (setPerModelInstanceData(currentData, pInstance, instanceID))
                         {
+                            currentData.cullEntry = mCullEnabled ? mpCuller->getFirstEntry(modelID, instanceID) : 0;
                             renderModelInstance(currentData, pInstance);
                         }
                     }
@@ -352,6 +403,118 @@ namespace Falcor
         }
     }
 
+    void SceneRenderer::renderSceneFromInstanceBuffer(CurrentWorkingData& currentData)
+    {
+        // Size the buffer for every instance in the scene, so it is mapped only once per frame
+        size_t maxInstanceCount = 0;
+        for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = mpScene->getModel(modelID).get();
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                maxInstanceCount += mpScene->getModelInstanceCount(modelID) * pModel->getMeshInstanceCount(meshID);
+            }
+        }
+
+        if (maxInstanceCount == 0)
+        {
+            return;
+        }
+
+        const size_t requiredSize = maxInstanceCount * sizeof(MeshInstanceData);
+        if (mpInstanceDataBuffer == nullptr || mpInstanceDataBuffer->getSize() < requiredSize)
+        {
+            const size_t size = mpInstanceDataBuffer ? std::max(requiredSize, mpInstanceDataBuffer->getSize() * 2) : requiredSize;
+            mpInstanceDataBuffer = Buffer::create(size, Resource::BindFlags::ShaderResource, Buffer::CpuAccess::Write, nullptr);
+        }
+
+        // Write-discard hands out a new range of the upload heap every frame, the previous range is recycled once the GPU is done with it
+        MeshInstanceData* pInstanceData = (MeshInstanceData*)mpInstanceDataBuffer->map(Buffer::MapType::WriteDiscard);
+        currentData.pVars->setRawBuffer(kInstanceDataBufferName, mpInstanceDataBuffer);
+        ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(kPerMeshCbName).get();
+
+        uint32_t instanceCount = 0;
+        for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
+        {
+            currentData.pModel = mpScene->getModel(modelID).get();
+            if (setPerModelData(currentData) == false)
+            {
+                continue;
+            }
+
+            mBatchedModelInstances.clear();
+            for (uint32_t instanceID = 0; instanceID < mpScene->getModelInstanceCount(modelID); instanceID++)
+            {
+                const auto pInstance = mpScene->getModelInstance(modelID, instanceID).get();
+                if (pInstance->isVisible() && setPerModelInstanceData(currentData, pInstance, instanceID))
+                {
+                    const uint32_t cullEntry = mCullEnabled ? mpCuller->getFirstEntry(modelID, instanceID) : 0;
+                    mBatchedModelInstances.push_back({ pInstance, cullEntry });
+                }
+            }
+
+            mpLastMaterial = nullptr;
+            const Model* pModel = currentData.pModel;
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                const Mesh* pMesh = pModel->getMesh(meshID).get();
+                const uint32_t meshInstanceCount = pModel->getMeshInstanceCount(meshID);
+                if (setPerMeshData(currentData, pMesh) == false)
+                {
+                    for (BatchedModelInstance& batch : mBatchedModelInstances)
+                    {
+                        batch.cullEntry += meshInstanceCount;
+                    }
+                    continue;
+                }
+
+                // Gather the instances of this mesh from all model instances into one contiguous range
+                const uint32_t firstInstance = instanceCount;
+                for (BatchedModelInstance& batch : mBatchedModelInstances)
+                {
+                    for (uint32_t meshInstanceID = 0; meshInstanceID < meshInstanceCount; meshInstanceID++)
+                    {
+                        const Model::MeshInstance* pMeshInstance = pModel->getMeshInstance(meshID, meshInstanceID).get();
+                        if (((mCullEnabled == false) || mpCuller->isEntryVisible(batch.cullEntry + meshInstanceID)) && pMeshInstance->isVisible())
+                        {
+                            MeshInstanceData& data = pInstanceData[instanceCount++];
+                            getMeshInstanceTransforms(batch.pModelInstance, pMeshInstance, data.worldMat, data.prevWorldMat, data.worldInvTransposeMat);
+                            data.drawId = currentData.drawID++;
+                        }
+                    }
+                    batch.cullEntry += meshInstanceCount;
+                }
+
+                if (instanceCount == firstInstance)
+                {
+                    continue;
+                }
+
+                Program* pProgram = currentData.pState->getProgram().get();
+                if (pMesh->hasBones())
+                {
+                    pProgram->addDefine("_VERTEX_BLENDING");
+                }
+
+                currentData.pState->setVao(pMesh->getVao());
+                if (pCB && sFirstInstanceOffset != ConstantBuffer::kInvalidOffset)
+                {
+                    pCB->setVariable(sMeshIdOffset, pMesh->getId());
+                    pCB->setVariable(sFirstInstanceOffset, firstInstance);
+                    setPositionDecodeData(pCB, pMesh);
+                }
+                draw(currentData, pMesh, instanceCount - firstInstance);
+
+                if (pMesh->hasBones())
+                {
+                    pProgram->removeDefine("_VERTEX_BLENDING");
+                }
+            }
+        }
+
+        mpInstanceDataBuffer->unmap();
+    }
+
     void SceneRenderer::renderScene(RenderContext* pContext, Camera* pCamera)
     {
         updateVariableOffsets(pContext->getGraphicsVars()->getReflection().get());
@@ -30,6 +30,7 @@
 #include "Utils/Gui.h"
 #include "Graphics/Camera/CameraController.h"
 #include "Graphics/Scene/Scene.h"
+#include "Graphics/Scene/SceneCuller.h"
 #include "Utils/CpuTimer.h"
 #include "API/ConstantBuffer.h"
 #include "Utils/DebugDrawer.h"
@@ -96,6 +97,13 @@ namespace Falcor
 
         void toggleStaticMaterialCompilation(bool on) { mCompileMaterialWithProgram = on; }
 
+        /** Read instance transforms from a buffer instead of the per-mesh constant buffer. All visible instance data for a frame is written once into
+            upload memory, and each mesh of a model is drawn with a single instanced draw call covering all its instances, without the MAX_INSTANCES limit.
+            Programs have to be compiled with _INSTANCE_DATA_BUFFER defined, otherwise the renderer falls back to the constant buffer path.
+            setPerMeshInstanceData() is not called in this mode, and state set in setPerModelInstanceData() has to be the same for all instances of a model.
+        */
+        void toggleInstanceDataBuffer(bool on) { mInstanceDataBufferEnabled = on; }
+
     protected:
 
         struct CurrentWorkingData
@@ -108,6 +116,7 @@ namespace Falcor
             const Material* pMaterial = nullptr;
 
             uint32_t drawID; // Zero-based mesh instance draw order/ID. Resets at the beginning of renderScene, and increments per mesh instance drawn.
+            uint32_t cullEntry = 0; // SceneCuller entry of the first instance of the next mesh. Set per model instance, advanced by renderMeshInstances.
         };
 
         SceneRenderer(const Scene::SharedPtr& pScene);
@@ -117,6 +126,7 @@ namespace Falcor
         static const char* kPerFrameCbName;
         static const char* kPerMeshCbName;
         static const char* kBoneCbName;
+        static const char* kInstanceDataBufferName;
 
         static size_t sBonesOffset;
         static size_t sBonesInvTransposeOffset;
@@ -130,9 +140,16 @@ namespace Falcor
         static size_t sWorldInvTransposeMatOffset;
         static size_t sMeshIdOffset;
         static size_t sDrawIDOffset;
+        static size_t sFirstInstanceOffset;
+        static size_t sPositionScaleOffset;
+        static size_t sPositionBiasOffset;
 
         static void updateVariableOffsets(const ProgramReflection* pReflector);
 
+        /** Set the constants decoding quantized positions, see getPackedVertexFormat()
+        */
+        static void setPositionDecodeData(ConstantBuffer* pCB, const Mesh* pMesh);
+
         virtual void setPerFrameData(const CurrentWorkingData& currentData);
         virtual bool setPerModelData(const CurrentWorkingData& currentData);
         virtual bool setPerModelInstanceData(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, uint32_t instanceID);
@@ -147,6 +164,7 @@ namespace Falcor
         void draw(CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t instanceCount);
 
         void renderScene(CurrentWorkingData& currentData);
+        void renderSceneFromInstanceBuffer(CurrentWorkingData& currentData);
 
         CameraControllerType mCamControllerType = CameraControllerType::SixDof;
         CameraController::SharedPtr mpCameraController;
@@ -154,6 +172,17 @@ namespace Falcor
         uint32_t mMaxInstanceCount = 64;
         const Material* mpLastMaterial = nullptr;
         bool mCullEnabled = true;
+        SceneCuller::SharedPtr mpCuller;
+
+        bool mInstanceDataBufferEnabled = false;
+        Buffer::SharedPtr mpInstanceDataBuffer;
+
+        struct BatchedModelInstance
+        {
+            const Scene::ModelInstance* pModelInstance;
+            uint32_t cullEntry;
+        };
+        std::vector<BatchedModelInstance> mBatchedModelInstances;
         bool mCompileMaterialWithProgram = true;
     };
 }
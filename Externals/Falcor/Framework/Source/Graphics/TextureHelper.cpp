@@ -251,6 +251,18 @@ namespace Falcor
         }
     }
 
+    DXFormat dxgiFormatFromFalcorFormat(ResourceFormat format)
+    {
+        for(uint32_t fmt = FORMAT_UNKNOWN + 1; fmt <= FORMAT_B4G4R4A4_UNORM; fmt++)
+        {
+            if(falcorFormatFromDXGIFormat((DXFormat)fmt) == format)
+            {
+                return (DXFormat)fmt;
+            }
+        }
+        return FORMAT_UNKNOWN;
+    }
+
     DXFormat getRgbDxgiFormat(const DdsHeader::PixelFormat& format)
     {
         switch(format.bitcount)
@@ -540,14 +552,14 @@ namespace Falcor
         }
     }
 
-    void loadDDSDataFromFile(const std::string filename, DdsData& ddsData)
+    bool loadDDSDataFromFile(const std::string filename, DdsData& ddsData)
     {
         std::string fullpath;
         if (findFileInDataDirectories(filename, fullpath) == false)
         {
             logError(std::string("Can't find texture file ") + filename);
             //could not find file
-            return;
+            return false;
         }
 
         BinaryFileStream stream(fullpath, BinaryFileStream::Mode::Read);
@@ -559,7 +571,7 @@ namespace Falcor
         {
             //not valid dds file apparently
             logError(std::string("The dds file ") + filename + std::string(" is not a valid dds file"));
-            return;
+            return false;
         }
 
         stream >> ddsData.header;
@@ -577,6 +589,7 @@ namespace Falcor
         uint32_t dataSize = stream.getRemainingStreamSize();
         ddsData.data.resize(dataSize);
         stream.read(ddsData.data.data(), dataSize);
+        return true;
     }
 
     static ResourceFormat convertBgrxFormatToBgra(DdsData& ddsData, ResourceFormat format)
@@ -663,11 +676,8 @@ namespace Falcor
         return nullptr;
     }
 
-    Texture::SharedPtr createTextureFromDDSFile(const std::string filename, bool generateMips, bool loadAsSrgb, Texture::BindFlags bindFlags)
+    Texture::SharedPtr createTextureFromDdsData(DdsData& ddsData, const std::string& filename, bool generateMips, bool loadAsSrgb, Texture::BindFlags bindFlags)
     {
-        DdsData ddsData;
-        loadDDSDataFromFile(filename, ddsData);
-
         ResourceFormat format = getDdsResourceFormat(ddsData);
         assert(format != ResourceFormat::Unknown);
 
@@ -697,35 +707,101 @@ namespace Falcor
         return nullptr;
     }
 
-    Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags)
+    TextureFileData::~TextureFileData() = default;
+
+    TextureFileData::SharedPtr TextureFileData::create(const std::string& filename)
     {
-#define no_srgb()   \
-    if(loadAsSrgb)  \
-    {               \
-        logWarning("createTexture2DFromFile() warning. " + std::to_string(pBitmap->getBytesPerPixel()) + " channel images doesn't have a matching sRGB format. Loading in linear space.");  \
-    }
+        SharedPtr pData = SharedPtr(new TextureFileData());
+        pData->mFilename = filename;
 
         if (hasSuffix(filename, ".dds"))
         {
-            return createTextureFromDDSFile(filename, generateMipLevels, loadAsSrgb, bindFlags);
+            pData->mpDdsData = std::make_unique<DdsData>();
+            if (loadDDSDataFromFile(filename, *pData->mpDdsData) == false)
+            {
+                return nullptr;
+            }
         }
-
-        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(filename, kTopDown);
-        Texture::SharedPtr pTex;
-
-        if(pBitmap)
+        else
         {
-            ResourceFormat texFormat = pBitmap->getFormat();
-            if(loadAsSrgb)
+            pData->mpBitmap = Bitmap::createFromFile(filename, kTopDown);
+            if (pData->mpBitmap == nullptr)
             {
-                texFormat = linearToSrgbFormat(texFormat);
+                return nullptr;
             }
+        }
+        return pData;
+    }
+
+    Texture::SharedPtr createTextureFromFileData(const TextureFileData* pFileData, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags)
+    {
+        const std::string& filename = pFileData->getFilename();
 
-            pTex = Texture::create2D(pBitmap->getWidth(), pBitmap->getHeight(), texFormat, 1, generateMipLevels ? Texture::kMaxPossible : 1, pBitmap->getData(), bindFlags);
-            pTex->setRelativeSourceFilename(stripDataDirectories(filename));
-            pTex->setAbsoluteSourceFilename(filename);
+        if (pFileData->getDdsData())
+        {
+            // Creating the texture may convert the data in place, so work on a copy and keep the file data reusable
+            DdsData ddsData = *pFileData->getDdsData();
+            return createTextureFromDdsData(ddsData, filename, generateMipLevels, loadAsSrgb, bindFlags);
+        }
+
+        const Bitmap* pBitmap = pFileData->getBitmap();
+        ResourceFormat texFormat = pBitmap->getFormat();
+        if(loadAsSrgb)
+        {
+            texFormat = linearToSrgbFormat(texFormat);
         }
+
+        Texture::SharedPtr pTex = Texture::create2D(pBitmap->getWidth(), pBitmap->getHeight(), texFormat, 1, generateMipLevels ? Texture::kMaxPossible : 1, pBitmap->getData(), bindFlags);
+        pTex->setRelativeSourceFilename(stripDataDirectories(filename));
+        pTex->setAbsoluteSourceFilename(filename);
         return pTex;
     }
-#undef no_srgb
+
+    Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags)
+    {
+        TextureFileData::SharedConstPtr pFileData = TextureFileData::create(filename);
+        return pFileData ? createTextureFromFileData(pFileData.get(), generateMipLevels, loadAsSrgb, bindFlags) : nullptr;
+    }
+
+    bool saveTextureDataToDDSFile(const std::string& filename, uint32_t width, uint32_t height, ResourceFormat format, const void* pData)
+    {
+        DXFormat dxgiFormat = dxgiFormatFromFalcorFormat(format);
+        if(dxgiFormat == FORMAT_UNKNOWN || isCompressedFormat(format))
+        {
+            logError("Can't save texture to DDS file " + filename + ". Unsupported format " + to_string(format) + ".");
+            return false;
+        }
+
+        BinaryFileStream stream(filename, BinaryFileStream::Mode::Write);
+        if(stream.isGood() == false)
+        {
+            logError("Can't open DDS file " + filename + " for writing.");
+            return false;
+        }
+
+        const uint32_t pitch = width * getFormatBytesPerBlock(format);
+
+        DdsHeader header = {};
+        header.headerSize = sizeof(DdsHeader);
+        header.flags = DdsHeader::kCapsMask | DdsHeader::kHeightMask | DdsHeader::kWidthMask | DdsHeader::kPixelFormatMask | DdsHeader::kPitchMask;
+        header.height = height;
+        header.width = width;
+        header.pitch = pitch;
+        header.depth = 1;
+        header.mipCount = 1;
+        header.pixelFormat.structSize = sizeof(DdsHeader::PixelFormat);
+        header.pixelFormat.flags = DdsHeader::PixelFormat::kFourCCFlag;
+        header.pixelFormat.fourCC = makeFourCC("DX10");
+        header.caps[0] = DdsHeader::kCapsTextureMask;
+
+        DdsHeaderDX10 dx10Header = {};
+        dx10Header.dxgiFormat = dxgiFormat;
+        dx10Header.resourceDimension = RESOURCE_DIMENSION_TEXTURE2D;
+        dx10Header.arraySize = 1;
+
+        // The loader keeps rows in file order (kTopDown), so the data is written as is
+        stream << kDdsMagicNumber << header << dx10Header;
+        stream.write(pData, (size_t)pitch * height);
+        return stream.isBad() == false;
+    }
 }
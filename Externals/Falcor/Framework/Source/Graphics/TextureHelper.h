@@ -26,10 +26,17 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
 #pragma once
+#include <memory>
 #include <string>
 #include "API/Texture.h"
 namespace Falcor
 {
+    class Bitmap;
+
+    namespace DdsHelper
+    {
+        struct DdsData;
+    }
     /*!
     *  \addtogroup Falcor
     *  @{
@@ -43,5 +50,60 @@ namespace Falcor
     */
     Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags = Texture::BindFlags::ShaderResource);
 
+    /** Contents of an image file, read and decoded but not uploaded to the GPU yet.
+        Loading doesn't use the device, so it can run on worker threads. Create the texture on the render thread using createTextureFromFileData().
+    */
+    class TextureFileData
+    {
+    public:
+        using SharedPtr = std::shared_ptr<TextureFileData>;
+        using SharedConstPtr = std::shared_ptr<const TextureFileData>;
+
+        /** Read and decode an image file.
+            \param[in] filename Filename of the image. Can also include a full path or relative path from a data directory
+            \return A new object, or nullptr if the file couldn't be loaded
+        */
+        static SharedPtr create(const std::string& filename);
+
+        ~TextureFileData();
+
+        /** Get the filename the data was loaded from
+        */
+        const std::string& getFilename() const { return mFilename; }
+
+        /** Get the decoded image. nullptr for DDS files
+        */
+        const Bitmap* getBitmap() const { return mpBitmap.get(); }
+
+        /** Get the DDS file contents. nullptr for non-DDS files
+        */
+        const DdsHelper::DdsData* getDdsData() const { return mpDdsData.get(); }
+
+    private:
+        TextureFileData() = default;
+
+        std::string mFilename;
+        std::unique_ptr<const Bitmap> mpBitmap;
+        std::unique_ptr<DdsHelper::DdsData> mpDdsData;
+    };
+
+    /** Create a new texture object from image data loaded by TextureFileData::create().
+        \param[in] pFileData The decoded file
+        \param[in] generateMipLevels Whether the mip-chain should be generated
+        \param[in] loadAsSrgb Load the texture using sRGB format. Only valid for 3 or 4 component textures.
+        \param[in] bindFlags The bind flags to create the texture with
+    */
+    Texture::SharedPtr createTextureFromFileData(const TextureFileData* pFileData, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags = Texture::BindFlags::ShaderResource);
+
+    /** Save raw texel data of a single-mip 2D texture to a DDS file. The file uses the DX10 header extension, so any uncompressed format can be stored.
+        \param[in] filename Output filename
+        \param[in] width Texture width
+        \param[in] height Texture height
+        \param[in] format Texel format. Compressed formats are not supported
+        \param[in] pData Tightly packed texel data, rows ordered top to bottom
+        \return true if the file was written successfully
+    */
+    bool saveTextureDataToDDSFile(const std::string& filename, uint32_t width, uint32_t height, ResourceFormat format, const void* pData);
+
     /*! @} */
 }
\ No newline at end of file
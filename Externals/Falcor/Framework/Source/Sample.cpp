@@ -41,6 +41,9 @@
 
 namespace Falcor
 {
+    static const uint32_t kTraceCaptureFrames = 8;
+    static const size_t kMaxVideoFramesInFlight = 4;
+
     Sample::Sample()
     {
     }
@@ -88,6 +91,12 @@ namespace Falcor
                 {
                     initVideoCapture();
                 }
+#if _PROFILING_ENABLED
+                else if (keyEvent.mods.isShiftDown && keyEvent.key == KeyboardEvent::Key::P)
+                {
+                    captureProfilerTrace();
+                }
+#endif
                 else if (!keyEvent.mods.isAltDown && !keyEvent.mods.isCtrlDown && !keyEvent.mods.isShiftDown)
                 {
                     switch (keyEvent.key)
@@ -162,6 +171,7 @@ namespace Falcor
         mpDefaultFBO.reset();
         mpTextRenderer.reset();
         mpPixelZoom.reset();
+        mpFrameCapture.reset();
         mpRenderContext.reset();
         if(gpDevice) gpDevice->cleanup();
         gpDevice.reset();
@@ -175,7 +185,7 @@ namespace Falcor
         mVsyncOn = config.deviceDesc.enableVsync;
 
         // Start the logger
-        Logger::init();
+        Logger::init(config.binaryLog);
         Logger::showBoxOnError(config.showMessageBoxOnError);
 
         // Create the window
@@ -226,6 +236,7 @@ namespace Falcor
             initUI();
 
             mpPixelZoom = PixelZoom::create(mpDefaultFBO.get());
+            mpFrameCapture = FrameCapture::create();
         }
         else
         {
@@ -293,7 +304,8 @@ namespace Falcor
             "  'Z'       - Zoom in on a pixel\n"
             "  'MouseWheel' - Change level of zoom\n"
 #if _PROFILING_ENABLED
-            "  'P'       - Enable profiling\n";
+            "  'P'       - Enable profiling\n"
+            "  'Shift+P' - Capture a profiler trace\n";
 #else
             ;
 #endif
@@ -409,7 +421,7 @@ namespace Falcor
         if (findAvailableFilename(filename, outputDirectory, "png", pngFile))
         {
             Texture::SharedPtr pTexture = gpDevice->getSwapChainFbo()->getColorTexture(0);
-            pTexture->captureToFile(0, 0, pngFile);
+            mpFrameCapture->captureToFile(pTexture.get(), 0, 0, pngFile);
         }
         else
         {
@@ -479,11 +491,30 @@ namespace Falcor
     void Sample::printProfileData()
     {
 #if _PROFILING_ENABLED
-        if (gProfileEnabled)
+        if (gProfileEnabled || Profiler::isTraceCaptureActive())
         {
             std::string profileMsg;
             Profiler::endFrame(profileMsg);
-            renderText(profileMsg, glm::vec2(10, 300));
+            if (gProfileEnabled)
+            {
+                renderText(profileMsg, glm::vec2(10, 300));
+            }
+        }
+#endif
+    }
+
+    void Sample::captureProfilerTrace()
+    {
+#if _PROFILING_ENABLED
+        std::string traceFile;
+        if (findAvailableFilename(getExecutableName() + "_trace", getExecutableDirectory(), "json", traceFile))
+        {
+            Profiler::setTraceThreadName("Main");
+            Profiler::startTraceCapture(kTraceCaptureFrames, traceFile);
+        }
+        else
+        {
+            logError("Could not find available filename when capturing a profiler trace");
         }
 #endif
     }
@@ -536,6 +567,11 @@ namespace Falcor
     {
         if (mVideoCapture.pVideoCapture)
         {
+            for (const auto& pFrameTask : mVideoCapture.pendingFrames)
+            {
+                JobSystem::wait(pFrameTask);
+            }
+            mVideoCapture.pendingFrames.clear();
             mVideoCapture.pVideoCapture->endCapture();
             mShowUI = true;
         }
@@ -549,7 +585,19 @@ namespace Falcor
     {
         if (mVideoCapture.pVideoCapture)
         {
-            mVideoCapture.pVideoCapture->appendFrame(mpRenderContext->readTextureSubresource(mpDefaultFBO->getColorTexture(0).get(), 0).data());
+            // Bound the frames in flight, encoding may be slower than rendering
+            auto& pendingFrames = mVideoCapture.pendingFrames;
+            while (pendingFrames.size() >= kMaxVideoFramesInFlight)
+            {
+                JobSystem::wait(pendingFrames.front());
+                pendingFrames.pop_front();
+            }
+
+            // The encoder isn't thread-safe and expects the frames in order, so each frame depends on the previous one
+            auto pFrameData = std::make_shared<std::vector<uint8>>(mpRenderContext->readTextureSubresource(mpDefaultFBO->getColorTexture(0).get(), 0));
+            VideoEncoder* pEncoder = mVideoCapture.pVideoCapture.get();
+            JobSystem::TaskHandle pPrevious = pendingFrames.empty() ? nullptr : pendingFrames.back();
+            pendingFrames.push_back(JobSystem::schedule([pEncoder, pFrameData]() { pEncoder->appendFrame(pFrameData->data()); }, { pPrevious }));
 
             if (mVideoCapture.pUI->useTimeRange())
             {
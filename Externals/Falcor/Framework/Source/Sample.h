@@ -39,6 +39,9 @@
 #include "API/Device.h"
 #include "ArgList.h"
 #include "Utils/PixelZoom.h"
+#include "Utils/FrameCapture.h"
+#include "Utils/JobSystem.h"
+#include <deque>
 
 namespace Falcor
 {
@@ -63,6 +66,7 @@ namespace Falcor
         Window::Desc windowDesc;                                    ///< Controls window creation
         Device::Desc deviceDesc;                                    ///< Controls device creation;
         bool showMessageBoxOnError = _SHOW_MB_BY_DEFAULT;           ///< Show message box on framework/API errors.
+        bool binaryLog = false;                                     ///< Also write the log as binary records, see Logger::init().
         float timeScale = 1.0f;                                     ///< A scaling factor for the time elapsed between frames.
         float fixedTimeDelta = 0.0f;                                ///< If non-zero, specifies a fixed simulation time step per frame, which is further affected by time scale.
         bool freezeTimeOnStartup = false;                           ///< Control whether or not to start the clock when the sample start running.
@@ -201,6 +205,14 @@ namespace Falcor
 
         std::string captureScreen(const std::string explicitFilename = "", const std::string explicitOutputDirectory = "");
 
+        /** Capture a profiler trace of the next frames into a Chrome trace JSON file next to the executable. See Profiler::startTraceCapture().
+        */
+        void captureProfilerTrace();
+
+        /** Get the object used for asynchronous texture captures. Screen captures go through it as well.
+        */
+        FrameCapture* getFrameCapture() const { return mpFrameCapture.get(); }
+
         void toggleText(bool enabled);
         uint32_t getFrameID() const { return mFrameRate.getFrameCount(); }
     private:
@@ -224,6 +236,7 @@ namespace Falcor
             VideoEncoderUI::UniquePtr pUI;
             VideoEncoder::UniquePtr pVideoCapture;
             uint8_t* pFrame = nullptr;
+            std::deque<JobSystem::TaskHandle> pendingFrames; // Frames being encoded, in capture order
             float sampleTimeDelta; // Saves the sample's fixed time delta because video capture overwrites it while recording
         };
 
@@ -236,6 +249,7 @@ namespace Falcor
         TextRenderer::UniquePtr mpTextRenderer;
         std::set<KeyboardEvent::Key> mPressedKeys;
         PixelZoom::SharedPtr mpPixelZoom;
+        FrameCapture::UniquePtr mpFrameCapture;
         uint32_t mSampleGuiWidth = 250;
         uint32_t mSampleGuiHeight = 200;
     };
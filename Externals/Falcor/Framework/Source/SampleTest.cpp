@@ -27,6 +27,7 @@
 ***************************************************************************/
 #include "Framework.h"
 #include "SampleTest.h"
+#include "Utils/ImageMetrics.h"
 #include <algorithm>
 #include <fstream>
 
@@ -290,6 +291,12 @@ namespace Falcor
     // Write the Screen Capture Results.
     void SampleTest::writeScreenCaptureResults(rapidjson::Document & jsonTestResults)
     {
+        // Captures are encoded in the background, make sure every file was written before it is reported
+        if (getFrameCapture())
+        {
+            getFrameCapture()->flush();
+        }
+
         auto & jsonAllocator = jsonTestResults.GetAllocator();
 
         // Write the screen captured image files to the output file.
@@ -313,6 +320,7 @@ namespace Falcor
                     scfFile.SetObject();
                     scfFile.AddMember("Filename", scffilename, jsonAllocator);
                     scfFile.AddMember("Filepath", scffilepath, jsonAllocator);
+                    writeScreenCaptureMetrics(scfFile, jsonAllocator, scfTask->mCaptureFilepath, scfTask->mCaptureFilename);
 
                     scfArray.PushBack(scfFile, jsonAllocator);
                 }
@@ -342,6 +350,7 @@ namespace Falcor
                     sctFile.SetObject();
                     sctFile.AddMember("Filename", sctfilename, jsonAllocator);
                     sctFile.AddMember("Filepath", sctfilepath, jsonAllocator);
+                    writeScreenCaptureMetrics(sctFile, jsonAllocator, sctTask->mCaptureFilepath, sctTask->mCaptureFilename);
 
                     sctArray.PushBack(sctFile, jsonAllocator);
                 }
@@ -351,6 +360,30 @@ namespace Falcor
         jsonTestResults.AddMember("Time Screen Captures", sctArray, jsonAllocator);
     }
 
+    // Write the Screen Capture Metrics.
+    void SampleTest::writeScreenCaptureMetrics(rapidjson::Value& jval, rapidjson::Document::AllocatorType& jallocator, const std::string& captureFilepath, const std::string& captureFilename)
+    {
+        if (mHasSetReferenceDirectory == false)
+        {
+            return;
+        }
+
+        std::string referenceFile = mTestReferenceDirectory + "/" + captureFilename;
+        if (doesFileExist(referenceFile) == false)
+        {
+            logWarning("No reference image for screen capture " + captureFilename + " in " + mTestReferenceDirectory);
+            return;
+        }
+
+        ImageMetrics::Result result;
+        if (ImageMetrics::compareFiles(captureFilepath + "/" + captureFilename, referenceFile, ImageMetrics::Options(), result))
+        {
+            rapidjson::Value jmetrics(rapidjson::kObjectType);
+            ImageMetrics::writeJson(result, jmetrics, jallocator, false);
+            jval.AddMember("Metrics", jmetrics, jallocator);
+        }
+    }
+
     // Initialize the Tests.
     void SampleTest::initializeTests()
     {
@@ -376,6 +409,17 @@ namespace Falcor
             }
         }
 
+        // Check for a Reference Directory, captures are compared against the images in it.
+        if (mArgList.argExists("refdir"))
+        {
+            std::vector<ArgList::Arg> rdArgs = mArgList.getValues("refdir");
+            if (!rdArgs.empty())
+            {
+                mHasSetReferenceDirectory = true;
+                mTestReferenceDirectory = rdArgs[0].asString();
+            }
+        }
+
         if (mArgList.argExists("fixedtimedelta"))
         {
             std::vector<ArgList::Arg> ftdArgs = mArgList.getValues("fixedtimedelta");
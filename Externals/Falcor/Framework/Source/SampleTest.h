@@ -332,6 +332,10 @@ namespace Falcor
         */
         void writeScreenCaptureResults(rapidjson::Document & jsonTestResults);
 
+        /** Compare a screen capture with the image of the same name in the reference directory, and add the metrics to its JSON entry.
+        */
+        void writeScreenCaptureMetrics(rapidjson::Value& jval, rapidjson::Document::AllocatorType& jallocator, const std::string& captureFilepath, const std::string& captureFilename);
+
         /** Initialize the Tests.
         */
         void initializeTests();
@@ -350,6 +354,9 @@ namespace Falcor
         bool mHasSetFilename = false;
         std::string mTestOutputFilename = "";
 
+        bool mHasSetReferenceDirectory = false;
+        std::string mTestReferenceDirectory = "";
+
         // The Memory Check Between Frames.
         struct MemoryCheckRange
         {
@@ -87,7 +87,8 @@ namespace Falcor
         }
 
         uint32_t bpp = FreeImage_GetBPP(pDib);
-		bool rgb32FloatSupported = gpDevice->isRgb32FloatSupported();
+        // Without a device (headless tools) there is no upload restriction, keep the data as is
+        bool rgb32FloatSupported = gpDevice ? gpDevice->isRgb32FloatSupported() : true;
 
         switch(bpp)
         {
@@ -186,18 +187,18 @@ namespace Falcor
         return FIT_BITMAP;
     }
 
-    void Bitmap::saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, void* pData)
+    bool Bitmap::saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, void* pData)
     {
         if(pData == nullptr)
         {
             logError("Bitmap::saveImage provided no data to save.");
-            return;
+            return false;
         }
         
         if(is_set(exportFlags, ExportFlags::Uncompressed) && is_set(exportFlags, ExportFlags::Lossy))
         {
             logError("Bitmap::saveImage incompatible flags: lossy cannot be combined with uncompressed.");
-            return;
+            return false;
         }
 
         int flags = 0;
@@ -236,7 +237,7 @@ namespace Falcor
             if(is_set(exportFlags, ExportFlags::Lossy))
             {
                 logError("Bitmap::saveImage: PNG does not support lossy compression mode.");
-                return;
+                return false;
             }
         }
         else if (fileFormat == Bitmap::FileFormat::JpegFile)
@@ -252,7 +253,7 @@ namespace Falcor
             if(is_set(exportFlags, ExportFlags::ExportAlpha))
             {
                 logError("Bitmap::saveImage: JPEG does not support alpha channel.");
-                return;
+                return false;
             }
         }
         else if (fileFormat == Bitmap::FileFormat::PfmFile || fileFormat == Bitmap::FileFormat::ExrFile)
@@ -260,7 +261,7 @@ namespace Falcor
             if(bytesPerPixel != 16 && bytesPerPixel != 12)
             {
                 logError("Bitmap::saveImage supports only 32-bit/channel RGB/RGBA images as PFM/EXR files.");
-                return;
+                return false;
             }
 
             const bool exportAlpha = is_set(exportFlags, ExportFlags::ExportAlpha);
@@ -270,19 +271,19 @@ namespace Falcor
                 if (is_set(exportFlags, ExportFlags::Lossy))
                 {
                     logError("Bitmap::saveImage: PFM does not support lossy compression mode.");
-                    return;
+                    return false;
                 }
                 if (exportAlpha)
                 {
                     logError("Bitmap::saveImage: PFM does not support alpha channel.");
-                    return;
+                    return false;
                 }
             }
 
             if (exportAlpha && bytesPerPixel != 16)
             {
                 logError("Bitmap::saveImage requesting to export alpha-channel to EXR file, but the resource doesn't have an alpha-channel");
-                return;
+                return false;
             }
 
             // Upload the image manually and flip it vertically
@@ -324,7 +325,12 @@ namespace Falcor
             }
         }
 
-        FreeImage_Save(toFreeImageFormat(fileFormat), pImage, filename.c_str(), flags);
+        bool saved = FreeImage_Save(toFreeImageFormat(fileFormat), pImage, filename.c_str(), flags) != FALSE;
         FreeImage_Unload(pImage);
+        if(saved == false)
+        {
+            logError("Bitmap::saveImage failed to write '" + filename + "'");
+        }
+        return saved;
     }
 }
\ No newline at end of file
@@ -70,8 +70,9 @@ namespace Falcor
             \param[in] ResourceFormat the format of the resource data
             \param[in] isTopDown Control the memory layout of the image. If true, the top-left pixel will be stored first, otherwise the bottom-left pixel will be stored first
             \param[in] pData Pointer to the buffer containing the image
+            \return true if the file was written
         */
-        static void saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, void* pData);
+        static bool saveImage(const std::string& filename, uint32_t width, uint32_t height, FileFormat fileFormat, ExportFlags exportFlags, ResourceFormat resourceFormat, bool isTopDown, void* pData);
 
         ~Bitmap();
 
@@ -0,0 +1,90 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "FrameCapture.h"
+#include "API/Device.h"
+#include "Utils/Platform/OS.h"
+#include "Utils/JobSystem.h"
+
+namespace Falcor
+{
+    FrameCapture::UniquePtr FrameCapture::create(uint32_t ringSize)
+    {
+        return UniquePtr(new FrameCapture(std::max(ringSize, 1u)));
+    }
+
+    FrameCapture::~FrameCapture()
+    {
+        flush();
+    }
+
+    FrameCapture::Future FrameCapture::captureToFile(const Texture* pTexture, uint32_t mipLevel, uint32_t arraySlice, const std::string& filename,
+                                                     Bitmap::FileFormat format, Bitmap::ExportFlags exportFlags, CompletionCallback callback)
+    {
+        Slot& slot = mRing[mNextSlot];
+        mNextSlot = (mNextSlot + 1) % (uint32_t)mRing.size();
+
+        // Reusing a slot waits for its previous capture. This bounds the readback memory in flight, and makes sure the task is released on this thread.
+        if (slot.result.valid())
+        {
+            slot.result.wait();
+        }
+        slot.pTask = gpDevice->getRenderContext()->asyncReadTextureSubresource(pTexture, pTexture->getSubresourceIndex(arraySlice, mipLevel));
+
+        // The slot keeps the task alive until the result was waited for
+        CopyContext::ReadTextureTask* pTask = slot.pTask.get();
+        const uint32_t width = pTexture->getWidth(mipLevel);
+        const uint32_t height = pTexture->getHeight(mipLevel);
+        const ResourceFormat resourceFormat = pTexture->getFormat();
+
+        slot.result = JobSystem::async([=]()
+        {
+            std::vector<uint8> data = pTask->getData();
+            const bool success = Bitmap::saveImage(filename, width, height, format, exportFlags, resourceFormat, true, data.data());
+            if (callback)
+            {
+                callback(filename, success);
+            }
+            return success;
+        }).share();
+
+        return slot.result;
+    }
+
+    void FrameCapture::flush()
+    {
+        for (auto& slot : mRing)
+        {
+            if (slot.result.valid())
+            {
+                slot.result.wait();
+            }
+            slot.pTask = nullptr;
+        }
+    }
+}
@@ -0,0 +1,93 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Framework.h"
+#include "API/Texture.h"
+#include "API/CopyContext.h"
+#include "Utils/Bitmap.h"
+#include <functional>
+#include <future>
+
+namespace Falcor
+{
+    /** Captures textures to image files without stalling the CPU.
+        The readback is recorded into the render context and the file is encoded by Bitmap::saveImage on a JobSystem worker once the GPU finished the copy.
+        Each capture returns a future which becomes ready exactly when the file was written.
+    */
+    class FrameCapture
+    {
+    public:
+        using UniquePtr = std::unique_ptr<FrameCapture>;
+        using Future = std::shared_future<bool>;
+
+        /** Called on the worker thread once a capture completed
+            \param[in] filename The file the capture was written to
+            \param[in] success Whether the file was written
+        */
+        using CompletionCallback = std::function<void(const std::string& filename, bool success)>;
+
+        /** Create a new object
+            \param[in] ringSize Maximum number of captures in flight. Once all slots are used, a new capture waits for the oldest one to complete.
+        */
+        static UniquePtr create(uint32_t ringSize = 4);
+
+        /** Waits for all pending captures
+        */
+        ~FrameCapture();
+
+        /** Capture a texture subresource to a file
+            \param[in] pTexture The texture to capture. Only the GPU copy is recorded during this call, the texture can be modified afterwards.
+            \param[in] mipLevel Mip-level to capture
+            \param[in] arraySlice Array slice to capture
+            \param[in] filename Destination file
+            \param[in] format Destination file format
+            \param[in] exportFlags Flags passed to Bitmap::saveImage
+            \param[in] callback Optional callback invoked once the file was written
+            \return A future holding true if the file was written
+        */
+        Future captureToFile(const Texture* pTexture, uint32_t mipLevel, uint32_t arraySlice, const std::string& filename,
+                             Bitmap::FileFormat format = Bitmap::FileFormat::PngFile, Bitmap::ExportFlags exportFlags = Bitmap::ExportFlags::None,
+                             CompletionCallback callback = nullptr);
+
+        /** Wait for all pending captures to complete
+        */
+        void flush();
+
+    private:
+        FrameCapture(uint32_t ringSize) : mRing(ringSize) {}
+
+        struct Slot
+        {
+            CopyContext::ReadTextureTask::SharedPtr pTask;
+            Future result;
+        };
+
+        std::vector<Slot> mRing;
+        uint32_t mNextSlot = 0;
+    };
+}
@@ -0,0 +1,602 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ImageMetrics.h"
+#include "Utils/ParallelFor.h"
+#include "Utils/Platform/OS.h"
+#include "Externals/RapidJson/include/rapidjson/stringbuffer.h"
+#include "Externals/RapidJson/include/rapidjson/prettywriter.h"
+#include "glm/gtc/packing.hpp"
+#include <emmintrin.h>
+#include <cmath>
+#include <fstream>
+
+namespace Falcor
+{
+    namespace
+    {
+        // SSIM is evaluated on non-overlapping windows of this size
+        const uint32_t kSsimWindowSize = 8;
+        const float kSsimC1 = 0.01f * 0.01f;
+        const float kSsimC2 = 0.03f * 0.03f;
+
+        // FLIP error redistribution parameters
+        const float kFlipQc = 0.7f;
+        const float kFlipPc = 0.4f;
+        const float kFlipPt = 0.95f;
+
+        struct ImagePlanes
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<float> rgb[3];      // Linear color, one plane per channel
+            std::vector<float> luma;        // sRGB-encoded display luminance, used for SSIM
+        };
+
+        // Per-tile sums, reduced in tile order so the global result doesn't depend on scheduling
+        struct TileSums
+        {
+            double squaredError = 0;
+            double relativeError = 0;
+            double ssim = 0;
+            double flip = 0;
+            uint32_t ssimWindowCount = 0;
+            float maxFlip = 0;
+        };
+
+        float srgbToLinear(float v)
+        {
+            return (v <= 0.04045f) ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+        }
+
+        float linearToSrgb(float v)
+        {
+            return (v <= 0.0031308f) ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+        }
+
+        float luminance(const glm::vec3& c)
+        {
+            return glm::dot(c, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+        }
+
+        glm::vec3 linearRgbToLab(const glm::vec3& c)
+        {
+            // sRGB primaries, D65 white
+            glm::vec3 xyz;
+            xyz.x = (0.4124564f * c.r + 0.3575761f * c.g + 0.1804375f * c.b) / 0.95047f;
+            xyz.y = (0.2126729f * c.r + 0.7151522f * c.g + 0.0721750f * c.b);
+            xyz.z = (0.0193339f * c.r + 0.1191920f * c.g + 0.9503041f * c.b) / 1.08883f;
+
+            const float delta = 6.0f / 29.0f;
+            auto f = [delta](float t)
+            {
+                return (t > delta * delta * delta) ? std::cbrt(t) : t / (3.0f * delta * delta) + 4.0f / 29.0f;
+            };
+            const glm::vec3 fxyz(f(xyz.x), f(xyz.y), f(xyz.z));
+            return glm::vec3(116.0f * fxyz.y - 16.0f, 500.0f * (fxyz.x - fxyz.y), 200.0f * (fxyz.y - fxyz.z));
+        }
+
+        float hyab(const glm::vec3& lab0, const glm::vec3& lab1)
+        {
+            const glm::vec3 d = lab0 - lab1;
+            return std::abs(d.x) + std::sqrt(d.y * d.y + d.z * d.z);
+        }
+
+        // The largest color difference FLIP expects, between pure green and pure blue
+        float getFlipMaxError()
+        {
+            static const float cmax = std::pow(hyab(linearRgbToLab(glm::vec3(0, 1, 0)), linearRgbToLab(glm::vec3(0, 0, 1))), kFlipQc);
+            return cmax;
+        }
+
+        // Compress the HyAB difference and remap it so small differences use most of the [0, 1] range
+        float flipColorError(const glm::vec3& test, const glm::vec3& reference)
+        {
+            const float cmax = getFlipMaxError();
+            const float e = std::pow(hyab(linearRgbToLab(test), linearRgbToLab(reference)), kFlipQc);
+            const float threshold = kFlipPc * cmax;
+            const float error = (e < threshold) ? (kFlipPt / threshold) * e : kFlipPt + ((e - threshold) / (cmax - threshold)) * (1.0f - kFlipPt);
+            return std::min(error, 1.0f);
+        }
+
+        float horizontalSum(__m128 v)
+        {
+            __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+            __m128 sums = _mm_add_ps(v, shuf);
+            shuf = _mm_movehl_ps(shuf, sums);
+            sums = _mm_add_ss(sums, shuf);
+            return _mm_cvtss_f32(sums);
+        }
+
+        void accumulateError(const float* pTest, const float* pRef, uint32_t count, float epsilon, double& squaredError, double& relativeError)
+        {
+            __m128 sq = _mm_setzero_ps();
+            __m128 rel = _mm_setzero_ps();
+            const __m128 eps = _mm_set1_ps(epsilon);
+
+            uint32_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m128 t = _mm_loadu_ps(pTest + i);
+                const __m128 r = _mm_loadu_ps(pRef + i);
+                const __m128 d = _mm_sub_ps(t, r);
+                const __m128 d2 = _mm_mul_ps(d, d);
+                sq = _mm_add_ps(sq, d2);
+                rel = _mm_add_ps(rel, _mm_div_ps(d2, _mm_add_ps(_mm_mul_ps(r, r), eps)));
+            }
+
+            float sqSum = horizontalSum(sq);
+            float relSum = horizontalSum(rel);
+            for (; i < count; ++i)
+            {
+                const float d = pTest[i] - pRef[i];
+                sqSum += d * d;
+                relSum += d * d / (pRef[i] * pRef[i] + epsilon);
+            }
+
+            squaredError += sqSum;
+            relativeError += relSum;
+        }
+
+        struct Moments
+        {
+            float x = 0, y = 0, xx = 0, yy = 0, xy = 0;
+        };
+
+        void accumulateMoments(const float* pX, const float* pY, uint32_t count, Moments& m)
+        {
+            __m128 sx = _mm_setzero_ps();
+            __m128 sy = _mm_setzero_ps();
+            __m128 sxx = _mm_setzero_ps();
+            __m128 syy = _mm_setzero_ps();
+            __m128 sxy = _mm_setzero_ps();
+
+            uint32_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m128 x = _mm_loadu_ps(pX + i);
+                const __m128 y = _mm_loadu_ps(pY + i);
+                sx = _mm_add_ps(sx, x);
+                sy = _mm_add_ps(sy, y);
+                sxx = _mm_add_ps(sxx, _mm_mul_ps(x, x));
+                syy = _mm_add_ps(syy, _mm_mul_ps(y, y));
+                sxy = _mm_add_ps(sxy, _mm_mul_ps(x, y));
+            }
+
+            m.x += horizontalSum(sx);
+            m.y += horizontalSum(sy);
+            m.xx += horizontalSum(sxx);
+            m.yy += horizontalSum(syy);
+            m.xy += horizontalSum(sxy);
+            for (; i < count; ++i)
+            {
+                m.x += pX[i];
+                m.y += pY[i];
+                m.xx += pX[i] * pX[i];
+                m.yy += pY[i] * pY[i];
+                m.xy += pX[i] * pY[i];
+            }
+        }
+
+        float ssimFromMoments(const Moments& m, uint32_t count)
+        {
+            const float n = (float)count;
+            const float mx = m.x / n;
+            const float my = m.y / n;
+            const float vx = std::max(m.xx / n - mx * mx, 0.0f);
+            const float vy = std::max(m.yy / n - my * my, 0.0f);
+            const float cxy = m.xy / n - mx * my;
+            return ((2 * mx * my + kSsimC1) * (2 * cxy + kSsimC2)) / ((mx * mx + my * my + kSsimC1) * (vx + vy + kSsimC2));
+        }
+
+        template<typename ReadFunc>
+        void convertPixels(const Bitmap* pBitmap, uint32_t bytesPerPixel, bool decodeSrgb, float exposureScale, ImagePlanes& planes, ReadFunc read)
+        {
+            const uint32_t width = planes.width;
+            parallelFor(0, planes.height, [&](size_t y)
+            {
+                const uint8_t* pRow = pBitmap->getData() + y * width * bytesPerPixel;
+                const size_t offset = y * width;
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    glm::vec3 c = read(pRow + x * bytesPerPixel);
+                    if (decodeSrgb)
+                    {
+                        c = glm::vec3(srgbToLinear(c.r), srgbToLinear(c.g), srgbToLinear(c.b));
+                    }
+                    planes.rgb[0][offset + x] = c.r;
+                    planes.rgb[1][offset + x] = c.g;
+                    planes.rgb[2][offset + x] = c.b;
+                    planes.luma[offset + x] = linearToSrgb(glm::clamp(luminance(c) * exposureScale, 0.0f, 1.0f));
+                }
+            });
+        }
+
+        bool loadPlanes(const Bitmap* pBitmap, const ImageMetrics::Options& options, ImagePlanes& planes)
+        {
+            planes.width = pBitmap->getWidth();
+            planes.height = pBitmap->getHeight();
+            const size_t pixelCount = (size_t)planes.width * planes.height;
+            for (auto& c : planes.rgb)
+            {
+                c.resize(pixelCount);
+            }
+            planes.luma.resize(pixelCount);
+
+            const float scale = std::exp2(options.exposure);
+            const bool decodeSrgb = options.ldrIsSrgb;
+            const float kUnorm = 1.0f / 255.0f;
+
+            switch (pBitmap->getFormat())
+            {
+            case ResourceFormat::RGBA32Float:
+            case ResourceFormat::RGB32Float:
+                convertPixels(pBitmap, getFormatBytesPerBlock(pBitmap->getFormat()), false, scale, planes, [](const uint8_t* p)
+                {
+                    const float* f = (const float*)p;
+                    return glm::vec3(f[0], f[1], f[2]);
+                });
+                break;
+            case ResourceFormat::RGBA16Float:
+            case ResourceFormat::RGB16Float:
+                convertPixels(pBitmap, getFormatBytesPerBlock(pBitmap->getFormat()), false, scale, planes, [](const uint8_t* p)
+                {
+                    const uint16_t* h = (const uint16_t*)p;
+                    return glm::vec3(glm::unpackHalf1x16(h[0]), glm::unpackHalf1x16(h[1]), glm::unpackHalf1x16(h[2]));
+                });
+                break;
+            case ResourceFormat::BGRA8Unorm:
+                convertPixels(pBitmap, 4, decodeSrgb, scale, planes, [kUnorm](const uint8_t* p)
+                {
+                    return glm::vec3(p[2], p[1], p[0]) * kUnorm;
+                });
+                break;
+            case ResourceFormat::RG8Unorm:
+                convertPixels(pBitmap, 2, decodeSrgb, scale, planes, [kUnorm](const uint8_t* p)
+                {
+                    return glm::vec3(p[0], p[1], 0) * kUnorm;
+                });
+                break;
+            case ResourceFormat::R8Unorm:
+                convertPixels(pBitmap, 1, decodeSrgb, scale, planes, [kUnorm](const uint8_t* p)
+                {
+                    return glm::vec3(p[0] * kUnorm);
+                });
+                break;
+            default:
+                logError("ImageMetrics: unsupported bitmap format " + to_string(pBitmap->getFormat()));
+                return false;
+            }
+            return true;
+        }
+
+        void computeTile(const ImagePlanes& test, const ImagePlanes& ref, const ImageMetrics::Options& options, float exposureScale, ImageMetrics::TileResult& tile, TileSums& sums)
+        {
+            const uint32_t width = test.width;
+
+            for (uint32_t y = tile.y; y < tile.y + tile.height; ++y)
+            {
+                const size_t offset = (size_t)y * width + tile.x;
+                for (uint32_t c = 0; c < 3; ++c)
+                {
+                    accumulateError(test.rgb[c].data() + offset, ref.rgb[c].data() + offset, tile.width, options.relMseEpsilon, sums.squaredError, sums.relativeError);
+                }
+
+                for (uint32_t x = 0; x < tile.width; ++x)
+                {
+                    const size_t i = offset + x;
+                    const glm::vec3 t = glm::clamp(glm::vec3(test.rgb[0][i], test.rgb[1][i], test.rgb[2][i]) * exposureScale, 0.0f, 1.0f);
+                    const glm::vec3 r = glm::clamp(glm::vec3(ref.rgb[0][i], ref.rgb[1][i], ref.rgb[2][i]) * exposureScale, 0.0f, 1.0f);
+                    const float flip = flipColorError(t, r);
+                    sums.flip += flip;
+                    sums.maxFlip = std::max(sums.maxFlip, flip);
+                }
+            }
+
+            // Tiles start at multiples of the window size, so windows never straddle two tiles
+            for (uint32_t wy = tile.y; wy < tile.y + tile.height; wy += kSsimWindowSize)
+            {
+                const uint32_t windowHeight = std::min(kSsimWindowSize, tile.y + tile.height - wy);
+                for (uint32_t wx = tile.x; wx < tile.x + tile.width; wx += kSsimWindowSize)
+                {
+                    const uint32_t windowWidth = std::min(kSsimWindowSize, tile.x + tile.width - wx);
+                    Moments m;
+                    for (uint32_t y = wy; y < wy + windowHeight; ++y)
+                    {
+                        const size_t offset = (size_t)y * width + wx;
+                        accumulateMoments(test.luma.data() + offset, ref.luma.data() + offset, windowWidth, m);
+                    }
+                    sums.ssim += ssimFromMoments(m, windowWidth * windowHeight);
+                    sums.ssimWindowCount++;
+                }
+            }
+
+            const double sampleCount = 3.0 * tile.width * tile.height;
+            tile.rmse = (float)std::sqrt(sums.squaredError / sampleCount);
+            tile.relMse = (float)(sums.relativeError / sampleCount);
+            tile.ssim = (float)(sums.ssim / sums.ssimWindowCount);
+            tile.flip = (float)(sums.flip / (tile.width * tile.height));
+        }
+
+        // Piecewise-linear black-purple-red-yellow-white ramp
+        glm::vec3 heatmapColor(float v)
+        {
+            static const glm::vec3 kRamp[] =
+            {
+                glm::vec3(0.0f, 0.0f, 0.0f),
+                glm::vec3(0.4f, 0.0f, 0.6f),
+                glm::vec3(0.9f, 0.1f, 0.1f),
+                glm::vec3(1.0f, 0.9f, 0.0f),
+                glm::vec3(1.0f, 1.0f, 1.0f),
+            };
+            const uint32_t segmentCount = (uint32_t)arraysize(kRamp) - 1;
+            const float s = glm::clamp(v, 0.0f, 1.0f) * segmentCount;
+            const uint32_t i = std::min((uint32_t)s, segmentCount - 1);
+            return glm::mix(kRamp[i], kRamp[i + 1], s - i);
+        }
+
+        void addUint(rapidjson::Value& jval, rapidjson::Document::AllocatorType& jallocator, const char* key, uint32_t value)
+        {
+            rapidjson::Value jvalue(value);
+            jval.AddMember(rapidjson::StringRef(key), jvalue, jallocator);
+        }
+
+        void addFloat(rapidjson::Value& jval, rapidjson::Document::AllocatorType& jallocator, const char* key, float value)
+        {
+            rapidjson::Value jvalue((double)value);
+            jval.AddMember(rapidjson::StringRef(key), jvalue, jallocator);
+        }
+    }
+
+    float ImageMetrics::Result::getValue(Metric metric) const
+    {
+        switch (metric)
+        {
+        case Metric::Rmse:
+            return rmse;
+        case Metric::RelMse:
+            return relMse;
+        case Metric::Ssim:
+            return ssim;
+        case Metric::Flip:
+            return flip;
+        default:
+            should_not_get_here();
+            return 0;
+        }
+    }
+
+    const char* ImageMetrics::getMetricName(Metric metric)
+    {
+        switch (metric)
+        {
+        case Metric::Rmse:
+            return "RMSE";
+        case Metric::RelMse:
+            return "RelMSE";
+        case Metric::Ssim:
+            return "SSIM";
+        case Metric::Flip:
+            return "FLIP";
+        default:
+            should_not_get_here();
+            return "";
+        }
+    }
+
+    bool ImageMetrics::compare(const Bitmap* pTest, const Bitmap* pReference, const Options& options, Result& result)
+    {
+        if (pTest == nullptr || pReference == nullptr)
+        {
+            logError("ImageMetrics::compare() - missing image");
+            return false;
+        }
+
+        if (pTest->getWidth() != pReference->getWidth() || pTest->getHeight() != pReference->getHeight())
+        {
+            logError("ImageMetrics::compare() - image dimensions don't match (" + std::to_string(pTest->getWidth()) + "x" + std::to_string(pTest->getHeight()) + " vs " +
+                std::to_string(pReference->getWidth()) + "x" + std::to_string(pReference->getHeight()) + ")");
+            return false;
+        }
+
+        ImagePlanes test, ref;
+        if (loadPlanes(pTest, options, test) == false || loadPlanes(pReference, options, ref) == false)
+        {
+            return false;
+        }
+
+        const uint32_t tileSize = std::max((options.tileSize + kSsimWindowSize - 1) / kSsimWindowSize, 1u) * kSsimWindowSize;
+        result = Result();
+        result.width = test.width;
+        result.height = test.height;
+        result.tileSize = tileSize;
+        result.tileCountX = (test.width + tileSize - 1) / tileSize;
+        result.tileCountY = (test.height + tileSize - 1) / tileSize;
+
+        const size_t tileCount = (size_t)result.tileCountX * result.tileCountY;
+        result.tiles.resize(tileCount);
+        std::vector<TileSums> sums(tileCount);
+
+        const float exposureScale = std::exp2(options.exposure);
+        parallelFor(0, tileCount, [&](size_t i)
+        {
+            TileResult& tile = result.tiles[i];
+            tile.x = (uint32_t)(i % result.tileCountX) * tileSize;
+            tile.y = (uint32_t)(i / result.tileCountX) * tileSize;
+            tile.width = std::min(tileSize, test.width - tile.x);
+            tile.height = std::min(tileSize, test.height - tile.y);
+            computeTile(test, ref, options, exposureScale, tile, sums[i]);
+        });
+
+        TileSums total;
+        for (const auto& s : sums)
+        {
+            total.squaredError += s.squaredError;
+            total.relativeError += s.relativeError;
+            total.ssim += s.ssim;
+            total.ssimWindowCount += s.ssimWindowCount;
+            total.flip += s.flip;
+            total.maxFlip = std::max(total.maxFlip, s.maxFlip);
+        }
+
+        const double pixelCount = (double)test.width * test.height;
+        result.rmse = (float)std::sqrt(total.squaredError / (3.0 * pixelCount));
+        result.relMse = (float)(total.relativeError / (3.0 * pixelCount));
+        result.ssim = (float)(total.ssim / total.ssimWindowCount);
+        result.flip = (float)(total.flip / pixelCount);
+        result.maxFlip = total.maxFlip;
+        return true;
+    }
+
+    bool ImageMetrics::compareFiles(const std::string& testFile, const std::string& referenceFile, const Options& options, Result& result)
+    {
+        Bitmap::UniqueConstPtr pTest = Bitmap::createFromFile(testFile, true);
+        Bitmap::UniqueConstPtr pReference = Bitmap::createFromFile(referenceFile, true);
+        if (pTest == nullptr || pReference == nullptr)
+        {
+            return false;
+        }
+        return compare(pTest.get(), pReference.get(), options, result);
+    }
+
+    void ImageMetrics::writeJson(const Result& result, rapidjson::Value& jval, rapidjson::Document::AllocatorType& jallocator, bool writeTiles)
+    {
+        addUint(jval, jallocator, "Width", result.width);
+        addUint(jval, jallocator, "Height", result.height);
+        addFloat(jval, jallocator, "RMSE", result.rmse);
+        addFloat(jval, jallocator, "RelMSE", result.relMse);
+        addFloat(jval, jallocator, "SSIM", result.ssim);
+        addFloat(jval, jallocator, "FLIP", result.flip);
+        addFloat(jval, jallocator, "Max FLIP", result.maxFlip);
+
+        if (writeTiles)
+        {
+            addUint(jval, jallocator, "Tile Size", result.tileSize);
+            addUint(jval, jallocator, "Tile Count X", result.tileCountX);
+            addUint(jval, jallocator, "Tile Count Y", result.tileCountY);
+
+            rapidjson::Value jtiles(rapidjson::kArrayType);
+            for (const auto& tile : result.tiles)
+            {
+                rapidjson::Value jtile(rapidjson::kObjectType);
+                addUint(jtile, jallocator, "X", tile.x);
+                addUint(jtile, jallocator, "Y", tile.y);
+                addUint(jtile, jallocator, "Width", tile.width);
+                addUint(jtile, jallocator, "Height", tile.height);
+                addFloat(jtile, jallocator, "RMSE", tile.rmse);
+                addFloat(jtile, jallocator, "RelMSE", tile.relMse);
+                addFloat(jtile, jallocator, "SSIM", tile.ssim);
+                addFloat(jtile, jallocator, "FLIP", tile.flip);
+                jtiles.PushBack(jtile, jallocator);
+            }
+            jval.AddMember("Tiles", jtiles, jallocator);
+        }
+    }
+
+    bool ImageMetrics::saveJson(const std::string& filename, const Result& result, bool writeTiles)
+    {
+        rapidjson::Document jdoc;
+        jdoc.SetObject();
+        writeJson(result, jdoc, jdoc.GetAllocator(), writeTiles);
+
+        rapidjson::StringBuffer buffer;
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+        writer.SetIndent(' ', 4);
+        jdoc.Accept(writer);
+
+        std::ofstream outputStream(filename.c_str());
+        if (outputStream.fail())
+        {
+            logError("ImageMetrics::saveJson() - cannot write to " + filename);
+            return false;
+        }
+        outputStream.write(buffer.GetString(), buffer.GetSize());
+        return outputStream.good();
+    }
+
+    bool ImageMetrics::saveHeatmap(const std::string& filename, const Result& result, Metric metric)
+    {
+        if (result.tiles.empty())
+        {
+            logError("ImageMetrics::saveHeatmap() - result is empty");
+            return false;
+        }
+
+        // Map every tile to [0, 1], where 1 is the worst
+        std::vector<float> values(result.tiles.size());
+        float maxValue = 0;
+        for (size_t i = 0; i < result.tiles.size(); ++i)
+        {
+            const TileResult& tile = result.tiles[i];
+            switch (metric)
+            {
+            case Metric::Rmse:
+                values[i] = tile.rmse;
+                break;
+            case Metric::RelMse:
+                values[i] = tile.relMse;
+                break;
+            case Metric::Ssim:
+                values[i] = 1.0f - tile.ssim;
+                break;
+            case Metric::Flip:
+                values[i] = tile.flip;
+                break;
+            default:
+                should_not_get_here();
+            }
+            maxValue = std::max(maxValue, values[i]);
+        }
+
+        if ((metric == Metric::Rmse || metric == Metric::RelMse) && maxValue > 0)
+        {
+            for (auto& v : values)
+            {
+                v /= maxValue;
+            }
+        }
+
+        // BGRA, which is the byte order Bitmap::saveImage() expects for PNGs
+        std::vector<uint8_t> pixels((size_t)result.width * result.height * 4);
+        parallelFor(0, result.height, [&](size_t y)
+        {
+            const uint32_t tileY = (uint32_t)y / result.tileSize;
+            for (uint32_t x = 0; x < result.width; ++x)
+            {
+                const glm::vec3 c = heatmapColor(values[tileY * result.tileCountX + x / result.tileSize]);
+                uint8_t* p = &pixels[(y * result.width + x) * 4];
+                p[0] = (uint8_t)(c.b * 255.0f + 0.5f);
+                p[1] = (uint8_t)(c.g * 255.0f + 0.5f);
+                p[2] = (uint8_t)(c.r * 255.0f + 0.5f);
+                p[3] = 0xff;
+            }
+        });
+
+        return Bitmap::saveImage(filename, result.width, result.height, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::None, ResourceFormat::BGRA8Unorm, true, pixels.data());
+    }
+}
@@ -0,0 +1,122 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Framework.h"
+#include "Utils/Bitmap.h"
+#include "Externals/RapidJson/include/rapidjson/document.h"
+#include <vector>
+
+namespace Falcor
+{
+    /** CPU image comparison for regression tests.
+        Computes RMSE, relMSE, SSIM and a FLIP-style perceptual error between a test and a reference image, globally and per screen tile.
+        Tiles are processed in parallel and the inner loops use SSE, so no device or window is required.
+    */
+    class ImageMetrics
+    {
+    public:
+        enum class Metric
+        {
+            Rmse,       ///< Root mean squared error over all color channels
+            RelMse,     ///< Squared error relative to the squared reference value
+            Ssim,       ///< Structural similarity of the display luminance, 1 means identical
+            Flip,       ///< FLIP-style color difference of the display values, in [0, 1]
+        };
+
+        struct Options
+        {
+            uint32_t tileSize = 32;         ///< Edge length of the heatmap tiles in pixels. Rounded up to a multiple of the 8x8 SSIM window.
+            float relMseEpsilon = 1e-2f;    ///< Added to the squared reference value to avoid dividing by zero in dark regions
+            float exposure = 0.0f;          ///< Exposure in stops applied before clamping to [0, 1] for the display-referred metrics (SSIM and FLIP)
+            bool ldrIsSrgb = true;          ///< Decode 8-bit images from sRGB, so they are compared in the same linear space as HDR images
+        };
+
+        struct TileResult
+        {
+            uint32_t x = 0;
+            uint32_t y = 0;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            float rmse = 0;
+            float relMse = 0;
+            float ssim = 1;
+            float flip = 0;
+        };
+
+        struct Result
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t tileSize = 0;
+            uint32_t tileCountX = 0;
+            uint32_t tileCountY = 0;
+            float rmse = 0;
+            float relMse = 0;
+            float ssim = 1;
+            float flip = 0;
+            float maxFlip = 0;
+            std::vector<TileResult> tiles;  ///< Row-major, tileCountX * tileCountY entries
+
+            float getValue(Metric metric) const;
+        };
+
+        /** Compare two images
+            \param[in] pTest The image under test
+            \param[in] pReference The reference image. Must have the same dimensions as pTest.
+            \param[in] options Comparison options
+            \param[out] result The metrics
+            \return false if the images can't be compared, otherwise true
+        */
+        static bool compare(const Bitmap* pTest, const Bitmap* pReference, const Options& options, Result& result);
+
+        /** Load two images with Bitmap::createFromFile() and compare them
+        */
+        static bool compareFiles(const std::string& testFile, const std::string& referenceFile, const Options& options, Result& result);
+
+        /** Add the metrics as members of a JSON object
+            \param[in] result The comparison result
+            \param[in] jval JSON object to add the members to
+            \param[in] jallocator The document's allocator
+            \param[in] writeTiles Also write the per-tile values
+        */
+        static void writeJson(const Result& result, rapidjson::Value& jval, rapidjson::Document::AllocatorType& jallocator, bool writeTiles);
+
+        /** Write the metrics to a JSON file
+        */
+        static bool saveJson(const std::string& filename, const Result& result, bool writeTiles);
+
+        /** Save a per-tile heatmap of a metric as a PNG with the resolution of the compared images.
+            Values are normalized to the largest tile error, or to [0, 1] for SSIM and FLIP.
+        */
+        static bool saveHeatmap(const std::string& filename, const Result& result, Metric metric);
+
+        /** Get the name of a metric as used in the JSON output
+        */
+        static const char* getMetricName(Metric metric);
+    };
+}
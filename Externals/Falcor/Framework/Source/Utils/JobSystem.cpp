@@ -0,0 +1,351 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Utils/JobSystem.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace Falcor
+{
+    class JobSystem::Task
+    {
+    public:
+        Job job;
+        std::atomic<uint32_t> pendingDependencies;
+
+        // Guards the continuations and the done flag, so a task scheduled with this one as a dependency either sees it done or gets released by it
+        std::mutex mutex;
+        std::vector<TaskHandle> continuations;
+        std::atomic<bool> done;
+
+        Task(Job j) : job(std::move(j)), pendingDependencies(1), done(false) {}
+    };
+
+    namespace
+    {
+        struct WorkQueue
+        {
+            std::mutex mutex;
+            std::deque<JobSystem::TaskHandle> tasks;
+        };
+
+        // Times a thread waiting in runUntil() yields without finding a task before it goes to sleep
+        const uint32_t kIdleSpinCount = 64;
+
+        // Index of the worker owning the thread, or -1 for threads the scheduler doesn't own
+        thread_local int32_t tWorkerIndex = -1;
+
+        class Scheduler
+        {
+        public:
+            Scheduler()
+            {
+                // Workers name their trace track. Touching the profiler first makes its trace state outlive the scheduler, the workers use it until they exit.
+                Profiler::isTraceCaptureActive();
+
+                const uint32_t coreCount = std::max(1u, std::thread::hardware_concurrency());
+                mWorkerCount = std::max(1u, coreCount - 1);
+
+                // One deque per worker, the last queue receives the tasks scheduled by other threads
+                mQueues = std::vector<WorkQueue>(mWorkerCount + 1);
+                for (uint32_t i = 0; i < mWorkerCount; i++)
+                {
+                    mThreads.emplace_back(&Scheduler::workerLoop, this, i);
+                }
+            }
+
+            ~Scheduler()
+            {
+                // Workers drain the queues before exiting, fire-and-forget tasks such as file writes still complete
+                {
+                    std::lock_guard<std::mutex> lock(mWakeMutex);
+                    mStop = true;
+                }
+                mWakeCondition.notify_all();
+                for (auto& t : mThreads)
+                {
+                    t.join();
+                }
+            }
+
+            uint32_t getWorkerCount() const { return mWorkerCount; }
+
+            void push(JobSystem::TaskHandle pTask)
+            {
+                const uint32_t queueIndex = tWorkerIndex >= 0 ? (uint32_t)tWorkerIndex : mWorkerCount;
+                {
+                    WorkQueue& queue = mQueues[queueIndex];
+                    std::lock_guard<std::mutex> lock(queue.mutex);
+                    queue.tasks.push_back(std::move(pTask));
+                }
+
+                // Taking the lock orders the increment with a worker checking the count before going to sleep
+                {
+                    std::lock_guard<std::mutex> lock(mWakeMutex);
+                    mQueuedTasks.fetch_add(1, std::memory_order_relaxed);
+                }
+                mWakeCondition.notify_one();
+
+                // A waiting thread registers under the same lock, so it either sees the count or is already counted here
+                if (mWaitingThreads.load(std::memory_order_relaxed) > 0)
+                {
+                    mWaiterCondition.notify_all();
+                }
+            }
+
+            bool runPendingTask()
+            {
+                JobSystem::TaskHandle pTask = pop();
+                if (pTask == nullptr)
+                {
+                    return false;
+                }
+                execute(pTask);
+                return true;
+            }
+
+            void execute(const JobSystem::TaskHandle& pTask)
+            {
+                pTask->job();
+                pTask->job = nullptr;
+
+                std::vector<JobSystem::TaskHandle> continuations;
+                {
+                    std::lock_guard<std::mutex> lock(pTask->mutex);
+                    pTask->done.store(true, std::memory_order_release);
+                    continuations.swap(pTask->continuations);
+                }
+
+                for (auto& pNext : continuations)
+                {
+                    release(pNext);
+                }
+
+                // The completed task may be what a thread blocked in waitForProgress() waits for. Pairs with the fence there, so either the
+                // waiter sees the task's effects when checking its condition or it is counted here.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (mWaitingThreads.load(std::memory_order_relaxed) > 0)
+                {
+                    // Taking the lock makes sure the waiter is either before its check or asleep
+                    {
+                        std::lock_guard<std::mutex> lock(mWakeMutex);
+                    }
+                    mWaiterCondition.notify_all();
+                }
+            }
+
+            // Block a thread in JobSystem::runUntil() until a task is queued or the condition holds. Every completed task wakes it to check the condition again.
+            void waitForProgress(const std::function<bool()>& condition)
+            {
+                std::unique_lock<std::mutex> lock(mWakeMutex);
+                mWaitingThreads.fetch_add(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                mWaiterCondition.wait(lock, [&]() { return mQueuedTasks.load(std::memory_order_relaxed) > 0 || condition(); });
+                mWaitingThreads.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            // Drop one dependency of a task and queue it once it has none left
+            void release(const JobSystem::TaskHandle& pTask)
+            {
+                if (pTask->pendingDependencies.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    push(pTask);
+                }
+            }
+
+        private:
+            JobSystem::TaskHandle pop()
+            {
+                const uint32_t queueCount = (uint32_t)mQueues.size();
+                const uint32_t ownQueue = tWorkerIndex >= 0 ? (uint32_t)tWorkerIndex : mWorkerCount;
+
+                // Newest task of our own deque first, it's the most likely to have its data in the cache
+                JobSystem::TaskHandle pTask = takeTask(mQueues[ownQueue], true);
+
+                // Then the oldest tasks of the other queues, starting with the shared queue
+                for (uint32_t i = 0; i < queueCount && pTask == nullptr; i++)
+                {
+                    const uint32_t victim = (mWorkerCount + i) % queueCount;
+                    if (victim != ownQueue)
+                    {
+                        pTask = takeTask(mQueues[victim], false);
+                    }
+                }
+
+                if (pTask)
+                {
+                    mQueuedTasks.fetch_sub(1, std::memory_order_relaxed);
+                }
+                return pTask;
+            }
+
+            static JobSystem::TaskHandle takeTask(WorkQueue& queue, bool newest)
+            {
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                if (queue.tasks.empty())
+                {
+                    return nullptr;
+                }
+
+                JobSystem::TaskHandle pTask;
+                if (newest)
+                {
+                    pTask = std::move(queue.tasks.back());
+                    queue.tasks.pop_back();
+                }
+                else
+                {
+                    pTask = std::move(queue.tasks.front());
+                    queue.tasks.pop_front();
+                }
+                return pTask;
+            }
+
+            void workerLoop(uint32_t index)
+            {
+                tWorkerIndex = (int32_t)index;
+                Profiler::setTraceThreadName("Worker " + std::to_string(index));
+
+                for (;;)
+                {
+                    if (runPendingTask())
+                    {
+                        continue;
+                    }
+
+                    std::unique_lock<std::mutex> lock(mWakeMutex);
+                    mWakeCondition.wait(lock, [this]() { return mStop || mQueuedTasks.load(std::memory_order_relaxed) > 0; });
+                    if (mStop && mQueuedTasks.load(std::memory_order_relaxed) <= 0)
+                    {
+                        return;
+                    }
+                }
+            }
+
+            uint32_t mWorkerCount = 0;
+            std::vector<WorkQueue> mQueues;
+            std::vector<std::thread> mThreads;
+
+            std::mutex mWakeMutex;
+            std::condition_variable mWakeCondition;
+            std::atomic<int32_t> mQueuedTasks{ 0 }; // Can briefly go negative, a task may be popped before its push is counted
+            bool mStop = false;
+
+            // Threads sleeping in waitForProgress(). They are woken by every push and every completed task, the workers only by pushes.
+            std::condition_variable mWaiterCondition;
+            std::atomic<uint32_t> mWaitingThreads{ 0 };
+        };
+
+        Scheduler& getScheduler()
+        {
+            static Scheduler scheduler;
+            return scheduler;
+        }
+    }
+
+    uint32_t JobSystem::getWorkerCount()
+    {
+        return getScheduler().getWorkerCount();
+    }
+
+    JobSystem::TaskHandle JobSystem::schedule(Job job, const std::vector<TaskHandle>& dependencies)
+    {
+        Scheduler& scheduler = getScheduler();
+        TaskHandle pTask = std::make_shared<Task>(std::move(job));
+
+        // The task holds an extra dependency until all the others are registered, so it can't start halfway through this loop
+        for (const TaskHandle& pDependency : dependencies)
+        {
+            if (pDependency == nullptr)
+            {
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(pDependency->mutex);
+            if (pDependency->done.load(std::memory_order_acquire) == false)
+            {
+                pTask->pendingDependencies.fetch_add(1, std::memory_order_relaxed);
+                pDependency->continuations.push_back(pTask);
+            }
+        }
+
+        scheduler.release(pTask);
+        return pTask;
+    }
+
+    bool JobSystem::isDone(const TaskHandle& pTask)
+    {
+        return pTask == nullptr || pTask->done.load(std::memory_order_acquire);
+    }
+
+    void JobSystem::wait(const TaskHandle& pTask)
+    {
+        runUntil([&pTask]() { return isDone(pTask); });
+    }
+
+    void JobSystem::runUntil(const std::function<bool()>& condition)
+    {
+        Scheduler& scheduler = getScheduler();
+        uint32_t idleSpins = 0;
+        while (condition() == false)
+        {
+            if (scheduler.runPendingTask())
+            {
+                idleSpins = 0;
+            }
+            else if (idleSpins < kIdleSpinCount)
+            {
+                // Nothing to help with means the remaining tasks are running on other threads. They are usually short, so yield a few times before sleeping.
+                idleSpins++;
+                std::this_thread::yield();
+            }
+            else
+            {
+                scheduler.waitForProgress(condition);
+                idleSpins = 0;
+            }
+        }
+    }
+
+    JobSystem::TaskHandle TaskGroup::run(JobSystem::Job job, const std::vector<JobSystem::TaskHandle>& dependencies)
+    {
+        mPending.fetch_add(1, std::memory_order_relaxed);
+        return JobSystem::schedule([this, job]()
+        {
+            job();
+            mPending.fetch_sub(1, std::memory_order_release);
+        }, dependencies);
+    }
+
+    void TaskGroup::wait()
+    {
+        JobSystem::runUntil([this]() { return mPending.load(std::memory_order_acquire) == 0; });
+    }
+}
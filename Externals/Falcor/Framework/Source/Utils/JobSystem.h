@@ -0,0 +1,116 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace Falcor
+{
+    /** Work-stealing task scheduler shared by all CPU work in the framework.
+        The scheduler owns one worker per core, minus one for the main thread. Each worker has its own deque. It pops the tasks it scheduled itself from the back and steals from the front of the other deques when it runs out. Tasks scheduled from other threads go to a shared queue.
+        Threads waiting for a task or a TaskGroup execute pending tasks instead of blocking, so nested parallel work doesn't deadlock or oversubscribe the cores. They only sleep once there is nothing left to help with.
+    */
+    class JobSystem
+    {
+    public:
+        class Task;
+        using TaskHandle = std::shared_ptr<Task>;
+        using Job = std::function<void()>;
+
+        /** Get the number of worker threads. Threads waiting for tasks also execute them, so up to getWorkerCount() + 1 tasks run concurrently.
+        */
+        static uint32_t getWorkerCount();
+
+        /** Schedule a job
+            \param[in] job The job to execute
+            \param[in] dependencies Tasks that must complete before the job starts
+            \return A handle which can be waited for or used as a dependency of other tasks
+        */
+        static TaskHandle schedule(Job job, const std::vector<TaskHandle>& dependencies = {});
+
+        /** Check if a task completed
+        */
+        static bool isDone(const TaskHandle& pTask);
+
+        /** Wait for a task to complete. The calling thread executes other pending tasks in the meantime.
+        */
+        static void wait(const TaskHandle& pTask);
+
+        /** Schedule a function and get its result through a future.
+            Waiting on the future blocks the calling thread. Jobs that need the result of other tasks should declare them as dependencies instead.
+            \param[in] func The function to execute
+            \param[in] dependencies Tasks that must complete before the function starts
+        */
+        template<typename Func>
+        static auto async(Func func, const std::vector<TaskHandle>& dependencies = {}) -> std::future<decltype(func())>
+        {
+            using ResultType = decltype(func());
+            auto pTask = std::make_shared<std::packaged_task<ResultType()>>(std::move(func));
+            std::future<ResultType> result = pTask->get_future();
+            schedule([pTask]() { (*pTask)(); }, dependencies);
+            return result;
+        }
+
+    private:
+        friend class TaskGroup;
+        static void runUntil(const std::function<bool()>& condition);
+    };
+
+    /** A set of tasks which can be waited for together
+    */
+    class TaskGroup
+    {
+    public:
+        TaskGroup() : mPending(0) {}
+
+        /** Waits for all the tasks of the group
+        */
+        ~TaskGroup() { wait(); }
+
+        /** Schedule a job as part of the group
+            \param[in] job The job to execute
+            \param[in] dependencies Tasks that must complete before the job starts
+            \return The task handle, which can be used as a dependency of other tasks
+        */
+        JobSystem::TaskHandle run(JobSystem::Job job, const std::vector<JobSystem::TaskHandle>& dependencies = {});
+
+        /** Wait for all the tasks of the group. The calling thread executes pending tasks in the meantime.
+        */
+        void wait();
+
+    private:
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        std::atomic<uint32_t> mPending;
+    };
+}
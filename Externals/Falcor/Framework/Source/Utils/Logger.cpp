@@ -29,6 +29,13 @@
 #include "Logger.h"
 #include "Utils/Platform/OS.h"
 #include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace Falcor
 {
@@ -39,10 +46,121 @@ namespace Falcor
 #endif
 
     bool Logger::sInit = false;
-    FILE* Logger::sLogFile = nullptr;
     Logger::Level Logger::sVerbosity = Logger::Level::Warning;
 
-    static FILE* openLogFile()
+    namespace
+    {
+        const uint32_t kQueueSize = 4096;                   // Messages in flight, must be a power of 2. Info and warning messages are dropped when it's full.
+        const auto kWriteInterval = std::chrono::milliseconds(10);
+        const auto kRepeatWindow = std::chrono::seconds(1);
+        const uint32_t kMaxRepeatsPerWindow = 8;
+        const size_t kMaxTrackedMessages = 4096;            // Per thread, the repeat tracking restarts when a thread logged more unique messages
+
+        /** Binary log layout. The file starts with the 8 bytes "FLOGBIN1", followed by one record per message:
+            uint64_t timestamp      Nanoseconds since the logger was initialized
+            uint32_t threadId       Index of the logging thread, in order of the first message of each thread
+            uint32_t level          Logger::Level
+            uint32_t suppressed     Number of copies of the message suppressed before this one
+            uint32_t length         Message length in bytes
+            char     message[length] UTF-8, not null-terminated
+            All values are little-endian.
+        */
+        const char kBinaryLogMagic[8] = { 'F', 'L', 'O', 'G', 'B', 'I', 'N', '1' };
+
+        // Set while the writer thread is running. Trivially destructible, so it stays valid after the LogState static is destroyed and logging from later static destructors is ignored.
+        std::atomic<bool> sWriterRunning(false);
+
+        struct Message
+        {
+            std::atomic<uint64_t> sequence;
+            Logger::Level level;
+            uint32_t threadId;
+            uint32_t suppressed;
+            int64_t timeNs;
+            std::string text;       // Keeps its capacity when the slot is reused, so logging rarely allocates
+        };
+
+        // Bounded multi-producer single-consumer queue. Each slot's sequence number tells whether it's free for the producer holding that position or ready for the writer.
+        struct LogState
+        {
+            std::vector<Message> queue;
+            std::atomic<uint64_t> tail;     // Next position to be claimed by a producer
+            uint64_t head = 0;              // Next position to be written, only accessed by the writer thread
+            std::atomic<uint64_t> written;  // Number of messages consumed by the writer
+            std::atomic<uint64_t> dropped;
+
+            FILE* pTextFile = nullptr;
+            FILE* pBinaryFile = nullptr;
+            std::chrono::steady_clock::time_point startTime;
+            std::atomic<uint32_t> nextThreadId;
+
+            std::thread writer;
+            std::mutex mutex;
+            std::condition_variable wakeWriter;
+            std::condition_variable messagesWritten;
+            bool flushRequested = false;
+            bool stop = false;
+            bool stopped = false;           // Set once the writer thread exited
+
+            LogState() : queue(kQueueSize), tail(0), written(0), dropped(0), nextThreadId(0) {}
+
+            // Applications exiting without Logger::shutdown(), such as logErrorAndExit(), still get their log written
+            ~LogState() { close(); }
+
+            void close()
+            {
+                sWriterRunning.store(false, std::memory_order_release);
+                if (writer.joinable() == false)
+                {
+                    return;
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stop = true;
+                }
+                wakeWriter.notify_one();
+                writer.join();
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopped = true;
+                }
+                messagesWritten.notify_all();
+
+                fclose(pTextFile);
+                pTextFile = nullptr;
+                if (pBinaryFile)
+                {
+                    fclose(pBinaryFile);
+                    pBinaryFile = nullptr;
+                }
+            }
+        };
+
+        LogState& getLogState()
+        {
+            static LogState state;
+            return state;
+        }
+
+        struct RepeatTracker
+        {
+            std::chrono::steady_clock::time_point windowStart;
+            uint32_t count = 0;
+            uint32_t suppressed = 0;
+        };
+
+        struct ThreadLogState
+        {
+            uint32_t threadId = uint32_t(-1);
+            std::unordered_map<size_t, RepeatTracker> repeats;
+        };
+
+        thread_local ThreadLogState tThreadLogState;
+        std::hash<std::string> sMessageHash;
+    }
+
+    static FILE* openLogFile(const std::string& extension, const char* mode)
     {
         FILE* pFile = nullptr;
 
@@ -53,9 +171,9 @@ namespace Falcor
         std::string prefix = std::string(filename);
         std::string executableDir = getExecutableDirectory();
         std::string logFile;
-        if(findAvailableFilename(prefix, executableDir, "log", logFile))
+        if(findAvailableFilename(prefix, executableDir, extension, logFile))
         {
-            pFile = std::fopen(logFile.c_str(), "w");
+            pFile = std::fopen(logFile.c_str(), mode);
             if(pFile != nullptr)
             {
                 // Success
@@ -67,14 +185,214 @@ namespace Falcor
         return pFile;
     }
 
-    void Logger::init()
+    const char* getLogLevelString(Logger::Level L)
+    {
+        const char* c = nullptr;
+#define create_level_case(_l) case _l: c = "(" #_l ")" ;break;
+        switch(L)
+        {
+            create_level_case(Logger::Level::Info);
+            create_level_case(Logger::Level::Warning);
+            create_level_case(Logger::Level::Error);
+        default:
+            should_not_get_here();
+        }
+#undef create_level_case
+        return c;
+    }
+
+    static void writeMessage(LogState& state, const Message& msg)
+    {
+        std::string s = getLogLevelString(msg.level) + std::string("\t") + msg.text;
+        if (msg.suppressed)
+        {
+            s += " (" + std::to_string(msg.suppressed) + " repeats suppressed)";
+        }
+        s += "\n";
+
+        std::fputs(s.c_str(), state.pTextFile);
+        if (isDebuggerPresent())
+        {
+            printToDebugWindow(s);
+        }
+
+        if (state.pBinaryFile)
+        {
+            const uint64_t timestamp = (uint64_t)msg.timeNs;
+            const uint32_t header[4] = { msg.threadId, (uint32_t)msg.level, msg.suppressed, (uint32_t)msg.text.size() };
+            std::fwrite(&timestamp, sizeof(timestamp), 1, state.pBinaryFile);
+            std::fwrite(header, sizeof(header), 1, state.pBinaryFile);
+            std::fwrite(msg.text.data(), 1, msg.text.size(), state.pBinaryFile);
+        }
+    }
+
+    // Write all the messages in the queue, returns the number of messages written
+    static uint64_t drainQueue(LogState& state)
+    {
+        uint64_t count = 0;
+        for (;;)
+        {
+            Message& msg = state.queue[state.head & (kQueueSize - 1)];
+            if (msg.sequence.load(std::memory_order_acquire) != state.head + 1)
+            {
+                break;
+            }
+
+            writeMessage(state, msg);
+            msg.sequence.store(state.head + kQueueSize, std::memory_order_release);
+            state.head++;
+            count++;
+        }
+
+        const uint64_t dropped = state.dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped)
+        {
+            std::fprintf(state.pTextFile, "%s\tLog queue full, %llu messages were dropped\n", getLogLevelString(Logger::Level::Warning), (unsigned long long)dropped);
+        }
+
+        if (count || dropped)
+        {
+            // Once per batch rather than per message, errors are flushed by the thread logging them
+            std::fflush(state.pTextFile);
+            if (state.pBinaryFile)
+            {
+                std::fflush(state.pBinaryFile);
+            }
+        }
+        return count;
+    }
+
+    static void writerThread(LogState* pState)
+    {
+        LogState& state = *pState;
+        std::unique_lock<std::mutex> lock(state.mutex);
+        for (;;)
+        {
+            state.flushRequested = false;
+            const bool stop = state.stop;
+            lock.unlock();
+            const uint64_t count = drainQueue(state);
+            lock.lock();
+
+            if (count)
+            {
+                state.written.fetch_add(count, std::memory_order_release);
+                state.messagesWritten.notify_all();
+            }
+
+            // Producers may still be finishing a message they claimed, keep draining until they're done
+            if (stop && state.written.load(std::memory_order_relaxed) == state.tail.load(std::memory_order_acquire))
+            {
+                return;
+            }
+            state.wakeWriter.wait_for(lock, kWriteInterval, [&state]() { return state.flushRequested || state.stop; });
+        }
+    }
+
+    // Claim a queue slot and fill it. Returns false if the queue is full.
+    static bool enqueueMessage(LogState& state, Logger::Level level, const std::string& text, uint32_t suppressed)
+    {
+        uint64_t pos = state.tail.load(std::memory_order_relaxed);
+        Message* pMsg;
+        for (;;)
+        {
+            pMsg = &state.queue[pos & (kQueueSize - 1)];
+            const int64_t diff = (int64_t)(pMsg->sequence.load(std::memory_order_acquire) - pos);
+            if (diff == 0)
+            {
+                if (state.tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = state.tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        ThreadLogState& threadState = tThreadLogState;
+        if (threadState.threadId == uint32_t(-1))
+        {
+            threadState.threadId = state.nextThreadId.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        pMsg->level = level;
+        pMsg->threadId = threadState.threadId;
+        pMsg->suppressed = suppressed;
+        pMsg->timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - state.startTime).count();
+        pMsg->text = text;
+        pMsg->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Returns false if the message should be suppressed. Otherwise returns the number of copies suppressed since it was last logged.
+    static bool checkRepeats(const std::string& msg, uint32_t& suppressed)
+    {
+        ThreadLogState& threadState = tThreadLogState;
+        if (threadState.repeats.size() >= kMaxTrackedMessages)
+        {
+            threadState.repeats.clear();
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        RepeatTracker& tracker = threadState.repeats[sMessageHash(msg)];
+        if (tracker.count == 0 || now - tracker.windowStart >= kRepeatWindow)
+        {
+            tracker.windowStart = now;
+            tracker.count = 0;
+        }
+
+        if (tracker.count >= kMaxRepeatsPerWindow)
+        {
+            tracker.suppressed++;
+            return false;
+        }
+
+        tracker.count++;
+        suppressed = tracker.suppressed;
+        tracker.suppressed = 0;
+        return true;
+    }
+
+    void Logger::init(bool binaryLog)
     {
 #if _LOG_ENABLED
         if(sInit == false)
         {
-            sLogFile = openLogFile();
-            sInit = sLogFile != nullptr;
-            assert(sInit);
+            LogState& state = getLogState();
+            state.pTextFile = openLogFile("log", "w");
+            if (state.pTextFile == nullptr)
+            {
+                return;
+            }
+
+            if (binaryLog)
+            {
+                state.pBinaryFile = openLogFile("flog", "wb");
+                if (state.pBinaryFile)
+                {
+                    std::fwrite(kBinaryLogMagic, sizeof(kBinaryLogMagic), 1, state.pBinaryFile);
+                }
+            }
+
+            // Positions start where the previous session stopped, the slot sequence numbers stay valid
+            for (uint32_t i = 0; i < kQueueSize; i++)
+            {
+                state.queue[(state.head + i) & (kQueueSize - 1)].sequence.store(state.head + i, std::memory_order_relaxed);
+            }
+            state.tail.store(state.head, std::memory_order_relaxed);
+            state.written.store(state.head, std::memory_order_relaxed);
+            state.startTime = std::chrono::steady_clock::now();
+            state.stop = false;
+            state.stopped = false;
+            state.writer = std::thread(writerThread, &state);
+            sWriterRunning.store(true, std::memory_order_release);
+            sInit = true;
         }
 #endif
     }
@@ -82,44 +400,51 @@ namespace Falcor
     void Logger::shutdown()
     {
 #if _LOG_ENABLED
-        if(sLogFile)
+        if(sInit)
         {
-            fclose(sLogFile);
-            sLogFile = nullptr;
             sInit = false;
+            getLogState().close();
         }
 #endif
     }
 
-    const char* getLogLevelString(Logger::Level L)
+    void Logger::flush()
     {
-        const char* c = nullptr;
-#define create_level_case(_l) case _l: c = "(" #_l ")" ;break;
-        switch(L)
+#if _LOG_ENABLED
+        if(sInit && sWriterRunning.load(std::memory_order_acquire))
         {
-            create_level_case(Logger::Level::Info);
-            create_level_case(Logger::Level::Warning);
-            create_level_case(Logger::Level::Error);
-        default:
-            should_not_get_here();
+            LogState& state = getLogState();
+            const uint64_t target = state.tail.load(std::memory_order_acquire);
+            std::unique_lock<std::mutex> lock(state.mutex);
+            state.flushRequested = true;
+            state.wakeWriter.notify_one();
+            // Don't wait for a writer that stopped while we were waiting, it wrote everything it could
+            state.messagesWritten.wait(lock, [&state, target]() { return state.stopped || state.written.load(std::memory_order_acquire) >= target; });
         }
-#undef create_level_case
-        return c;
+#endif
     }
 
     void Logger::log(Level L, const std::string& msg, bool forceMsgBox)
     {
 #if _LOG_ENABLED
-        if(sInit)
+        if(sInit && sWriterRunning.load(std::memory_order_acquire))
         {
-            if(L >= sVerbosity)
+            uint32_t suppressed = 0;
+            if(L >= sVerbosity && checkRepeats(msg, suppressed))
             {
-                std::string s = getLogLevelString(L) + std::string("\t") + msg + "\n";
-                std::fprintf(sLogFile, "%s", s.c_str());
-                fflush(sLogFile);   // Slows down execution, but ensures that the message will be printed in case of a crash
-                if (isDebuggerPresent())
+                LogState& state = getLogState();
+                if (L >= Level::Error)
+                {
+                    // Errors are never dropped, and are written before returning in case the application is about to crash
+                    while (enqueueMessage(state, L, msg, suppressed) == false)
+                    {
+                        std::this_thread::yield();
+                    }
+                    flush();
+                }
+                else if (enqueueMessage(state, L, msg, suppressed) == false)
                 {
-                    printToDebugWindow(s);
+                    state.dropped.fetch_add(1, std::memory_order_relaxed);
                 }
             }
         }
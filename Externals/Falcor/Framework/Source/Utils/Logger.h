@@ -34,6 +34,8 @@ namespace Falcor
     /** Container class for logging messages. 
     *   To enable log messages, make sure _LOG_ENABLED is set to true in FalcorConfig.h.
     *   Messages are printed to a log file in the application directory. Using Logger#ShowBoxOnError() you can control if a message box will be shown as well.
+    *   Logging only copies the message into a lock-free queue, a background thread writes it to the log files. Errors are written before log() returns, so they survive a crash.
+    *   A message repeated more than a few times per second from the same thread is suppressed, the number of suppressed copies is logged with its next occurrence.
     */
     class Logger
     {
@@ -49,14 +51,19 @@ namespace Falcor
             Disabled = -1
         };
 
-        /** Initialize the logger. Has to be called once before logging is possible. This function will create the log file.
+        /** Initialize the logger. Has to be called once before logging is possible. This function will create the log file and start the writer thread.
+            \param[in] binaryLog Also write the messages as binary records into a .flog file, for tools that filter or analyze logs. The record layout is described in Logger.cpp.
         */
-        static void init();
+        static void init(bool binaryLog = false);
 
-        /** Shutdown the logger and close the log file.
+        /** Shutdown the logger. Writes the pending messages and closes the log files.
         */
         static void shutdown();
 
+        /** Wait until all the messages logged so far were written to the log files.
+        */
+        static void flush();
+
         /** Controls weather or not to show message box on log messages.
             \param[in] showBox true to show a message box, false to disable it.
         */
@@ -85,7 +92,6 @@ namespace Falcor
 
         Logger() = delete;
         static bool sShowErrorBox;
-        static FILE* sLogFile;
         static bool sInit;
         static Level sVerbosity;
     };
@@ -0,0 +1,263 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "Utils/Math/Bvh.h"
+#include <algorithm>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kBinCount = 16;
+
+        // Cost of a node traversal step relative to intersecting one item
+        const float kTraversalCost = 1.0f;
+
+        struct Bounds
+        {
+            glm::vec3 minPos = glm::vec3(std::numeric_limits<float>::max());
+            glm::vec3 maxPos = glm::vec3(-std::numeric_limits<float>::max());
+
+            void grow(const glm::vec3& p) { minPos = glm::min(minPos, p); maxPos = glm::max(maxPos, p); }
+            void grow(const Bounds& b) { minPos = glm::min(minPos, b.minPos); maxPos = glm::max(maxPos, b.maxPos); }
+
+            float getArea() const
+            {
+                const glm::vec3 d = glm::max(maxPos - minPos, glm::vec3(0.0f));
+                return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+            }
+        };
+
+        Bounds getItemBounds(const BoundingBox& box)
+        {
+            Bounds b;
+            b.minPos = box.getMinPos();
+            b.maxPos = box.getMaxPos();
+            return b;
+        }
+
+        float getNodeArea(const Bvh::Node& node)
+        {
+            Bounds b;
+            b.minPos = node.boundsMin;
+            b.maxPos = node.boundsMax;
+            return b.getArea();
+        }
+    }
+
+    void Bvh::build(const std::vector<BoundingBox>& itemBounds, uint32_t maxLeafSize)
+    {
+        mMaxLeafSize = std::max(maxLeafSize, 1u);
+        mNodes.clear();
+        mItemIndices.resize(itemBounds.size());
+        for (uint32_t i = 0; i < (uint32_t)itemBounds.size(); i++)
+        {
+            mItemIndices[i] = i;
+        }
+
+        if (itemBounds.empty() == false)
+        {
+            mNodes.reserve(2 * itemBounds.size());
+            buildNode(itemBounds, 0, (uint32_t)itemBounds.size(), 0);
+        }
+    }
+
+    uint32_t Bvh::buildNode(const std::vector<BoundingBox>& itemBounds, uint32_t begin, uint32_t end, uint32_t depth)
+    {
+        const uint32_t nodeIndex = (uint32_t)mNodes.size();
+        mNodes.emplace_back();
+
+        Bounds bounds;
+        Bounds centroidBounds;
+        for (uint32_t i = begin; i < end; i++)
+        {
+            const BoundingBox& box = itemBounds[mItemIndices[i]];
+            bounds.grow(getItemBounds(box));
+            centroidBounds.grow(box.center);
+        }
+
+        mNodes[nodeIndex].boundsMin = bounds.minPos;
+        mNodes[nodeIndex].boundsMax = bounds.maxPos;
+
+        auto makeLeaf = [&]()
+        {
+            mNodes[nodeIndex].offset = begin;
+            mNodes[nodeIndex].count = end - begin;
+            return nodeIndex;
+        };
+
+        const uint32_t count = end - begin;
+        if (count == 1 || depth >= kMaxDepth)
+        {
+            return makeLeaf();
+        }
+
+        // Evaluate the SAH at the bin boundaries of every axis
+        struct Bin
+        {
+            Bounds bounds;
+            uint32_t count = 0;
+        };
+
+        float bestCost = std::numeric_limits<float>::max();
+        uint32_t bestAxis = 0;
+        uint32_t bestSplit = 0;
+        const glm::vec3 centroidExtent = centroidBounds.maxPos - centroidBounds.minPos;
+
+        auto getBinIndex = [&](const BoundingBox& box, uint32_t axis)
+        {
+            const float relative = (box.center[axis] - centroidBounds.minPos[axis]) / centroidExtent[axis];
+            return std::min(uint32_t(relative * kBinCount), kBinCount - 1);
+        };
+
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            if (centroidExtent[axis] <= 0.0f)
+            {
+                continue;
+            }
+
+            Bin bins[kBinCount];
+            for (uint32_t i = begin; i < end; i++)
+            {
+                const BoundingBox& box = itemBounds[mItemIndices[i]];
+                Bin& bin = bins[getBinIndex(box, axis)];
+                bin.bounds.grow(getItemBounds(box));
+                bin.count++;
+            }
+
+            // Sweep from the right to get the cost of everything above each split, then from the left
+            float rightCost[kBinCount];
+            Bounds rightBounds;
+            uint32_t rightCount = 0;
+            for (uint32_t b = kBinCount - 1; b > 0; b--)
+            {
+                rightBounds.grow(bins[b].bounds);
+                rightCount += bins[b].count;
+                rightCost[b] = rightCount ? rightBounds.getArea() * rightCount : 0.0f;
+            }
+
+            Bounds leftBounds;
+            uint32_t leftCount = 0;
+            for (uint32_t b = 1; b < kBinCount; b++)
+            {
+                leftBounds.grow(bins[b - 1].bounds);
+                leftCount += bins[b - 1].count;
+                if (leftCount == 0 || leftCount == count)
+                {
+                    continue;
+                }
+
+                const float cost = leftBounds.getArea() * leftCount + rightCost[b];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b;
+                }
+            }
+        }
+
+        uint32_t mid;
+        if (bestSplit == 0)
+        {
+            // All centroids coincide. Split in the middle if the node is too large for a leaf.
+            if (count <= mMaxLeafSize)
+            {
+                return makeLeaf();
+            }
+            mid = begin + count / 2;
+        }
+        else
+        {
+            const float area = bounds.getArea();
+            const float splitCost = kTraversalCost + (area > 0.0f ? bestCost / area : float(count));
+            if (count <= mMaxLeafSize && splitCost >= float(count))
+            {
+                return makeLeaf();
+            }
+
+            auto it = std::partition(mItemIndices.begin() + begin, mItemIndices.begin() + end, [&](uint32_t item)
+            {
+                return getBinIndex(itemBounds[item], bestAxis) < bestSplit;
+            });
+            mid = uint32_t(it - mItemIndices.begin());
+        }
+
+        buildNode(itemBounds, begin, mid, depth + 1);
+        const uint32_t right = buildNode(itemBounds, mid, end, depth + 1);
+        mNodes[nodeIndex].offset = right;
+        mNodes[nodeIndex].count = 0;
+        return nodeIndex;
+    }
+
+    void Bvh::refit(const std::vector<BoundingBox>& itemBounds)
+    {
+        assert(itemBounds.size() == mItemIndices.size());
+
+        // Children are always stored after their parent, so a reverse sweep updates them first
+        for (size_t i = mNodes.size(); i-- > 0;)
+        {
+            Node& node = mNodes[i];
+            Bounds bounds;
+            if (node.isLeaf())
+            {
+                for (uint32_t j = 0; j < node.count; j++)
+                {
+                    bounds.grow(getItemBounds(itemBounds[mItemIndices[node.offset + j]]));
+                }
+            }
+            else
+            {
+                const Node& left = mNodes[i + 1];
+                const Node& right = mNodes[node.offset];
+                bounds.minPos = glm::min(left.boundsMin, right.boundsMin);
+                bounds.maxPos = glm::max(left.boundsMax, right.boundsMax);
+            }
+            node.boundsMin = bounds.minPos;
+            node.boundsMax = bounds.maxPos;
+        }
+    }
+
+    float Bvh::getSahCost() const
+    {
+        if (mNodes.empty())
+        {
+            return 0.0f;
+        }
+
+        float cost = 0.0f;
+        for (const Node& node : mNodes)
+        {
+            cost += getNodeArea(node) * (node.isLeaf() ? float(node.count) : kTraversalCost);
+        }
+
+        const float rootArea = getNodeArea(mNodes[0]);
+        return rootArea > 0.0f ? cost / rootArea : 0.0f;
+    }
+}
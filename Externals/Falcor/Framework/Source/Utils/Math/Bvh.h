@@ -0,0 +1,220 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Utils/AABB.h"
+#include <limits>
+#include <vector>
+
+namespace Falcor
+{
+    /** A ray with a parametric interval. Hit distances are in units of the direction length.
+    */
+    struct Ray
+    {
+        glm::vec3 origin;
+        glm::vec3 direction;
+        float tMin = 0.0f;
+        float tMax = std::numeric_limits<float>::max();
+    };
+
+    /** Bounding volume hierarchy over a set of bounding boxes, built with a binned SAH.
+        Items are referenced by their index in the array the hierarchy was built from. MeshBvh and SceneBvh use it for the triangle and instance levels.
+    */
+    class Bvh
+    {
+    public:
+        struct Node
+        {
+            glm::vec3 boundsMin;
+            uint32_t offset;    ///< Leaf: first entry in the item index list. Interior: index of the second child, the first child directly follows its parent.
+            glm::vec3 boundsMax;
+            uint32_t count;     ///< Number of items in a leaf, 0 for interior nodes
+
+            bool isLeaf() const { return count > 0; }
+        };
+
+        /** Build the hierarchy.
+            \param[in] itemBounds Bounding box of every item
+            \param[in] maxLeafSize Nodes with more items are always split. Smaller nodes are split only if the SAH says it pays off.
+        */
+        void build(const std::vector<BoundingBox>& itemBounds, uint32_t maxLeafSize);
+
+        /** Update the node bounds after items moved, keeping the tree topology. Much cheaper than a rebuild, but the tree quality degrades with large motion.
+            \param[in] itemBounds New bounding box of every item. Must hold the same items the hierarchy was built from.
+        */
+        void refit(const std::vector<BoundingBox>& itemBounds);
+
+        /** Get the SAH cost of the tree, normalized by the root surface area. Comparing it to the cost after the last build tells when a refitted tree should be rebuilt.
+        */
+        float getSahCost() const;
+
+        bool isEmpty() const { return mNodes.empty(); }
+        const std::vector<Node>& getNodes() const { return mNodes; }
+        const std::vector<uint32_t>& getItemIndices() const { return mItemIndices; }
+
+        /** Find the closest hit along a ray.
+            \param[in,out] ray Ray to trace. tMax is shortened to the closest hit.
+            \param[in] intersectItem Callable bool(uint32_t item, Ray& ray). Returns true on a hit closer than ray.tMax and shortens ray.tMax to it.
+            \return Whether any item was hit
+        */
+        template<typename IntersectFunc>
+        bool intersect(Ray& ray, IntersectFunc intersectItem) const;
+
+        /** Visit all items in leaves whose bounds pass a test.
+            \param[in] overlaps Callable bool(const BoundingBox& box), used to prune nodes
+            \param[in] visitItem Callable void(uint32_t item), called for every item in a leaf that passed the test
+        */
+        template<typename OverlapFunc, typename VisitFunc>
+        void query(OverlapFunc overlaps, VisitFunc visitItem) const;
+
+        /** Maximum tree depth. Deeper nodes are turned into leaves, which bounds the traversal stack.
+        */
+        static const uint32_t kMaxDepth = 64;
+
+    private:
+        static bool intersectNode(const Node& node, const Ray& ray, const glm::vec3& invDir, float& tEntry)
+        {
+            const glm::vec3 t0 = (node.boundsMin - ray.origin) * invDir;
+            const glm::vec3 t1 = (node.boundsMax - ray.origin) * invDir;
+            const glm::vec3 tNear = glm::min(t0, t1);
+            const glm::vec3 tFar = glm::max(t0, t1);
+            tEntry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, ray.tMin));
+            const float tExit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, ray.tMax));
+            return tEntry <= tExit;
+        }
+
+        uint32_t buildNode(const std::vector<BoundingBox>& itemBounds, uint32_t begin, uint32_t end, uint32_t depth);
+
+        std::vector<Node> mNodes;
+        std::vector<uint32_t> mItemIndices;
+        uint32_t mMaxLeafSize = 1;
+    };
+
+    template<typename IntersectFunc>
+    bool Bvh::intersect(Ray& ray, IntersectFunc intersectItem) const
+    {
+        float tEntry;
+        const glm::vec3 invDir = 1.0f / ray.direction;
+        if (mNodes.empty() || intersectNode(mNodes[0], ray, invDir, tEntry) == false)
+        {
+            return false;
+        }
+
+        struct StackEntry
+        {
+            uint32_t node;
+            float tEntry;
+        };
+        StackEntry stack[kMaxDepth + 1];
+        uint32_t stackSize = 0;
+        uint32_t nodeIndex = 0;
+        bool hit = false;
+
+        for (;;)
+        {
+            const Node& node = mNodes[nodeIndex];
+            if (node.isLeaf())
+            {
+                for (uint32_t i = 0; i < node.count; i++)
+                {
+                    hit = intersectItem(mItemIndices[node.offset + i], ray) || hit;
+                }
+            }
+            else
+            {
+                // Descend into the nearer child first, the other one is revisited only if it can still contain a closer hit
+                uint32_t nearChild = nodeIndex + 1;
+                uint32_t farChild = node.offset;
+                float tNear, tFar;
+                const bool hitNear = intersectNode(mNodes[nearChild], ray, invDir, tNear);
+                const bool hitFar = intersectNode(mNodes[farChild], ray, invDir, tFar);
+                if (hitNear && hitFar)
+                {
+                    if (tFar < tNear)
+                    {
+                        std::swap(nearChild, farChild);
+                        std::swap(tNear, tFar);
+                    }
+                    stack[stackSize++] = { farChild, tFar };
+                    nodeIndex = nearChild;
+                    continue;
+                }
+                else if (hitNear || hitFar)
+                {
+                    nodeIndex = hitNear ? nearChild : farChild;
+                    continue;
+                }
+            }
+
+            do
+            {
+                if (stackSize == 0)
+                {
+                    return hit;
+                }
+                --stackSize;
+            } while (stack[stackSize].tEntry > ray.tMax);
+            nodeIndex = stack[stackSize].node;
+        }
+    }
+
+    template<typename OverlapFunc, typename VisitFunc>
+    void Bvh::query(OverlapFunc overlaps, VisitFunc visitItem) const
+    {
+        if (mNodes.empty())
+        {
+            return;
+        }
+
+        uint32_t stack[kMaxDepth + 1];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while (stackSize > 0)
+        {
+            const Node& node = mNodes[stack[--stackSize]];
+            if (overlaps(BoundingBox::fromMinMax(node.boundsMin, node.boundsMax)) == false)
+            {
+                continue;
+            }
+
+            if (node.isLeaf())
+            {
+                for (uint32_t i = 0; i < node.count; i++)
+                {
+                    visitItem(mItemIndices[node.offset + i]);
+                }
+            }
+            else
+            {
+                stack[stackSize++] = node.offset;
+                stack[stackSize++] = uint32_t(&node - mNodes.data()) + 1;
+            }
+        }
+    }
+}
@@ -0,0 +1,101 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include "Utils/JobSystem.h"
+
+namespace Falcor
+{
+    /** Get the number of threads used by parallelFor(), including the calling thread.
+    */
+    inline uint32_t getParallelWorkerCount()
+    {
+        return JobSystem::getWorkerCount() + 1;
+    }
+
+    /** Run func(i) for every i in [begin, end) on the JobSystem workers.
+        The range is split into chunks of grainSize items which are handed out dynamically, so uneven work per item still balances.
+        The calling thread participates in the work and the function returns once every item has been processed. Calls can be nested, a thread waiting for its items executes other pending tasks.
+        \param[in] begin First item of the range
+        \param[in] end One past the last item of the range
+        \param[in] func Callable with signature void(size_t). Invocations for different items must not write to shared state.
+        \param[in] grainSize Number of consecutive items processed by a worker at a time
+    */
+    template<typename Func>
+    void parallelFor(size_t begin, size_t end, Func func, size_t grainSize = 1)
+    {
+        if (end <= begin)
+        {
+            return;
+        }
+
+        grainSize = std::max<size_t>(grainSize, 1);
+        const size_t chunkCount = (end - begin + grainSize - 1) / grainSize;
+        const size_t workerCount = std::min<size_t>(getParallelWorkerCount(), chunkCount);
+
+        if (workerCount <= 1)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                func(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> nextChunk(0);
+        auto worker = [&]()
+        {
+            for (;;)
+            {
+                const size_t chunk = nextChunk.fetch_add(1);
+                if (chunk >= chunkCount)
+                {
+                    break;
+                }
+
+                const size_t chunkBegin = begin + chunk * grainSize;
+                const size_t chunkEnd = std::min(chunkBegin + grainSize, end);
+                for (size_t i = chunkBegin; i < chunkEnd; ++i)
+                {
+                    func(i);
+                }
+            }
+        };
+
+        TaskGroup group;
+        for (size_t i = 1; i < workerCount; ++i)
+        {
+            group.run(worker);
+        }
+
+        worker();
+        group.wait();
+    }
+}
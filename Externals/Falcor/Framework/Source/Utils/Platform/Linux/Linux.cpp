@@ -37,6 +37,7 @@
 #include <gtk/gtk.h>
 #include <fstream>
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <libgen.h>
 #include <errno.h>
 #include <algorithm>
@@ -379,6 +380,41 @@ namespace Falcor
         return s.st_mtime;
     }
 
+    const void* mapFileForReading(const std::string& fullpath, size_t& size)
+    {
+        int fd = open(fullpath.c_str(), O_RDONLY);
+        if (fd == -1)
+        {
+            return nullptr;
+        }
+
+        struct stat s;
+        if (fstat(fd, &s) != 0 || s.st_size == 0)
+        {
+            close(fd);
+            return nullptr;
+        }
+
+        // The mapping stays valid after the descriptor is closed
+        void* pData = mmap(nullptr, (size_t)s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (pData == MAP_FAILED)
+        {
+            return nullptr;
+        }
+
+        size = (size_t)s.st_size;
+        return pData;
+    }
+
+    void unmapFile(const void* pData, size_t size)
+    {
+        if (pData)
+        {
+            munmap(const_cast<void*>(pData), size);
+        }
+    }
+
     uint32_t bitScanReverse(uint32_t a)
     {
         // __builtin_clz counts 0's from the MSB, convert to index from the LSB
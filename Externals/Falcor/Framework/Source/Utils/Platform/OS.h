@@ -227,6 +227,19 @@ namespace Falcor
     */
     time_t getFileModifiedTime(const std::string& filename);
 
+    /** Map a file into the address space of the process for reading. The pages are loaded on first access.
+        \param[in] fullpath The full path of the file
+        \param[out] size The size of the file in bytes
+        \return A pointer to the file contents, or nullptr if the file couldn't be mapped. Release the mapping with unmapFile()
+    */
+    const void* mapFileForReading(const std::string& fullpath, size_t& size);
+
+    /** Release a mapping created with mapFileForReading()
+        \param[in] pData The pointer returned by mapFileForReading()
+        \param[in] size The size of the mapping
+    */
+    void unmapFile(const void* pData, size_t size);
+
     enum class ThreadPriorityType : int32_t
     {
         BackgroundBegin     = -2,   //< Indicates I/O-intense thread
@@ -314,6 +314,43 @@ namespace Falcor
         return s.st_mtime;
     }
 
+    const void* mapFileForReading(const std::string& fullpath, size_t& size)
+    {
+        HANDLE hFile = CreateFileA(fullpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (hFile == INVALID_HANDLE_VALUE)
+        {
+            return nullptr;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(hFile, &fileSize) == FALSE || fileSize.QuadPart == 0)
+        {
+            CloseHandle(hFile);
+            return nullptr;
+        }
+
+        HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(hFile);
+        if (hMapping == nullptr)
+        {
+            return nullptr;
+        }
+
+        // The view keeps the mapping alive, so the handle can be closed right away
+        const void* pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(hMapping);
+        size = pData ? (size_t)fileSize.QuadPart : 0;
+        return pData;
+    }
+
+    void unmapFile(const void* pData, size_t size)
+    {
+        if (pData)
+        {
+            UnmapViewOfFile(pData);
+        }
+    }
+
     uint64_t getTotalVirtualMemory()
     {
         MEMORYSTATUSEX memInfo;
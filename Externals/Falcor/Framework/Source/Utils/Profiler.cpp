@@ -34,6 +34,11 @@
 #include <fstream>
 #include <sstream>
 #include <cstdio>
+#include <iomanip>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace Falcor
 {
@@ -46,9 +51,244 @@ namespace Falcor
     
     std::hash<std::string> HashedString::hashFunc;
 
+    namespace
+    {
+        // Each thread owns one ring buffer, old records are overwritten once it's full
+        const uint32_t kTraceRecordsPerThread = 1 << 14;
+
+        struct TraceRecord
+        {
+            enum class Type : uint32_t
+            {
+                Begin,
+                End,
+            };
+
+            size_t nameHash;
+            int64_t timeNs;
+            Type type;
+        };
+
+        // Single-producer ring buffer. Only the owning thread writes, the trace writer reads the records below 'head' once the capture is done.
+        struct TraceBuffer
+        {
+            std::vector<TraceRecord> records;
+            std::atomic<uint64_t> head;
+            std::string threadName;
+            uint32_t threadId;
+            bool inUse;
+        };
+
+        struct GpuTraceEvent
+        {
+            size_t nameHash;
+            double startMs;
+            double durationMs;
+        };
+
+        struct TraceCapture
+        {
+            std::atomic<bool> recording;
+            std::string filename;
+            uint32_t framesLeft = 0;
+            bool frameRecorded[2] = { false, false }; // Indexed like EventData::frameData, the GPU times of recorded frames are added to the trace
+            std::atomic<bool> writePending;
+            int64_t startNs = 0;
+            std::vector<GpuTraceEvent> gpuEvents; // Only accessed from the thread calling endFrame()
+
+            // Buffers are never freed, a thread's records stay available after it exits. The buffers of exited threads are reused by new threads.
+            std::mutex mutex;
+            std::vector<std::unique_ptr<TraceBuffer>> buffers;
+            std::unordered_map<size_t, std::string> names;
+
+            TraceCapture() : recording(false), writePending(false) {}
+        };
+
+        TraceCapture& getTraceCapture()
+        {
+            static TraceCapture capture;
+            return capture;
+        }
+
+        int64_t getTraceTime(const CpuTimer::TimePoint& time)
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        }
+
+        // Owned by a thread_local, returns the buffer to the pool when the thread exits
+        struct ThreadTraceState
+        {
+            TraceBuffer* pBuffer = nullptr;
+            std::unordered_set<size_t> registeredNames;
+
+            ~ThreadTraceState()
+            {
+                if (pBuffer)
+                {
+                    TraceCapture& capture = getTraceCapture();
+                    std::lock_guard<std::mutex> lock(capture.mutex);
+                    pBuffer->inUse = false;
+                }
+            }
+        };
+
+        thread_local ThreadTraceState tThreadTraceState;
+
+        TraceBuffer* getThreadTraceBuffer()
+        {
+            ThreadTraceState& state = tThreadTraceState;
+            if (state.pBuffer)
+            {
+                return state.pBuffer;
+            }
+
+            TraceCapture& capture = getTraceCapture();
+            std::lock_guard<std::mutex> lock(capture.mutex);
+            for (auto& pBuffer : capture.buffers)
+            {
+                if (pBuffer->inUse == false)
+                {
+                    pBuffer->inUse = true;
+                    state.pBuffer = pBuffer.get();
+                    return state.pBuffer;
+                }
+            }
+
+            TraceBuffer* pBuffer = new TraceBuffer;
+            pBuffer->records.resize(kTraceRecordsPerThread);
+            pBuffer->head = 0;
+            pBuffer->threadId = (uint32_t)capture.buffers.size();
+            pBuffer->threadName = "Thread " + std::to_string(pBuffer->threadId);
+            pBuffer->inUse = true;
+            capture.buffers.emplace_back(pBuffer);
+            state.pBuffer = pBuffer;
+            return pBuffer;
+        }
+
+        void registerTraceName(const HashedString& name)
+        {
+            ThreadTraceState& state = tThreadTraceState;
+            if (state.registeredNames.insert(name.hash).second)
+            {
+                TraceCapture& capture = getTraceCapture();
+                std::lock_guard<std::mutex> lock(capture.mutex);
+                capture.names.emplace(name.hash, name.str);
+            }
+        }
+
+        void recordTraceEvent(const HashedString& name, TraceRecord::Type type, int64_t timeNs)
+        {
+            registerTraceName(name);
+            TraceBuffer* pBuffer = getThreadTraceBuffer();
+            uint64_t head = pBuffer->head.load(std::memory_order_relaxed);
+            TraceRecord& record = pBuffer->records[head % kTraceRecordsPerThread];
+            record.nameHash = name.hash;
+            record.timeNs = timeNs;
+            record.type = type;
+            pBuffer->head.store(head + 1, std::memory_order_release);
+        }
+
+        void writeJsonString(std::ostream& out, const std::string& str)
+        {
+            out << '"';
+            for (char c : str)
+            {
+                if (c == '"' || c == '\\')
+                {
+                    out << '\\' << c;
+                }
+                else if ((unsigned char)c < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+                    out << escaped;
+                }
+                else
+                {
+                    out << c;
+                }
+            }
+            out << '"';
+        }
+
+        const std::string& getTraceName(const TraceCapture& capture, size_t nameHash)
+        {
+            static const std::string kUnknown = "<unknown>";
+            auto it = capture.names.find(nameHash);
+            return it == capture.names.end() ? kUnknown : it->second;
+        }
+
+        void writeTrace(TraceCapture& capture)
+        {
+            std::ofstream out(capture.filename);
+            if (out.fail())
+            {
+                logError("Profiler: can't open trace file " + capture.filename);
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(capture.mutex);
+            out << std::fixed << std::setprecision(3);
+            const uint32_t gpuThreadId = (uint32_t)capture.buffers.size();
+            out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+            bool first = true;
+            auto beginEvent = [&]()
+            {
+                out << (first ? "" : ",\n");
+                first = false;
+            };
+
+            // Track names
+            for (const auto& pBuffer : capture.buffers)
+            {
+                beginEvent();
+                out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << pBuffer->threadId << ",\"args\":{\"name\":";
+                writeJsonString(out, pBuffer->threadName);
+                out << "}}";
+            }
+            beginEvent();
+            out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << gpuThreadId << ",\"args\":{\"name\":\"GPU\"}}";
+
+            // CPU events. A thread may still be finishing the event it started before the capture stopped, so the oldest slot could be overwritten and is skipped when the buffer wrapped.
+            size_t eventCount = 0;
+            for (const auto& pBuffer : capture.buffers)
+            {
+                const uint64_t head = pBuffer->head.load(std::memory_order_acquire);
+                const uint64_t oldest = head > kTraceRecordsPerThread ? head - kTraceRecordsPerThread + 1 : 0;
+                for (uint64_t i = oldest; i < head; i++)
+                {
+                    const TraceRecord& record = pBuffer->records[i % kTraceRecordsPerThread];
+                    if (record.timeNs < capture.startNs)
+                    {
+                        continue;
+                    }
+                    beginEvent();
+                    out << "{\"ph\":\"" << (record.type == TraceRecord::Type::Begin ? 'B' : 'E') << "\",\"pid\":0,\"tid\":" << pBuffer->threadId << ",\"ts\":" << double(record.timeNs - capture.startNs) * 1.0e-3 << ",\"name\":";
+                    writeJsonString(out, getTraceName(capture, record.nameHash));
+                    out << "}";
+                    eventCount++;
+                }
+            }
+
+            // GPU events, as complete events since they're already resolved
+            for (const GpuTraceEvent& event : capture.gpuEvents)
+            {
+                beginEvent();
+                out << "{\"ph\":\"X\",\"pid\":0,\"tid\":" << gpuThreadId << ",\"ts\":" << event.startMs * 1.0e3 << ",\"dur\":" << event.durationMs * 1.0e3 << ",\"name\":";
+                writeJsonString(out, getTraceName(capture, event.nameHash));
+                out << "}";
+            }
+            out << "\n]}\n";
+
+            logInfo("Profiler: wrote " + std::to_string(eventCount) + " CPU and " + std::to_string(capture.gpuEvents.size()) + " GPU events to " + capture.filename);
+            capture.gpuEvents.clear();
+        }
+    }
+
 	void Profiler::initNewEvent(EventData *pEvent, const HashedString& name)
     {
 	    pEvent->name = name.str;
+        pEvent->nameHash = name.hash;
         pEvent->level = sCurrentLevel;
 		sProfilerEvents[name.hash] = pEvent;
         sProfilerVector.push_back(pEvent);
@@ -90,12 +330,19 @@ namespace Falcor
     void Profiler::startEvent(const HashedString& name, EventData* pData)
     {
         pData->cpuStart = CpuTimer::getCurrentTimePoint();
+        if (getTraceCapture().recording.load(std::memory_order_relaxed))
+        {
+            recordTraceEvent(name, TraceRecord::Type::Begin, getTraceTime(pData->cpuStart));
+        }
+
         EventData::FrameData& frame = pData->frameData[sGpuTimerIndex];
         if (frame.currentTimer >= frame.pTimers.size())
         {
             frame.pTimers.push_back(GpuTimer::create());
+            frame.cpuStart.push_back(pData->cpuStart);
         }
         frame.pTimers[frame.currentTimer]->begin();
+        frame.cpuStart[frame.currentTimer] = pData->cpuStart;
         pData->callStack.push(frame.currentTimer);
         frame.currentTimer++;
         sCurrentLevel++;
@@ -105,6 +352,10 @@ namespace Falcor
     {
         pData->cpuEnd = CpuTimer::getCurrentTimePoint();
         pData->cpuTotal += CpuTimer::calcDuration(pData->cpuStart, pData->cpuEnd);
+        if (getTraceCapture().recording.load(std::memory_order_relaxed))
+        {
+            recordTraceEvent(name, TraceRecord::Type::End, getTraceTime(pData->cpuEnd));
+        }
 
         pData->frameData[sGpuTimerIndex].pTimers[pData->callStack.top()]->end();
         pData->callStack.pop();
@@ -116,15 +367,37 @@ namespace Falcor
     {
         profileResults = "Name\t\t\tCPU time(ms)\t\t\tGPU time(ms)\n";
 
+        // GPU timestamps are in their own clock domain. The first resolved event is aligned with its CPU start time and the others keep their offset from it.
+        TraceCapture& capture = getTraceCapture();
+        const bool traceGpu = capture.frameRecorded[1 - sGpuTimerIndex];
+        bool gpuClockAligned = false;
+        double gpuToTraceMs = 0;
+
 		for (EventData* pData : sProfilerVector)
 		{
             double gpuTime = 0;
-            for(size_t i = 0 ; i < pData->frameData[1 - sGpuTimerIndex].currentTimer ; i++)
+            EventData::FrameData& frame = pData->frameData[1 - sGpuTimerIndex];
+            for(size_t i = 0 ; i < frame.currentTimer ; i++)
             {
-                gpuTime += pData->frameData[1 - sGpuTimerIndex].pTimers[i]->getElapsedTime();
+                double beginTime, endTime;
+                if (frame.pTimers[i]->getTimestamps(beginTime, endTime) == false)
+                {
+                    continue;
+                }
+                gpuTime += endTime - beginTime;
+
+                if (traceGpu)
+                {
+                    if (gpuClockAligned == false)
+                    {
+                        gpuToTraceMs = double(getTraceTime(frame.cpuStart[i]) - capture.startNs) * 1.0e-6 - beginTime;
+                        gpuClockAligned = true;
+                    }
+                    capture.gpuEvents.push_back({ pData->nameHash, beginTime + gpuToTraceMs, endTime - beginTime });
+                }
             }
 
-            pData->frameData[1 - sGpuTimerIndex].currentTimer = 0;
+            frame.currentTimer = 0;
             assert(pData->callStack.empty());
 
 			char event[1000];
@@ -154,9 +427,81 @@ namespace Falcor
             profileResults += event;
         }
 
+        updateTraceCapture();
         sGpuTimerIndex = 1 - sGpuTimerIndex;
     }
 
+    void Profiler::updateTraceCapture()
+    {
+        TraceCapture& capture = getTraceCapture();
+        capture.frameRecorded[1 - sGpuTimerIndex] = false;
+
+        if (capture.recording.load(std::memory_order_relaxed))
+        {
+            capture.frameRecorded[sGpuTimerIndex] = true;
+            if (--capture.framesLeft == 0)
+            {
+                capture.recording.store(false, std::memory_order_relaxed);
+            }
+        }
+        else if (capture.writePending && capture.frameRecorded[sGpuTimerIndex] == false)
+        {
+            // The GPU times of the last recorded frame were resolved above
+            writeTrace(capture);
+            capture.writePending = false;
+        }
+    }
+
+    void Profiler::startTraceCapture(uint32_t frameCount, const std::string& filename)
+    {
+        TraceCapture& capture = getTraceCapture();
+        if (capture.writePending)
+        {
+            logWarning("Profiler::startTraceCapture() was called while another capture is in progress. Ignoring call.");
+            return;
+        }
+        if (frameCount == 0)
+        {
+            return;
+        }
+
+        capture.filename = filename;
+        capture.framesLeft = frameCount;
+        capture.writePending = true;
+        capture.startNs = getTraceTime(CpuTimer::getCurrentTimePoint());
+        capture.gpuEvents.clear();
+        capture.recording.store(true, std::memory_order_relaxed);
+    }
+
+    bool Profiler::isTraceCaptureActive()
+    {
+        return getTraceCapture().writePending;
+    }
+
+    void Profiler::startTraceEvent(const HashedString& name)
+    {
+        if (getTraceCapture().recording.load(std::memory_order_relaxed))
+        {
+            recordTraceEvent(name, TraceRecord::Type::Begin, getTraceTime(CpuTimer::getCurrentTimePoint()));
+        }
+    }
+
+    void Profiler::endTraceEvent(const HashedString& name)
+    {
+        if (getTraceCapture().recording.load(std::memory_order_relaxed))
+        {
+            recordTraceEvent(name, TraceRecord::Type::End, getTraceTime(CpuTimer::getCurrentTimePoint()));
+        }
+    }
+
+    void Profiler::setTraceThreadName(const std::string& name)
+    {
+        TraceBuffer* pBuffer = getThreadTraceBuffer();
+        TraceCapture& capture = getTraceCapture();
+        std::lock_guard<std::mutex> lock(capture.mutex);
+        pBuffer->threadName = name;
+    }
+
 #if _PROFILING_LOG == 1
 	void Profiler::flushLog() {
 		for (EventData* pData : sProfilerVector)
@@ -70,9 +70,11 @@ namespace Falcor
         {
             virtual ~EventData() {}
             std::string name;
+            size_t nameHash = 0;
             struct FrameData
             {
                 std::vector<GpuTimer::SharedPtr> pTimers;
+                std::vector<CpuTimer::TimePoint> cpuStart; // CPU start time of each timer, used to place the GPU times in captured traces
                 size_t currentTimer = 0;
             };
             FrameData frameData[2]; // Double-buffering, to avoid GPU flushes
@@ -148,11 +150,42 @@ namespace Falcor
         */
         static void clearEvents();
 
+        /** Start capturing a timeline trace of the next frames.
+            While the capture is active, every thread records the begin/end time of its events into its own lock-free ring buffer. The GPU times of the events started with startEvent() are added on a separate track once they're resolved.
+            When the last frame's GPU times are available the trace is written in the Chrome trace event JSON format, which can be opened in chrome://tracing or the Perfetto UI.
+            The capture advances in endFrame(), which must be called every frame while the capture is active.
+            \param[in] frameCount Number of frames to capture
+            \param[in] filename The output file
+        */
+        static void startTraceCapture(uint32_t frameCount, const std::string& filename);
+
+        /** Check if a trace capture is in progress, including the frame used to collect the last GPU times.
+        */
+        static bool isTraceCaptureActive();
+
+        /** Record the start of a CPU event in the calling thread's trace. Can be called from any thread, does nothing when no capture is active.
+            Unlike startEvent(), the event isn't added to the event hierarchy and has no GPU timer.
+            \param[in] name The event name.
+        */
+        static void startTraceEvent(const HashedString& name);
+
+        /** Record the end of a CPU event in the calling thread's trace. Can be called from any thread, does nothing when no capture is active.
+            \param[in] name The event name.
+        */
+        static void endTraceEvent(const HashedString& name);
+
+        /** Set the name of the calling thread's track in the captured traces.
+            \param[in] name The thread name.
+        */
+        static void setTraceThreadName(const std::string& name);
+
     private:
         static std::map<size_t, EventData*> sProfilerEvents;
         static std::vector<EventData*> sProfilerVector;
         static uint32_t sCurrentLevel;
         static uint32_t sGpuTimerIndex;
+
+        static void updateTraceCapture();
     };
 
     /** Helper class for starting and ending profiling events.
@@ -164,10 +197,28 @@ namespace Falcor
     public:
         /** C'tor
         */
-        ProfilerEvent(const HashedString& name) : mName(name) { if(gProfileEnabled) { Profiler::startEvent(name); } }
+        ProfilerEvent(const HashedString& name) : mName(name), mActive(gProfileEnabled || Profiler::isTraceCaptureActive()) { if(mActive) { Profiler::startEvent(name); } }
+        /** D'tor
+        */
+        ~ProfilerEvent() { if(mActive) {Profiler::endEvent(mName); }}
+
+    private:
+        const HashedString mName;
+        const bool mActive;
+    };
+
+    /** Helper class for recording CPU-only trace events, see Profiler#startTraceEvent().
+        Unlike ProfilerEvent, this is safe to use from any thread. The PROFILE_CPU macro should be used instead of directly creating TraceEvent objects.
+    */
+    class TraceEvent
+    {
+    public:
+        /** C'tor
+        */
+        TraceEvent(const HashedString& name) : mName(name) { Profiler::startTraceEvent(name); }
         /** D'tor
         */
-        ~ProfilerEvent() { if(gProfileEnabled) {Profiler::endEvent(mName); }}
+        ~TraceEvent() { Profiler::endTraceEvent(mName); }
 
     private:
         const HashedString mName;
@@ -175,7 +226,9 @@ namespace Falcor
 
 #if _PROFILING_ENABLED
 #define PROFILE(_name) static const Falcor::HashedString hashed ## _name(#_name); Falcor::ProfilerEvent _profileEvent(hashed ## _name);
+#define PROFILE_CPU(_name) static const Falcor::HashedString hashed ## _name(#_name); Falcor::TraceEvent _traceEvent(hashed ## _name);
 #else
 #define PROFILE(_name)
+#define PROFILE_CPU(_name)
 #endif
 }
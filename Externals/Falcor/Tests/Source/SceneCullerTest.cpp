@@ -0,0 +1,147 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "SceneCullerTest.h"
+
+void SceneCullerTest::addTests()
+{
+    addTestToList<TestRemoveThenAdd>();
+    addTestToList<TestUniqueVersions>();
+}
+
+testing_func(SceneCullerTest, TestRemoveThenAdd)
+{
+    Model::SharedPtr pModel = createTriangleModel();
+    Camera::SharedPtr pCamera = createCamera();
+
+    // The first instance keeps the model in the scene, the second slot is replaced over and over
+    Scene::SharedPtr pScene = Scene::create();
+    pScene->addModelInstance(pModel, "anchor", glm::vec3(0, 0, -5));
+    pScene->addModelInstance(pModel, "instance", glm::vec3(0, 0, -10));
+    SceneCuller::SharedPtr pCuller = SceneCuller::create(pScene);
+
+    // Deleting an instance and creating the next one usually reuses its memory. Alternating in front of and behind the camera makes
+    // stale bounds show up as a wrong visibility result.
+    uint32_t reusedCount = 0;
+    const Scene::ModelInstance* pPrevInstance = nullptr;
+    for (uint32_t i = 0; i < 32; ++i)
+    {
+        const bool inFront = (i % 2) == 0;
+        if (i > 0)
+        {
+            pScene->deleteModelInstance(0, 1);
+            pScene->addModelInstance(pModel, "instance", glm::vec3(0, 0, inFront ? -10.0f : 10.0f));
+        }
+
+        const Scene::ModelInstance* pInstance = pScene->getModelInstance(0, 1).get();
+        reusedCount += (pInstance == pPrevInstance) ? 1 : 0;
+        pPrevInstance = pInstance;
+
+        pCuller->cull(pCamera.get());
+        if (pCuller->getEntryCount() != 2 || pCuller->isEntryVisible(pCuller->getFirstEntry(0, 0)) == false)
+        {
+            return test_fail("The instance which was never replaced isn't visible");
+        }
+        if (pCuller->isEntryVisible(pCuller->getFirstEntry(0, 1)) != inFront)
+        {
+            return test_fail("Instance " + std::to_string(i) + " was culled with the bounds of the instance it replaced");
+        }
+    }
+
+    logInfo("SceneCullerTest: " + std::to_string(reusedCount) + " of 31 replaced instances reused the previous address");
+    return test_pass();
+}
+
+testing_func(SceneCullerTest, TestUniqueVersions)
+{
+    Model::SharedPtr pModel = createTriangleModel();
+    Scene::ModelInstance::SharedPtr pFirst = Scene::ModelInstance::create(pModel, glm::vec3(0), glm::vec3(0), glm::vec3(1));
+    Scene::ModelInstance::SharedPtr pSecond = Scene::ModelInstance::create(pModel, glm::vec3(0), glm::vec3(0), glm::vec3(1));
+
+    // Two instances with the same history must still report different versions
+    const uint64_t firstVersion = pFirst->getTransformVersion();
+    const uint64_t secondVersion = pSecond->getTransformVersion();
+    if (firstVersion == 0 || secondVersion == 0 || firstVersion == secondVersion)
+    {
+        return test_fail("Transform versions of new instances are not unique");
+    }
+
+    if (pFirst->getTransformVersion() != firstVersion)
+    {
+        return test_fail("Transform version changed without a transform change");
+    }
+
+    pFirst->setTranslation(glm::vec3(1, 0, 0), true);
+    const uint64_t movedVersion = pFirst->getTransformVersion();
+    if (movedVersion == firstVersion || movedVersion == secondVersion)
+    {
+        return test_fail("Transform version of a moved instance was seen before");
+    }
+
+    return test_pass();
+}
+
+Model::SharedPtr SceneCullerTest::createTriangleModel()
+{
+    const glm::vec3 positions[3] = { glm::vec3(-1, -1, 0), glm::vec3(1, -1, 0), glm::vec3(0, 1, 0) };
+    const uint32_t indices[3] = { 0, 1, 2 };
+
+    Vao::BufferVec vertexBuffers = { Buffer::create(sizeof(positions), Resource::BindFlags::Vertex, Buffer::CpuAccess::None, positions) };
+    Buffer::SharedPtr pIndexBuffer = Buffer::create(sizeof(indices), Resource::BindFlags::Index, Buffer::CpuAccess::None, indices);
+
+    VertexBufferLayout::SharedPtr pBufferLayout = VertexBufferLayout::create();
+    pBufferLayout->addElement(VERTEX_POSITION_NAME, 0, ResourceFormat::RGB32Float, 1, VERTEX_POSITION_LOC);
+    VertexLayout::SharedPtr pLayout = VertexLayout::create();
+    pLayout->addBufferLayout(0, pBufferLayout);
+
+    const BoundingBox box = BoundingBox::fromMinMax(glm::vec3(-1, -1, 0), glm::vec3(1, 1, 0));
+    Mesh::SharedPtr pMesh = Mesh::create(vertexBuffers, 3, pIndexBuffer, 3, pLayout, Vao::Topology::TriangleList, Material::create("Triangle"), box, false);
+
+    Model::SharedPtr pModel = Model::create();
+    pModel->addMeshInstance(pMesh, glm::mat4());
+    return pModel;
+}
+
+Camera::SharedPtr SceneCullerTest::createCamera()
+{
+    // Looks down -Z, objects at positive Z are behind it
+    Camera::SharedPtr pCamera = Camera::create();
+    pCamera->setPosition(glm::vec3(0));
+    pCamera->setTarget(glm::vec3(0, 0, -1));
+    pCamera->setUpVector(glm::vec3(0, 1, 0));
+    pCamera->setDepthRange(0.1f, 100.0f);
+    pCamera->setAspectRatio(1.0f);
+    return pCamera;
+}
+
+int main()
+{
+    SceneCullerTest sct;
+    sct.init(true);
+    sct.run();
+    return 0;
+}
@@ -1,5 +1,5 @@
 /***************************************************************************
-# Copyright (c) 2017, NVIDIA CORPORATION. All rights reserved.
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
 #
 # Redistribution and use in source and binary forms, with or without
 # modification, are permitted provided that the following conditions
@@ -25,29 +25,18 @@
 # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
-#include <thread>
+#pragma once
+#include "TestBase.h"
+#include "Graphics/Scene/SceneCuller.h"
 
-template<uint32_t threadCount>
-class ThreadPool
+class SceneCullerTest : public TestBase
 {
-public:
-    ~ThreadPool()
-    {
-        for (auto& t : mThreads)
-        {
-            if (t.joinable()) t.join();
-        }
-    }
-
-    std::thread& getAvailable()
-    {
-        std::thread& t = mThreads[mCurrent];
-        if (t.joinable()) t.join();
-        mCurrent = (mCurrent + 1) % arraysize(mThreads);
-        return t;
-    }
-
 private:
-    std::thread mThreads[threadCount];
-    uint32_t mCurrent = 0;
-};
\ No newline at end of file
+    void addTests() override;
+    void onInit() override {};
+    register_testing_func(TestRemoveThenAdd);
+    register_testing_func(TestUniqueVersions);
+
+    static Model::SharedPtr createTriangleModel();
+    static Camera::SharedPtr createCamera();
+};
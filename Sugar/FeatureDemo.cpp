@@ -27,6 +27,13 @@
 ***************************************************************************/
 #include "FeatureDemo.h"
 #include "SceneMitsubaExporter.h"
+#include "Utils/PathTracer/ReferencePathTracer.h"
+#include "Utils/Geometry/GeometryUtility.h"
+#include "Utils/LTC/LTC.h"
+#include "Graphics/LightBVH.h"
+#include "Testing/GeoSphereBenchmark.h"
+#include "Testing/Validation.h"
+#include <unordered_set>
 
 //  Halton Sampler Pattern.
 static const float kHaltonSamplePattern[8][2] = { { 1.0f / 2.0f - 0.5f, 1.0f / 3.0f - 0.5f },
@@ -59,6 +66,7 @@ void FeatureDemo::initLightingPass()
     mLightingPass.pProgram = GraphicsProgram::createFromFile("FeatureDemo.vs.slang", "FeatureDemo.ps.slang");
     mLightingPass.pProgram->addDefine("_LIGHT_COUNT", std::to_string(mpSceneRenderer->getScene()->getLightCount()));
     initControls();
+    mPrecompileLightingVersions = true;
     mLightingPass.pVars = GraphicsVars::create(mLightingPass.pProgram->getActiveVersion()->getReflector());
     
     DepthStencilState::Desc dsDesc;
@@ -183,6 +191,7 @@ void FeatureDemo::resetScene()
     mSkyBox.pEffect = nullptr;
     mpEnvMap = nullptr;
     mpEditor = nullptr;
+    mpLightClusters = nullptr;
 }
 
 void FeatureDemo::loadModel(const std::string& filename, bool showProgressBar)
@@ -196,10 +205,12 @@ void FeatureDemo::loadModel(const std::string& filename, bool showProgressBar)
         pBar = ProgressBar::create("Loading Model");
     }
 
-    Model::SharedPtr pModel = Model::createFromFile(filename.c_str());
+    CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+    Model::SharedPtr pModel = Model::createFromFile(filename.c_str(), mModelLoadFlags);
     if (!pModel) return;
     Scene::SharedPtr pScene = Scene::create();
     pScene->addModelInstance(pModel, "instance");
+    logSceneStats(pScene.get(), filename, CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()));
 
     initScene(pScene);
 }
@@ -215,15 +226,56 @@ void FeatureDemo::loadScene(const std::string& filename, bool showProgressBar)
         pBar = ProgressBar::create("Loading Scene", 100);
     }
 
-    Scene::SharedPtr pScene = Scene::loadFromFile(filename, Model::LoadFlags::None, Scene::LoadFlags::GenerateAreaLights | Scene::LoadFlags::StoreMaterialHistory);
+    CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+    Scene::SharedPtr pScene = Scene::loadFromFile(filename, mModelLoadFlags, Scene::LoadFlags::GenerateAreaLights | Scene::LoadFlags::StoreMaterialHistory);
 
     if (pScene != nullptr)
     {
+        logSceneStats(pScene.get(), filename, CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()));
         initScene(pScene);
         applyCustomSceneVars(pScene.get(), filename);
     }
 }
 
+void FeatureDemo::logSceneStats(const Scene* pScene, const std::string& filename, float loadMs)
+{
+    // The importers log the ACMR/ATVR before and after optimizing each model, and the vertex buffer sizes before and after packing.
+    // Load the same scene with and without the switches to compare the totals and load times
+    uint32_t meshCount = 0;
+    uint64_t vertexCount = 0;
+    uint64_t triangleCount = 0;
+    uint64_t vertexBufferBytes = 0;
+    std::unordered_set<const Buffer*> vertexBuffers;
+    for (uint32_t i = 0; i < pScene->getModelCount(); i++)
+    {
+        const Model* pModel = pScene->getModel(i).get();
+        meshCount += pModel->getMeshCount();
+        vertexCount += pModel->getVertexCount();
+        triangleCount += pModel->getPrimitiveCount();
+
+        // Meshes can share vertex buffers
+        for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+        {
+            const Vao* pVao = pModel->getMesh(meshID)->getVao().get();
+            for (uint32_t b = 0; b < pVao->getVertexBuffersCount(); b++)
+            {
+                const Buffer* pBuffer = pVao->getVertexBuffer(b).get();
+                if (pBuffer && vertexBuffers.insert(pBuffer).second)
+                {
+                    vertexBufferBytes += pBuffer->getSize();
+                }
+            }
+        }
+    }
+
+    std::string flags;
+    if (is_set(mModelLoadFlags, Model::LoadFlags::OptimizeMeshes)) flags += " OptimizeMeshes";
+    if (is_set(mModelLoadFlags, Model::LoadFlags::PackVertexAttributes)) flags += " PackVertexAttributes";
+    if (is_set(mModelLoadFlags, Model::LoadFlags::QuantizePositions)) flags += " QuantizePositions";
+    logInfo("Loaded '" + filename + "' in " + std::to_string(loadMs) + " ms, flags:" + (flags.empty() ? " None" : flags) + ". " + std::to_string(pScene->getModelCount()) + " models, " + std::to_string(meshCount) + " meshes, " +
+        std::to_string(vertexCount) + " vertices, " + std::to_string(triangleCount) + " triangles, " + std::to_string(vertexBufferBytes) + " vertex buffer bytes");
+}
+
 void FeatureDemo::initSkyBox(const std::string& name)
 {
     Sampler::Desc samplerDesc;
@@ -367,6 +419,16 @@ void FeatureDemo::lightingPass()
     mLightingPass.pVars->setTexture("gLtcAmp", mpLtcAmp);
     mLightingPass.pVars->setSampler("gLtcSampler", mpLtcSamp);
 
+    if (mControls[EnableClusteredLighting].enabled)
+    {
+        if (mpLightClusters == nullptr)
+        {
+            mpLightClusters = LightClusters::create(LightClusters::Desc());
+        }
+        mpLightClusters->build(mpSceneRenderer->getScene().get(), getActiveCamera());
+        mpLightClusters->setIntoProgramVars(mLightingPass.pVars.get(), mpMainFbo->getWidth(), mpMainFbo->getHeight());
+    }
+
     if(mControls[EnableTransparency].enabled)
     {
         renderOpaqueObjects();
@@ -483,7 +545,7 @@ void FeatureDemo::renderingComparisonWithMitsuba()
     if (mCompareWithMitsuba)
     {
         mCompareWithMitsuba = false;
-        compareSceneWithMitsuba(mpResolveFbo->getColorTexture(0).get(), mpSceneRenderer->getScene().get(), getActiveCamera(), mMitsubaForceRender);
+        compareSceneWithMitsuba(mpResolveFbo->getColorTexture(0).get(), mpSceneRenderer->getScene(), getActiveCamera(), mMitsubaForceRender);
     }
 }
 
@@ -517,6 +579,12 @@ void FeatureDemo::onFrameRender()
         mpState->setFbo(mpMainFbo);
         renderSkyBox();
         lightingPass();
+        if (mPrecompileLightingVersions)
+        {
+            // After the first frame, so the defines added by the scene renderer are part of the versions
+            mPrecompileLightingVersions = false;
+            precompileLightingVersions();
+        }
         renderEditor();
         antiAliasing();
         renderingComparisonWithMitsuba();
@@ -585,6 +653,12 @@ bool FeatureDemo::onMouseEvent(const MouseEvent& mouseEvent)
     return mpSceneRenderer ? mpSceneRenderer->onMouseEvent(mouseEvent) : true;
 }
 
+void FeatureDemo::onShutdown()
+{
+    // The generated mesh cache is a static that outlives the sample. Release its buffers while the device still exists.
+    ClearGeneratedMeshCache();
+}
+
 void FeatureDemo::onResizeSwapChain()
 {
     uint32_t w = mpDefaultFBO->getWidth();
@@ -628,11 +702,25 @@ void FeatureDemo::saveSceneToMitsuba(const Scene* pScene)
         info.mViewportWidth = gpDevice->getSwapChainFbo()->getWidth();
         info.mViewportHeight = gpDevice->getSwapChainFbo()->getHeight();
         info.sampleCount = mMitsubaSampleCount;
+        info.mShowProgressBar = true;
         SceneMitsubaExporter::saveScene(filename, pScene, info);
     }
 }
 
-void FeatureDemo::compareSceneWithMitsuba(Texture* pFalcorCapture, const Scene* pScene, const Camera* pActivaCamera, bool mitsubaRender)
+void FeatureDemo::saveScenePackage(const Scene::SharedPtr& pScene)
+{
+    std::string filename;
+    if (saveFileDialog(ScenePackage::kFileFormatString, filename))
+    {
+        if (hasSuffix(filename, ScenePackage::kFileExtension, false) == false)
+        {
+            filename += ScenePackage::kFileExtension;
+        }
+        ScenePackage::saveScene(filename, pScene);
+    }
+}
+
+void FeatureDemo::compareSceneWithMitsuba(Texture* pFalcorCapture, const Scene::SharedPtr& pScene, const Camera* pActivaCamera, bool mitsubaRender)
 {
     const std::string executableName = getExecutableName();
     const std::string outputDirectory = getTempDirectory();
@@ -641,51 +729,68 @@ void FeatureDemo::compareSceneWithMitsuba(Texture* pFalcorCapture, const Scene*
     std::string mitsubaRenderedFile;
     std::string falcorRenderedFile;
     if (!findAvailableFilename(executableName + "_scene", outputDirectory, "xml", mitsubaSceneFile) ||
-        !findAvailableFilename(executableName + "_mitsuba", outputDirectory, "exr", mitsubaRenderedFile) ||
+        !findAvailableFilename(executableName + (mUseReferencePathTracer ? "_reference" : "_mitsuba"), outputDirectory, "exr", mitsubaRenderedFile) ||
         !findAvailableFilename(executableName + "_falcor", outputDirectory, "exr", falcorRenderedFile))
     {
         logError("Could not find available filename for rendering comparison");
         return;
     }
 
-    // save screenshot
-    pFalcorCapture->captureToFile(0, 0, falcorRenderedFile, Bitmap::FileFormat::ExrFile);
+    // save screenshot, the file is written in the background while the reference image is rendered
+    FrameCapture::Future falcorCaptureResult = getFrameCapture()->captureToFile(pFalcorCapture, 0, 0, falcorRenderedFile, Bitmap::FileFormat::ExrFile);
 
-    const bool isMtsFilesExist = doesFileExist(mLastMitsubaSceneFile) && doesFileExist(mLastMitsubaRenderedFile);
-    if (mitsubaRender || !isMtsFilesExist)
+    if (mUseReferencePathTracer)
     {
-        // export mitsuba scene file
-        SceneMitsubaExporter::MitsubaCfg info;
-        info.mViewportWidth = gpDevice->getSwapChainFbo()->getWidth();
-        info.mViewportHeight = gpDevice->getSwapChainFbo()->getHeight();
-        info.mpCamera = pActivaCamera;
-        info.sampleCount = mMitsubaSampleCount;
-        SceneMitsubaExporter::saveScene(mitsubaSceneFile, pScene, info);
-
-        // rendered by mitsuba
-        std::string opts = "-o \"" + mitsubaRenderedFile + "\"";
-        opts += " \"" + mitsubaSceneFile + "\"";
-        Falcor::createProcess("mitsuba", opts, true);
-
-        mLastMitsubaSceneFile = mitsubaSceneFile;
-        mLastMitsubaRenderedFile = mitsubaRenderedFile;
+        if (mitsubaRender || !doesFileExist(mLastReferenceRenderedFile))
+        {
+            // rendered in-process, the image file is rewritten after every pass
+            ReferencePathTracer::Desc desc;
+            desc.width = gpDevice->getSwapChainFbo()->getWidth();
+            desc.height = gpDevice->getSwapChainFbo()->getHeight();
+            desc.samplesPerPixel = (uint32_t)std::max(1, mMitsubaSampleCount);
+            desc.outputFilename = mitsubaRenderedFile;
+            ReferencePathTracer::create(pScene)->render(pActivaCamera, desc);
+
+            mLastReferenceRenderedFile = mitsubaRenderedFile;
+        }
+        else
+        {
+            mitsubaRenderedFile = mLastReferenceRenderedFile;
+        }
     }
     else
     {
-        mitsubaSceneFile = mLastMitsubaSceneFile;
-        mitsubaRenderedFile = mLastMitsubaRenderedFile;
+        const bool isMtsFilesExist = doesFileExist(mLastMitsubaSceneFile) && doesFileExist(mLastMitsubaRenderedFile);
+        if (mitsubaRender || !isMtsFilesExist)
+        {
+            // export mitsuba scene file
+            SceneMitsubaExporter::MitsubaCfg info;
+            info.mViewportWidth = gpDevice->getSwapChainFbo()->getWidth();
+            info.mViewportHeight = gpDevice->getSwapChainFbo()->getHeight();
+            info.mpCamera = pActivaCamera;
+            info.sampleCount = mMitsubaSampleCount;
+            info.mShowProgressBar = true;
+            SceneMitsubaExporter::saveScene(mitsubaSceneFile, pScene.get(), info);
+
+            // rendered by mitsuba
+            std::string opts = "-o \"" + mitsubaRenderedFile + "\"";
+            opts += " \"" + mitsubaSceneFile + "\"";
+            Falcor::createProcess("mitsuba", opts, true);
+
+            mLastMitsubaSceneFile = mitsubaSceneFile;
+            mLastMitsubaRenderedFile = mitsubaRenderedFile;
+        }
+        else
+        {
+            mitsubaSceneFile = mLastMitsubaSceneFile;
+            mitsubaRenderedFile = mLastMitsubaRenderedFile;
+        }
     }
 
+    if (!falcorCaptureResult.get())
     {
-        // wait for screenshot saving thread
-        int counter = 20;
-        while (counter > 0)
-        {
-            if (doesFileExist(falcorRenderedFile)) { break; }
-
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-            --counter;
-        }
+        logError("Failed to capture " + falcorRenderedFile + " for rendering comparison");
+        return;
     }
 
     // launch ImageComparer
@@ -697,6 +802,21 @@ void FeatureDemo::compareSceneWithMitsuba(Texture* pFalcorCapture, const Scene*
 
 void FeatureDemo::onInitializeTesting()
 {
+    if (mArgList.argExists("optimizemeshes"))
+    {
+        mModelLoadFlags |= Model::LoadFlags::OptimizeMeshes;
+    }
+
+    if (mArgList.argExists("packvertices"))
+    {
+        mModelLoadFlags |= Model::LoadFlags::PackVertexAttributes;
+    }
+
+    if (mArgList.argExists("quantizepositions"))
+    {
+        mModelLoadFlags |= Model::LoadFlags::QuantizePositions;
+    }
+
     std::vector<ArgList::Arg> model = mArgList.getValues("loadmodel");
     if (!model.empty())
     {
@@ -720,6 +840,62 @@ void FeatureDemo::onInitializeTesting()
     {
         getActiveCamera()->setTarget(glm::vec3(cameraTarget[0].asFloat(), cameraTarget[1].asFloat(), cameraTarget[2].asFloat()));
     }
+
+    if (mArgList.argExists("instancedatabuffer") && mpSceneRenderer)
+    {
+        mControls[ControlID::EnableInstanceDataBuffer].enabled = true;
+        applyLightingProgramControl(ControlID::EnableInstanceDataBuffer);
+    }
+
+    if (mArgList.argExists("benchgeosphere"))
+    {
+        for (size_t tessellation = 1; tessellation <= 8; ++tessellation)
+        {
+            float referenceMs;
+            float ms = MeasureGeoSphereGenerationTime(tessellation, referenceMs);
+            logInfo("GeoSphere tessellation " + std::to_string(tessellation) + ": " + std::to_string(referenceMs) + " ms -> " + std::to_string(ms) + " ms, " + std::to_string(ms > 0 ? referenceMs / ms : 0.0f) + "x faster");
+        }
+    }
+
+    if (mArgList.argExists("benchmeshopt"))
+    {
+        for (size_t tessellation = 4; tessellation <= 64; tessellation *= 2)
+        {
+            MeshOptimizer::Stats before, after;
+            float ms = MeasureMeshOptimization(tessellation, before, after);
+            logInfo("Mesh optimization, " + std::to_string(after.triangleCount) + " triangles: " + std::to_string(ms) + " ms. ACMR " + std::to_string(before.getAcmr()) + " -> " + std::to_string(after.getAcmr()) +
+                ", ATVR " + std::to_string(before.getAtvr()) + " -> " + std::to_string(after.getAtvr()));
+        }
+    }
+
+    if (mArgList.argExists("validateltc"))
+    {
+        Ltc::Table::SharedPtr pTable = Ltc::Table::create(mpLtcMat.get(), mpLtcAmp.get());
+        Ltc::ValidationReport report = Ltc::validate(pTable.get());
+        std::vector<std::string> details;
+        details.push_back("batch vs scalar max error " + std::to_string(report.maxBatchError) + ", Lambert vs Monte Carlo max error " + std::to_string(report.maxLambertError) + " sigma");
+        if (pTable)
+        {
+            details.push_back("GGX fit vs Monte Carlo relative error mean " + std::to_string(report.meanGgxRelativeError) + ", max " + std::to_string(report.maxGgxRelativeError));
+        }
+        details.push_back("scalar " + std::to_string(report.scalarNsPerPoint) + " ns/point, " + std::to_string(Ltc::getBatchLaneCount()) + "-wide batch " + std::to_string(report.batchNsPerPoint) + " ns/point");
+        logValidationReport("LTC", report, details);
+    }
+
+    if (mArgList.argExists("validateclusters"))
+    {
+        LightClusters::ValidationReport report = LightClusters::validate();
+        logValidationReport("Light cluster", report, {
+            std::to_string(report.meanListedLightCount) + " lights listed per point, " + std::to_string(report.meanReachingLightCount) + " reach it. Build " + std::to_string(report.buildMs) + " ms" });
+    }
+
+    if (mArgList.argExists("validatelightbvh"))
+    {
+        LightBVH::ValidationReport report = LightBVH::validate();
+        logValidationReport("Light BVH", report, {
+            std::to_string(report.zeroPmfCount) + " reaching lights with pmf 0, " + std::to_string(report.pmfMismatchCount) + " pmf mismatches, " + std::to_string(report.intensityRebuildCount) + " rebuilds after intensity changes",
+            "variance reduction vs uniform selection " + std::to_string(report.varianceRatioUniform) + "x, vs power selection " + std::to_string(report.varianceRatioPower) + "x" });
+    }
 }
 
 #ifdef _WIN32
@@ -30,6 +30,7 @@
 #include "SampleTest.h"
 #include "FeatureDemoSceneRenderer.h"
 #include "SugarSceneEditor.h"
+#include "Graphics/LightClusters.h"
 
 using namespace Falcor;
 
@@ -39,6 +40,7 @@ public:
     void onLoad() override;
     void onFrameRender() override;
     void onResizeSwapChain() override;
+    void onShutdown() override;
     bool onKeyEvent(const KeyboardEvent& keyEvent) override;
     bool onMouseEvent(const MouseEvent& mouseEvent) override;
     void onGuiRender() override;
@@ -155,6 +157,7 @@ private:
     FeatureDemoSceneRenderer::SharedPtr mpSceneRenderer;
     void loadModel(const std::string& filename, bool showProgressBar);
     void loadScene(const std::string& filename, bool showProgressBar);
+    void logSceneStats(const Scene* pScene, const std::string& filename, float loadMs);
     void initScene(Scene::SharedPtr pScene);
     void applyCustomSceneVars(const Scene* pScene, const std::string& filename);
     void resetScene();
@@ -164,6 +167,9 @@ private:
 
     Camera* getActiveCamera() const;
 
+    // Flags used for every model and scene load, set from the command line
+    Model::LoadFlags mModelLoadFlags = Model::LoadFlags::None;
+
     Texture::SharedPtr mpLtcMat;
     Texture::SharedPtr mpLtcAmp;
     Sampler::SharedPtr mpLtcSamp;
@@ -171,6 +177,8 @@ private:
     Texture::SharedPtr mpEnvMap;
     Sampler::SharedPtr mpSceneSampler;
 
+    LightClusters::SharedPtr mpLightClusters;
+
     struct ProgramControl
     {
         bool enabled;
@@ -189,6 +197,8 @@ private:
         EnableHashedAlpha,
         EnableTransparency,
         VisualizeCascades,
+        EnableClusteredLighting,
+        EnableInstanceDataBuffer,
         Count
     };
 
@@ -213,6 +223,9 @@ private:
     void applyAaMode();
     std::vector<ProgramControl> mControls;
     void applyLightingProgramControl(ControlID controlID);
+    static bool isDepthPassControl(uint32_t controlId);
+    bool mPrecompileLightingVersions = false;
+    void precompileLightingVersions();
 
     bool mUseCameraPath = true;
     void applyCameraPathState();
@@ -224,8 +237,11 @@ private:
     int32_t mMitsubaSampleCount = 64;
     bool mCompareWithMitsuba = false;
     bool mMitsubaForceRender = false;
+    bool mUseReferencePathTracer = true;
+    std::string mLastReferenceRenderedFile;
     void saveSceneToMitsuba(const Scene* pScene);
-    void compareSceneWithMitsuba(Texture* pFalcorCapture, const Scene* pScene, const Camera* pActivaCamera, bool mitsubaRender);
+    void saveScenePackage(const Scene::SharedPtr& pScene);
+    void compareSceneWithMitsuba(Texture* pFalcorCapture, const Scene::SharedPtr& pScene, const Camera* pActivaCamera, bool mitsubaRender);
 
     bool mCameraLiveViewMode = false;
     SugarSceneEditor::UniquePtr mpEditor = nullptr;
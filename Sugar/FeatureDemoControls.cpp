@@ -53,6 +53,8 @@ void FeatureDemo::initControls()
     mControls[ControlID::EnableTransparency] = { false, false, "_ENABLE_TRANSPARENCY" };
     mControls[ControlID::EnableSSAO] = { false, false, "" };
     mControls[ControlID::VisualizeCascades] = { false, false, "_VISUALIZE_CASCADES" };
+    mControls[ControlID::EnableClusteredLighting] = { true, false, "_CLUSTERED_LIGHTING" };
+    mControls[ControlID::EnableInstanceDataBuffer] = { false, false, "_INSTANCE_DATA_BUFFER" };
 
     for (uint32_t i = 0 ; i < ControlID::Count ; i++)
     {
@@ -60,23 +62,77 @@ void FeatureDemo::initControls()
     }
 }
 
+// Controls whose define is set on the depth pass program as well
+bool FeatureDemo::isDepthPassControl(uint32_t controlId)
+{
+    return (controlId == ControlID::EnableHashedAlpha) || (controlId == ControlID::EnableInstanceDataBuffer);
+}
+
 void FeatureDemo::applyLightingProgramControl(ControlID controlId)
 {
     const ProgramControl control = mControls[controlId];
     if(control.define.size())
     {
         bool add = control.unsetOnEnabled ? !control.enabled : control.enabled;
+        const bool depthPassControl = isDepthPassControl(controlId);
         if (add)
         {
             mLightingPass.pProgram->addDefine(control.define, control.value);            
-            if (controlId == ControlID::EnableHashedAlpha) mDepthPass.pProgram->addDefine(control.define, control.value);
+            if (depthPassControl) mDepthPass.pProgram->addDefine(control.define, control.value);
         }
         else
         {
             mLightingPass.pProgram->removeDefine(control.define);
-            if (controlId == ControlID::EnableHashedAlpha) mDepthPass.pProgram->removeDefine(control.define);
+            if (depthPassControl) mDepthPass.pProgram->removeDefine(control.define);
         }
     }
+
+    if (controlId == ControlID::EnableInstanceDataBuffer)
+    {
+        // The renderer only binds the instance buffer if the vars were created from a program version which declares it
+        mpSceneRenderer->toggleInstanceDataBuffer(control.enabled);
+        mDepthPass.pVars = GraphicsVars::create(mDepthPass.pProgram->getActiveVersion()->getReflector());
+        mLightingPass.pVars = GraphicsVars::create(mLightingPass.pProgram->getActiveVersion()->getReflector());
+    }
+}
+
+void FeatureDemo::precompileLightingVersions()
+{
+    // Compile the versions reached by toggling a single control, so the first toggle doesn't stall
+    std::vector<Program::DefineList> lightingVersions;
+    std::vector<Program::DefineList> depthVersions;
+    for (uint32_t i = 0; i < ControlID::Count; i++)
+    {
+        const ProgramControl& control = mControls[i];
+        if (control.define.empty() || (i == ControlID::SuperSampling && mAAMode != AAMode::MSAA))
+        {
+            continue;
+        }
+
+        // The toggled control's define is set when the control currently clears it
+        const bool isSet = control.unsetOnEnabled ? control.enabled : !control.enabled;
+        auto toggleDefine = [&](Program::DefineList defines)
+        {
+            if (isSet)
+            {
+                defines.add(control.define, control.value);
+            }
+            else
+            {
+                defines.remove(control.define);
+            }
+            return defines;
+        };
+
+        lightingVersions.push_back(toggleDefine(mLightingPass.pProgram->getActiveDefinesList()));
+        if (isDepthPassControl(i))
+        {
+            depthVersions.push_back(toggleDefine(mDepthPass.pProgram->getActiveDefinesList()));
+        }
+    }
+
+    mLightingPass.pProgram->precompile(lightingVersions);
+    mDepthPass.pProgram->precompile(depthVersions);
 }
 
 void FeatureDemo::applyAaMode()
@@ -118,6 +174,7 @@ void FeatureDemo::applyAaMode()
 void FeatureDemo::onGuiRender()
 {
     static const char* kImageFileString = "Image files\0*.jpg;*.bmp;*.dds;*.png;*.tiff;*.tif;*.tga;*.hdr;*.exr\0\0";
+    static const char* kSceneFileString = "Scene files\0*.fscene;*.fscenepkg\0\0";
     if (mpGui->addButton("Load Model"))
     {
         std::string filename;
@@ -130,7 +187,7 @@ void FeatureDemo::onGuiRender()
     if (mpGui->addButton("Load Scene"))
     {
         std::string filename;
-        if (openFileDialog(Scene::kFileFormatString, filename))
+        if (openFileDialog(kSceneFileString, filename))
         {
             loadScene(filename, true);
         }
@@ -157,6 +214,11 @@ void FeatureDemo::onGuiRender()
             }
         }
 
+        if (mpGui->addButton("Bake Scene Package"))
+        {
+            saveScenePackage(mpSceneRenderer->getScene());
+        }
+
         if (mpGui->beginGroup("Mitsuba"))
         {
             if (mpGui->addButton("Export To Mitsuba"))
@@ -175,6 +237,7 @@ void FeatureDemo::onGuiRender()
             }
 
             mpGui->addSeparator();
+            mpGui->addCheckBox("Use Built-in Path Tracer", mUseReferencePathTracer);
             mpGui->addIntVar("Sampler - Sample Count", mMitsubaSampleCount, 1);
 
             mpGui->endGroup();
@@ -232,6 +295,12 @@ void FeatureDemo::onGuiRender()
 			}
 			mpGui->addTooltip("Create a specialized version of the lighting program for each material in the scene");
 
+			if (mpGui->addCheckBox("Instance Data Buffer", mControls[ControlID::EnableInstanceDataBuffer].enabled))
+			{
+				applyLightingProgramControl(ControlID::EnableInstanceDataBuffer);
+			}
+			mpGui->addTooltip("Read instance transforms from one buffer per frame and draw every instance of a mesh with a single call, instead of per-draw constant buffer arrays");
+
 			uint32_t maxAniso = mpSceneSampler->getMaxAnisotropy();
 			if (mpGui->addIntVar("Max Anisotropy", (int&)maxAniso, 1, 16))
 			{
@@ -325,6 +394,15 @@ void FeatureDemo::onGuiRender()
             mpGui->endGroup();
         }
 
+        if (mpGui->beginGroup("Lights"))
+        {
+            if (mpGui->addCheckBox("Clustered Lighting", mControls[ControlID::EnableClusteredLighting].enabled))
+            {
+                applyLightingProgramControl(ControlID::EnableClusteredLighting);
+            }
+            mpGui->endGroup();
+        }
+
         if (mpGui->beginGroup("SSAO"))
         {
             if (mpGui->addCheckBox("Enable SSAO", mControls[ControlID::EnableSSAO].enabled))
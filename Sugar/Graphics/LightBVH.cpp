@@ -0,0 +1,548 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "LightBVH.h"
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+namespace Falcor
+{
+    const uint32_t LightBVH::kInvalidIndex;
+
+    namespace
+    {
+        const uint32_t kBinCount = 12;
+        const float kRebuildCostRatio = 2.0f;   // Rebuild when refitting made the root this much more expensive than right after the build
+
+        static_assert(sizeof(LightBVH::Node) == 64, "LightBVH::Node must match the layout in LightBVH.slang");
+
+        LightBVH::Node createEmptyNode()
+        {
+            LightBVH::Node node;
+            node.aabbMin = glm::vec3(FLT_MAX);
+            node.aabbMax = glm::vec3(-FLT_MAX);
+            node.axis = glm::vec3(0, 0, 1);
+            node.thetaO = -1;   // No cone yet
+            return node;
+        }
+
+        /** Smallest cone, as an axis and a spread angle, containing two cones
+        */
+        void mergeCones(glm::vec3 axisA, float thetaA, glm::vec3 axisB, float thetaB, glm::vec3& axis, float& theta)
+        {
+            if (thetaB > thetaA)
+            {
+                std::swap(axisA, axisB);
+                std::swap(thetaA, thetaB);
+            }
+
+            const float thetaD = acos(glm::clamp(glm::dot(axisA, axisB), -1.0f, 1.0f));
+            if (std::min(thetaD + thetaB, (float)M_PI) <= thetaA)
+            {
+                axis = axisA;
+                theta = thetaA;
+                return;
+            }
+
+            theta = (thetaA + thetaD + thetaB) * 0.5f;
+            if (theta >= (float)M_PI)
+            {
+                axis = axisA;
+                theta = (float)M_PI;
+                return;
+            }
+
+            // Rotate the axis of the wider cone towards the other one
+            glm::vec3 ortho = axisB - axisA * glm::dot(axisA, axisB);
+            if (glm::dot(ortho, ortho) < 1e-12f)
+            {
+                axis = axisA;
+                theta = (float)M_PI;
+                return;
+            }
+            const float rotation = theta - thetaA;
+            axis = glm::normalize(axisA * cos(rotation) + glm::normalize(ortho) * sin(rotation));
+        }
+
+        LightBVH::Node mergeNodes(const LightBVH::Node& a, const LightBVH::Node& b)
+        {
+            if (a.thetaO < 0) return b;
+            if (b.thetaO < 0) return a;
+
+            LightBVH::Node node;
+            node.aabbMin = glm::min(a.aabbMin, b.aabbMin);
+            node.aabbMax = glm::max(a.aabbMax, b.aabbMax);
+            node.power = a.power + b.power;
+            node.thetaE = std::max(a.thetaE, b.thetaE);
+            mergeCones(a.axis, a.thetaO, b.axis, b.thetaO, node.axis, node.thetaO);
+            return node;
+        }
+
+        bool boundsEqual(const LightBVH::Node& a, const LightBVH::Node& b)
+        {
+            return a.aabbMin == b.aabbMin && a.aabbMax == b.aabbMax && a.power == b.power && a.axis == b.axis && a.thetaO == b.thetaO && a.thetaE == b.thetaE;
+        }
+    }
+
+    LightBVH::SharedPtr LightBVH::create()
+    {
+        return SharedPtr(new LightBVH());
+    }
+
+    bool LightBVH::getLightBounds(const LightData& light, float power, Node& bounds)
+    {
+        bounds = Node();
+        bounds.power = power;
+        bounds.axis = glm::vec3(0, 0, 1);
+        bounds.thetaO = (float)M_PI;
+        bounds.thetaE = (float)M_PI_2;
+
+        switch (light.type)
+        {
+        case LightPoint:
+            bounds.aabbMin = bounds.aabbMax = light.worldPos;
+            if (light.openingAngle < (float)M_PI && glm::dot(light.worldDir, light.worldDir) > 0)
+            {
+                bounds.axis = glm::normalize(light.worldDir);
+                bounds.thetaO = 0;
+                bounds.thetaE = light.openingAngle;
+            }
+            return true;
+        case LightSphere:
+            bounds.aabbMin = light.worldPos - glm::vec3(light.radius);
+            bounds.aabbMax = light.worldPos + glm::vec3(light.radius);
+            return true;
+        case LightPolygonal:
+        {
+            bounds.aabbMin = bounds.aabbMax = glm::vec3(light.vertices[0]);
+            for (uint32_t i = 1; i < 4; i++)
+            {
+                bounds.aabbMin = glm::min(bounds.aabbMin, glm::vec3(light.vertices[i]));
+                bounds.aabbMax = glm::max(bounds.aabbMax, glm::vec3(light.vertices[i]));
+            }
+            // The quad emits on one side only, see ltcEvaluate()
+            glm::vec3 normal = glm::cross(glm::vec3(light.vertices[2] - light.vertices[0]), glm::vec3(light.vertices[3] - light.vertices[1]));
+            if (glm::dot(normal, normal) > 0)
+            {
+                bounds.axis = glm::normalize(normal);
+                bounds.thetaO = 0;
+            }
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+    float LightBVH::getImportance(const Node& node, const glm::vec3& pos, const glm::vec3& normal)
+    {
+        if (node.power <= 0)
+        {
+            return 0;
+        }
+
+        const glm::vec3 center = (node.aabbMin + node.aabbMax) * 0.5f;
+        const float radius = glm::length(node.aabbMax - node.aabbMin) * 0.5f;
+        const glm::vec3 toCenter = center - pos;
+        const float dist2 = glm::dot(toCenter, toCenter);
+
+        // Inside the bounding sphere every direction may receive light
+        if (dist2 <= radius * radius)
+        {
+            return node.power / std::max(radius * radius, 1e-8f);
+        }
+
+        const float dist = sqrt(dist2);
+        const glm::vec3 dir = toCenter / dist;
+        const float thetaU = asin(std::min(radius / dist, 1.0f));
+
+        // Incident angle at the shading point
+        float cosI = 1;
+        if (glm::dot(normal, normal) > 0)
+        {
+            const float thetaI = acos(glm::clamp(glm::dot(normal, dir), -1.0f, 1.0f));
+            cosI = cos(std::max(thetaI - thetaU, 0.0f));
+            if (cosI <= 0)
+            {
+                return 0;
+            }
+        }
+
+        // Emission angle at the lights
+        const float theta = acos(glm::clamp(-glm::dot(node.axis, dir), -1.0f, 1.0f));
+        const float thetaP = std::max(theta - node.thetaO - thetaU, 0.0f);
+        if (thetaP >= node.thetaE)
+        {
+            return 0;
+        }
+
+        return node.power * cosI * cos(thetaP) / dist2;
+    }
+
+    float LightBVH::getCost(const Node& node)
+    {
+        return node.power * getBoundsCost(node);
+    }
+
+    float LightBVH::getBoundsCost(const Node& node)
+    {
+        // Surface area of the box times the orientation measure of the cone
+        const glm::vec3 extent = node.aabbMax - node.aabbMin;
+        const float area = 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+        const float thetaW = std::min(node.thetaO + node.thetaE, (float)M_PI);
+        const float orientation = 2.0f * (float)M_PI * (1.0f - cos(node.thetaO)) +
+            (float)M_PI_2 * (2.0f * thetaW * sin(node.thetaO) - cos(node.thetaO - 2.0f * thetaW) - 2.0f * node.thetaO * sin(node.thetaO) + cos(node.thetaO));
+        return area * orientation;
+    }
+
+    void LightBVH::build(const std::vector<LightData>& lights, const std::vector<float>& powers)
+    {
+        assert(lights.size() == powers.size());
+        mNodes.clear();
+        mParents.clear();
+        mUnboundedLights.clear();
+        mLeafOfLight.assign(lights.size(), kInvalidIndex);
+        mDirty = true;
+
+        std::vector<BuildItem> items;
+        items.reserve(lights.size());
+        for (uint32_t i = 0; i < (uint32_t)lights.size(); i++)
+        {
+            BuildItem item;
+            if (getLightBounds(lights[i], powers[i], item.bounds) == false)
+            {
+                mUnboundedLights.push_back(i);
+                continue;
+            }
+            item.bounds.lightIndex = i;
+            item.centroid = (item.bounds.aabbMin + item.bounds.aabbMax) * 0.5f;
+            items.push_back(item);
+        }
+
+        if (items.empty())
+        {
+            mBuildCost = 0;
+            return;
+        }
+
+        mNodes.reserve(items.size() * 2 - 1);
+        mParents.reserve(items.size() * 2 - 1);
+        buildRecursive(items, 0, (uint32_t)items.size(), kInvalidIndex);
+        mBuildCost = getBoundsCost(mNodes[0]);
+    }
+
+    uint32_t LightBVH::buildRecursive(std::vector<BuildItem>& items, uint32_t begin, uint32_t end, uint32_t parent)
+    {
+        const uint32_t nodeIndex = (uint32_t)mNodes.size();
+        mNodes.push_back(Node());
+        mParents.push_back(parent);
+
+        if (end - begin == 1)
+        {
+            mNodes[nodeIndex] = items[begin].bounds;
+            mNodes[nodeIndex].rightChild = 0;
+            mLeafOfLight[items[begin].bounds.lightIndex] = nodeIndex;
+            return nodeIndex;
+        }
+
+        Node bounds = createEmptyNode();
+        glm::vec3 centroidMin = glm::vec3(FLT_MAX);
+        glm::vec3 centroidMax = glm::vec3(-FLT_MAX);
+        for (uint32_t i = begin; i < end; i++)
+        {
+            bounds = mergeNodes(bounds, items[i].bounds);
+            centroidMin = glm::min(centroidMin, items[i].centroid);
+            centroidMax = glm::max(centroidMax, items[i].centroid);
+        }
+        const glm::vec3 boundsExtent = bounds.aabbMax - bounds.aabbMin;
+        const float maxExtent = std::max(boundsExtent.x, std::max(boundsExtent.y, boundsExtent.z));
+
+        // Binned split minimizing the surface area orientation heuristic
+        float bestCost = FLT_MAX;
+        uint32_t bestAxis = 0;
+        uint32_t bestSplit = 0;
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            const float centroidExtent = centroidMax[axis] - centroidMin[axis];
+            if (centroidExtent <= 0)
+            {
+                continue;
+            }
+
+            Node bins[kBinCount];
+            uint32_t counts[kBinCount] = {};
+            for (uint32_t b = 0; b < kBinCount; b++)
+            {
+                bins[b] = createEmptyNode();
+            }
+            for (uint32_t i = begin; i < end; i++)
+            {
+                uint32_t b = std::min(uint32_t((items[i].centroid[axis] - centroidMin[axis]) / centroidExtent * kBinCount), kBinCount - 1);
+                bins[b] = mergeNodes(bins[b], items[i].bounds);
+                counts[b]++;
+            }
+
+            // Suffix sweep, then evaluate the splits while sweeping from the left
+            Node right[kBinCount];
+            uint32_t rightCounts[kBinCount];
+            right[kBinCount - 1] = bins[kBinCount - 1];
+            rightCounts[kBinCount - 1] = counts[kBinCount - 1];
+            for (uint32_t b = kBinCount - 1; b > 0; b--)
+            {
+                right[b - 1] = mergeNodes(bins[b - 1], right[b]);
+                rightCounts[b - 1] = counts[b - 1] + rightCounts[b];
+            }
+
+            const float regularization = maxExtent / std::max(boundsExtent[axis], 1e-12f);
+            Node left = createEmptyNode();
+            uint32_t leftCount = 0;
+            for (uint32_t split = 1; split < kBinCount; split++)
+            {
+                left = mergeNodes(left, bins[split - 1]);
+                leftCount += counts[split - 1];
+                if (leftCount == 0 || rightCounts[split] == 0)
+                {
+                    continue;
+                }
+                float cost = (getCost(left) + getCost(right[split])) * regularization;
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = split;
+                }
+            }
+        }
+
+        uint32_t mid;
+        if (bestSplit != 0)
+        {
+            const float centroidExtent = centroidMax[bestAxis] - centroidMin[bestAxis];
+            auto pMid = std::partition(items.begin() + begin, items.begin() + end, [&](const BuildItem& item)
+            {
+                uint32_t b = std::min(uint32_t((item.centroid[bestAxis] - centroidMin[bestAxis]) / centroidExtent * kBinCount), kBinCount - 1);
+                return b < bestSplit;
+            });
+            mid = (uint32_t)(pMid - items.begin());
+        }
+        else
+        {
+            // All centroids coincide, split in the middle
+            mid = (begin + end) / 2;
+        }
+
+        buildRecursive(items, begin, mid, nodeIndex);
+        const uint32_t rightChild = buildRecursive(items, mid, end, nodeIndex);
+        mNodes[nodeIndex].rightChild = rightChild;
+        refitNode(nodeIndex);
+        return nodeIndex;
+    }
+
+    void LightBVH::refitNode(uint32_t nodeIndex)
+    {
+        Node& node = mNodes[nodeIndex];
+        const uint32_t rightChild = node.rightChild;
+        Node merged = mergeNodes(mNodes[nodeIndex + 1], mNodes[rightChild]);
+        merged.rightChild = rightChild;
+        merged.lightIndex = kInvalidIndex;
+        node = merged;
+    }
+
+    bool LightBVH::refit(const std::vector<LightData>& lights, const std::vector<float>& powers)
+    {
+        assert(lights.size() == mLeafOfLight.size() && powers.size() == lights.size());
+
+        std::vector<bool> dirty(mNodes.size(), false);
+        bool changed = false;
+        for (uint32_t i = 0; i < (uint32_t)lights.size(); i++)
+        {
+            const uint32_t leaf = mLeafOfLight[i];
+            if (leaf == kInvalidIndex)
+            {
+                continue;
+            }
+
+            Node bounds;
+            if (getLightBounds(lights[i], powers[i], bounds) == false)
+            {
+                build(lights, powers);
+                return true;
+            }
+            if (boundsEqual(bounds, mNodes[leaf]))
+            {
+                continue;
+            }
+
+            bounds.rightChild = 0;
+            bounds.lightIndex = i;
+            mNodes[leaf] = bounds;
+            changed = true;
+            for (uint32_t n = mParents[leaf]; n != kInvalidIndex && dirty[n] == false; n = mParents[n])
+            {
+                dirty[n] = true;
+            }
+        }
+
+        if (changed == false)
+        {
+            return false;
+        }
+
+        // Children are stored after their parents
+        for (size_t n = mNodes.size(); n-- > 0;)
+        {
+            if (dirty[n])
+            {
+                refitNode((uint32_t)n);
+            }
+        }
+        mDirty = true;
+
+        // Only the bounds decide, a light changing intensity doesn't make the topology worse
+        if (getBoundsCost(mNodes[0]) > mBuildCost * kRebuildCostRatio)
+        {
+            build(lights, powers);
+        }
+        return true;
+    }
+
+    bool LightBVH::update(const Scene* pScene)
+    {
+        std::vector<LightData> lights(pScene->getLightCount());
+        std::vector<float> powers(pScene->getLightCount());
+        std::vector<uint32_t> types(pScene->getLightCount());
+        for (uint32_t i = 0; i < pScene->getLightCount(); i++)
+        {
+            const auto& pLight = pScene->getLight(i);
+            pLight->prepareGPUData();
+            lights[i] = pLight->getData();
+            powers[i] = pLight->getPower();
+            types[i] = lights[i].type;
+        }
+
+        if (types != mLightTypes)
+        {
+            mLightTypes = types;
+            build(lights, powers);
+            return true;
+        }
+        return refit(lights, powers);
+    }
+
+    uint32_t LightBVH::sample(const glm::vec3& pos, const glm::vec3& normal, float u, float& pmf) const
+    {
+        pmf = 0;
+        if (mNodes.empty())
+        {
+            return kInvalidIndex;
+        }
+
+        float nodePmf = 1;
+        uint32_t nodeIndex = 0;
+        while (mNodes[nodeIndex].rightChild != 0)
+        {
+            const uint32_t rightChild = mNodes[nodeIndex].rightChild;
+            const float importanceL = getImportance(mNodes[nodeIndex + 1], pos, normal);
+            const float importanceR = getImportance(mNodes[rightChild], pos, normal);
+            const float total = importanceL + importanceR;
+            if (total <= 0)
+            {
+                return kInvalidIndex;
+            }
+
+            // Pick a child and rescale the random number to reuse it further down
+            const float probL = importanceL / total;
+            if (u < probL)
+            {
+                u = std::min(u / probL, 0.99999994f);
+                nodePmf *= probL;
+                nodeIndex = nodeIndex + 1;
+            }
+            else
+            {
+                u = std::min((u - probL) / (1 - probL), 0.99999994f);
+                nodePmf *= 1 - probL;
+                nodeIndex = rightChild;
+            }
+        }
+
+        pmf = nodePmf;
+        return mNodes[nodeIndex].lightIndex;
+    }
+
+    float LightBVH::getPmf(const glm::vec3& pos, const glm::vec3& normal, uint32_t lightIndex) const
+    {
+        if (lightIndex >= mLeafOfLight.size() || mLeafOfLight[lightIndex] == kInvalidIndex)
+        {
+            return 0;
+        }
+
+        float pmf = 1;
+        uint32_t child = mLeafOfLight[lightIndex];
+        for (uint32_t parent = mParents[child]; parent != kInvalidIndex; child = parent, parent = mParents[parent])
+        {
+            const float importanceL = getImportance(mNodes[parent + 1], pos, normal);
+            const float importanceR = getImportance(mNodes[mNodes[parent].rightChild], pos, normal);
+            const float total = importanceL + importanceR;
+            if (total <= 0)
+            {
+                return 0;
+            }
+            pmf *= ((child == parent + 1) ? importanceL : importanceR) / total;
+        }
+        return pmf;
+    }
+
+    bool LightBVH::setIntoProgramVars(ProgramVars* pVars)
+    {
+        const ReflectionVar* pVar = pVars->getReflection()->getDefaultParameterBlock()->getResource("gLightBvhNodes").get();
+        if (pVar == nullptr)
+        {
+            return false;
+        }
+
+        const uint32_t nodeCount = std::max(1u, (uint32_t)mNodes.size());
+        if (mpNodeBuffer == nullptr || mpNodeBuffer->getElementCount() < nodeCount)
+        {
+            ReflectionResourceType::SharedConstPtr pType = pVar->getType()->unwrapArray()->asResourceType()->inherit_shared_from_this::shared_from_this();
+            mpNodeBuffer = StructuredBuffer::create("gLightBvhNodes", pType, nodeCount, Resource::BindFlags::ShaderResource);
+            assert(mpNodeBuffer->getElementSize() == sizeof(Node));
+            mDirty = true;
+        }
+        if (mDirty && mNodes.size())
+        {
+            mpNodeBuffer->setBlob(mNodes.data(), 0, mNodes.size() * sizeof(Node));
+        }
+        mDirty = false;
+
+        pVars->setStructuredBuffer("gLightBvhNodes", mpNodeBuffer);
+        ConstantBuffer::SharedPtr pCB = pVars->getConstantBuffer("LightBvhCB");
+        pCB["gLightBvhNodeCount"] = (uint32_t)mNodes.size();
+        return true;
+    }
+}
@@ -0,0 +1,166 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Falcor.h"
+#include "Testing/Validation.h"
+#include <vector>
+
+namespace Falcor
+{
+    /** Bounding volume hierarchy over the lights of a scene, used to pick a light with probability roughly proportional to its contribution at a shading point.
+        Every node bounds its lights with a box, a cone of emission directions and their total power, see "Importance Sampling of Many Lights
+        with Adaptive Tree Splitting" by Conty Estevez and Kulla. Picking a light is a single root-to-leaf walk, O(log N) instead of O(N).
+        Leaves hold a single light and reference it by its index in the scene. Directional lights have no bounds and aren't part of the tree.
+        The tree is refit when lights move and only rebuilt when the set of lights changes or refitting degraded it too much.
+        Shaders sample it through LightBVH.slang.
+    */
+    class LightBVH
+    {
+    public:
+        using SharedPtr = std::shared_ptr<LightBVH>;
+        using SharedConstPtr = std::shared_ptr<const LightBVH>;
+
+        static const uint32_t kInvalidIndex = uint32_t(-1);
+
+        /** Node layout, shared with LightBVH.slang
+        */
+        struct Node
+        {
+            glm::vec3 aabbMin;
+            float power = 0;            ///< Total power of the lights below the node
+            glm::vec3 aabbMax;
+            float thetaO = 0;           ///< Spread of the emitter normals around the axis
+            glm::vec3 axis;
+            float thetaE = 0;           ///< Emission angle around the normals
+            uint32_t rightChild = 0;    ///< Index of the second child, the first one directly follows the node. 0 for leaves.
+            uint32_t lightIndex = kInvalidIndex;
+            uint32_t pad[2];
+        };
+
+        static SharedPtr create();
+
+        /** Update the tree for the lights of a scene. Rebuilds it when lights were added, removed or changed type, otherwise refits it.
+            \return true if the tree changed
+        */
+        bool update(const Scene* pScene);
+
+        /** Build the tree
+            \param[in] lights Lights to insert. Lights without bounds are skipped.
+            \param[in] powers Power of each light
+        */
+        void build(const std::vector<LightData>& lights, const std::vector<float>& powers);
+
+        /** Update the bounds of the tree after lights moved or changed intensity, without changing its topology.
+            The arrays must hold the same lights in the same order as the last build.
+            \return true if any node changed
+        */
+        bool refit(const std::vector<LightData>& lights, const std::vector<float>& powers);
+
+        /** Upload the tree to a program which imports LightBVH.slang
+            \return false if the program doesn't declare the tree
+        */
+        bool setIntoProgramVars(ProgramVars* pVars);
+
+        /** Pick a light for a shading point. Matches sampleLightBvh() in LightBVH.slang.
+            \param[in] pos Shading point
+            \param[in] normal Shading normal. Pass a zero vector for points which receive light from every direction.
+            \param[in] u Uniform random number in [0, 1)
+            \param[out] pmf Probability of picking the light
+            \return Index of the light in the array the tree was built from, or kInvalidIndex if no light reaches the point
+        */
+        uint32_t sample(const glm::vec3& pos, const glm::vec3& normal, float u, float& pmf) const;
+
+        /** Get the probability that sample() picks a light at a shading point, e.g. for multiple importance sampling
+        */
+        float getPmf(const glm::vec3& pos, const glm::vec3& normal, uint32_t lightIndex) const;
+
+        /** Get the importance of a node for a shading point. An upper bound of the irradiance its lights can deliver, up to a constant factor.
+        */
+        static float getImportance(const Node& node, const glm::vec3& pos, const glm::vec3& normal);
+
+        /** Get the bounds of a light
+            \return false for lights without bounds
+        */
+        static bool getLightBounds(const LightData& light, float power, Node& bounds);
+
+        const std::vector<Node>& getNodes() const { return mNodes; }
+        uint32_t getNodeCount() const { return (uint32_t)mNodes.size(); }
+
+        /** Get the lights which aren't part of the tree and have to be sampled separately
+        */
+        const std::vector<uint32_t>& getUnboundedLights() const { return mUnboundedLights; }
+
+        /** Results of validate()
+        */
+        struct ValidationReport : public Falcor::ValidationReport
+        {
+            // failedCount counts the points where the estimate is off by more than 5 standard errors, the pmfs sum to more than one or a reaching light has pmf 0
+            uint32_t zeroPmfCount = 0;          ///< Lights reaching a point which sample() never picks
+            uint32_t pmfMismatchCount = 0;      ///< Samples where getPmf() disagrees with sample()
+            uint32_t intensityRebuildCount = 0; ///< Cases where changing only light intensities rebuilt the tree instead of refitting it
+            float varianceRatioUniform = 0;     ///< Geometric mean over the points of the variance of uniform light selection divided by the variance of the tree
+            float varianceRatioPower = 0;       ///< Same, for selection proportional to light power
+        };
+
+        /** Test light selection against brute force. Random point and spot lights are inserted into a tree, then shading points estimate their irradiance
+            with one light picked by sample() per sample. The estimate must converge to the exact sum over all lights, and its variance is compared to
+            uniform and power-proportional selection. Each case finally changes the light intensities and checks that refit() keeps the topology.
+            \param[in] caseCount Number of random light sets
+            \param[in] lightCount Lights per case
+            \param[in] pointCount Shading points per case
+            \param[in] sampleCount Samples per shading point
+            \param[in] seed Random seed
+        */
+        static ValidationReport validate(uint32_t caseCount = 4, uint32_t lightCount = 4000, uint32_t pointCount = 32, uint32_t sampleCount = 1 << 14, uint32_t seed = 0);
+
+    private:
+        LightBVH() = default;
+
+        struct BuildItem
+        {
+            Node bounds;
+            glm::vec3 centroid;
+        };
+
+        uint32_t buildRecursive(std::vector<BuildItem>& items, uint32_t begin, uint32_t end, uint32_t parent);
+        void refitNode(uint32_t nodeIndex);
+        static float getCost(const Node& node);
+        static float getBoundsCost(const Node& node);
+
+        std::vector<Node> mNodes;
+        std::vector<uint32_t> mParents;
+        std::vector<uint32_t> mLeafOfLight;         ///< Leaf of each light, kInvalidIndex for lights not in the tree
+        std::vector<uint32_t> mUnboundedLights;
+        float mBuildCost = 0;                       ///< Bounds cost of the root right after the last build, used to decide when refitting isn't enough
+
+        std::vector<uint32_t> mLightTypes;         ///< Light types of the last update from a scene, a change triggers a rebuild
+
+        bool mDirty = true;
+        StructuredBuffer::SharedPtr mpNodeBuffer;
+    };
+}
@@ -0,0 +1,212 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "LightBVH.h"
+#include "Utils/ParallelFor.h"
+#include <algorithm>
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+namespace Falcor
+{
+    namespace
+    {
+        struct PointResult
+        {
+            bool failed = false;
+            uint32_t zeroPmfCount = 0;
+            uint32_t pmfMismatchCount = 0;
+            double logVarianceRatioUniform = 0;
+            double logVarianceRatioPower = 0;
+            bool hasVariance = false;
+        };
+
+        // Exact irradiance from a point or spot light with a hard cut-off
+        float getIrradiance(const LightData& light, const glm::vec3& pos, const glm::vec3& normal)
+        {
+            const glm::vec3 toLight = light.worldPos - pos;
+            const float dist2 = glm::dot(toLight, toLight);
+            const glm::vec3 dir = toLight / std::sqrt(dist2);
+            if (light.openingAngle < (float)M_PI && -glm::dot(dir, light.worldDir) < std::cos(light.openingAngle))
+            {
+                return 0;
+            }
+            return light.intensity.x * std::max(glm::dot(normal, dir), 0.0f) / dist2;
+        }
+
+        float getPower(const LightData& light)
+        {
+            return light.intensity.x * 2.0f * (float)M_PI * (1.0f - std::cos(std::min(light.openingAngle, (float)M_PI)));
+        }
+
+        struct Estimator
+        {
+            double sum = 0;
+            double sumSquares = 0;
+
+            void add(double value) { sum += value; sumSquares += value * value; }
+            double getMean(uint32_t count) const { return sum / count; }
+            double getVariance(uint32_t count) const { return std::max(sumSquares / count - getMean(count) * getMean(count), 0.0); }
+        };
+    }
+
+    LightBVH::ValidationReport LightBVH::validate(uint32_t caseCount, uint32_t lightCount, uint32_t pointCount, uint32_t sampleCount, uint32_t seed)
+    {
+        ValidationReport report;
+        report.caseCount = caseCount;
+        report.pointCount = caseCount * pointCount;
+
+        double logRatioUniform = 0;
+        double logRatioPower = 0;
+        uint32_t ratioCount = 0;
+
+        for (uint32_t c = 0; c < caseCount; c++)
+        {
+            // Lights above a ground plane, a third of them spot lights pointing down
+            const uint32_t caseSeed = getCaseSeed(seed, c);
+            CaseGenerator gen(caseSeed);
+            std::vector<LightData> lights(lightCount);
+            std::vector<float> powers(lightCount);
+            std::vector<double> powerCdf(lightCount);
+            double totalPower = 0;
+            for (uint32_t i = 0; i < lightCount; i++)
+            {
+                LightData& light = lights[i];
+                light.type = LightPoint;
+                light.worldPos = gen.uniform(glm::vec3(-50, 0, -50), glm::vec3(50, 4, 50));
+                light.intensity = glm::vec3(0.1f + gen.uniform(0.0f, 1.0f) * gen.uniform(0.0f, 1.0f) * 10);
+                if (i % 3 == 0)
+                {
+                    light.openingAngle = 0.3f + gen.uniform(0.0f, 1.0f);
+                    light.worldDir = glm::normalize(glm::vec3(gen.uniform(-0.5f, 0.5f), -1, gen.uniform(-0.5f, 0.5f)));
+                }
+                powers[i] = getPower(light);
+                totalPower += powers[i];
+                powerCdf[i] = totalPower;
+            }
+
+            SharedPtr pBvh = SharedPtr(new LightBVH());
+            pBvh->build(lights, powers);
+
+            std::vector<PointResult> results(pointCount);
+            parallelFor(0, pointCount, [&](size_t p)
+            {
+                CaseGenerator pointGen(getCaseSeed(caseSeed, (uint32_t)p));
+                const glm::vec3 pos = pointGen.uniform(glm::vec3(-40, -1, -40), glm::vec3(40, 0, 40));
+                const glm::vec3 normal = glm::normalize(glm::vec3(pointGen.uniform(-0.5f, 0.5f), 1.0f, pointGen.uniform(-0.5f, 0.5f)));
+                PointResult& result = results[p];
+
+                // Every light which reaches the point must be reachable. The pmfs sum to less than one when the walk can end in a subtree which doesn't reach the point.
+                double exact = 0;
+                double pmfSum = 0;
+                for (uint32_t i = 0; i < lightCount; i++)
+                {
+                    const float irradiance = getIrradiance(lights[i], pos, normal);
+                    const float pmf = pBvh->getPmf(pos, normal, i);
+                    exact += irradiance;
+                    pmfSum += pmf;
+                    if (irradiance > 0 && pmf <= 0)
+                    {
+                        result.zeroPmfCount++;
+                    }
+                }
+                result.failed = result.zeroPmfCount > 0 || pmfSum > 1 + 1e-3;
+
+                Estimator bvh, uniform, power;
+                for (uint32_t s = 0; s < sampleCount; s++)
+                {
+                    float pmf;
+                    const uint32_t light = pBvh->sample(pos, normal, pointGen.uniform(0.0f, 1.0f), pmf);
+                    if (light != kInvalidIndex)
+                    {
+                        bvh.add(getIrradiance(lights[light], pos, normal) / pmf);
+                        if (std::abs(pBvh->getPmf(pos, normal, light) - pmf) > 1e-4f * pmf)
+                        {
+                            result.pmfMismatchCount++;
+                        }
+                    }
+                    else
+                    {
+                        bvh.add(0);
+                    }
+
+                    const uint32_t uniformLight = std::min(uint32_t(pointGen.uniform(0.0f, 1.0f) * lightCount), lightCount - 1);
+                    uniform.add(getIrradiance(lights[uniformLight], pos, normal) * lightCount);
+
+                    const double r = pointGen.uniform(0.0f, 1.0f) * totalPower;
+                    const uint32_t powerLight = std::min(uint32_t(std::upper_bound(powerCdf.begin(), powerCdf.end(), r) - powerCdf.begin()), lightCount - 1);
+                    power.add(getIrradiance(lights[powerLight], pos, normal) * totalPower / powers[powerLight]);
+                }
+
+                const double mean = bvh.getMean(sampleCount);
+                const double variance = bvh.getVariance(sampleCount);
+                const double standardError = std::sqrt(variance / sampleCount);
+                result.failed |= result.pmfMismatchCount > 0 || std::abs(mean - exact) > 5 * standardError + 1e-6 * exact;
+                if (variance > 0)
+                {
+                    result.hasVariance = true;
+                    result.logVarianceRatioUniform = std::log(uniform.getVariance(sampleCount) / variance);
+                    result.logVarianceRatioPower = std::log(power.getVariance(sampleCount) / variance);
+                }
+            });
+
+            for (const auto& r : results)
+            {
+                report.failedCount += r.failed ? 1 : 0;
+                report.zeroPmfCount += r.zeroPmfCount;
+                report.pmfMismatchCount += r.pmfMismatchCount;
+                if (r.hasVariance)
+                {
+                    logRatioUniform += r.logVarianceRatioUniform;
+                    logRatioPower += r.logVarianceRatioPower;
+                    ratioCount++;
+                }
+            }
+
+            // Changing intensities only changes the node powers, the tree must be refit rather than rebuilt
+            const std::vector<uint32_t> leaves = pBvh->mLeafOfLight;
+            for (uint32_t i = 0; i < lightCount; i++)
+            {
+                lights[i].intensity *= 1.0f + 4.0f * gen.uniform(0.0f, 1.0f);
+                powers[i] = getPower(lights[i]);
+            }
+            pBvh->refit(lights, powers);
+            if (pBvh->mLeafOfLight != leaves)
+            {
+                report.intensityRebuildCount++;
+            }
+        }
+
+        if (ratioCount > 0)
+        {
+            report.varianceRatioUniform = (float)std::exp(logRatioUniform / ratioCount);
+            report.varianceRatioPower = (float)std::exp(logRatioPower / ratioCount);
+        }
+        return report;
+    }
+}
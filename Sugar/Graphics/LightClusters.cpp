@@ -0,0 +1,385 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "LightClusters.h"
+#include "Utils/ParallelFor.h"
+#include <atomic>
+#include <immintrin.h>
+
+namespace Falcor
+{
+    namespace
+    {
+        const uint32_t kClusterCountBits = 10;
+
+        uint32_t packRange(size_t offset, size_t count)
+        {
+            return (uint32_t(offset) << kClusterCountBits) | uint32_t(count);
+        }
+
+        /** Lights overlapping the depth range of a slice, padded to a multiple of 4 with lights which never intersect
+        */
+        struct SliceLights
+        {
+            std::vector<float> x, y, depth, radius;
+            std::vector<uint32_t> index;
+
+            void add(float lx, float ly, float ld, float lr, uint32_t i)
+            {
+                x.push_back(lx); y.push_back(ly); depth.push_back(ld); radius.push_back(lr); index.push_back(i);
+            }
+
+            void pad()
+            {
+                while (index.size() % 4)
+                {
+                    add(0, 0, -1e30f, 0, 0);
+                }
+            }
+        };
+
+        /** Extent along one axis of a froxel slab, given the ratios of the coordinate to the depth at its edges
+        */
+        void getSlabExtent(float ratio0, float ratio1, float d0, float d1, float& minCoord, float& maxCoord)
+        {
+            minCoord = ratio0 * (ratio0 < 0 ? d1 : d0);
+            maxCoord = ratio1 * (ratio1 > 0 ? d1 : d0);
+        }
+    }
+
+    LightClusters::SharedPtr LightClusters::create(const Desc& desc)
+    {
+        if (desc.tileCountX == 0 || desc.tileCountY == 0 || desc.sliceCount == 0)
+        {
+            logError("LightClusters::create() - cluster dimensions can't be zero");
+            return nullptr;
+        }
+        return SharedPtr(new LightClusters(desc));
+    }
+
+    bool LightClusters::getBoundingSphere(const LightData& light, float irradianceThreshold, glm::vec4& sphere)
+    {
+        const float threshold = std::max(irradianceThreshold, 1e-6f);
+        const float maxIntensity = std::max(light.intensity.x, std::max(light.intensity.y, light.intensity.z));
+
+        switch (light.type)
+        {
+        case LightPoint:
+            // Irradiance falls off with I / d^2
+            sphere = glm::vec4(light.worldPos, std::sqrt(maxIntensity / threshold));
+            return true;
+        case LightSphere:
+            // A sphere of radiance L and radius R delivers at most pi * L * R^2 / d^2
+            sphere = glm::vec4(light.worldPos, light.radius * std::max(1.0f, std::sqrt(glm::pi<float>() * maxIntensity / threshold)));
+            return true;
+        case LightPolygonal:
+        {
+            glm::vec3 center = glm::vec3(0);
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                center += glm::vec3(light.vertices[i]) * 0.25f;
+            }
+            float boundRadius = 0;
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                boundRadius = std::max(boundRadius, glm::length(glm::vec3(light.vertices[i]) - center));
+            }
+            // A quad of radiance L and area A delivers at most L * A / d^2, where d is the distance to its closest point
+            glm::vec3 diag0 = glm::vec3(light.vertices[2] - light.vertices[0]);
+            glm::vec3 diag1 = glm::vec3(light.vertices[3] - light.vertices[1]);
+            float area = 0.5f * glm::length(glm::cross(diag0, diag1));
+            sphere = glm::vec4(center, boundRadius + std::sqrt(maxIntensity * area / threshold));
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+    void LightClusters::build(const Scene* pScene, const Camera* pCamera)
+    {
+        std::vector<LightData> lights(pScene->getLightCount());
+        for (uint32_t i = 0; i < pScene->getLightCount(); i++)
+        {
+            const auto& pLight = pScene->getLight(i);
+            pLight->prepareGPUData();
+            lights[i] = pLight->getData();
+        }
+        build(lights, pCamera->getViewMatrix(), pCamera->getProjMatrix(), pCamera->getNearPlane(), pCamera->getFarPlane());
+    }
+
+    void LightClusters::build(const std::vector<LightData>& lights, const glm::mat4& viewMat, const glm::mat4& projMat, float nearZ, float farZ)
+    {
+        const uint32_t lightCount = (uint32_t)std::min<size_t>(lights.size(), kMaxLightCount);
+        if (lights.size() > kMaxLightCount)
+        {
+            logWarning("LightClusters::build() - only the first " + std::to_string(kMaxLightCount) + " lights are used");
+        }
+        mLights.assign(lights.begin(), lights.begin() + lightCount);
+
+        // Froxel geometry. Tiles are ordered top to bottom, matching pixel coordinates.
+        nearZ = std::max(nearZ, 1e-4f);
+        farZ = std::max(farZ, nearZ * 1.0001f);
+        mTileEdgesX.resize(mDesc.tileCountX + 1);
+        mTileEdgesY.resize(mDesc.tileCountY + 1);
+        mSliceDepths.resize(mDesc.sliceCount + 1);
+        for (uint32_t i = 0; i <= mDesc.tileCountX; i++)
+        {
+            float ndcX = -1.0f + 2.0f * float(i) / float(mDesc.tileCountX);
+            mTileEdgesX[i] = (ndcX + projMat[2][0]) / projMat[0][0];
+        }
+        for (uint32_t i = 0; i <= mDesc.tileCountY; i++)
+        {
+            float ndcY = 1.0f - 2.0f * float(i) / float(mDesc.tileCountY);
+            mTileEdgesY[i] = (ndcY + projMat[2][1]) / projMat[1][1];
+        }
+        const float depthRatio = std::log(farZ / nearZ);
+        for (uint32_t i = 0; i <= mDesc.sliceCount; i++)
+        {
+            mSliceDepths[i] = nearZ * std::exp(depthRatio * float(i) / float(mDesc.sliceCount));
+        }
+        mDepthScale = float(mDesc.sliceCount) / depthRatio;
+        mDepthBias = -std::log(nearZ) * mDepthScale;
+
+        // Bound the lights in view space. Depth is the distance along the view direction.
+        mLightX.clear(); mLightY.clear(); mLightDepth.clear(); mLightRadius.clear();
+        mBoundedLights.clear();
+        std::vector<uint16_t> globalLights;
+        for (uint32_t i = 0; i < lightCount; i++)
+        {
+            glm::vec4 sphere;
+            if (getBoundingSphere(mLights[i], mDesc.irradianceThreshold, sphere) == false)
+            {
+                globalLights.push_back(uint16_t(i));
+                continue;
+            }
+            glm::vec3 posV = glm::vec3(viewMat * glm::vec4(glm::vec3(sphere), 1));
+            mLightX.push_back(posV.x);
+            mLightY.push_back(posV.y);
+            mLightDepth.push_back(-posV.z);
+            mLightRadius.push_back(sphere.w);
+            mBoundedLights.push_back(i);
+        }
+
+        // Bin every slice in parallel
+        const uint32_t tilesPerSlice = mDesc.tileCountX * mDesc.tileCountY;
+        std::vector<std::vector<uint16_t>> sliceIndices(mDesc.sliceCount);
+        std::vector<uint32_t> clusterCounts(getClusterCount(), 0);
+        std::atomic<bool> overflow(false);
+
+        parallelFor(0, mDesc.sliceCount, [&](size_t slice)
+        {
+            const float d0 = mSliceDepths[slice];
+            const float d1 = mSliceDepths[slice + 1];
+
+            SliceLights candidates;
+            for (size_t l = 0; l < mBoundedLights.size(); l++)
+            {
+                if (mLightDepth[l] + mLightRadius[l] >= d0 && mLightDepth[l] - mLightRadius[l] <= d1)
+                {
+                    candidates.add(mLightX[l], mLightY[l], mLightDepth[l], mLightRadius[l], mBoundedLights[l]);
+                }
+            }
+            if (candidates.index.empty())
+            {
+                return;
+            }
+            candidates.pad();
+
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 depthMin = _mm_set1_ps(d0);
+            const __m128 depthMax = _mm_set1_ps(d1);
+            std::vector<uint16_t>& indices = sliceIndices[slice];
+
+            for (uint32_t ty = 0; ty < mDesc.tileCountY; ty++)
+            {
+                float yMin, yMax;
+                getSlabExtent(mTileEdgesY[ty + 1], mTileEdgesY[ty], d0, d1, yMin, yMax);
+                const __m128 minY = _mm_set1_ps(yMin);
+                const __m128 maxY = _mm_set1_ps(yMax);
+
+                for (uint32_t tx = 0; tx < mDesc.tileCountX; tx++)
+                {
+                    float xMin, xMax;
+                    getSlabExtent(mTileEdgesX[tx], mTileEdgesX[tx + 1], d0, d1, xMin, xMax);
+                    const __m128 minX = _mm_set1_ps(xMin);
+                    const __m128 maxX = _mm_set1_ps(xMax);
+
+                    uint32_t count = 0;
+                    for (size_t l = 0; l < candidates.index.size(); l += 4)
+                    {
+                        // Squared distance from the sphere center to the froxel bounds
+                        __m128 cx = _mm_loadu_ps(&candidates.x[l]);
+                        __m128 cy = _mm_loadu_ps(&candidates.y[l]);
+                        __m128 cd = _mm_loadu_ps(&candidates.depth[l]);
+                        __m128 r = _mm_loadu_ps(&candidates.radius[l]);
+                        __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, cx), _mm_sub_ps(cx, maxX)), zero);
+                        __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, cy), _mm_sub_ps(cy, maxY)), zero);
+                        __m128 dd = _mm_max_ps(_mm_max_ps(_mm_sub_ps(depthMin, cd), _mm_sub_ps(cd, depthMax)), zero);
+                        __m128 dist2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dd, dd));
+                        int mask = _mm_movemask_ps(_mm_cmple_ps(dist2, _mm_mul_ps(r, r)));
+
+                        while (mask)
+                        {
+                            unsigned long bit;
+                            _BitScanForward(&bit, mask);
+                            mask &= mask - 1;
+                            if (count == kMaxLightsPerCluster)
+                            {
+                                overflow = true;
+                                break;
+                            }
+                            indices.push_back(uint16_t(candidates.index[l + bit]));
+                            count++;
+                        }
+                    }
+                    clusterCounts[slice * tilesPerSlice + ty * mDesc.tileCountX + tx] = count;
+                }
+            }
+        });
+
+        if (overflow)
+        {
+            logWarning("LightClusters::build() - more than " + std::to_string(kMaxLightsPerCluster) + " lights in a cluster, some lights were dropped");
+        }
+
+        // Concatenate the lists. Global lights come first, slices follow in cluster order.
+        size_t indexCount = globalLights.size();
+        for (const auto& indices : sliceIndices)
+        {
+            indexCount += indices.size();
+        }
+        mLightIndices.resize(indexCount);
+        mRanges.resize(getClusterCount() + 1);
+
+        if (globalLights.size() > kMaxLightsPerCluster)
+        {
+            logWarning("LightClusters::build() - more than " + std::to_string(kMaxLightsPerCluster) + " unbounded lights, some lights were dropped");
+        }
+        std::copy(globalLights.begin(), globalLights.end(), mLightIndices.begin());
+        mRanges[getClusterCount()] = packRange(0, std::min<size_t>(globalLights.size(), kMaxLightsPerCluster));
+
+        size_t offset = globalLights.size();
+        for (uint32_t slice = 0; slice < mDesc.sliceCount; slice++)
+        {
+            std::copy(sliceIndices[slice].begin(), sliceIndices[slice].end(), mLightIndices.begin() + offset);
+            for (uint32_t t = 0; t < tilesPerSlice; t++)
+            {
+                uint32_t cluster = slice * tilesPerSlice + t;
+                mRanges[cluster] = packRange(offset, clusterCounts[cluster]);
+                offset += clusterCounts[cluster];
+            }
+        }
+    }
+
+    bool LightClusters::setIntoProgramVars(ProgramVars* pVars, uint32_t frameWidth, uint32_t frameHeight)
+    {
+        const ReflectionVar* pVar = pVars->getReflection()->getDefaultParameterBlock()->getResource("gClusteredLights").get();
+        if (pVar == nullptr)
+        {
+            return false;
+        }
+
+        // Lights
+        const uint32_t lightCount = std::max(1u, (uint32_t)mLights.size());
+        if (mpLightBuffer == nullptr || mpLightBuffer->getElementCount() < lightCount)
+        {
+            ReflectionResourceType::SharedConstPtr pType = pVar->getType()->unwrapArray()->asResourceType()->inherit_shared_from_this::shared_from_this();
+            mpLightBuffer = StructuredBuffer::create("gClusteredLights", pType, lightCount, Resource::BindFlags::ShaderResource);
+            assert(mpLightBuffer->getElementSize() == sizeof(LightData));
+        }
+        if (mLights.size())
+        {
+            mpLightBuffer->setBlob(mLights.data(), 0, mLights.size() * sizeof(LightData));
+        }
+
+        // Cluster lists. Indices are 16 bit, two per element.
+        const uint32_t rangeCount = (uint32_t)mRanges.size();
+        if (mpRangeBuffer == nullptr || mpRangeBuffer->getElementCount() < rangeCount)
+        {
+            mpRangeBuffer = TypedBuffer<uint32_t>::create(rangeCount, Resource::BindFlags::ShaderResource);
+        }
+        for (uint32_t i = 0; i < rangeCount; i++)
+        {
+            mpRangeBuffer->setElement(i, mRanges[i]);
+        }
+
+        const uint32_t packedCount = std::max(1u, (uint32_t)(mLightIndices.size() + 1) / 2);
+        if (mpIndexBuffer == nullptr || mpIndexBuffer->getElementCount() < packedCount)
+        {
+            mpIndexBuffer = TypedBuffer<uint32_t>::create(packedCount, Resource::BindFlags::ShaderResource);
+        }
+        for (uint32_t i = 0; i < packedCount; i++)
+        {
+            uint32_t lo = (2 * i < mLightIndices.size()) ? mLightIndices[2 * i] : 0;
+            uint32_t hi = (2 * i + 1 < mLightIndices.size()) ? mLightIndices[2 * i + 1] : 0;
+            mpIndexBuffer->setElement(i, lo | (hi << 16));
+        }
+
+        pVars->setStructuredBuffer("gClusteredLights", mpLightBuffer);
+        pVars->setTypedBuffer("gLightClusterRanges", mpRangeBuffer);
+        pVars->setTypedBuffer("gLightClusterIndices", mpIndexBuffer);
+
+        ConstantBuffer::SharedPtr pCB = pVars->getConstantBuffer("LightClustersCB");
+        pCB["gClusterDims"] = glm::uvec3(mDesc.tileCountX, mDesc.tileCountY, mDesc.sliceCount);
+        pCB["gGlobalLightRange"] = mRanges.empty() ? 0u : mRanges.back();
+        pCB["gClusterTileScale"] = glm::vec2(float(mDesc.tileCountX) / float(frameWidth), float(mDesc.tileCountY) / float(frameHeight));
+        pCB["gClusterDepthScale"] = mDepthScale;
+        pCB["gClusterDepthBias"] = mDepthBias;
+        return true;
+    }
+
+    BoundingBox LightClusters::getClusterBounds(uint32_t tileX, uint32_t tileY, uint32_t slice) const
+    {
+        const float d0 = mSliceDepths[slice];
+        const float d1 = mSliceDepths[slice + 1];
+        glm::vec3 minCrd, maxCrd;
+        getSlabExtent(mTileEdgesX[tileX], mTileEdgesX[tileX + 1], d0, d1, minCrd.x, maxCrd.x);
+        getSlabExtent(mTileEdgesY[tileY + 1], mTileEdgesY[tileY], d0, d1, minCrd.y, maxCrd.y);
+        minCrd.z = d0;
+        maxCrd.z = d1;
+        return BoundingBox::fromMinMax(minCrd, maxCrd);
+    }
+
+    void LightClusters::getRangeLights(uint32_t range, std::vector<uint32_t>& lights) const
+    {
+        const uint32_t offset = range >> kClusterCountBits;
+        const uint32_t count = range & kMaxLightsPerCluster;
+        lights.assign(mLightIndices.begin() + offset, mLightIndices.begin() + offset + count);
+    }
+
+    void LightClusters::getClusterLights(uint32_t tileX, uint32_t tileY, uint32_t slice, std::vector<uint32_t>& lights) const
+    {
+        getRangeLights(mRanges[getClusterIndex(tileX, tileY, slice)], lights);
+    }
+
+    void LightClusters::getGlobalLights(std::vector<uint32_t>& lights) const
+    {
+        getRangeLights(mRanges.back(), lights);
+    }
+}
@@ -0,0 +1,152 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Falcor.h"
+#include "Testing/Validation.h"
+#include <vector>
+
+namespace Falcor
+{
+    /** Assigns lights to the froxels of a camera, so shaders only evaluate the lights which can reach a pixel.
+        The screen is split into tiles and the view depth range between the near and far planes into logarithmic slices.
+        Point, sphere and polygonal lights are bound by a sphere extending to where their irradiance falls below a threshold, directional lights
+        and lights without a bound are evaluated everywhere. Slices are binned in parallel, each froxel tests 4 lights at a time.
+        Shaders read the result through LightClusters.slang.
+    */
+    class LightClusters
+    {
+    public:
+        using SharedPtr = std::shared_ptr<LightClusters>;
+        using SharedConstPtr = std::shared_ptr<const LightClusters>;
+
+        static const uint32_t kMaxLightCount = 0xFFFF;          ///< Light indices are stored as 16 bit
+        static const uint32_t kMaxLightsPerCluster = 0x3FF;     ///< Cluster light counts are stored as 10 bit
+
+        struct Desc
+        {
+            uint32_t tileCountX = 16;
+            uint32_t tileCountY = 9;
+            uint32_t sliceCount = 24;
+            float irradianceThreshold = 0.01f;      ///< Lights are ignored where their irradiance is below this value
+        };
+
+        static SharedPtr create(const Desc& desc);
+
+        /** Bin the lights of a scene for a camera.
+        */
+        void build(const Scene* pScene, const Camera* pCamera);
+
+        /** Bin lights for a perspective camera. Cluster lists reference lights by their index in the array.
+            \param[in] lights Lights to bin
+            \param[in] viewMat Camera view matrix
+            \param[in] projMat Camera projection matrix
+            \param[in] nearZ Distance to the near plane
+            \param[in] farZ Distance to the far plane
+        */
+        void build(const std::vector<LightData>& lights, const glm::mat4& viewMat, const glm::mat4& projMat, float nearZ, float farZ);
+
+        /** Bind the lights and cluster lists built last to a program which imports LightClusters.slang.
+            \param[in] pVars Program vars to bind to
+            \param[in] frameWidth Width of the render target in pixels
+            \param[in] frameHeight Height of the render target in pixels
+            \return false if the program doesn't declare the cluster resources
+        */
+        bool setIntoProgramVars(ProgramVars* pVars, uint32_t frameWidth, uint32_t frameHeight);
+
+        /** Get the world space sphere outside which a light contributes less than the threshold irradiance.
+            \param[in] light Light to bound
+            \param[in] irradianceThreshold Irradiance threshold
+            \param[out] sphere Center in xyz, radius in w
+            \return false if the light has no bound and affects every cluster
+        */
+        static bool getBoundingSphere(const LightData& light, float irradianceThreshold, glm::vec4& sphere);
+
+        /** Get the bounds of a cluster in view space. x and y are view space coordinates, z is the distance along the view direction.
+        */
+        BoundingBox getClusterBounds(uint32_t tileX, uint32_t tileY, uint32_t slice) const;
+
+        /** Get the lights assigned to a cluster, not including the global lights
+        */
+        void getClusterLights(uint32_t tileX, uint32_t tileY, uint32_t slice, std::vector<uint32_t>& lights) const;
+
+        /** Get the lights which affect every cluster
+        */
+        void getGlobalLights(std::vector<uint32_t>& lights) const;
+
+        const Desc& getDesc() const { return mDesc; }
+        uint32_t getClusterCount() const { return mDesc.tileCountX * mDesc.tileCountY * mDesc.sliceCount; }
+
+        /** Results of validate()
+        */
+        struct ValidationReport : public Falcor::ValidationReport
+        {
+            // failedCount counts the points reached by a light which is neither in their cluster nor in the global list
+            float meanListedLightCount = 0;     ///< Lights listed for a point, cluster and global lists together
+            float meanReachingLightCount = 0;   ///< Lights whose bounding sphere contains a point, the lower bound for the listed count
+            double buildMs = 0;                 ///< Average cost of build()
+        };
+
+        /** Test the binning against brute force. Random lights are binned for random cameras, then random points inside the frustum look up their
+            cluster the same way LightClusters.slang does. Every light whose bounding sphere contains a point must be listed for it.
+            \param[in] caseCount Number of random cameras and light sets
+            \param[in] lightCount Lights per case, a mix of point, sphere, polygonal and a few directional lights
+            \param[in] pointCount Test points per case
+            \param[in] seed Random seed
+        */
+        static ValidationReport validate(uint32_t caseCount = 16, uint32_t lightCount = 2000, uint32_t pointCount = 1 << 14, uint32_t seed = 0);
+
+    private:
+        LightClusters(const Desc& desc) : mDesc(desc) {}
+
+        uint32_t getClusterIndex(uint32_t tileX, uint32_t tileY, uint32_t slice) const { return (slice * mDesc.tileCountY + tileY) * mDesc.tileCountX + tileX; }
+        void getRangeLights(uint32_t range, std::vector<uint32_t>& lights) const;
+
+        Desc mDesc;
+
+        // Froxel geometry of the last build. Tile edges are stored as view space x/depth and y/depth ratios.
+        std::vector<float> mTileEdgesX;
+        std::vector<float> mTileEdgesY;
+        std::vector<float> mSliceDepths;
+
+        // Bounded lights in view space, structure-of-arrays
+        std::vector<float> mLightX, mLightY, mLightDepth, mLightRadius;
+        std::vector<uint32_t> mBoundedLights;
+
+        // One range per cluster followed by the global range. A range packs the first entry in mLightIndices in the upper 22 bits and the count in the lower 10.
+        std::vector<uint32_t> mRanges;
+        std::vector<uint16_t> mLightIndices;
+
+        std::vector<LightData> mLights;
+        float mDepthScale = 0;
+        float mDepthBias = 0;
+
+        StructuredBuffer::SharedPtr mpLightBuffer;
+        TypedBuffer<uint32_t>::SharedPtr mpRangeBuffer;
+        TypedBuffer<uint32_t>::SharedPtr mpIndexBuffer;
+    };
+}
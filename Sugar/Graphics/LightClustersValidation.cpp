@@ -0,0 +1,167 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "LightClusters.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        LightData createLight(CaseGenerator& gen, const glm::vec3& sceneMin, const glm::vec3& sceneMax)
+        {
+            LightData light;
+            const float kind = gen.uniform(0.0f, 1.0f);
+            light.worldPos = gen.uniform(sceneMin, sceneMax);
+            light.intensity = gen.uniform(glm::vec3(0.01f), glm::vec3(4.0f));
+            if (kind < 0.01f)
+            {
+                light.type = LightDirectional;
+                light.worldDir = glm::normalize(gen.uniform(glm::vec3(-1.0f), glm::vec3(1.0f)) + glm::vec3(0, 0, 1e-3f));
+            }
+            else if (kind < 0.4f)
+            {
+                light.type = LightPoint;
+            }
+            else if (kind < 0.7f)
+            {
+                light.type = LightSphere;
+                light.radius = gen.uniform(0.05f, 1.0f);
+            }
+            else
+            {
+                light.type = LightPolygonal;
+                const glm::vec3 u = gen.uniform(glm::vec3(-1.0f), glm::vec3(1.0f));
+                const glm::vec3 v = gen.uniform(glm::vec3(-1.0f), glm::vec3(1.0f));
+                light.vertices[0] = glm::vec4(light.worldPos - u - v, 1);
+                light.vertices[1] = glm::vec4(light.worldPos + u - v, 1);
+                light.vertices[2] = glm::vec4(light.worldPos + u + v, 1);
+                light.vertices[3] = glm::vec4(light.worldPos - u + v, 1);
+            }
+            return light;
+        }
+    }
+
+    LightClusters::ValidationReport LightClusters::validate(uint32_t caseCount, uint32_t lightCount, uint32_t pointCount, uint32_t seed)
+    {
+        ValidationReport report;
+        report.caseCount = caseCount;
+        report.pointCount = caseCount * pointCount;
+
+        double listedLights = 0;
+        double reachingLights = 0;
+        std::vector<uint32_t> clusterLights;
+        std::vector<uint32_t> globalLights;
+        std::vector<bool> listed(lightCount);
+
+        for (uint32_t c = 0; c < caseCount; c++)
+        {
+            CaseGenerator gen(getCaseSeed(seed, c));
+
+            // A camera inside the scene, with a jittered projection like the one used for TAA
+            const glm::vec3 sceneMin(-100.0f), sceneMax(100.0f);
+            const glm::vec3 eye = gen.uniform(sceneMin * 0.5f, sceneMax * 0.5f);
+            const glm::mat4 viewMat = glm::lookAt(eye, gen.uniform(sceneMin, sceneMax), glm::vec3(0, 1, 0));
+            const float nearZ = gen.uniform(0.05f, 1.0f);
+            const float farZ = gen.uniform(100.0f, 1000.0f);
+            glm::mat4 projMat = glm::perspective(gen.uniform(0.3f, 1.8f), gen.uniform(0.5f, 2.5f), nearZ, farZ);
+            projMat[2][0] = gen.uniform(-0.01f, 0.01f);
+            projMat[2][1] = gen.uniform(-0.01f, 0.01f);
+
+            std::vector<LightData> lights(lightCount);
+            for (auto& light : lights)
+            {
+                light = createLight(gen, sceneMin, sceneMax);
+            }
+
+            Desc desc;
+            desc.tileCountX = (uint32_t)gen.uniform(1.0f, 32.0f);
+            desc.tileCountY = (uint32_t)gen.uniform(1.0f, 32.0f);
+            desc.sliceCount = (uint32_t)gen.uniform(1.0f, 48.0f);
+            LightClusters clusters(desc);
+
+            CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+            clusters.build(lights, viewMat, projMat, nearZ, farZ);
+            report.buildMs += CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / caseCount;
+
+            clusters.getGlobalLights(globalLights);
+            const glm::mat4 invViewMat = glm::inverse(viewMat);
+
+            for (uint32_t p = 0; p < pointCount; p++)
+            {
+                // Pick the point in NDC and depth, then look up its cluster the way LightClusters.slang does
+                const float ndcX = gen.uniform(-1.0f, 1.0f);
+                const float ndcY = gen.uniform(-1.0f, 1.0f);
+                const float depth = nearZ * std::exp(gen.uniform(0.0f, 1.0f) * std::log(farZ / nearZ));
+                const glm::vec3 posV((ndcX + projMat[2][0]) / projMat[0][0] * depth, (ndcY + projMat[2][1]) / projMat[1][1] * depth, -depth);
+                const glm::vec3 posW = glm::vec3(invViewMat * glm::vec4(posV, 1));
+
+                const uint32_t tileX = std::min(uint32_t((ndcX * 0.5f + 0.5f) * desc.tileCountX), desc.tileCountX - 1);
+                const uint32_t tileY = std::min(uint32_t((0.5f - ndcY * 0.5f) * desc.tileCountY), desc.tileCountY - 1);
+                const float slice = std::log(std::max(depth, 1e-4f)) * clusters.mDepthScale + clusters.mDepthBias;
+                const uint32_t sliceIndex = (uint32_t)glm::clamp(slice, 0.0f, float(desc.sliceCount - 1));
+                clusters.getClusterLights(tileX, tileY, sliceIndex, clusterLights);
+
+                std::fill(listed.begin(), listed.end(), false);
+                for (uint32_t l : clusterLights)
+                {
+                    listed[l] = true;
+                }
+                for (uint32_t l : globalLights)
+                {
+                    listed[l] = true;
+                }
+                listedLights += clusterLights.size() + globalLights.size();
+
+                bool failed = false;
+                for (uint32_t l = 0; l < lightCount; l++)
+                {
+                    glm::vec4 sphere;
+                    bool reaches = true;
+                    if (getBoundingSphere(lights[l], desc.irradianceThreshold, sphere))
+                    {
+                        // Leave some slack at the sphere boundary, the binning runs in view space and rounds differently
+                        reaches = glm::length(posW - glm::vec3(sphere)) < sphere.w * 0.9999f;
+                    }
+                    if (reaches)
+                    {
+                        reachingLights++;
+                        failed |= !listed[l];
+                    }
+                }
+                report.failedCount += failed ? 1 : 0;
+            }
+        }
+
+        if (report.pointCount > 0)
+        {
+            report.meanListedLightCount = float(listedLights / report.pointCount);
+            report.meanReachingLightCount = float(reachingLights / report.pointCount);
+        }
+        return report;
+    }
+}
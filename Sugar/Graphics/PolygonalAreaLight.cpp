@@ -89,7 +89,8 @@ namespace Falcor
 
     float PolygonalAreaLight::getPower()
     {
-        assert(false);
+        // One-sided Lambertian emitter. The instance transform may have changed since the area was last computed.
+        updateSurfaceArea();
         return luminance(mData.intensity) * (float)M_PI * mSurfaceArea;
     }
 
@@ -200,6 +201,7 @@ namespace Falcor
     void PolygonalAreaLight::prepareGPUData()
     {
         // Get the surface area of the geometry mesh
+        updateSurfaceArea();
         mData.surfaceArea = mSurfaceArea;
 
         // Fetch the mesh instance transformation
@@ -285,8 +287,17 @@ namespace Falcor
 
     void PolygonalAreaLight::updateSurfaceArea()
     {
-        // TODO
-        mSurfaceArea = 0;
+        // Area of the quad the shaders integrate over (see prepareGPUData()), in world space so the instance scaling is included
+        if (mpVertices.size() < 4)
+        {
+            mSurfaceArea = 0;
+            return;
+        }
+
+        const glm::mat4 transform = mpModelInstance ? mpModelInstance->getTransformMatrix() : glm::mat4();
+        glm::vec3 diag0 = glm::vec3(transform * glm::vec4(polarCoordToCartesian(mpVertices[3]) - polarCoordToCartesian(mpVertices[0]), 0.0f));
+        glm::vec3 diag1 = glm::vec3(transform * glm::vec4(polarCoordToCartesian(mpVertices[2]) - polarCoordToCartesian(mpVertices[1]), 0.0f));
+        mSurfaceArea = 0.5f * glm::length(glm::cross(diag0, diag1));
     }
 
     glm::vec3 PolygonalAreaLight::polarCoordToCartesian(PolarCoordinate coord)
@@ -33,7 +33,15 @@
 #include "Graphics/Scene/Editor/SceneEditor.h"
 #include "Externals/ASSIMP/Include/assimp/Exporter.hpp"
 #include "glm/gtc/quaternion.hpp"
+#include "Utils/Platform/ProgressBar.h"
+#include "Utils/ParallelFor.h"
+#include "Graphics/Model/VertexPacking.h"
 #include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
 
 namespace Falcor
 {
@@ -658,9 +666,19 @@ namespace Falcor
         }
     }
 
-    void exportMeshDataToOBJ(const Model* pModel, std::string& filename)
+    // Triangle data of all meshes in a model, read back from the GPU buffers and merged into a single indexed mesh
+    struct ExportMeshData
     {
-        std::ofstream fs(filename);
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> texCoords;
+        std::vector<uint32_t> indices;
+    };
+
+    static bool readMeshData(const Model* pModel, ExportMeshData& data)
+    {
+        bool hasNormals = true;
+        bool hasTexCoords = true;
 
         for (uint32_t meshIdx = 0; meshIdx < pModel->getMeshCount(); ++meshIdx)
         {
@@ -669,78 +687,510 @@ namespace Falcor
 
             if (pVao->getPrimitiveTopology() != Vao::Topology::TriangleList)
             {
-                logError("obj exporter doesn't support topologies other than triangles.");
+                logError("Mitsuba exporter doesn't support topologies other than triangles.");
+                continue;
             }
 
+            const uint32_t vertexBase = (uint32_t)data.positions.size();
             const uint32_t vertCnt = pMesh->getVertexCount();
-            const uint32_t vbCnt = pVao->getVertexBuffersCount();
-            for (uint32_t vbIdx = 0; vbIdx < vbCnt; ++vbIdx)
+            bool foundPositions = false;
+            bool foundNormals = false;
+            bool foundTexCoords = false;
+
+            for (uint32_t vbIdx = 0; vbIdx < pVao->getVertexBuffersCount(); ++vbIdx)
             {
                 Buffer::SharedPtr pVB = pVao->getVertexBuffer(vbIdx);
-                float* pVBData = (float*)pVB->map(Buffer::MapType::Read);
+                const uint8_t* pVBData = (const uint8_t*)pVB->map(Buffer::MapType::Read);
 
                 const VertexBufferLayout* pLayout = pVao->getVertexLayout()->getBufferLayout(vbIdx).get();
                 for (uint32_t elemIdx = 0; elemIdx < pLayout->getElementCount(); ++elemIdx)
                 {
-                    float* pData = reinterpret_cast<float*>((uint8_t*)pVBData + pLayout->getElementOffset(elemIdx));
-
-                    if (pLayout->getElementName(elemIdx) == VERTEX_POSITION_NAME)
+                    const std::string& name = pLayout->getElementName(elemIdx);
+                    if (name == VERTEX_POSITION_NAME && !foundPositions)
                     {
-                        assert(pLayout->getElementFormat(elemIdx) == ResourceFormat::RGB32Float);
-                        for (uint32_t vertIdx = 0; vertIdx < vertCnt; ++vertIdx)
-                        {
-                            fs << "v " << pData[0] << " " << pData[1] << " " << pData[2] << std::endl;
-                            pData = reinterpret_cast<float*>((uint8_t*)pData + pLayout->getStride());
-                        }
+                        foundPositions = readVertexAttribute(pVBData, pLayout, elemIdx, vertCnt, pMesh->getBoundingBox(), data.positions);
                     }
-                    else if (pLayout->getElementName(elemIdx) == VERTEX_NORMAL_NAME)
+                    else if (name == VERTEX_NORMAL_NAME && !foundNormals)
                     {
-                        assert(pLayout->getElementFormat(elemIdx) == ResourceFormat::RGB32Float);
-                        for (uint32_t vertIdx = 0; vertIdx < vertCnt; ++vertIdx)
-                        {
-                            fs << "vn " << pData[0] << " " << pData[1] << " " << pData[2] << std::endl;
-                            pData = reinterpret_cast<float*>((uint8_t*)pData + pLayout->getStride());
-                        }
+                        foundNormals = readVertexAttribute(pVBData, pLayout, elemIdx, vertCnt, pMesh->getBoundingBox(), data.normals);
                     }
-                    else if (pLayout->getElementName(elemIdx) == VERTEX_TEXCOORD_NAME)
+                    else if (name == VERTEX_TEXCOORD_NAME && !foundTexCoords)
                     {
-                        assert(pLayout->getElementFormat(elemIdx) == ResourceFormat::RG32Float);
-                        for (uint32_t vertIdx = 0; vertIdx < vertCnt; ++vertIdx)
-                        {
-                            fs << "vt " << pData[0] << " " << pData[1] << " " << pData[2] << std::endl;
-                            pData = reinterpret_cast<float*>((uint8_t*)pData + pLayout->getStride());
-                        }
-                    }
-                    else
-                    {
-                        logError("Vertex attribute not supported.");
+                        foundTexCoords = readVertexAttribute(pVBData, pLayout, elemIdx, vertCnt, pMesh->getBoundingBox(), data.texCoords);
                     }
                 }
 
-                fs << "# " << vertCnt << " vertices" << std::endl;
-
                 pVB->unmap();
             }
 
+            if (!foundPositions)
+            {
+                logError("Mesh without vertex positions can't be exported.");
+                data.positions.resize(vertexBase);
+                data.normals.resize(std::min(data.normals.size(), (size_t)vertexBase));
+                data.texCoords.resize(std::min(data.texCoords.size(), (size_t)vertexBase));
+                continue;
+            }
+
+            // Keep the attribute arrays in sync with the positions, attributes missing from any mesh are dropped at the end
+            hasNormals = hasNormals && foundNormals;
+            hasTexCoords = hasTexCoords && foundTexCoords;
+            data.normals.resize(data.positions.size());
+            data.texCoords.resize(data.positions.size());
 
             {
                 Buffer::SharedPtr pIB = pVao->getIndexBuffer();
                 assert(pVao->getIndexBufferFormat() == ResourceFormat::R32Uint);
-                uint32_t* pData = (uint32_t*)pIB->map(Buffer::MapType::Read);
-                for (uint32_t triangleIdx = 0; triangleIdx < pMesh->getPrimitiveCount(); ++triangleIdx)
+                const uint32_t* pData = (const uint32_t*)pIB->map(Buffer::MapType::Read);
+
+                const uint32_t indexCnt = pMesh->getPrimitiveCount() * 3;
+                const size_t indexBase = data.indices.size();
+                data.indices.resize(indexBase + indexCnt);
+                for (uint32_t i = 0; i < indexCnt; ++i)
                 {
-                    fs << "f "
-                        << (pData[3 * triangleIdx + 0] + 1) << " "
-                        << (pData[3 * triangleIdx + 1] + 1) << " "
-                        << (pData[3 * triangleIdx + 2] + 1) << std::endl;
+                    data.indices[indexBase + i] = pData[i] + vertexBase;
                 }
 
                 pIB->unmap();
             }
         }
+
+        if (!hasNormals) data.normals.clear();
+        if (!hasTexCoords) data.texCoords.clear();
+
+        return data.positions.size() > 0;
+    }
+
+    static bool writeFileContents(const std::string& filename, const void* pData, size_t size)
+    {
+        std::ofstream fs(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!fs.is_open())
+        {
+            logError("Can't open file " + filename + " for writing.");
+            return false;
+        }
+        fs.write((const char*)pData, size);
+        return fs.good();
+    }
+
+    template<typename T>
+    static void appendBytes(std::vector<uint8_t>& buffer, const T* pData, size_t count)
+    {
+        const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(pData);
+        buffer.insert(buffer.end(), pBytes, pBytes + sizeof(T) * count);
+    }
+
+    template<typename T>
+    static void appendValue(std::vector<uint8_t>& buffer, const T& value)
+    {
+        appendBytes(buffer, &value, 1);
+    }
+
+    static bool exportMeshDataToOBJ(const ExportMeshData& data, const std::string& filename)
+    {
+        // Format into one string and write it at once, formatting through an ostream and flushing every line is very slow for large meshes
+        std::string text;
+        text.reserve(data.positions.size() * 96 + data.indices.size() * 12);
+
+        char line[128];
+        for (const auto& p : data.positions)
+        {
+            int len = snprintf(line, sizeof(line), "v %g %g %g\n", p.x, p.y, p.z);
+            text.append(line, len);
+        }
+        for (const auto& n : data.normals)
+        {
+            int len = snprintf(line, sizeof(line), "vn %g %g %g\n", n.x, n.y, n.z);
+            text.append(line, len);
+        }
+        for (const auto& t : data.texCoords)
+        {
+            int len = snprintf(line, sizeof(line), "vt %g %g\n", t.x, t.y);
+            text.append(line, len);
+        }
+        text += "# " + std::to_string(data.positions.size()) + " vertices\n";
+
+        for (size_t i = 0; i + 2 < data.indices.size(); i += 3)
+        {
+            int len = snprintf(line, sizeof(line), "f %u %u %u\n", data.indices[i + 0] + 1, data.indices[i + 1] + 1, data.indices[i + 2] + 1);
+            text.append(line, len);
+        }
+
+        return writeFileContents(filename, text.data(), text.size());
     }
 
-    void addWavefrontOBJ(const Scene* pScene, uint32_t modelID, pugi::xml_node& parent)
+    // Binary little-endian PLY, which matches the memory layout on all platforms we run on
+    static bool exportMeshDataToPLY(const ExportMeshData& data, const std::string& filename)
+    {
+        const bool hasNormals = data.normals.size() > 0;
+        const bool hasTexCoords = data.texCoords.size() > 0;
+        const size_t vertCnt = data.positions.size();
+        const size_t triCnt = data.indices.size() / 3;
+
+        std::string header = "ply\nformat binary_little_endian 1.0\n";
+        header += "element vertex " + std::to_string(vertCnt) + "\n";
+        header += "property float x\nproperty float y\nproperty float z\n";
+        if (hasNormals) header += "property float nx\nproperty float ny\nproperty float nz\n";
+        if (hasTexCoords) header += "property float u\nproperty float v\n";
+        header += "element face " + std::to_string(triCnt) + "\n";
+        header += "property list uchar int vertex_indices\n";
+        header += "end_header\n";
+
+        const size_t vertexSize = sizeof(glm::vec3) + (hasNormals ? sizeof(glm::vec3) : 0) + (hasTexCoords ? sizeof(glm::vec2) : 0);
+        const size_t faceSize = sizeof(uint8_t) + 3 * sizeof(uint32_t);
+
+        std::vector<uint8_t> buffer;
+        buffer.reserve(header.size() + vertCnt * vertexSize + triCnt * faceSize);
+        appendBytes(buffer, header.data(), header.size());
+
+        for (size_t i = 0; i < vertCnt; ++i)
+        {
+            appendValue(buffer, data.positions[i]);
+            if (hasNormals) appendValue(buffer, data.normals[i]);
+            if (hasTexCoords) appendValue(buffer, data.texCoords[i]);
+        }
+
+        for (size_t i = 0; i < triCnt; ++i)
+        {
+            appendValue(buffer, uint8_t(3));
+            appendBytes(buffer, &data.indices[i * 3], 3);
+        }
+
+        return writeFileContents(filename, buffer.data(), buffer.size());
+    }
+
+    // Wrap the data into a zlib stream made of stored deflate blocks. Mitsuba always inflates the shape data, but doesn't require it to be compressed
+    static void appendZlibStoredStream(std::vector<uint8_t>& buffer, const std::vector<uint8_t>& data)
+    {
+        const size_t kMaxStoredBlockSize = 0xFFFF;
+        const size_t blockCount = std::max<size_t>(1, (data.size() + kMaxStoredBlockSize - 1) / kMaxStoredBlockSize);
+        buffer.reserve(buffer.size() + data.size() + blockCount * 5 + 6);
+
+        // CMF/FLG: deflate with a 32K window, no preset dictionary, check bits make the header a multiple of 31
+        buffer.push_back(0x78);
+        buffer.push_back(0x01);
+
+        size_t offset = 0;
+        for (size_t block = 0; block < blockCount; ++block)
+        {
+            const uint16_t len = (uint16_t)std::min(kMaxStoredBlockSize, data.size() - offset);
+            const uint16_t nlen = (uint16_t)~len;
+            buffer.push_back(block + 1 == blockCount ? 1 : 0);
+            buffer.push_back(uint8_t(len & 0xFF));
+            buffer.push_back(uint8_t(len >> 8));
+            buffer.push_back(uint8_t(nlen & 0xFF));
+            buffer.push_back(uint8_t(nlen >> 8));
+            buffer.insert(buffer.end(), data.begin() + offset, data.begin() + offset + len);
+            offset += len;
+        }
+
+        // Adler-32 of the uncompressed data, big-endian. 5552 is the largest run which can't overflow the 32-bit sums
+        uint32_t a = 1;
+        uint32_t b = 0;
+        for (size_t i = 0; i < data.size();)
+        {
+            const size_t runEnd = std::min(data.size(), i + 5552);
+            for (; i < runEnd; ++i)
+            {
+                a += data[i];
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+        }
+        const uint32_t adler = (b << 16) | a;
+        buffer.push_back(uint8_t(adler >> 24));
+        buffer.push_back(uint8_t(adler >> 16));
+        buffer.push_back(uint8_t(adler >> 8));
+        buffer.push_back(uint8_t(adler));
+    }
+
+    // Mitsuba 'serialized' mesh format, version 4, holding a single shape
+    static bool exportMeshDataToSerialized(const ExportMeshData& data, const std::string& shapeName, const std::string& filename)
+    {
+        enum : uint32_t
+        {
+            HasNormals      = 0x0001,
+            HasTexcoords    = 0x0002,
+            SinglePrecision = 0x1000,
+        };
+
+        const uint16_t kFormatId = 0x041C;
+        const uint16_t kFormatVersion = 4;
+
+        uint32_t flags = SinglePrecision;
+        if (data.normals.size() > 0) flags |= HasNormals;
+        if (data.texCoords.size() > 0) flags |= HasTexcoords;
+
+        std::vector<uint8_t> shapeData;
+        shapeData.reserve(sizeof(uint32_t) + shapeName.size() + 1 + 2 * sizeof(uint64_t) +
+                          data.positions.size() * sizeof(glm::vec3) + data.normals.size() * sizeof(glm::vec3) +
+                          data.texCoords.size() * sizeof(glm::vec2) + data.indices.size() * sizeof(uint32_t));
+        appendValue(shapeData, flags);
+        appendBytes(shapeData, shapeName.c_str(), shapeName.size() + 1);
+        appendValue(shapeData, uint64_t(data.positions.size()));
+        appendValue(shapeData, uint64_t(data.indices.size() / 3));
+        appendBytes(shapeData, data.positions.data(), data.positions.size());
+        appendBytes(shapeData, data.normals.data(), data.normals.size());
+        appendBytes(shapeData, data.texCoords.data(), data.texCoords.size());
+        appendBytes(shapeData, data.indices.data(), data.indices.size());
+
+        std::vector<uint8_t> buffer;
+        appendValue(buffer, kFormatId);
+        appendValue(buffer, kFormatVersion);
+        appendZlibStoredStream(buffer, shapeData);
+
+        // Dictionary at the end of the file: the offset of every shape followed by the shape count
+        appendValue(buffer, uint64_t(0));
+        appendValue(buffer, uint32_t(1));
+
+        return writeFileContents(filename, buffer.data(), buffer.size());
+    }
+
+    static const char* getShapeFormatExtension(SceneMitsubaExporter::MitsubaCfg::ShapeFormat format)
+    {
+        switch (format)
+        {
+        case SceneMitsubaExporter::MitsubaCfg::ShapeFormat::OBJ:
+            return "obj";
+        case SceneMitsubaExporter::MitsubaCfg::ShapeFormat::PLY:
+            return "ply";
+        case SceneMitsubaExporter::MitsubaCfg::ShapeFormat::Serialized:
+            return "serialized";
+        default:
+            should_not_get_here();
+            return "";
+        }
+    }
+
+    // 64-bit FNV-1a. Exported shape files are named after the hash of their contents
+    static uint64_t hashBytes(const void* pData, size_t size, uint64_t hash = 14695981039346656037ull)
+    {
+        const uint8_t* pBytes = (const uint8_t*)pData;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= pBytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    template<typename T>
+    static uint64_t hashArray(const std::vector<T>& v, uint64_t hash)
+    {
+        const uint64_t count = v.size();
+        hash = hashBytes(&count, sizeof(count), hash);
+        return hashBytes(v.data(), v.size() * sizeof(T), hash);
+    }
+
+    static uint64_t hashMeshData(const ExportMeshData& data, const std::string& shapeName, SceneMitsubaExporter::MitsubaCfg::ShapeFormat format)
+    {
+        uint64_t hash = hashBytes(&format, sizeof(format));
+        hash = hashBytes(shapeName.c_str(), shapeName.size() + 1, hash);
+        hash = hashArray(data.positions, hash);
+        hash = hashArray(data.normals, hash);
+        hash = hashArray(data.texCoords, hash);
+        hash = hashArray(data.indices, hash);
+        return hash;
+    }
+
+    /** Remembers which shape file was exported for a set of GPU buffers. Mesh buffers are immutable, so while the same buffers are alive the
+        file can be reused without reading the data back and hashing it again.
+    */
+    class ShapeFileCache
+    {
+    public:
+        static ShapeFileCache& instance()
+        {
+            static ShapeFileCache sCache;
+            return sCache;
+        }
+
+        bool find(const Model* pModel, SceneMitsubaExporter::MitsubaCfg::ShapeFormat format, const std::string& shapeName, std::string& filename)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto it = mEntries.find(getKey(pModel, format, shapeName));
+            if (it == mEntries.end())
+            {
+                return false;
+            }
+
+            for (const auto& pBuffer : it->second.buffers)
+            {
+                if (pBuffer.expired())
+                {
+                    mEntries.erase(it);
+                    return false;
+                }
+            }
+
+            if (!doesFileExist(it->second.filename))
+            {
+                mEntries.erase(it);
+                return false;
+            }
+
+            filename = it->second.filename;
+            return true;
+        }
+
+        void insert(const Model* pModel, SceneMitsubaExporter::MitsubaCfg::ShapeFormat format, const std::string& shapeName, const std::string& filename)
+        {
+            Entry entry;
+            entry.filename = filename;
+            for (uint32_t meshIdx = 0; meshIdx < pModel->getMeshCount(); ++meshIdx)
+            {
+                const Vao::SharedPtr& pVao = pModel->getMesh(meshIdx)->getVao();
+                for (uint32_t vbIdx = 0; vbIdx < pVao->getVertexBuffersCount(); ++vbIdx)
+                {
+                    entry.buffers.push_back(pVao->getVertexBuffer(vbIdx));
+                }
+                entry.buffers.push_back(pVao->getIndexBuffer());
+            }
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            mEntries[getKey(pModel, format, shapeName)] = std::move(entry);
+        }
+
+    private:
+        struct Entry
+        {
+            std::vector<std::weak_ptr<Buffer>> buffers;
+            std::string filename;
+        };
+
+        static std::string getKey(const Model* pModel, SceneMitsubaExporter::MitsubaCfg::ShapeFormat format, const std::string& shapeName)
+        {
+            std::string key((const char*)&format, sizeof(format));
+            key.append(shapeName.c_str(), shapeName.size() + 1);
+            for (uint32_t meshIdx = 0; meshIdx < pModel->getMeshCount(); ++meshIdx)
+            {
+                const Vao::SharedPtr& pVao = pModel->getMesh(meshIdx)->getVao();
+                for (uint32_t vbIdx = 0; vbIdx < pVao->getVertexBuffersCount(); ++vbIdx)
+                {
+                    const Buffer* pVB = pVao->getVertexBuffer(vbIdx).get();
+                    key.append((const char*)&pVB, sizeof(pVB));
+                }
+                const Buffer* pIB = pVao->getIndexBuffer().get();
+                key.append((const char*)&pIB, sizeof(pIB));
+            }
+            return key;
+        }
+
+        std::unordered_map<std::string, Entry> mEntries;
+        std::mutex mMutex;
+    };
+
+    static std::string getShapeCacheDirectory(const SceneMitsubaExporter::MitsubaCfg& mtsCfg)
+    {
+        std::string directory = mtsCfg.mShapeCacheDirectory.length() > 0 ? mtsCfg.mShapeCacheDirectory : getTempDirectory() + "/MitsubaShapes";
+        if (!isDirectoryExists(directory))
+        {
+            createDirectory(directory);
+        }
+        return directory;
+    }
+
+    static bool writeMeshDataFile(const ExportMeshData& data, SceneMitsubaExporter::MitsubaCfg::ShapeFormat format, const std::string& shapeName, const std::string& filename)
+    {
+        switch (format)
+        {
+        case SceneMitsubaExporter::MitsubaCfg::ShapeFormat::OBJ:
+            return exportMeshDataToOBJ(data, filename);
+        case SceneMitsubaExporter::MitsubaCfg::ShapeFormat::PLY:
+            return exportMeshDataToPLY(data, filename);
+        case SceneMitsubaExporter::MitsubaCfg::ShapeFormat::Serialized:
+            return exportMeshDataToSerialized(data, shapeName, filename);
+        default:
+            should_not_get_here();
+            return false;
+        }
+    }
+
+    // Shape file of a model as it moves through the export stages
+    struct ModelShapeExport
+    {
+        std::string name;
+        std::string filename;
+        const char* shapeType = "obj";
+        ExportMeshData data;
+        std::string error;
+        bool needsWrite = false;
+        bool needsCacheInsert = false;
+    };
+
+    /** Stage 1, runs on the main thread since it maps GPU buffers.
+        Models loaded from a file reference it directly. Generated models reuse the file exported for the same buffers, otherwise their data is read back.
+    */
+    static void beginModelExport(const Model* pModel, const SceneMitsubaExporter::MitsubaCfg& mtsCfg, ModelShapeExport& shape)
+    {
+        shape.filename = pModel->getAbsoluteFilename();
+        if (shape.filename.length() > 0)
+        {
+            return;
+        }
+
+        shape.name = pModel->getName().length() > 0 ? pModel->getName() : "Untitled";
+        shape.shapeType = getShapeFormatExtension(mtsCfg.mShapeFormat);
+
+        if (ShapeFileCache::instance().find(pModel, mtsCfg.mShapeFormat, shape.name, shape.filename))
+        {
+            return;
+        }
+
+        if (!readMeshData(pModel, shape.data))
+        {
+            shape.error = "Model " + shape.name + " has no exportable triangles.";
+            return;
+        }
+
+        shape.needsWrite = true;
+    }
+
+    /** Stage 2a, runs on a worker thread.
+        Shape files are content-addressed, geometry exported before by this or an earlier run reuses the existing file.
+    */
+    static void hashModelExport(const SceneMitsubaExporter::MitsubaCfg& mtsCfg, const std::string& cacheDirectory, ModelShapeExport& shape)
+    {
+        const SceneMitsubaExporter::MitsubaCfg::ShapeFormat format = mtsCfg.mShapeFormat;
+
+        char hashStr[17];
+        snprintf(hashStr, sizeof(hashStr), "%016llx", (unsigned long long)hashMeshData(shape.data, shape.name, format));
+        shape.filename = cacheDirectory + "/" + hashStr + "." + getShapeFormatExtension(format);
+    }
+
+    /** Stage 2b, runs on a worker thread. Each file is written by a single task, duplicates are removed before this stage.
+        \param[in] writeIndex Index of the write in this export, keeps the temporary file names unique
+    */
+    static void writeModelExport(const SceneMitsubaExporter::MitsubaCfg& mtsCfg, size_t writeIndex, ModelShapeExport& shape)
+    {
+        if (!doesFileExist(shape.filename))
+        {
+            // Write to a temporary file first, so an interrupted export never leaves a truncated file under the final name
+            const std::string tempFilename = shape.filename + "." + std::to_string(writeIndex) + ".tmp";
+            if (!writeMeshDataFile(shape.data, mtsCfg.mShapeFormat, shape.name, tempFilename))
+            {
+                std::remove(tempFilename.c_str());
+                shape.error = "Can't write shape file " + tempFilename;
+                return;
+            }
+
+            if (std::rename(tempFilename.c_str(), shape.filename.c_str()) != 0)
+            {
+                std::remove(tempFilename.c_str());
+                if (!doesFileExist(shape.filename))
+                {
+                    shape.error = "Can't write shape file " + shape.filename;
+                    return;
+                }
+            }
+        }
+
+        shape.needsCacheInsert = true;
+    }
+
+    // Stage 3, runs on the main thread in model order so the document doesn't depend on thread scheduling
+    void addModelShapes(const Scene* pScene, uint32_t modelID, const ModelShapeExport& shape, pugi::xml_node& parent)
     {
         assert(pScene->getModelInstanceCount(modelID) > 0);
 
@@ -750,24 +1200,26 @@ namespace Falcor
 
         assert(parent.child(shapegroupId.c_str()).empty());
 
+        if (shape.error.length() > 0)
+        {
+            logError(shape.error);
+            return;
+        }
+
         for (uint32_t i = 0; i < pScene->getModelInstanceCount(modelID); i++)
         {
             auto& pInstance = pScene->getModelInstance(modelID, i);
 
             pugi::xml_node obj = addNodeWithType(parent, "shape");
-            setNodeAttr(obj, "type", "obj");
+            setNodeAttr(obj, "type", shape.shapeType);
 
             addComments(obj, pInstance->getName());
 
-            std::string filename = pModel->getAbsoluteFilename();
-            if (filename.length() <= 0)
+            addString(obj, "filename", shape.filename);
+            if (strcmp(shape.shapeType, "serialized") == 0)
             {
-                const std::string dir = getTempDirectory();
-                findAvailableFilename(pModel->getName().length() > 0 ? pModel->getName() : "Untitled", dir, "obj",
-                                      filename);
-                exportMeshDataToOBJ(pModel, filename);
+                addInteger(obj, "shapeIndex", 0);
             }
-            addString(obj, "filename", filename);
 
             addTransformWithMatrix(obj, "toWorld", pInstance->getTransformMatrix());
 
@@ -789,9 +1241,77 @@ namespace Falcor
 
         addComments(mSceneNode, "Models");
 
-        for (uint32_t i = 0; i < mpScene->getModelCount(); i++)
+        const uint32_t modelCount = mpScene->getModelCount();
+        std::vector<ModelShapeExport> shapes(modelCount);
+
+        for (uint32_t i = 0; i < modelCount; i++)
+        {
+            beginModelExport(mpScene->getModel(i).get(), mMitsubaCfg, shapes[i]);
+        }
+
+        std::vector<uint32_t> pendingWrites;
+        for (uint32_t i = 0; i < modelCount; i++)
         {
-            addWavefrontOBJ(mpScene, i, mSceneNode);
+            if (shapes[i].needsWrite) pendingWrites.push_back(i);
+        }
+
+        if (pendingWrites.size() > 0)
+        {
+            ProgressBar::SharedPtr pBar;
+            if (mMitsubaCfg.mShowProgressBar)
+            {
+                pBar = ProgressBar::create("Exporting Models");
+            }
+
+            const std::string cacheDirectory = getShapeCacheDirectory(mMitsubaCfg);
+            parallelFor(0, pendingWrites.size(), [&](size_t i)
+            {
+                PROFILE_CPU(hashModelShape);
+                hashModelExport(mMitsubaCfg, cacheDirectory, shapes[pendingWrites[i]]);
+            });
+
+            // Models with the same geometry and name map to the same file, only the first one writes it
+            std::unordered_map<std::string, uint32_t> writerByFilename;
+            std::vector<uint32_t> uniqueWrites;
+            std::vector<std::pair<uint32_t, uint32_t>> duplicates;
+            for (uint32_t modelID : pendingWrites)
+            {
+                auto result = writerByFilename.emplace(shapes[modelID].filename, modelID);
+                if (result.second)
+                {
+                    uniqueWrites.push_back(modelID);
+                }
+                else
+                {
+                    duplicates.push_back({ modelID, result.first->second });
+                }
+            }
+
+            parallelFor(0, uniqueWrites.size(), [&](size_t i)
+            {
+                PROFILE_CPU(writeModelShape);
+                writeModelExport(mMitsubaCfg, i, shapes[uniqueWrites[i]]);
+            });
+
+            for (const auto& d : duplicates)
+            {
+                shapes[d.first].error = shapes[d.second].error;
+                shapes[d.first].needsCacheInsert = shapes[d.second].needsCacheInsert;
+            }
+
+            for (uint32_t modelID : pendingWrites)
+            {
+                shapes[modelID].data = ExportMeshData();
+            }
+        }
+
+        for (uint32_t i = 0; i < modelCount; i++)
+        {
+            if (shapes[i].needsCacheInsert)
+            {
+                ShapeFileCache::instance().insert(mpScene->getModel(i).get(), mMitsubaCfg.mShapeFormat, shapes[i].name, shapes[i].filename);
+            }
+            addModelShapes(mpScene, i, shapes[i], mSceneNode);
         }
     }
 
@@ -45,6 +45,25 @@ namespace Falcor
             float mViewportHeight = 1024.0f;
             const Camera* mpCamera = nullptr;
             int32_t sampleCount = 64;
+
+            /** File format used for models which have to be written out, i.e. models which weren't loaded from a file
+            */
+            enum class ShapeFormat
+            {
+                OBJ,            ///< Wavefront OBJ text
+                PLY,            ///< Binary little-endian PLY
+                Serialized,     ///< Mitsuba serialized mesh format
+            };
+            ShapeFormat mShapeFormat = ShapeFormat::PLY;
+
+            /** Directory for exported shape files. Files are named after a hash of their contents, so geometry exported before is reused
+                instead of being written again. Defaults to a folder in the temp directory when empty.
+            */
+            std::string mShapeCacheDirectory;
+
+            /** Show a progress bar while shape files are written
+            */
+            bool mShowProgressBar = false;
         };
 
         enum : uint32_t
@@ -36,6 +36,7 @@
 #include "Graphics/Model/AnimationController.h"
 #include "API/Device.h"
 #include "Graphics/Model/ModelRenderer.h"
+#include "Graphics/LightClusters.h"
 #include "Utils/Math/FalcorMath.h"
 #include "Data/HostDeviceData.h"
 #include "Utils/StringUtils.h"
@@ -348,9 +349,9 @@ namespace Falcor
         {
             if (pGui->addButton("Add Point Light"))
             {
-                if (mpScene->getLightCount() >= MAX_LIGHT_SOURCES)
+                if (mpScene->getLightCount() >= LightClusters::kMaxLightCount)
                 {
-                    msgBox("There cannot be more than 16 lights at a time in a scene!");
+                    msgBox("There cannot be more than " + std::to_string(LightClusters::kMaxLightCount) + " lights at a time in a scene!");
                     return;
                 }
 
@@ -385,9 +386,9 @@ namespace Falcor
         {
             if (pGui->addButton("Add Directional Light"))
             {
-                if (mpScene->getLightCount() >= MAX_LIGHT_SOURCES)
+                if (mpScene->getLightCount() >= LightClusters::kMaxLightCount)
                 {
-                    msgBox("There cannot be more than 16 lights at a time in a scene!");
+                    msgBox("There cannot be more than " + std::to_string(LightClusters::kMaxLightCount) + " lights at a time in a scene!");
                     return;
                 }
 
@@ -410,9 +411,9 @@ namespace Falcor
         {
             if (pGui->addButton("Add Sphere Area Light"))
             {
-                if (mpScene->getLightCount() >= MAX_LIGHT_SOURCES)
+                if (mpScene->getLightCount() >= LightClusters::kMaxLightCount)
                 {
-                    msgBox("There cannot be more than 16 lights at a time in a scene!");
+                    msgBox("There cannot be more than " + std::to_string(LightClusters::kMaxLightCount) + " lights at a time in a scene!");
                     return;
                 }
 
@@ -436,9 +437,9 @@ namespace Falcor
         {
             if (pGui->addButton("Add Polygonal Light"))
             {
-                if (mpScene->getLightCount() >= MAX_LIGHT_SOURCES)
+                if (mpScene->getLightCount() >= LightClusters::kMaxLightCount)
                 {
-                    msgBox("There cannot be more than 16 lights at a time in a scene!");
+                    msgBox("There cannot be more than " + std::to_string(LightClusters::kMaxLightCount) + " lights at a time in a scene!");
                     return;
                 }
 
@@ -549,7 +550,7 @@ namespace Falcor
         // Master Scene Picking
         //
 
-        mpScenePicker = Picking::create(mpScene, backBufferWidth, backBufferHeight);
+        mpSceneBvh = SceneBvh::create(mpScene);
 
         //
         // Editor Scene and Picking
@@ -937,13 +938,14 @@ namespace Falcor
                 if (mMouseHoldTimer.getElapsedTime() < 0.2f)
                 {
                     // When selecting meshes for applying material override, don't check editor objects
+                    SceneBvh::Hit hit;
                     if (mpEditorPicker->pick(pContext, mouseEvent.pos, mpEditorScene->getActiveCamera()))
                     {
                         select(mpEditorPicker->getPickedModelInstance());
                     }
-                    else if (mpScenePicker->pick(pContext, mouseEvent.pos, mpEditorScene->getActiveCamera()))
+                    else if (raycastScene(mouseEvent.pos, hit))
                     {
-                        select(mpScenePicker->getPickedModelInstance(), mpScenePicker->getPickedMeshInstance());
+                        select(hit.instance.pModelInstance, hit.instance.pMeshInstance);
                     }
                     else
                     {
@@ -970,13 +972,26 @@ namespace Falcor
 
     void SugarSceneEditor::onResizeSwapChain()
     {
-        if (mpScenePicker)
+        if (mpEditorPicker)
         {
             auto backBufferFBO = gpDevice->getSwapChainFbo();
-            mpScenePicker->resizeFBO(backBufferFBO->getWidth(), backBufferFBO->getHeight());
+            mpEditorPicker->resizeFBO(backBufferFBO->getWidth(), backBufferFBO->getHeight());
         }
     }
 
+    bool SugarSceneEditor::raycastScene(const glm::vec2& mousePos, SceneBvh::Hit& hit)
+    {
+        const Camera* pCamera = mpEditorScene->getActiveCamera().get();
+
+        Ray ray;
+        ray.origin = pCamera->getPosition();
+        ray.direction = mousePosToWorldRay(mousePos, pCamera->getViewMatrix(), pCamera->getProjMatrix());
+
+        // Picks up instances which were added, removed or moved since the last click
+        mpSceneBvh->update();
+        return mpSceneBvh->raycast(ray, hit);
+    }
+
     void SugarSceneEditor::setActiveModelInstance(const Scene::ModelInstance::SharedPtr& pModelInstance)
     {
         for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
@@ -32,6 +32,7 @@
 #include "Graphics/Material/MaterialEditor.h"
 #include "Utils/DebugDrawer.h"
 #include "Utils/Picking/Picking.h"
+#include "Graphics/Scene/SceneBvh.h"
 #include "Graphics/Scene/Editor/Gizmo.h"
 #include "Graphics/Scene/Editor/SceneEditorRenderer.h"
 #include "Graphics/Material/MaterialHistory.h"
@@ -225,6 +226,9 @@ namespace Falcor
         void select(const Scene::ModelInstance::SharedPtr& pModelInstance, const Model::MeshInstance::SharedPtr& pMeshInstance = nullptr);
         void deselect();
 
+        // Casts a ray from the mouse position into the master scene on the CPU
+        bool raycastScene(const glm::vec2& mousePos, SceneBvh::Hit& hit);
+
         void setActiveModelInstance(const Scene::ModelInstance::SharedPtr& pModelInstance);
 
         // ID's in master scene
@@ -235,7 +239,7 @@ namespace Falcor
         uint32_t mSelectedPath = 0;
         uint32_t mSelectedMaterial = 0;
 
-        Picking::UniquePtr mpScenePicker;
+        SceneBvh::SharedPtr mpSceneBvh;
 
         std::set<Scene::ModelInstance*> mSelectedInstances;
         ObjectType mSelectedObjectType = ObjectType::None;
@@ -0,0 +1,130 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Falcor.h"
+#include <random>
+#include <string>
+#include <vector>
+
+namespace Falcor
+{
+    /** Counters shared by the reports of the CPU validators. Each validator derives its own report with the measurements specific to it.
+    */
+    struct ValidationReport
+    {
+        uint32_t caseCount = 0;
+        uint32_t pointCount = 0;    ///< Points tested over all cases, 0 if the validator only checks whole cases
+        uint32_t failedCount = 0;   ///< Failed points, or failed cases if pointCount is 0
+    };
+
+    /** Log the counters of a report followed by one line per detail
+        \param[in] name Name of the validated component, starting the first line
+        \param[in] report Report returned by the validator
+        \param[in] details Additional lines, indented below the counters
+    */
+    void logValidationReport(const std::string& name, const ValidationReport& report, const std::vector<std::string>& details);
+
+    /** Seed for one case of a validation run, or for one item inside a case when called with the seed of the case.
+        Consecutive indices and seeds give unrelated sequences, so cases can run in any order and on any thread.
+    */
+    inline uint32_t getCaseSeed(uint32_t seed, uint32_t index)
+    {
+        // Golden ratio increment followed by the MurmurHash3 finalizer
+        uint32_t h = seed * 0x9E3779B9u + index;
+        h ^= h >> 16;
+        h *= 0x85EBCA6Bu;
+        h ^= h >> 13;
+        h *= 0xC2B2AE35u;
+        h ^= h >> 16;
+        return h;
+    }
+
+    /** Random configurations for one validation case
+    */
+    class CaseGenerator
+    {
+    public:
+        CaseGenerator(uint32_t seed) : mRng(seed) {}
+
+        float uniform(float a, float b) { return std::uniform_real_distribution<float>(a, b)(mRng); }
+        glm::vec3 uniform(const glm::vec3& a, const glm::vec3& b) { return glm::vec3(uniform(a.x, b.x), uniform(a.y, b.y), uniform(a.z, b.z)); }
+
+        glm::vec3 unitVector()
+        {
+            const float z = uniform(-1.0f, 1.0f);
+            const float phi = uniform(0.0f, 2.0f * glm::pi<float>());
+            const float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+            return glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
+        }
+
+        // Direction around N with the cosine to N in [cosMin, cosMax]
+        glm::vec3 directionAround(const glm::vec3& N, float cosMin, float cosMax)
+        {
+            glm::vec3 T, B;
+            buildFrame(N, T, B);
+            const float cosTheta = uniform(cosMin, cosMax);
+            const float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+            const float phi = uniform(0.0f, 2.0f * glm::pi<float>());
+            return glm::normalize(T * (sinTheta * std::cos(phi)) + B * (sinTheta * std::sin(phi)) + N * cosTheta);
+        }
+
+        /** Rectangle in front of P, counter-clockwise as seen from the side it faces
+        */
+        void quad(const glm::vec3& P, const glm::vec3& N, glm::vec3 points[4])
+        {
+            // Below-horizon centers produce the clipped configurations
+            const glm::vec3 dir = directionAround(N, -0.3f, 1.0f);
+            const glm::vec3 center = P + dir * uniform(1.0f, 4.0f);
+
+            glm::vec3 facing = glm::normalize(-dir + unitVector() * 0.5f);
+            if (uniform(0.0f, 1.0f) < 0.1f)
+            {
+                facing = -facing;
+            }
+
+            glm::vec3 t1, t2;
+            buildFrame(facing, t1, t2);
+            t1 *= uniform(0.05f, 0.5f);
+            t2 *= uniform(0.05f, 0.5f);
+            points[0] = center - t1 - t2;
+            points[1] = center + t1 - t2;
+            points[2] = center + t1 + t2;
+            points[3] = center - t1 + t2;
+        }
+
+        static void buildFrame(const glm::vec3& n, glm::vec3& t1, glm::vec3& t2)
+        {
+            const glm::vec3 up = (std::abs(n.z) < 0.9f) ? glm::vec3(0, 0, 1) : glm::vec3(1, 0, 0);
+            t1 = glm::normalize(glm::cross(up, n));
+            t2 = glm::cross(n, t1);
+        }
+
+    private:
+        std::mt19937 mRng;
+    };
+}
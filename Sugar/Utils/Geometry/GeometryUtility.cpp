@@ -28,13 +28,23 @@
 
 #include "GeometryUtility.h"
 #include "Utils/Geometry/Private/Geometry.h"
+#include "Graphics/Model/TangentSpace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <unordered_map>
 
 namespace DirectX
 {
 
 // Create a polygonal plane lay on X/Z plane
 static void ComputePolygonalPlane(VertexCollection& vertices,
-                                  IndexCollection& indices,
+                                  IndexCollection32& indices,
                                   const PolarCoordinateCollection& points,
                                   const glm::mat4& transform,
                                   bool rhcoords)
@@ -54,6 +64,9 @@ static void ComputePolygonalPlane(VertexCollection& vertices,
     // TODO: UV is not supported
     const XMFLOAT2 texCoordDX{0.0f, 0.0f};
 
+    vertices.reserve(points.size());
+    indices.reserve((points.size() - 2) * 3);
+
     for (const auto pt : points)
     {
         const float r = pt.x;
@@ -89,142 +102,406 @@ static void ComputePolygonalPlane(VertexCollection& vertices,
 }
 }
 
-static Model::SharedPtr CreateModel(DirectX::VertexCollection& vertices, DirectX::IndexCollection& indices)
+// Primitive vertex with the generated bitangent appended, matching the vertex layout in CreateModel()
+struct VertexPositionNormalTextureBitangent
+{
+    DirectX::VertexPositionNormalTexture vertex;
+    glm::vec3 bitangent;
+};
+
+// The primitives are generated with 32-bit indices so they can be uploaded as-is
+static Model::SharedPtr CreateModel(const DirectX::VertexCollection& vertices, const DirectX::IndexCollection32& indices)
 {
-    std::vector<uint32_t> u32indices;
-    std::transform(indices.begin(), indices.end(), std::back_inserter(u32indices), [](uint16_t v) -> uint32_t { return v; });
+    using Vertex = DirectX::VertexPositionNormalTexture;
+
+    // The generators don't output tangents, derive the bitangents from the texture coordinates
+    std::vector<VertexPositionNormalTextureBitangent> vertexData(vertices.size());
+    std::vector<glm::vec3> bitangents(vertices.size());
+    const uint8_t* pVertices = (const uint8_t*)vertices.data();
+    generateTangentSpace(indices.data(), uint32_t(indices.size()), uint32_t(vertices.size()),
+                         pVertices + offsetof(Vertex, position), sizeof(Vertex),
+                         pVertices + offsetof(Vertex, normal), sizeof(Vertex),
+                         pVertices + offsetof(Vertex, textureCoordinate), sizeof(Vertex),
+                         bitangents.data(), sizeof(glm::vec3));
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        vertexData[i].vertex = vertices[i];
+        vertexData[i].bitangent = bitangents[i];
+    }
 
     SimpleModelImporter::VertexFormat vertLayout;
     vertLayout.attribs.push_back({SimpleModelImporter::AttribType::Position, 3, AttribFormat::AttribFormat_F32});
     vertLayout.attribs.push_back({SimpleModelImporter::AttribType::Normal, 3, AttribFormat::AttribFormat_F32});
     vertLayout.attribs.push_back({SimpleModelImporter::AttribType::TexCoord, 2, AttribFormat::AttribFormat_F32});
+    vertLayout.attribs.push_back({SimpleModelImporter::AttribType::Bitangent, 3, AttribFormat::AttribFormat_F32});
     Model::SharedPtr pModel = SimpleModelImporter::create(vertLayout,
-                                                          uint32_t(sizeof(DirectX::VertexCollection::value_type) * vertices.size()),
-                                                          vertices.data(),
-                                                          uint32_t(sizeof(uint32_t) * u32indices.size()),
-                                                          u32indices.data(),
+                                                          uint32_t(sizeof(VertexPositionNormalTextureBitangent) * vertexData.size()),
+                                                          vertexData.data(),
+                                                          uint32_t(sizeof(uint32_t) * indices.size()),
+                                                          indices.data(),
                                                           nullptr);
     return pModel;
 }
 
+namespace
+{
+    enum class GeneratedPrimitive : uint32_t
+    {
+        Box,
+        Sphere,
+        GeoSphere,
+        Cylinder,
+        Cone,
+        Torus,
+        Tetrahedron,
+        Octahedron,
+        Dodecahedron,
+        Icosahedron,
+        Teapot,
+        PolygonalPlane,
+    };
+
+    // Primitive type followed by the generator parameters, packed into a byte string which is used as the cache key
+    class GeneratedMeshKey
+    {
+    public:
+        explicit GeneratedMeshKey(GeneratedPrimitive type)
+        {
+            append(&type, sizeof(type));
+        }
+
+        GeneratedMeshKey& add(float value)
+        {
+            // -0 and +0 generate the same geometry, and all NaNs are folded into one
+            if (value == 0.0f) value = 0.0f;
+            if (std::isnan(value)) value = std::numeric_limits<float>::quiet_NaN();
+            append(&value, sizeof(value));
+            return *this;
+        }
+
+        GeneratedMeshKey& add(size_t value)
+        {
+            uint64_t v = value;
+            append(&v, sizeof(v));
+            return *this;
+        }
+
+        GeneratedMeshKey& add(bool value)
+        {
+            uint8_t v = value ? 1 : 0;
+            append(&v, sizeof(v));
+            return *this;
+        }
+
+        GeneratedMeshKey& add(const glm::vec3& v) { return add(v.x).add(v.y).add(v.z); }
+        GeneratedMeshKey& add(const glm::vec2& v) { return add(v.x).add(v.y); }
+
+        const std::string& str() const { return mData; }
+
+    private:
+        void append(const void* pData, size_t size) { mData.append(reinterpret_cast<const char*>(pData), size); }
+
+        std::string mData;
+    };
+
+    // Process-wide LRU cache of generated meshes. The cached mesh is never handed out, it only owns the GPU buffers which are shared by the meshes created from it
+    class GeneratedMeshCache
+    {
+    public:
+        static const size_t kDefaultCapacity = 64;
+
+        static GeneratedMeshCache& instance()
+        {
+            static GeneratedMeshCache sCache;
+            return sCache;
+        }
+
+        Mesh::SharedPtr find(const std::string& key)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto it = mLookup.find(key);
+            if (it == mLookup.end())
+            {
+                return nullptr;
+            }
+
+            // Move to the front of the list, the back holds the least recently used entry
+            mEntries.splice(mEntries.begin(), mEntries, it->second);
+            return it->second->second;
+        }
+
+        // Returns the mesh which ended up in the cache. If another thread inserted the same key first, its mesh wins
+        Mesh::SharedPtr insert(const std::string& key, const Mesh::SharedPtr& pMesh)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto it = mLookup.find(key);
+            if (it != mLookup.end())
+            {
+                mEntries.splice(mEntries.begin(), mEntries, it->second);
+                return it->second->second;
+            }
+
+            mEntries.emplace_front(key, pMesh);
+            mLookup[key] = mEntries.begin();
+            evict();
+            return pMesh;
+        }
+
+        void setCapacity(size_t capacity)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mCapacity = capacity;
+            evict();
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mLookup.clear();
+            mEntries.clear();
+        }
+
+    private:
+        // Models created from an evicted entry keep their own references to the buffers, so dropping it here is always safe
+        void evict()
+        {
+            while (mEntries.size() > mCapacity)
+            {
+                mLookup.erase(mEntries.back().first);
+                mEntries.pop_back();
+            }
+        }
+
+        using EntryList = std::list<std::pair<std::string, Mesh::SharedPtr>>;
+        EntryList mEntries;
+        std::unordered_map<std::string, EntryList::iterator> mLookup;
+        size_t mCapacity = kDefaultCapacity;
+        std::mutex mMutex;
+    };
+}
+
+// Create a model whose mesh references the buffers of the shared mesh. Each model gets its own mesh and material, so callers can change the material without affecting other models
+static Model::SharedPtr CreateModelFromSharedMesh(const Mesh::SharedPtr& pSharedMesh)
+{
+    const Vao::SharedPtr& pVao = pSharedMesh->getVao();
+    Vao::BufferVec vertexBuffers;
+    for (uint32_t i = 0; i < pVao->getVertexBuffersCount(); ++i)
+    {
+        vertexBuffers.push_back(pVao->getVertexBuffer(i));
+    }
+
+    BasicMaterial basicMat;
+    basicMat.diffuseColor = glm::vec3(1.0f);
+
+    Mesh::SharedPtr pMesh = Mesh::create(vertexBuffers,
+                                         pSharedMesh->getVertexCount(),
+                                         pVao->getIndexBuffer(),
+                                         pSharedMesh->getIndexCount(),
+                                         pVao->getVertexLayout(),
+                                         pVao->getPrimitiveTopology(),
+                                         basicMat.convertToMaterial(),
+                                         pSharedMesh->getBoundingBox(),
+                                         false);
+    return SimpleModelImporter::createFromMesh(pMesh);
+}
+
+template<typename GenerateFunc>
+static Model::SharedPtr CreateCachedModel(const GeneratedMeshKey& key, GenerateFunc generate)
+{
+    GeneratedMeshCache& cache = GeneratedMeshCache::instance();
+    Mesh::SharedPtr pSharedMesh = cache.find(key.str());
+    if (pSharedMesh == nullptr)
+    {
+        DirectX::VertexCollection vertices;
+        DirectX::IndexCollection32 indices;
+        generate(vertices, indices);
+
+        Model::SharedPtr pModel = CreateModel(vertices, indices);
+        pSharedMesh = cache.insert(key.str(), pModel->getMesh(0));
+    }
+
+    return CreateModelFromSharedMesh(pSharedMesh);
+}
+
 Model::SharedPtr CreateModelBox(const glm::vec3 & size, bool rhcoords, bool invertn)
 {
-    DirectX::VertexCollection vertices;
-    DirectX::IndexCollection indices;
-    DirectX::XMFLOAT3 boxSize{size.x, size.y, size.z};
-    DirectX::ComputeBox(vertices, indices, boxSize, rhcoords, invertn);
+    GeneratedMeshKey key(GeneratedPrimitive::Box);
+    key.add(size).add(rhcoords).add(invertn);
 
-    auto pModel = CreateModel(vertices, indices);
-    return pModel;
+    return CreateCachedModel(key, [&](DirectX::VertexCollection& vertices, DirectX::IndexCollection32& indices)
+    {
+        DirectX::XMFLOAT3 boxSize{size.x, size.y, size.z};
+        DirectX::ComputeBox(vertices, indices, boxSize, rhcoords, invertn);
+    });
 }
 
 Model::SharedPtr CreateModelSphere(float diameter, size_t tessellation, bool rhcoords, bool invertn)
 {
-    DirectX::VertexCollection vertices;
-    DirectX::IndexCollection indices;
-    DirectX::ComputeSphere(vertices, indices, diameter, tessellation, rhcoords, invertn);
+    GeneratedMeshKey key(GeneratedPrimitive::Sphere);
+    key.add(diameter).add(tessellation).add(rhcoords).add(invertn);
 
-    auto pModel = CreateModel(vertices, indices);
-    return pModel;
+    return CreateCachedModel(key, [&](DirectX::VertexCollection& vertices, DirectX::IndexCollection32& indices)
+    {
+        DirectX::ComputeSphere(vertices, indices, diameter, tessellation, rhcoords, invertn);
+    });
 }
 
 Model::SharedPtr CreateModelGeoSphere(float diameter, size_t tessellation, bool rhcoords)
 {
-    DirectX::VertexCollection vertices;
-    DirectX::IndexCollection indices;
-    DirectX::ComputeGeoSphere(vertices, indices, diameter, tessellation, rhcoords);
+    GeneratedMeshKey key(GeneratedPrimitive::GeoSphere);
+    key.add(diameter).add(tessellation).add(rhcoords);
 
-    auto pModel = CreateModel(vertices, indices);
-    return pModel;
+    return CreateCachedModel(key, [&](DirectX::VertexCollection& vertices, DirectX::IndexCollection32& indices)
+    {
+        DirectX::ComputeGeoSphere(vertices, indices, diameter, tessellation, rhcoords);
+    });
 }
 
 Model::SharedPtr CreateModelCylinder(float height, float diameter, size_t tessellation, bool rhcoords)
 {
-    DirectX::VertexCollection vertices;
-    DirectX::IndexCollection indices;
-    DirectX::ComputeCylinder(vertices, indices, height, diameter, tessellation, rhcoords);
+    GeneratedMeshKey key(GeneratedPrimitive::Cylinder);
+    key.add(height).add(diameter).add(tessellation).add(rhcoords);
 
-    auto pModel = CreateModel(vertices, indices);
-    return pModel;
+    return CreateCachedModel(key, [&](DirectX::VertexCollection& vertices, DirectX::IndexCollection32& indices)
+    {
+        DirectX::ComputeCylinder(vertices, indices, height, diameter, tessellation, rhcoords);
+    });
 }
 
 Model::SharedPtr CreateModelCone(float diameter, float height, size_t tessellation, bool rhcoords)
 {
-    DirectX::VertexCollection vertices;
-    DirectX::IndexCollection indices;
-    DirectX::ComputeCone(vertices, indices, diameter, height, tessellation, rhcoords);
+    GeneratedMeshKey key(GeneratedPrimitive::Cone);
+    key.add(diameter).add(height).add(tessellation).add(rhcoords);
 
-    auto pModel = CreateModel(vertices, indices);
-    return pModel;
+    return CreateCachedModel(key, [&](DirectX::VertexCollection& vertices, DirectX::IndexCollection32& indices)
+    {
+        DirectX::ComputeCone(vertices, indices, diameter, height, tessellation, rhcoords);
+    });
 }
 
 Model::SharedPtr CreateModelTorus(float diameter, float thickness, size_t tessellation, bool rhcoords)
 {
-    DirectX::VertexCollection vertices;
-    DirectX::IndexCollection indices;
-    DirectX::ComputeTorus(vertices, indices, diameter, thickness, tessellation, rhcoords);
+    GeneratedMeshKey key(GeneratedPrimitive::Torus);
+    key.add(diameter).add(thickness).add(tessellation).add(rhcoords);
 
-    auto pModel = CreateModel(vertices, indices);
-    return pModel;
+    return CreateCachedModel(key, [&](DirectX::VertexCollection& vertices, DirectX::IndexCollection32& indices)
+    {
+        DirectX::ComputeTorus(vertices, indices, diameter, thickness, tessellation, rhcoords);
+    });
 }
 
 Model::SharedPtr CreateModelTetrahedron(float size, bool rhcoords)
 {
-    DirectX::VertexCollection vertices;
-    DirectX::IndexCollection indices;
-    DirectX::ComputeTetrahedron(vertices, indices, size, rhcoords);
+    GeneratedMeshKey key(GeneratedPrimitive::Tetrahedron);
+    key.add(size).add(rhcoords);
 
-    auto pModel = CreateModel(vertices, indices);
-    return pModel;
+    return CreateCachedModel(key, [&](DirectX::VertexCollection& vertices, DirectX::IndexCollection32& indices)
+    {
+        DirectX::ComputeTetrahedron(vertices, indices, size, rhcoords);
+    });
 }
 
 Model::SharedPtr CreateModelOctahedron(float size, bool rhcoords)
 {
-    DirectX::VertexCollection vertices;
-    DirectX::IndexCollection indices;
-    DirectX::ComputeOctahedron(vertices, indices, size, rhcoords);
+    GeneratedMeshKey key(GeneratedPrimitive::Octahedron);
+    key.add(size).add(rhcoords);
 
-    auto pModel = CreateModel(vertices, indices);
-    return pModel;
+    return CreateCachedModel(key, [&](DirectX::VertexCollection& vertices, DirectX::IndexCollection32& indices)
+    {
+        DirectX::ComputeOctahedron(vertices, indices, size, rhcoords);
+    });
 }
 
 Model::SharedPtr CreateModelDodecahedron(float size, bool rhcoords)
 {
-    DirectX::VertexCollection vertices;
-    DirectX::IndexCollection indices;
-    DirectX::ComputeDodecahedron(vertices, indices, size, rhcoords);
+    GeneratedMeshKey key(GeneratedPrimitive::Dodecahedron);
+    key.add(size).add(rhcoords);
 
-    auto pModel = CreateModel(vertices, indices);
-    return pModel;
+    return CreateCachedModel(key, [&](DirectX::VertexCollection& vertices, DirectX::IndexCollection32& indices)
+    {
+        DirectX::ComputeDodecahedron(vertices, indices, size, rhcoords);
+    });
 }
 
 Model::SharedPtr CreateModelIcosahedron(float size, bool rhcoords)
 {
-    DirectX::VertexCollection vertices;
-    DirectX::IndexCollection indices;
-    DirectX::ComputeIcosahedron(vertices, indices, size, rhcoords);
+    GeneratedMeshKey key(GeneratedPrimitive::Icosahedron);
+    key.add(size).add(rhcoords);
 
-    auto pModel = CreateModel(vertices, indices);
-    return pModel;
+    return CreateCachedModel(key, [&](DirectX::VertexCollection& vertices, DirectX::IndexCollection32& indices)
+    {
+        DirectX::ComputeIcosahedron(vertices, indices, size, rhcoords);
+    });
 }
 
 Model::SharedPtr CreateModelTeapot(float size, size_t tessellation, bool rhcoords)
 {
-    DirectX::VertexCollection vertices;
-    DirectX::IndexCollection indices;
-    DirectX::ComputeTeapot(vertices, indices, size, tessellation, rhcoords);
+    GeneratedMeshKey key(GeneratedPrimitive::Teapot);
+    key.add(size).add(tessellation).add(rhcoords);
 
-    auto pModel = CreateModel(vertices, indices);
-    return pModel;
+    return CreateCachedModel(key, [&](DirectX::VertexCollection& vertices, DirectX::IndexCollection32& indices)
+    {
+        DirectX::ComputeTeapot(vertices, indices, size, tessellation, rhcoords);
+    });
 }
 
 Model::SharedPtr CreateModelPolygonalPlane(const PolarCoordinateCollection pts, const glm::mat4x4 transform, bool rhcoords)
 {
-    DirectX::VertexCollection vertices;
-    DirectX::IndexCollection indices;
-    DirectX::ComputePolygonalPlane(vertices, indices, pts, transform, rhcoords);
+    GeneratedMeshKey key(GeneratedPrimitive::PolygonalPlane);
+    key.add(pts.size());
+    for (const auto& pt : pts)
+    {
+        key.add(pt);
+    }
+    for (int col = 0; col < 4; ++col)
+    {
+        key.add(transform[col].x).add(transform[col].y).add(transform[col].z).add(transform[col].w);
+    }
+    key.add(rhcoords);
 
-    auto pModel = CreateModel(vertices, indices);
-    return pModel;
+    return CreateCachedModel(key, [&](DirectX::VertexCollection& vertices, DirectX::IndexCollection32& indices)
+    {
+        DirectX::ComputePolygonalPlane(vertices, indices, pts, transform, rhcoords);
+    });
+}
+
+void SetGeneratedMeshCacheCapacity(size_t capacity)
+{
+    GeneratedMeshCache::instance().setCapacity(capacity);
 }
 
+void ClearGeneratedMeshCache()
+{
+    GeneratedMeshCache::instance().clear();
+}
+
+float MeasureMeshOptimization(size_t tessellation, MeshOptimizer::Stats& before, MeshOptimizer::Stats& after)
+{
+    DirectX::VertexCollection vertices;
+    DirectX::IndexCollection32 indices;
+    DirectX::ComputeGeoSphere(vertices, indices, 1.0f, tessellation, true);
+
+    // Shuffle the triangles with a fixed seed, so runs are comparable
+    std::vector<uint32_t> triangles(indices.size() / 3);
+    std::iota(triangles.begin(), triangles.end(), 0);
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(1234));
+
+    std::vector<uint32_t> shuffled(indices.size());
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        for (size_t c = 0; c < 3; ++c)
+        {
+            shuffled[i * 3 + c] = indices[triangles[i] * 3 + c];
+        }
+    }
+
+    const uint32_t stride = sizeof(DirectX::VertexPositionNormalTexture);
+    std::vector<uint8_t> vertexData((const uint8_t*)vertices.data(), (const uint8_t*)vertices.data() + vertices.size() * stride);
+    uint32_t vertexCount = (uint32_t)vertices.size();
+
+    before = MeshOptimizer::Stats();
+    after = MeshOptimizer::Stats();
+    CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+    MeshOptimizer::optimize({ &shuffled }, { { &vertexData, stride } }, vertexCount, 0, &before, &after);
+    return CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+}
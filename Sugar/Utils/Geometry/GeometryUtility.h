@@ -45,4 +45,19 @@ Model::SharedPtr CreateModelOctahedron(float size, bool rhcoords = true);
 Model::SharedPtr CreateModelDodecahedron(float size, bool rhcoords = true);
 Model::SharedPtr CreateModelIcosahedron(float size, bool rhcoords = true);
 Model::SharedPtr CreateModelTeapot(float size, size_t tessellation = 32, bool rhcoords = true);
-Model::SharedPtr CreateModelPolygonalPlane(const PolarCoordinateCollection pts, const glm::mat4x4 transform, bool rhcoords = true);
\ No newline at end of file
+Model::SharedPtr CreateModelPolygonalPlane(const PolarCoordinateCollection pts, const glm::mat4x4 transform, bool rhcoords = true);
+
+/** The CreateModel* functions cache the generated geometry by shape and parameters. Models created with matching parameters share
+    one vertex and index buffer, but each model gets its own mesh and material so they can be modified independently.
+    Least recently used entries are evicted once the cache grows past its capacity.
+    The cache holds GPU buffers, call ClearGeneratedMeshCache() before the device is destroyed.
+*/
+void SetGeneratedMeshCacheCapacity(size_t capacity);
+void ClearGeneratedMeshCache();
+
+/** Micro-benchmark for the import-time mesh optimizer. A geodesic sphere has its triangles shuffled, like geometry written by an exporter which doesn't care about ordering, and is then optimized.
+    \param[out] before Vertex cache statistics of the shuffled mesh
+    \param[out] after Vertex cache statistics of the optimized mesh
+    \return Optimization time in milliseconds
+*/
+float MeasureMeshOptimization(size_t tessellation, MeshOptimizer::Stats& before, MeshOptimizer::Stats& after);
\ No newline at end of file
@@ -13,7 +13,8 @@
 
 #include "Geometry.h"
 #include "Bezier.h"
-#include <map>
+#include "Utils/ParallelFor.h"
+#include <limits>
 
 using namespace DirectX;
 
@@ -23,24 +24,27 @@ namespace
     const float SQRT3 = 1.73205080756887729352f;
     const float SQRT6 = 2.44948974278317809820f;
 
+    template<typename TIndex>
     inline void CheckIndexOverflow(size_t value)
     {
         // Use >=, not > comparison, because some D3D level 9_x hardware does not support 0xFFFF index values.
-        if (value >= USHRT_MAX)
+        if (value >= std::numeric_limits<TIndex>::max())
             throw std::exception("Index value out of range: cannot tesselate primitive so finely");
     }
 
 
     // Collection types used when generating the geometry.
-    inline void index_push_back(IndexCollection& indices, size_t value)
+    template<typename TIndex>
+    inline void index_push_back(std::vector<TIndex>& indices, size_t value)
     {
-        CheckIndexOverflow(value);
-        indices.push_back((uint16_t)value);
+        CheckIndexOverflow<TIndex>(value);
+        indices.push_back((TIndex)value);
     }
 
 
     // Helper for flipping winding of geometric primitives for LH vs. RH coords
-    inline void ReverseWinding(IndexCollection& indices, VertexCollection& vertices)
+    template<typename TIndex>
+    inline void ReverseWinding(std::vector<TIndex>& indices, VertexCollection& vertices)
     {
         assert((indices.size() % 3) == 0);
         for (auto it = indices.begin(); it != indices.end(); it += 3)
@@ -71,7 +75,8 @@ namespace
 //--------------------------------------------------------------------------------------
 // Cube (aka a Hexahedron) or Box
 //--------------------------------------------------------------------------------------
-void DirectX::ComputeBox(VertexCollection& vertices, IndexCollection& indices, const XMFLOAT3& size, bool rhcoords, bool invertn)
+template<typename TIndex>
+void DirectX::ComputeBox(VertexCollection& vertices, std::vector<TIndex>& indices, const XMFLOAT3& size, bool rhcoords, bool invertn)
 {
     vertices.clear();
     indices.clear();
@@ -79,6 +84,9 @@ void DirectX::ComputeBox(VertexCollection& vertices, IndexCollection& indices, c
     // A box has six faces, each one pointing in a different direction.
     const int FaceCount = 6;
 
+    vertices.reserve(FaceCount * 4);
+    indices.reserve(FaceCount * 6);
+
     static const XMVECTORF32 faceNormals[FaceCount] =
     {
         {  0,  0,  1 },
@@ -140,7 +148,8 @@ void DirectX::ComputeBox(VertexCollection& vertices, IndexCollection& indices, c
 //--------------------------------------------------------------------------------------
 // Sphere
 //--------------------------------------------------------------------------------------
-void DirectX::ComputeSphere(VertexCollection& vertices, IndexCollection& indices, float diameter, size_t tessellation, bool rhcoords, bool invertn)
+template<typename TIndex>
+void DirectX::ComputeSphere(VertexCollection& vertices, std::vector<TIndex>& indices, float diameter, size_t tessellation, bool rhcoords, bool invertn)
 {
     vertices.clear();
     indices.clear();
@@ -153,8 +162,18 @@ void DirectX::ComputeSphere(VertexCollection& vertices, IndexCollection& indices
 
     float radius = diameter / 2;
 
+    size_t stride = horizontalSegments + 1;
+
+    // Every ring and every band between two rings has a fixed size, so both collections are sized up front
+    // and each ring is generated independently.
+    const size_t vertexCount = (verticalSegments + 1) * stride;
+    CheckIndexOverflow<TIndex>(vertexCount - 1);
+
+    vertices.resize(vertexCount);
+    indices.resize(verticalSegments * stride * 6);
+
     // Create rings of vertices at progressively higher latitudes.
-    for (size_t i = 0; i <= verticalSegments; i++)
+    Falcor::parallelFor(0, verticalSegments + 1, [&](size_t i)
     {
         float v = 1 - (float)i / verticalSegments;
 
@@ -179,29 +198,29 @@ void DirectX::ComputeSphere(VertexCollection& vertices, IndexCollection& indices
             XMVECTOR normal = XMVectorSet(dx, dy, dz, 0);
             XMVECTOR textureCoordinate = XMVectorSet(u, v, 0, 0);
 
-            vertices.push_back(VertexPositionNormalTexture(normal * radius, normal, textureCoordinate));
+            vertices[i * stride + j] = VertexPositionNormalTexture(normal * radius, normal, textureCoordinate);
         }
-    }
+    });
 
     // Fill the index buffer with triangles joining each pair of latitude rings.
-    size_t stride = horizontalSegments + 1;
-
-    for (size_t i = 0; i < verticalSegments; i++)
+    Falcor::parallelFor(0, verticalSegments, [&](size_t i)
     {
+        TIndex* pIndex = &indices[i * stride * 6];
+
         for (size_t j = 0; j <= horizontalSegments; j++)
         {
             size_t nextI = i + 1;
             size_t nextJ = (j + 1) % stride;
 
-            index_push_back(indices, i * stride + j);
-            index_push_back(indices, nextI * stride + j);
-            index_push_back(indices, i * stride + nextJ);
+            *pIndex++ = (TIndex)(i * stride + j);
+            *pIndex++ = (TIndex)(nextI * stride + j);
+            *pIndex++ = (TIndex)(i * stride + nextJ);
 
-            index_push_back(indices, i * stride + nextJ);
-            index_push_back(indices, nextI * stride + j);
-            index_push_back(indices, nextI * stride + nextJ);
+            *pIndex++ = (TIndex)(i * stride + nextJ);
+            *pIndex++ = (TIndex)(nextI * stride + j);
+            *pIndex++ = (TIndex)(nextI * stride + nextJ);
         }
-    }
+    });
 
     // Build RH above
     if (!rhcoords)
@@ -215,27 +234,104 @@ void DirectX::ComputeSphere(VertexCollection& vertices, IndexCollection& indices
 //--------------------------------------------------------------------------------------
 // Geodesic sphere
 //--------------------------------------------------------------------------------------
-void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indices, float diameter, size_t tessellation, bool rhcoords)
+namespace
 {
-    vertices.clear();
-    indices.clear();
+    const uint64_t kEmptyEdgeKey = ~0ull;
+
+    // Open-addressing hash table mapping an undirected edge to the index of the vertex at its midpoint.
+    // Sized once for the number of edges of a subdivision level and probed linearly, so lookups never allocate.
+    template<typename TIndex>
+    class EdgeSubdivisionTable
+    {
+    public:
+        explicit EdgeSubdivisionTable(size_t edgeCount)
+        {
+            // Keep the load factor at or below 50%
+            size_t capacity = 16;
+            while (capacity < edgeCount * 2)
+                capacity *= 2;
+
+            mMask = capacity - 1;
+            mKeys.assign(capacity, kEmptyEdgeKey);
+            mValues.resize(capacity);
+        }
+
+        // Looks up the edge (a,b). Returns true if it was already present, otherwise inserts it.
+        // Either way, ppValue points to the value slot of the edge on return.
+        bool findOrInsert(TIndex a, TIndex b, TIndex** ppValue)
+        {
+            // Because the edge is undirected, (a,b) is the same as (b,a): the larger index always goes in the upper half.
+            const uint64_t key = (uint64_t(std::max(a, b)) << 32) | uint64_t(std::min(a, b));
+
+            for (size_t slot = hash(key) & mMask; ; slot = (slot + 1) & mMask)
+            {
+                if (mKeys[slot] == key)
+                {
+                    *ppValue = &mValues[slot];
+                    return true;
+                }
+
+                if (mKeys[slot] == kEmptyEdgeKey)
+                {
+                    mKeys[slot] = key;
+                    *ppValue = &mValues[slot];
+                    return false;
+                }
+            }
+        }
+
+    private:
+        static size_t hash(uint64_t key)
+        {
+            // 64-bit finalizer from MurmurHash3
+            key ^= key >> 33;
+            key *= 0xff51afd7ed558ccdull;
+            key ^= key >> 33;
+            key *= 0xc4ceb9fe1a85ec53ull;
+            key ^= key >> 33;
+            return (size_t)key;
+        }
+
+        std::vector<uint64_t> mKeys;
+        std::vector<TIndex> mValues;
+        size_t mMask = 0;
+    };
 
-    // An undirected edge between two vertices, represented by a pair of indexes into a vertex array.
-    // Becuse this edge is undirected, (a,b) is the same as (b,a).
-    typedef std::pair<uint16_t, uint16_t> UndirectedEdge;
 
-    // Makes an undirected edge. Rather than overloading comparison operators to give us the (a,b)==(b,a) property,
-    // we'll just ensure that the larger of the two goes first. This'll simplify things greatly.
-    auto makeUndirectedEdge = [](uint16_t a, uint16_t b)
+    // Vertex to triangle adjacency in compressed form. The triangles using vertex v are
+    // triangles[offsets[v]] .. triangles[offsets[v + 1] - 1], listed in index buffer order.
+    struct VertexTriangleAdjacency
     {
-        return std::make_pair(std::max(a, b), std::min(a, b));
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
     };
 
-    // Key: an edge
-    // Value: the index of the vertex which lies midway between the two vertices pointed to by the key value
-    // This map is used to avoid duplicating vertices when subdividing triangles along edges.
-    typedef std::map<UndirectedEdge, uint16_t> EdgeSubdivisionMap;
+    template<typename TIndex>
+    VertexTriangleAdjacency BuildVertexTriangleAdjacency(const std::vector<TIndex>& indices, size_t vertexCount)
+    {
+        VertexTriangleAdjacency adjacency;
+        adjacency.offsets.assign(vertexCount + 1, 0);
+        adjacency.triangles.resize(indices.size());
+
+        for (TIndex index : indices)
+            adjacency.offsets[index + 1]++;
 
+        for (size_t i = 0; i < vertexCount; ++i)
+            adjacency.offsets[i + 1] += adjacency.offsets[i];
+
+        std::vector<uint32_t> cursor(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i)
+            adjacency.triangles[cursor[indices[i]]++] = (uint32_t)(i / 3);
+
+        return adjacency;
+    }
+}
+
+template<typename TIndex>
+void DirectX::ComputeGeoSphere(VertexCollection& vertices, std::vector<TIndex>& indices, float diameter, size_t tessellation, bool rhcoords)
+{
+    vertices.clear();
+    indices.clear();
 
     static const XMFLOAT3 OctahedronVertices[] =
     {
@@ -261,27 +357,39 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
 
     const float radius = diameter / 2.0f;
 
+    // Every subdivision level quadruples the face count. Each level adds one vertex per edge and the octahedron
+    // starts with 12 edges, so after n levels there are 8 * 4^n faces and 4 * 4^n + 2 vertices.
+    size_t finalFaceCount = _countof(OctahedronIndices) / 3;
+    for (size_t iSubdivision = 0; iSubdivision < tessellation; ++iSubdivision)
+        finalFaceCount *= 4;
+    const size_t finalVertexCount = finalFaceCount / 2 + 2;
+
     // Start with an octahedron; copy the data into the vertex/index collection.
 
-    std::vector<XMFLOAT3> vertexPositions(std::begin(OctahedronVertices), std::end(OctahedronVertices));
+    std::vector<XMFLOAT3> vertexPositions;
+    vertexPositions.reserve(finalVertexCount);
+    vertexPositions.assign(std::begin(OctahedronVertices), std::end(OctahedronVertices));
 
+    indices.reserve(finalFaceCount * 3);
     indices.insert(indices.begin(), std::begin(OctahedronIndices), std::end(OctahedronIndices));
 
     // We know these values by looking at the above index list for the octahedron. Despite the subdivisions that are
     // about to go on, these values aren't ever going to change because the vertices don't move around in the array.
     // We'll need these values later on to fix the singularities that show up at the poles.
-    const uint16_t northPoleIndex = 0;
-    const uint16_t southPoleIndex = 5;
+    const TIndex northPoleIndex = 0;
+    const TIndex southPoleIndex = 5;
 
     for (size_t iSubdivision = 0; iSubdivision < tessellation; ++iSubdivision)
     {
         assert(indices.size() % 3 == 0); // sanity
 
         // We use this to keep track of which edges have already been subdivided.
-        EdgeSubdivisionMap subdividedEdges;
+        // On a closed triangle mesh every edge is shared by two faces, so there are 3/2 edges per face.
+        EdgeSubdivisionTable<TIndex> subdividedEdges(indices.size() / 2);
 
         // The new index collection after subdivision.
-        IndexCollection newIndices;
+        std::vector<TIndex> newIndices;
+        newIndices.reserve(indices.size() * 4);
 
         const size_t triangleCount = indices.size() / 3;
         for (size_t iTriangle = 0; iTriangle < triangleCount; ++iTriangle)
@@ -290,29 +398,27 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
             // The winding order of the triangles we output are the same as the winding order of the inputs.
 
             // Indices of the vertices making up this triangle
-            uint16_t iv0 = indices[iTriangle * 3 + 0];
-            uint16_t iv1 = indices[iTriangle * 3 + 1];
-            uint16_t iv2 = indices[iTriangle * 3 + 2];
+            TIndex iv0 = indices[iTriangle * 3 + 0];
+            TIndex iv1 = indices[iTriangle * 3 + 1];
+            TIndex iv2 = indices[iTriangle * 3 + 2];
 
             // Get the new vertices
             XMFLOAT3 v01; // vertex on the midpoint of v0 and v1
             XMFLOAT3 v12; // ditto v1 and v2
             XMFLOAT3 v20; // ditto v2 and v0
-            uint16_t iv01; // index of v01
-            uint16_t iv12; // index of v12
-            uint16_t iv20; // index of v20
+            TIndex iv01; // index of v01
+            TIndex iv12; // index of v12
+            TIndex iv20; // index of v20
 
             // Function that, when given the index of two vertices, creates a new vertex at the midpoint of those vertices.
-            auto divideEdge = [&](uint16_t i0, uint16_t i1, XMFLOAT3& outVertex, uint16_t& outIndex)
+            auto divideEdge = [&](TIndex i0, TIndex i1, XMFLOAT3& outVertex, TIndex& outIndex)
             {
-                const UndirectedEdge edge = makeUndirectedEdge(i0, i1);
-
                 // Check to see if we've already generated this vertex
-                auto it = subdividedEdges.find(edge);
-                if (it != subdividedEdges.end())
+                TIndex* pMidpointIndex;
+                if (subdividedEdges.findOrInsert(i0, i1, &pMidpointIndex))
                 {
                     // We've already generated this vertex before
-                    outIndex = it->second; // the index of this vertex
+                    outIndex = *pMidpointIndex; // the index of this vertex
                     outVertex = vertexPositions[outIndex]; // and the vertex itself
                 }
                 else
@@ -328,12 +434,12 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
                         )
                     );
 
-                    outIndex = static_cast<uint16_t>(vertexPositions.size());
-                    CheckIndexOverflow(outIndex);
+                    CheckIndexOverflow<TIndex>(vertexPositions.size());
+                    outIndex = static_cast<TIndex>(vertexPositions.size());
                     vertexPositions.push_back(outVertex);
 
-                    // Now add it to the map.
-                    subdividedEdges.insert(std::make_pair(edge, outIndex));
+                    // Now record it in the table.
+                    *pMidpointIndex = outIndex;
                 }
             };
 
@@ -350,7 +456,7 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
             //     /b\c/d\
             // v2 o---o---o v1
             //       v12
-            const uint16_t indicesToAdd[] =
+            const TIndex indicesToAdd[] =
             {
                  iv0, iv01, iv20, // a
                 iv20, iv12,  iv2, // b
@@ -396,7 +502,12 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
     // completed sphere. If you imagine the vertices along that edge, they circumscribe a semicircular arc starting at
     // y=1 and ending at y=-1, and sweeping across the range of z=0 to z=1. x stays zero. It's along this edge that we
     // need to duplicate our vertices - and provide the correct texture coordinates.
+    //
+    // Both this fixup and the pole fixup below only need the triangles around a single vertex, so build the
+    // vertex -> triangle adjacency once instead of rescanning the whole index list for every vertex.
     size_t preFixupVertexCount = vertices.size();
+    const VertexTriangleAdjacency adjacency = BuildVertexTriangleAdjacency(indices, preFixupVertexCount);
+
     for (size_t i = 0; i < preFixupVertexCount; ++i)
     {
         // This vertex is on the prime meridian if position.x and texcoord.u are both zero (allowing for small epsilon).
@@ -408,19 +519,21 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
         if (isOnPrimeMeridian)
         {
             size_t newIndex = vertices.size(); // the index of this vertex that we're about to add
-            CheckIndexOverflow(newIndex);
+            CheckIndexOverflow<TIndex>(newIndex);
 
             // copy this vertex, correct the texture coordinate, and add the vertex
             VertexPositionNormalTexture v = vertices[i];
             v.textureCoordinate.x = 1.0f;
             vertices.push_back(v);
 
-            // Now find all the triangles which contain this vertex and update them if necessary
-            for (size_t j = 0; j < indices.size(); j += 3)
+            // Now visit all the triangles which contain this vertex and update them if necessary
+            for (uint32_t k = adjacency.offsets[i]; k < adjacency.offsets[i + 1]; ++k)
             {
-                uint16_t* triIndex0 = &indices[j + 0];
-                uint16_t* triIndex1 = &indices[j + 1];
-                uint16_t* triIndex2 = &indices[j + 2];
+                const size_t j = adjacency.triangles[k] * 3;
+
+                TIndex* triIndex0 = &indices[j + 0];
+                TIndex* triIndex1 = &indices[j + 1];
+                TIndex* triIndex2 = &indices[j + 2];
 
                 if (*triIndex0 == i)
                 {
@@ -454,7 +567,7 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
                     abs(v0.textureCoordinate.x - v2.textureCoordinate.x) > 0.5f)
                 {
                     // yep; replace the specified index to point to the new, corrected vertex
-                    *triIndex0 = static_cast<uint16_t>(newIndex);
+                    *triIndex0 = static_cast<TIndex>(newIndex);
                 }
             }
         }
@@ -470,14 +583,19 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
         auto poleVertex = vertices[poleIndex];
         bool overwrittenPoleVertex = false; // overwriting the original pole vertex saves us one vertex
 
-        for (size_t i = 0; i < indices.size(); i += 3)
+        for (uint32_t k = adjacency.offsets[poleIndex]; k < adjacency.offsets[poleIndex + 1]; ++k)
         {
+            const size_t i = adjacency.triangles[k] * 3;
+
+            // The seam fixup may already have redirected this triangle to a duplicate of the pole; the
+            // checks below skip it in that case.
+
             // These pointers point to the three indices which make up this triangle. pPoleIndex is the pointer to the
             // entry in the index array which represents the pole index, and the other two pointers point to the other
             // two indices making up this triangle.
-            uint16_t* pPoleIndex;
-            uint16_t* pOtherIndex0;
-            uint16_t* pOtherIndex1;
+            TIndex* pPoleIndex;
+            TIndex* pOtherIndex0;
+            TIndex* pOtherIndex1;
             if (indices[i + 0] == poleIndex)
             {
                 pPoleIndex = &indices[i + 0];
@@ -516,9 +634,9 @@ void DirectX::ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indi
             }
             else
             {
-                CheckIndexOverflow(vertices.size());
+                CheckIndexOverflow<TIndex>(vertices.size());
 
-                *pPoleIndex = static_cast<uint16_t>(vertices.size());
+                *pPoleIndex = static_cast<TIndex>(vertices.size());
                 vertices.push_back(newPoleVertex);
             }
         }
@@ -563,7 +681,8 @@ namespace
 
 
     // Helper creates a triangle fan to close the end of a cylinder / cone
-    void CreateCylinderCap(VertexCollection& vertices, IndexCollection& indices, size_t tessellation, float height, float radius, bool isTop)
+    template<typename TIndex>
+    void CreateCylinderCap(VertexCollection& vertices, std::vector<TIndex>& indices, size_t tessellation, float height, float radius, bool isTop)
     {
         // Create cap indices.
         for (size_t i = 0; i < tessellation - 2; i++)
@@ -606,7 +725,8 @@ namespace
     }
 }
 
-void DirectX::ComputeCylinder(VertexCollection& vertices, IndexCollection& indices, float height, float diameter, size_t tessellation, bool rhcoords)
+template<typename TIndex>
+void DirectX::ComputeCylinder(VertexCollection& vertices, std::vector<TIndex>& indices, float height, float diameter, size_t tessellation, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
@@ -614,6 +734,10 @@ void DirectX::ComputeCylinder(VertexCollection& vertices, IndexCollection& indic
     if (tessellation < 3)
         throw std::out_of_range("tesselation parameter out of range");
 
+    // Side ring plus two caps.
+    vertices.reserve((tessellation + 1) * 2 + tessellation * 2);
+    indices.reserve((tessellation + 1) * 6 + (tessellation - 2) * 6);
+
     height /= 2;
 
     XMVECTOR topOffset = g_XMIdentityR1 * height;
@@ -655,7 +779,8 @@ void DirectX::ComputeCylinder(VertexCollection& vertices, IndexCollection& indic
 
 
 // Creates a cone primitive.
-void DirectX::ComputeCone(VertexCollection& vertices, IndexCollection& indices, float diameter, float height, size_t tessellation, bool rhcoords)
+template<typename TIndex>
+void DirectX::ComputeCone(VertexCollection& vertices, std::vector<TIndex>& indices, float diameter, float height, size_t tessellation, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
@@ -663,6 +788,10 @@ void DirectX::ComputeCone(VertexCollection& vertices, IndexCollection& indices,
     if (tessellation < 3)
         throw std::out_of_range("tesselation parameter out of range");
 
+    // Side ring plus the bottom cap.
+    vertices.reserve((tessellation + 1) * 2 + tessellation);
+    indices.reserve((tessellation + 1) * 3 + (tessellation - 2) * 3);
+
     height /= 2;
 
     XMVECTOR topOffset = g_XMIdentityR1 * height;
@@ -707,7 +836,8 @@ void DirectX::ComputeCone(VertexCollection& vertices, IndexCollection& indices,
 //--------------------------------------------------------------------------------------
 // Torus
 //--------------------------------------------------------------------------------------
-void DirectX::ComputeTorus(VertexCollection& vertices, IndexCollection& indices, float diameter, float thickness, size_t tessellation, bool rhcoords)
+template<typename TIndex>
+void DirectX::ComputeTorus(VertexCollection& vertices, std::vector<TIndex>& indices, float diameter, float thickness, size_t tessellation, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
@@ -717,8 +847,13 @@ void DirectX::ComputeTorus(VertexCollection& vertices, IndexCollection& indices,
 
     size_t stride = tessellation + 1;
 
-    // First we loop around the main ring of the torus.
-    for (size_t i = 0; i <= tessellation; i++)
+    CheckIndexOverflow<TIndex>(stride * stride - 1);
+
+    vertices.resize(stride * stride);
+    indices.resize(stride * stride * 6);
+
+    // First we loop around the main ring of the torus. Each slice owns a fixed range of vertices and indices.
+    Falcor::parallelFor(0, stride, [&](size_t i)
     {
         float u = (float)i / tessellation;
 
@@ -728,6 +863,8 @@ void DirectX::ComputeTorus(VertexCollection& vertices, IndexCollection& indices,
         // slice perpendicularly though the current ring position.
         XMMATRIX transform = XMMatrixTranslation(diameter / 2, 0, 0) * XMMatrixRotationY(outerAngle);
 
+        TIndex* pIndex = &indices[i * stride * 6];
+
         // Now we loop along the other axis, around the side of the tube.
         for (size_t j = 0; j <= tessellation; j++)
         {
@@ -746,21 +883,21 @@ void DirectX::ComputeTorus(VertexCollection& vertices, IndexCollection& indices,
             position = XMVector3Transform(position, transform);
             normal = XMVector3TransformNormal(normal, transform);
 
-            vertices.push_back(VertexPositionNormalTexture(position, normal, textureCoordinate));
+            vertices[i * stride + j] = VertexPositionNormalTexture(position, normal, textureCoordinate);
 
             // And create indices for two triangles.
             size_t nextI = (i + 1) % stride;
             size_t nextJ = (j + 1) % stride;
 
-            index_push_back(indices, i * stride + j);
-            index_push_back(indices, i * stride + nextJ);
-            index_push_back(indices, nextI * stride + j);
+            *pIndex++ = (TIndex)(i * stride + j);
+            *pIndex++ = (TIndex)(i * stride + nextJ);
+            *pIndex++ = (TIndex)(nextI * stride + j);
 
-            index_push_back(indices, i * stride + nextJ);
-            index_push_back(indices, nextI * stride + nextJ);
-            index_push_back(indices, nextI * stride + j);
+            *pIndex++ = (TIndex)(i * stride + nextJ);
+            *pIndex++ = (TIndex)(nextI * stride + nextJ);
+            *pIndex++ = (TIndex)(nextI * stride + j);
         }
-    }
+    });
 
     // Build RH above
     if (!rhcoords)
@@ -771,11 +908,15 @@ void DirectX::ComputeTorus(VertexCollection& vertices, IndexCollection& indices,
 //--------------------------------------------------------------------------------------
 // Tetrahedron
 //--------------------------------------------------------------------------------------
-void DirectX::ComputeTetrahedron(VertexCollection& vertices, IndexCollection& indices, float size, bool rhcoords)
+template<typename TIndex>
+void DirectX::ComputeTetrahedron(VertexCollection& vertices, std::vector<TIndex>& indices, float size, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
 
+    vertices.reserve(4 * 3);
+    indices.reserve(4 * 3);
+
     static const XMVECTORF32 verts[4] =
     {
         {            0.f,        0.f,      1.f },
@@ -830,11 +971,15 @@ void DirectX::ComputeTetrahedron(VertexCollection& vertices, IndexCollection& in
 //--------------------------------------------------------------------------------------
 // Octahedron
 //--------------------------------------------------------------------------------------
-void DirectX::ComputeOctahedron(VertexCollection& vertices, IndexCollection& indices, float size, bool rhcoords)
+template<typename TIndex>
+void DirectX::ComputeOctahedron(VertexCollection& vertices, std::vector<TIndex>& indices, float size, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
 
+    vertices.reserve(8 * 3);
+    indices.reserve(8 * 3);
+
     static const XMVECTORF32 verts[6] =
     {
         {  1,  0,  0 },
@@ -895,11 +1040,15 @@ void DirectX::ComputeOctahedron(VertexCollection& vertices, IndexCollection& ind
 //--------------------------------------------------------------------------------------
 // Dodecahedron
 //--------------------------------------------------------------------------------------
-void DirectX::ComputeDodecahedron(VertexCollection& vertices, IndexCollection& indices, float size, bool rhcoords)
+template<typename TIndex>
+void DirectX::ComputeDodecahedron(VertexCollection& vertices, std::vector<TIndex>& indices, float size, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
 
+    vertices.reserve(12 * 5);
+    indices.reserve(12 * 3 * 3);
+
     static const float a = 1.f / SQRT3;
     static const float b = 0.356822089773089931942f; // sqrt( ( 3 - sqrt(5) ) / 6 )
     static const float c = 0.934172358962715696451f; // sqrt( ( 3 + sqrt(5) ) / 6 );
@@ -1025,11 +1174,15 @@ void DirectX::ComputeDodecahedron(VertexCollection& vertices, IndexCollection& i
 //--------------------------------------------------------------------------------------
 // Icosahedron
 //--------------------------------------------------------------------------------------
-void DirectX::ComputeIcosahedron(VertexCollection& vertices, IndexCollection& indices, float size, bool rhcoords)
+template<typename TIndex>
+void DirectX::ComputeIcosahedron(VertexCollection& vertices, std::vector<TIndex>& indices, float size, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
 
+    vertices.reserve(20 * 3);
+    indices.reserve(20 * 3);
+
     static const float  t = 1.618033988749894848205f; // (1 + sqrt(5)) / 2
     static const float t2 = 1.519544995837552493271f; // sqrt( 1 + sqr( (1 + sqrt(5)) / 2 ) )
 
@@ -1117,8 +1270,10 @@ namespace
 {
 #include "TeapotData.inc"
 
-    // Tessellates the specified bezier patch.
-    void XM_CALLCONV TessellatePatch(VertexCollection& vertices, IndexCollection& indices, TeapotPatch const& patch, size_t tessellation, FXMVECTOR scale, bool isMirrored)
+    // Tessellates the specified bezier patch into preallocated vertex and index storage.
+    // A patch produces (tessellation + 1)^2 vertices and tessellation^2 * 6 indices.
+    template<typename TIndex>
+    void XM_CALLCONV TessellatePatch(VertexPositionNormalTexture* pVertices, TIndex* pIndices, size_t vbase, TeapotPatch const& patch, size_t tessellation, FXMVECTOR scale, bool isMirrored)
     {
         // Look up the 16 control points for this patch.
         XMVECTOR controlPoints[16];
@@ -1129,23 +1284,32 @@ namespace
         }
 
         // Create the index data.
-        size_t vbase = vertices.size();
         Bezier::CreatePatchIndices(tessellation, isMirrored, [&](size_t index)
         {
-            index_push_back(indices, vbase + index);
+            *pIndices++ = (TIndex)(vbase + index);
         });
 
         // Create the vertex data.
         Bezier::CreatePatchVertices(controlPoints, tessellation, isMirrored, [&](FXMVECTOR position, FXMVECTOR normal, FXMVECTOR textureCoordinate)
         {
-            vertices.push_back(VertexPositionNormalTexture(position, normal, textureCoordinate));
+            *pVertices++ = VertexPositionNormalTexture(position, normal, textureCoordinate);
         });
     }
+
+
+    // One tessellated copy of a teapot patch.
+    struct TeapotPatchInstance
+    {
+        size_t patchIndex;
+        XMFLOAT3 scale;
+        bool isMirrored;
+    };
 }
 
         
 // Creates a teapot primitive.
-void DirectX::ComputeTeapot(VertexCollection& vertices, IndexCollection& indices, float size, size_t tessellation, bool rhcoords)
+template<typename TIndex>
+void DirectX::ComputeTeapot(VertexCollection& vertices, std::vector<TIndex>& indices, float size, size_t tessellation, bool rhcoords)
 {
     vertices.clear();
     indices.clear();
@@ -1153,32 +1317,74 @@ void DirectX::ComputeTeapot(VertexCollection& vertices, IndexCollection& indices
     if (tessellation < 1)
         throw std::out_of_range("tesselation parameter out of range");
 
-    XMVECTOR scaleVector = XMVectorReplicate(size);
+    const XMFLOAT3 scaleVector(size, size, size);
+    const XMFLOAT3 scaleNegateX(-size, size, size);
+    const XMFLOAT3 scaleNegateZ(size, size, -size);
+    const XMFLOAT3 scaleNegateXZ(-size, size, -size);
 
-    XMVECTOR scaleNegateX = scaleVector * g_XMNegateX;
-    XMVECTOR scaleNegateZ = scaleVector * g_XMNegateZ;
-    XMVECTOR scaleNegateXZ = scaleVector * g_XMNegateX * g_XMNegateZ;
+    std::vector<TeapotPatchInstance> patchInstances;
+    patchInstances.reserve(_countof(TeapotPatches) * 4);
 
-    for (int i = 0; i < sizeof(TeapotPatches) / sizeof(TeapotPatches[0]); i++)
+    for (size_t i = 0; i < _countof(TeapotPatches); i++)
     {
         TeapotPatch const& patch = TeapotPatches[i];
 
         // Because the teapot is symmetrical from left to right, we only store
         // data for one side, then tessellate each patch twice, mirroring in X.
-        TessellatePatch(vertices, indices, patch, tessellation, scaleVector, false);
-        TessellatePatch(vertices, indices, patch, tessellation, scaleNegateX, true);
+        patchInstances.push_back({ i, scaleVector, false });
+        patchInstances.push_back({ i, scaleNegateX, true });
 
         if (patch.mirrorZ)
         {
             // Some parts of the teapot (the body, lid, and rim, but not the
             // handle or spout) are also symmetrical from front to back, so
             // we tessellate them four times, mirroring in Z as well as X.
-            TessellatePatch(vertices, indices, patch, tessellation, scaleNegateZ, true);
-            TessellatePatch(vertices, indices, patch, tessellation, scaleNegateXZ, false);
+            patchInstances.push_back({ i, scaleNegateZ, true });
+            patchInstances.push_back({ i, scaleNegateXZ, false });
         }
     }
 
+    // Every patch has the same size, so each one writes into its own slice of the collections.
+    const size_t patchVertexCount = (tessellation + 1) * (tessellation + 1);
+    const size_t patchIndexCount = tessellation * tessellation * 6;
+
+    CheckIndexOverflow<TIndex>(patchInstances.size() * patchVertexCount - 1);
+
+    vertices.resize(patchInstances.size() * patchVertexCount);
+    indices.resize(patchInstances.size() * patchIndexCount);
+
+    Falcor::parallelFor(0, patchInstances.size(), [&](size_t i)
+    {
+        const TeapotPatchInstance& instance = patchInstances[i];
+        const size_t vbase = i * patchVertexCount;
+
+        TessellatePatch(&vertices[vbase], &indices[i * patchIndexCount], vbase, TeapotPatches[instance.patchIndex],
+                        tessellation, XMLoadFloat3(&instance.scale), instance.isMirrored);
+    });
+
     // Built RH above
     if (!rhcoords)
         ReverseWinding(indices, vertices);
-}
\ No newline at end of file
+}
+
+
+//--------------------------------------------------------------------------------------
+// Explicit instantiations for 16-bit and 32-bit index collections
+//--------------------------------------------------------------------------------------
+#define INSTANTIATE_GEOMETRY(TIndex) \
+    template void DirectX::ComputeBox<TIndex>(VertexCollection&, std::vector<TIndex>&, const XMFLOAT3&, bool, bool); \
+    template void DirectX::ComputeSphere<TIndex>(VertexCollection&, std::vector<TIndex>&, float, size_t, bool, bool); \
+    template void DirectX::ComputeGeoSphere<TIndex>(VertexCollection&, std::vector<TIndex>&, float, size_t, bool); \
+    template void DirectX::ComputeCylinder<TIndex>(VertexCollection&, std::vector<TIndex>&, float, float, size_t, bool); \
+    template void DirectX::ComputeCone<TIndex>(VertexCollection&, std::vector<TIndex>&, float, float, size_t, bool); \
+    template void DirectX::ComputeTorus<TIndex>(VertexCollection&, std::vector<TIndex>&, float, float, size_t, bool); \
+    template void DirectX::ComputeTetrahedron<TIndex>(VertexCollection&, std::vector<TIndex>&, float, bool); \
+    template void DirectX::ComputeOctahedron<TIndex>(VertexCollection&, std::vector<TIndex>&, float, bool); \
+    template void DirectX::ComputeDodecahedron<TIndex>(VertexCollection&, std::vector<TIndex>&, float, bool); \
+    template void DirectX::ComputeIcosahedron<TIndex>(VertexCollection&, std::vector<TIndex>&, float, bool); \
+    template void DirectX::ComputeTeapot<TIndex>(VertexCollection&, std::vector<TIndex>&, float, size_t, bool);
+
+INSTANTIATE_GEOMETRY(uint16_t)
+INSTANTIATE_GEOMETRY(uint32_t)
+
+#undef INSTANTIATE_GEOMETRY
@@ -41,16 +41,19 @@ namespace DirectX
 
     typedef std::vector<DirectX::VertexPositionNormalTexture> VertexCollection;
     typedef std::vector<uint16_t> IndexCollection;
+    typedef std::vector<uint32_t> IndexCollection32;
 
-    void ComputeBox(VertexCollection& vertices, IndexCollection& indices, const XMFLOAT3& size, bool rhcoords, bool invertn);
-    void ComputeSphere(VertexCollection& vertices, IndexCollection& indices, float diameter, size_t tessellation, bool rhcoords, bool invertn);
-    void ComputeGeoSphere(VertexCollection& vertices, IndexCollection& indices, float diameter, size_t tessellation, bool rhcoords);
-    void ComputeCylinder(VertexCollection& vertices, IndexCollection& indices, float height, float diameter, size_t tessellation, bool rhcoords);
-    void ComputeCone(VertexCollection& vertices, IndexCollection& indices, float diameter, float height, size_t tessellation, bool rhcoords);
-    void ComputeTorus(VertexCollection& vertices, IndexCollection& indices, float diameter, float thickness, size_t tessellation, bool rhcoords);
-    void ComputeTetrahedron(VertexCollection& vertices, IndexCollection& indices, float size, bool rhcoords);
-    void ComputeOctahedron(VertexCollection& vertices, IndexCollection& indices, float size, bool rhcoords);
-    void ComputeDodecahedron(VertexCollection& vertices, IndexCollection& indices, float size, bool rhcoords);
-    void ComputeIcosahedron(VertexCollection& vertices, IndexCollection& indices, float size, bool rhcoords);
-    void ComputeTeapot(VertexCollection& vertices, IndexCollection& indices, float size, size_t tessellation, bool rhcoords);
+    // All generators are templated on the index type and instantiated for uint16_t and uint32_t.
+    // The vertex and index collections are sized exactly once; the 16-bit variants throw if the primitive needs more than 65535 vertices.
+    template<typename TIndex> void ComputeBox(VertexCollection& vertices, std::vector<TIndex>& indices, const XMFLOAT3& size, bool rhcoords, bool invertn);
+    template<typename TIndex> void ComputeSphere(VertexCollection& vertices, std::vector<TIndex>& indices, float diameter, size_t tessellation, bool rhcoords, bool invertn);
+    template<typename TIndex> void ComputeGeoSphere(VertexCollection& vertices, std::vector<TIndex>& indices, float diameter, size_t tessellation, bool rhcoords);
+    template<typename TIndex> void ComputeCylinder(VertexCollection& vertices, std::vector<TIndex>& indices, float height, float diameter, size_t tessellation, bool rhcoords);
+    template<typename TIndex> void ComputeCone(VertexCollection& vertices, std::vector<TIndex>& indices, float diameter, float height, size_t tessellation, bool rhcoords);
+    template<typename TIndex> void ComputeTorus(VertexCollection& vertices, std::vector<TIndex>& indices, float diameter, float thickness, size_t tessellation, bool rhcoords);
+    template<typename TIndex> void ComputeTetrahedron(VertexCollection& vertices, std::vector<TIndex>& indices, float size, bool rhcoords);
+    template<typename TIndex> void ComputeOctahedron(VertexCollection& vertices, std::vector<TIndex>& indices, float size, bool rhcoords);
+    template<typename TIndex> void ComputeDodecahedron(VertexCollection& vertices, std::vector<TIndex>& indices, float size, bool rhcoords);
+    template<typename TIndex> void ComputeIcosahedron(VertexCollection& vertices, std::vector<TIndex>& indices, float size, bool rhcoords);
+    template<typename TIndex> void ComputeTeapot(VertexCollection& vertices, std::vector<TIndex>& indices, float size, size_t tessellation, bool rhcoords);
 }
\ No newline at end of file
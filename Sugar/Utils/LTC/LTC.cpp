@@ -0,0 +1,326 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "LTC.h"
+#include "glm/gtc/packing.hpp"
+
+namespace Falcor
+{
+    namespace Ltc
+    {
+        uint32_t clipQuadToHorizon(glm::vec3 L[5])
+        {
+            // Detect clipping config
+            uint32_t config = 0;
+            if (L[0].z > 0.0f) config += 1;
+            if (L[1].z > 0.0f) config += 2;
+            if (L[2].z > 0.0f) config += 4;
+            if (L[3].z > 0.0f) config += 8;
+
+            uint32_t n = 0;
+
+            switch (config)
+            {
+            case 0: // clip all
+                break;
+            case 1: // V1 clip V2 V3 V4
+                n = 3;
+                L[1] = -L[1].z * L[0] + L[0].z * L[1];
+                L[2] = -L[3].z * L[0] + L[0].z * L[3];
+                break;
+            case 2: // V2 clip V1 V3 V4
+                n = 3;
+                L[0] = -L[0].z * L[1] + L[1].z * L[0];
+                L[2] = -L[2].z * L[1] + L[1].z * L[2];
+                break;
+            case 3: // V1 V2 clip V3 V4
+                n = 4;
+                L[2] = -L[2].z * L[1] + L[1].z * L[2];
+                L[3] = -L[3].z * L[0] + L[0].z * L[3];
+                break;
+            case 4: // V3 clip V1 V2 V4
+                n = 3;
+                L[0] = -L[3].z * L[2] + L[2].z * L[3];
+                L[1] = -L[1].z * L[2] + L[2].z * L[1];
+                break;
+            case 5: // V1 V3 clip V2 V4, impossible
+                n = 0;
+                break;
+            case 6: // V2 V3 clip V1 V4
+                n = 4;
+                L[0] = -L[0].z * L[1] + L[1].z * L[0];
+                L[3] = -L[3].z * L[2] + L[2].z * L[3];
+                break;
+            case 7: // V1 V2 V3 clip V4
+                n = 5;
+                L[4] = -L[3].z * L[0] + L[0].z * L[3];
+                L[3] = -L[3].z * L[2] + L[2].z * L[3];
+                break;
+            case 8: // V4 clip V1 V2 V3
+                n = 3;
+                L[0] = -L[0].z * L[3] + L[3].z * L[0];
+                L[1] = -L[2].z * L[3] + L[3].z * L[2];
+                L[2] = L[3];
+                break;
+            case 9: // V1 V4 clip V2 V3
+                n = 4;
+                L[1] = -L[1].z * L[0] + L[0].z * L[1];
+                L[2] = -L[2].z * L[3] + L[3].z * L[2];
+                break;
+            case 10: // V2 V4 clip V1 V3, impossible
+                n = 0;
+                break;
+            case 11: // V1 V2 V4 clip V3
+                n = 5;
+                L[4] = L[3];
+                L[3] = -L[2].z * L[3] + L[3].z * L[2];
+                L[2] = -L[2].z * L[1] + L[1].z * L[2];
+                break;
+            case 12: // V3 V4 clip V1 V2
+                n = 4;
+                L[1] = -L[1].z * L[2] + L[2].z * L[1];
+                L[0] = -L[0].z * L[3] + L[3].z * L[0];
+                break;
+            case 13: // V1 V3 V4 clip V2
+                n = 5;
+                L[4] = L[3];
+                L[3] = L[2];
+                L[2] = -L[1].z * L[2] + L[2].z * L[1];
+                L[1] = -L[1].z * L[0] + L[0].z * L[1];
+                break;
+            case 14: // V2 V3 V4 clip V1
+                n = 5;
+                L[4] = -L[0].z * L[3] + L[3].z * L[0];
+                L[0] = -L[0].z * L[1] + L[1].z * L[0];
+                break;
+            case 15: // V1 V2 V3 V4
+                n = 4;
+                break;
+            }
+
+            if (n == 3)
+            {
+                L[3] = L[0];
+            }
+            if (n == 4)
+            {
+                L[4] = L[0];
+            }
+            return n;
+        }
+
+        float integrateEdge(const glm::vec3& v1, const glm::vec3& v2)
+        {
+            const float cosTheta = glm::clamp(glm::dot(v1, v2), -0.9999f, 0.9999f);
+            const float theta = std::acos(cosTheta);
+            // For theta <= 0.001 `theta/sin(theta)` is approximated as 1.0
+            return glm::cross(v1, v2).z * ((theta > 0.001f) ? theta / std::sin(theta) : 1.0f);
+        }
+
+        float evaluate(const glm::vec3& N, const glm::vec3& V, const glm::vec3& P, const InverseMatrix& invM, const glm::vec3 points[4], bool twoSided)
+        {
+            // Construct orthonormal basis around N
+            const glm::vec3 T1 = glm::normalize(V - N * glm::dot(N, V));
+            const glm::vec3 T2 = glm::normalize(glm::cross(N, T1));
+
+            // Rotate the area light into the local basis, then into the cosine distribution's frame
+            glm::vec3 L[5];
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                const glm::vec3 d = points[i] - P;
+                L[i] = invM.transform(glm::vec3(glm::dot(d, T1), glm::dot(d, T2), glm::dot(d, N)));
+            }
+            L[4] = glm::vec3(0.0f);
+
+            // Clip the quad so that the part behind the surface doesn't affect the lighting of the point
+            const uint32_t n = clipQuadToHorizon(L);
+            if (n == 0)
+            {
+                return 0.0f;
+            }
+
+            // Project onto the sphere
+            for (uint32_t i = 0; i < n; ++i)
+            {
+                L[i] = glm::normalize(L[i]);
+            }
+            if (n < 5)
+            {
+                L[n] = L[0];
+            }
+
+            // Integrate over the clamped cosine distribution in the domain of the transformed light polygon
+            float sum = integrateEdge(L[0], L[1]) + integrateEdge(L[1], L[2]) + integrateEdge(L[2], L[3]);
+            if (n >= 4)
+            {
+                sum += integrateEdge(L[3], L[4]);
+            }
+            if (n == 5)
+            {
+                sum += integrateEdge(L[4], L[0]);
+            }
+
+            // Negated due to winding order
+            sum = twoSided ? std::abs(sum) : std::max(0.0f, -sum);
+            return sum / (2.0f * glm::pi<float>());
+        }
+
+        void PointBatch::resize(size_t count)
+        {
+            for (auto* pArray : { &normalX, &normalY, &normalZ, &viewX, &viewY, &viewZ, &posX, &posY, &posZ, &matA, &matB, &matC, &matD })
+            {
+                pArray->resize(count);
+            }
+        }
+
+        void PointBatch::setPoint(size_t index, const glm::vec3& N, const glm::vec3& V, const glm::vec3& P, const InverseMatrix& invM)
+        {
+            normalX[index] = N.x;
+            normalY[index] = N.y;
+            normalZ[index] = N.z;
+            viewX[index] = V.x;
+            viewY[index] = V.y;
+            viewZ[index] = V.z;
+            posX[index] = P.x;
+            posY[index] = P.y;
+            posZ[index] = P.z;
+            matA[index] = invM.a;
+            matB[index] = invM.b;
+            matC[index] = invM.c;
+            matD[index] = invM.d;
+        }
+
+        namespace
+        {
+            // Convert a readback of a float texture to 4 channels per texel
+            bool readTexels(const Texture* pTexture, std::vector<glm::vec4>& texels)
+            {
+                const ResourceFormat format = pTexture->getFormat();
+                const uint32_t channelCount = getFormatChannelCount(format);
+                const uint32_t bytesPerChannel = getFormatBytesPerBlock(format) / channelCount;
+                if (getFormatType(format) != FormatType::Float || (bytesPerChannel != 2 && bytesPerChannel != 4))
+                {
+                    logError("Ltc::Table: unsupported texture format " + to_string(format));
+                    return false;
+                }
+
+                const std::vector<uint8> data = gpDevice->getRenderContext()->readTextureSubresource(pTexture, 0);
+                const size_t texelCount = (size_t)pTexture->getWidth() * pTexture->getHeight();
+                texels.resize(texelCount);
+                for (size_t i = 0; i < texelCount; ++i)
+                {
+                    glm::vec4 t(0.0f);
+                    const uint8* pTexel = data.data() + i * channelCount * bytesPerChannel;
+                    for (uint32_t c = 0; c < channelCount; ++c)
+                    {
+                        t[c] = (bytesPerChannel == 4) ? ((const float*)pTexel)[c] : glm::unpackHalf1x16(((const uint16_t*)pTexel)[c]);
+                    }
+                    texels[i] = t;
+                }
+                return true;
+            }
+
+            template<typename T>
+            T sampleBilinear(const std::vector<T>& texels, uint32_t size, const glm::vec2& uv)
+            {
+                // Texel centers are at (i + 0.5) / size, clamp at the border
+                const glm::vec2 st = glm::clamp(uv * (float)size - 0.5f, glm::vec2(0.0f), glm::vec2((float)(size - 1)));
+                const uint32_t x0 = (uint32_t)st.x;
+                const uint32_t y0 = (uint32_t)st.y;
+                const uint32_t x1 = std::min(x0 + 1, size - 1);
+                const uint32_t y1 = std::min(y0 + 1, size - 1);
+                const glm::vec2 f = st - glm::vec2(x0, y0);
+
+                const T top = glm::mix(texels[y0 * size + x0], texels[y0 * size + x1], f.x);
+                const T bottom = glm::mix(texels[y1 * size + x0], texels[y1 * size + x1], f.x);
+                return glm::mix(top, bottom, f.y);
+            }
+        }
+
+        Table::SharedPtr Table::create(const Texture* pMatTexture, const Texture* pAmpTexture)
+        {
+            if (pMatTexture == nullptr || pAmpTexture == nullptr)
+            {
+                return nullptr;
+            }
+
+            const uint32_t size = pMatTexture->getWidth();
+            if (pMatTexture->getHeight() != size || pAmpTexture->getWidth() != size || pAmpTexture->getHeight() != size)
+            {
+                logError("Ltc::Table: the LTC tables must be square and of the same size");
+                return nullptr;
+            }
+
+            std::vector<glm::vec4> mat, amp;
+            if (readTexels(pMatTexture, mat) == false || readTexels(pAmpTexture, amp) == false)
+            {
+                return nullptr;
+            }
+
+            std::vector<glm::vec2> amp2(amp.size());
+            for (size_t i = 0; i < amp.size(); ++i)
+            {
+                amp2[i] = glm::vec2(amp[i]);
+            }
+            return create(size, std::move(mat), std::move(amp2));
+        }
+
+        Table::SharedPtr Table::create(uint32_t size, std::vector<glm::vec4> mat, std::vector<glm::vec2> amp)
+        {
+            if (size == 0 || mat.size() != (size_t)size * size || amp.size() != (size_t)size * size)
+            {
+                logError("Ltc::Table: texel count doesn't match the table size");
+                return nullptr;
+            }
+            return SharedPtr(new Table(size, std::move(mat), std::move(amp)));
+        }
+
+        glm::vec2 Table::getCoords(float roughness, const glm::vec3& N, const glm::vec3& V) const
+        {
+            const float lutSize = (float)mSize;
+            const float theta = std::acos(glm::dot(N, V));
+            const glm::vec2 uv(roughness, theta / (0.5f * glm::pi<float>()));
+            return uv * ((lutSize - 1.0f) / lutSize) + 0.5f / lutSize;
+        }
+
+        InverseMatrix Table::getMatrix(const glm::vec2& uv) const
+        {
+            const glm::vec4 t = sampleBilinear(mMat, mSize, uv);
+            InverseMatrix m;
+            m.a = t.x;
+            m.b = t.y;
+            m.c = t.z;
+            m.d = t.w;
+            return m;
+        }
+
+        glm::vec2 Table::getAmplitude(const glm::vec2& uv) const
+        {
+            return sampleBilinear(mAmp, mSize, uv);
+        }
+    }
+}
@@ -0,0 +1,169 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Falcor.h"
+#include "Testing/Validation.h"
+
+namespace Falcor
+{
+    /** CPU port of Data/LTC.slang.
+        The scalar functions follow the shader line by line, so they can serve as an oracle for the polygonal area lights.
+        evaluateBatch() computes the same integral for many shading points at once with SSE or AVX.
+    */
+    namespace Ltc
+    {
+        /** Inverse LTC matrix, as stored in ltc_mat.dds. With t the texel, the shader builds
+            | 1    0    t.y |
+            | 0    t.z  0   |
+            | t.w  0    t.x |
+            and transforms row vectors with it.
+        */
+        struct InverseMatrix
+        {
+            float a = 1;    ///< t.x
+            float b = 0;    ///< t.y
+            float c = 1;    ///< t.z
+            float d = 0;    ///< t.w
+
+            /** Transform a direction from the shading frame into the cosine distribution's frame
+            */
+            glm::vec3 transform(const glm::vec3& v) const { return glm::vec3(v.x + d * v.z, c * v.y, b * v.x + a * v.z); }
+        };
+
+        /** Clip a polygon in the shading frame to the upper hemisphere. Matches clipQuadToHorizon() in LTC.slang.
+            \param[in,out] L The quad in L[0..3]. Receives the clipped polygon, closed by repeating the first vertex.
+            \return The number of vertices of the clipped polygon, 0 if it is completely below the horizon
+        */
+        uint32_t clipQuadToHorizon(glm::vec3 L[5]);
+
+        /** Integrate a clamped cosine distribution over the spherical edge between two normalized directions
+        */
+        float integrateEdge(const glm::vec3& v1, const glm::vec3& v2);
+
+        /** Integrate the LTC distribution over a quad light. Matches ltcEvaluate() in LTC.slang.
+            \param[in] N Shading normal
+            \param[in] V Direction towards the viewer
+            \param[in] P Shading position
+            \param[in] invM Inverse LTC matrix
+            \param[in] points Quad vertices. A one-sided quad emits towards the side it appears counter-clockwise from.
+            \param[in] twoSided Whether the quad emits on both sides
+        */
+        float evaluate(const glm::vec3& N, const glm::vec3& V, const glm::vec3& P, const InverseMatrix& invM, const glm::vec3 points[4], bool twoSided);
+
+        /** Shading points in structure-of-arrays layout, so evaluateBatch() can load consecutive points into SIMD lanes
+        */
+        struct PointBatch
+        {
+            std::vector<float> normalX, normalY, normalZ;
+            std::vector<float> viewX, viewY, viewZ;
+            std::vector<float> posX, posY, posZ;
+            std::vector<float> matA, matB, matC, matD;
+
+            void resize(size_t count);
+            size_t getCount() const { return normalX.size(); }
+            void setPoint(size_t index, const glm::vec3& N, const glm::vec3& V, const glm::vec3& P, const InverseMatrix& invM);
+        };
+
+        /** Evaluate a batch of shading points against one quad light. Produces the same values as evaluate() up to float rounding.
+            \param[in] batch The shading points
+            \param[in] points Quad vertices
+            \param[in] twoSided Whether the quad emits on both sides
+            \param[out] pResults Receives one value per shading point
+        */
+        void evaluateBatch(const PointBatch& batch, const glm::vec3 points[4], bool twoSided, float* pResults);
+
+        /** Get the number of points evaluateBatch() processes per SIMD instruction, 8 when built with AVX, otherwise 4
+        */
+        uint32_t getBatchLaneCount();
+
+        /** CPU copy of the ltc_mat/ltc_amp lookup tables, sampled like the shader does
+        */
+        class Table
+        {
+        public:
+            using SharedPtr = std::shared_ptr<Table>;
+            using SharedConstPtr = std::shared_ptr<const Table>;
+
+            /** Create from the table textures. The data is read back from the GPU.
+                \return A new object, or nullptr if the textures have an unsupported format or don't match
+            */
+            static SharedPtr create(const Texture* pMatTexture, const Texture* pAmpTexture);
+
+            /** Create from texel data
+                \param[in] size Edge length of the square tables
+                \param[in] mat size*size inverse matrix texels, see InverseMatrix
+                \param[in] amp size*size amplitude texels, x is the BRDF norm and y its Fresnel weighted part
+            */
+            static SharedPtr create(uint32_t size, std::vector<glm::vec4> mat, std::vector<glm::vec2> amp);
+
+            /** Get the table coordinates for a roughness and view angle. Matches ltcCoords() in LTC.slang.
+            */
+            glm::vec2 getCoords(float roughness, const glm::vec3& N, const glm::vec3& V) const;
+
+            /** Bilinearly interpolate the inverse matrix
+            */
+            InverseMatrix getMatrix(const glm::vec2& uv) const;
+
+            /** Bilinearly interpolate the amplitude
+            */
+            glm::vec2 getAmplitude(const glm::vec2& uv) const;
+
+            uint32_t getSize() const { return mSize; }
+
+        private:
+            Table(uint32_t size, std::vector<glm::vec4> mat, std::vector<glm::vec2> amp) : mSize(size), mMat(std::move(mat)), mAmp(std::move(amp)) {}
+
+            uint32_t mSize;
+            std::vector<glm::vec4> mMat;
+            std::vector<glm::vec2> mAmp;
+        };
+
+        /** Results of validate()
+        */
+        struct ValidationReport : public Falcor::ValidationReport
+        {
+            // failedCount counts the cases where the batch or the Lambert integral disagree with their reference
+            float maxBatchError = 0;            ///< Largest difference between evaluateBatch() and evaluate()
+            float maxLambertError = 0;          ///< Largest difference between the LTC Lambert integral and Monte Carlo, in standard errors
+            float meanGgxRelativeError = 0;     ///< Mean relative difference between the fitted LTC and Monte Carlo integration of the GGX lobe
+            float maxGgxRelativeError = 0;
+            double scalarNsPerPoint = 0;        ///< Cost of evaluate()
+            double batchNsPerPoint = 0;         ///< Cost of evaluateBatch()
+        };
+
+        /** Test the CPU port against brute-force Monte Carlo integration over random quads and shading configurations.
+            The Lambert integral (identity matrix) has an exact reference and must agree within the Monte Carlo error, as must evaluate() and evaluateBatch().
+            If a table is provided, the fitted GGX lobe is compared to Monte Carlo integration of the GGX BRDF as well. This measures the fit, so it is only reported.
+            \param[in] pTable LTC tables, or nullptr to skip the GGX comparison
+            \param[in] caseCount Number of random configurations
+            \param[in] sampleCount Monte Carlo samples per configuration
+            \param[in] seed Random seed
+        */
+        ValidationReport validate(const Table* pTable, uint32_t caseCount = 256, uint32_t sampleCount = 1 << 16, uint32_t seed = 0);
+    }
+}
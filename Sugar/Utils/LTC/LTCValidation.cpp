@@ -0,0 +1,245 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "LTC.h"
+#include "Utils/ParallelFor.h"
+
+namespace Falcor
+{
+    namespace Ltc
+    {
+        namespace
+        {
+            // Shading points evaluated per case to compare evaluateBatch() with evaluate(). Not a multiple of the lane count, so the tail path is covered.
+            const uint32_t kBatchPointsPerCase = 37;
+            const uint32_t kBenchmarkPointCount = 1 << 16;
+
+            struct CaseResult
+            {
+                bool failed = false;
+                float batchError = 0;
+                float lambertError = 0;
+                bool hasGgx = false;
+                float ggxRelativeError = 0;
+            };
+
+            /** Integrate func(l) over the solid angle of a parallelogram by stratified uniform sampling of its area
+            */
+            template<typename Func>
+            void integrateOverQuad(const glm::vec3& P, const glm::vec3 points[4], uint32_t sampleCount, CaseGenerator& gen, Func func, double& mean, double& standardError)
+            {
+                const glm::vec3 e1 = points[1] - points[0];
+                const glm::vec3 e2 = points[3] - points[0];
+                glm::vec3 normal = glm::cross(e1, e2);
+                const float area = glm::length(normal);
+                normal /= area;
+
+                const uint32_t strata = std::max(1u, (uint32_t)std::sqrt((float)sampleCount));
+                double sum = 0;
+                double sumSquared = 0;
+                for (uint32_t sy = 0; sy < strata; ++sy)
+                {
+                    for (uint32_t sx = 0; sx < strata; ++sx)
+                    {
+                        const float u = (sx + gen.uniform(0.0f, 1.0f)) / strata;
+                        const float v = (sy + gen.uniform(0.0f, 1.0f)) / strata;
+                        const glm::vec3 d = points[0] + e1 * u + e2 * v - P;
+                        const float distSquared = glm::dot(d, d);
+                        const glm::vec3 l = d / std::sqrt(distSquared);
+                        const double value = func(l) * area * std::abs(glm::dot(normal, l)) / distSquared;
+                        sum += value;
+                        sumSquared += value * value;
+                    }
+                }
+
+                const double n = (double)strata * strata;
+                mean = sum / n;
+                // Ignores the stratification, so this overestimates the error
+                standardError = std::sqrt(std::max(0.0, sumSquared / n - mean * mean) / n);
+            }
+
+            // Isotropic GGX with height-correlated Smith masking, without Fresnel
+            float evalGgx(const glm::vec3& N, const glm::vec3& V, const glm::vec3& L, float alpha)
+            {
+                const float NoV = glm::dot(N, V);
+                const float NoL = glm::dot(N, L);
+                if (NoV <= 0.0f || NoL <= 0.0f)
+                {
+                    return 0.0f;
+                }
+
+                const glm::vec3 H = glm::normalize(V + L);
+                const float NoH = glm::dot(N, H);
+                const float a2 = alpha * alpha;
+                const float t = NoH * NoH * (a2 - 1.0f) + 1.0f;
+                const float D = a2 / (glm::pi<float>() * t * t);
+
+                auto lambda = [a2](float cosTheta)
+                {
+                    const float tan2 = std::max(0.0f, 1.0f - cosTheta * cosTheta) / (cosTheta * cosTheta);
+                    return 0.5f * (std::sqrt(1.0f + a2 * tan2) - 1.0f);
+                };
+                const float G2 = 1.0f / (1.0f + lambda(NoV) + lambda(NoL));
+                return D * G2 / (4.0f * NoV * NoL);
+            }
+
+            CaseResult runCase(const Table* pTable, uint32_t sampleCount, uint32_t seed)
+            {
+                CaseResult result;
+                CaseGenerator gen(seed);
+
+                const glm::vec3 P(gen.uniform(-1.0f, 1.0f), gen.uniform(-1.0f, 1.0f), gen.uniform(-1.0f, 1.0f));
+                const glm::vec3 N = gen.unitVector();
+                // V == N leaves the tangent undefined, the shader has the same singularity
+                const glm::vec3 V = gen.directionAround(N, 0.05f, 0.995f);
+
+                glm::vec3 points[4];
+                gen.quad(P, N, points);
+                const bool frontFacing = glm::dot(glm::cross(points[1] - points[0], points[3] - points[0]), P - points[0]) > 0.0f;
+
+                // The Lambert lobe is exactly the clamped cosine, so the LTC integral has to match up to the Monte Carlo error
+                const float ltcLambert = evaluate(N, V, P, InverseMatrix(), points, false);
+                double mcLambert = 0, mcLambertError = 0;
+                if (frontFacing)
+                {
+                    integrateOverQuad(P, points, sampleCount, gen, [&N](const glm::vec3& l) { return std::max(0.0f, glm::dot(N, l)) / glm::pi<float>(); }, mcLambert, mcLambertError);
+                }
+                const double lambertDiff = std::abs(ltcLambert - mcLambert);
+                result.lambertError = (float)(lambertDiff / std::max(mcLambertError, 1e-6));
+                result.failed |= lambertDiff > 4.0 * mcLambertError + 1e-4;
+
+                // The fitted GGX lobe only approximates the BRDF, so the difference is reported but not checked
+                if (pTable && frontFacing)
+                {
+                    const float roughness = gen.uniform(0.25f, 1.0f);
+                    const float alpha = roughness * roughness;
+                    const glm::vec2 uv = pTable->getCoords(roughness, N, V);
+                    const float ltcGgx = evaluate(N, V, P, pTable->getMatrix(uv), points, false) * pTable->getAmplitude(uv).x;
+
+                    double mcGgx = 0, mcGgxError = 0;
+                    integrateOverQuad(P, points, sampleCount, gen, [&](const glm::vec3& l) { return evalGgx(N, V, l, alpha) * std::max(0.0f, glm::dot(N, l)); }, mcGgx, mcGgxError);
+                    if (mcGgx > 1e-3)
+                    {
+                        result.hasGgx = true;
+                        result.ggxRelativeError = (float)(std::abs(ltcGgx - mcGgx) / mcGgx);
+                    }
+                }
+
+                // Random shading points and matrices against the same quad
+                PointBatch batch;
+                batch.resize(kBatchPointsPerCase);
+                std::vector<float> scalar(kBatchPointsPerCase);
+                for (uint32_t i = 0; i < kBatchPointsPerCase; ++i)
+                {
+                    const glm::vec3 n = gen.unitVector();
+                    const glm::vec3 v = gen.directionAround(n, 0.05f, 0.995f);
+                    const glm::vec3 p = P + glm::vec3(gen.uniform(-0.5f, 0.5f), gen.uniform(-0.5f, 0.5f), gen.uniform(-0.5f, 0.5f));
+                    InverseMatrix m;
+                    m.a = gen.uniform(0.1f, 2.0f);
+                    m.b = gen.uniform(-1.0f, 1.0f);
+                    m.c = gen.uniform(0.1f, 2.0f);
+                    m.d = gen.uniform(-1.0f, 1.0f);
+                    batch.setPoint(i, n, v, p, m);
+                    scalar[i] = evaluate(n, v, p, m, points, i % 2 == 0);
+                }
+
+                // evaluateBatch() takes one sidedness per call, so evaluate odd and even points separately
+                std::vector<float> batched[2];
+                for (uint32_t twoSided = 0; twoSided < 2; ++twoSided)
+                {
+                    batched[twoSided].resize(kBatchPointsPerCase);
+                    evaluateBatch(batch, points, twoSided != 0, batched[twoSided].data());
+                }
+                for (uint32_t i = 0; i < kBatchPointsPerCase; ++i)
+                {
+                    const float diff = std::abs(batched[(i % 2 == 0) ? 1 : 0][i] - scalar[i]);
+                    result.batchError = std::max(result.batchError, diff);
+                    result.failed |= !(diff <= 1e-4f + 1e-3f * std::abs(scalar[i]));
+                }
+                return result;
+            }
+        }
+
+        ValidationReport validate(const Table* pTable, uint32_t caseCount, uint32_t sampleCount, uint32_t seed)
+        {
+            std::vector<CaseResult> results(caseCount);
+            parallelFor(0, caseCount, [&](size_t i)
+            {
+                results[i] = runCase(pTable, sampleCount, getCaseSeed(seed, (uint32_t)i));
+            });
+
+            ValidationReport report;
+            report.caseCount = caseCount;
+            uint32_t ggxCount = 0;
+            for (const auto& r : results)
+            {
+                report.failedCount += r.failed ? 1 : 0;
+                report.maxBatchError = std::max(report.maxBatchError, r.batchError);
+                report.maxLambertError = std::max(report.maxLambertError, r.lambertError);
+                if (r.hasGgx)
+                {
+                    ggxCount++;
+                    report.meanGgxRelativeError += r.ggxRelativeError;
+                    report.maxGgxRelativeError = std::max(report.maxGgxRelativeError, r.ggxRelativeError);
+                }
+            }
+            if (ggxCount > 0)
+            {
+                report.meanGgxRelativeError /= ggxCount;
+            }
+
+            // Throughput of both paths on one light
+            CaseGenerator gen(seed);
+            PointBatch batch;
+            batch.resize(kBenchmarkPointCount);
+            for (uint32_t i = 0; i < kBenchmarkPointCount; ++i)
+            {
+                const glm::vec3 n = gen.unitVector();
+                batch.setPoint(i, n, gen.directionAround(n, 0.05f, 0.995f), glm::vec3(gen.uniform(-1.0f, 1.0f), gen.uniform(-1.0f, 1.0f), gen.uniform(-1.0f, 1.0f)), InverseMatrix());
+            }
+            glm::vec3 points[4];
+            gen.quad(glm::vec3(0.0f), glm::vec3(0, 0, 1), points);
+
+            std::vector<float> values(kBenchmarkPointCount);
+            CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+            for (uint32_t i = 0; i < kBenchmarkPointCount; ++i)
+            {
+                const glm::vec3 n(batch.normalX[i], batch.normalY[i], batch.normalZ[i]);
+                const glm::vec3 v(batch.viewX[i], batch.viewY[i], batch.viewZ[i]);
+                const glm::vec3 p(batch.posX[i], batch.posY[i], batch.posZ[i]);
+                values[i] = evaluate(n, v, p, InverseMatrix(), points, false);
+            }
+            report.scalarNsPerPoint = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) * 1.0e6 / kBenchmarkPointCount;
+
+            start = CpuTimer::getCurrentTimePoint();
+            evaluateBatch(batch, points, false, values.data());
+            report.batchNsPerPoint = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) * 1.0e6 / kBenchmarkPointCount;
+
+            return report;
+        }
+    }
+}
@@ -0,0 +1,281 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Utils/LTC/LTC.h"
+#include <immintrin.h>
+
+namespace Falcor
+{
+    namespace Ltc
+    {
+        namespace
+        {
+            /** Thin wrappers around the SSE and AVX registers, so the kernel below is written once for both widths
+            */
+            struct Float4
+            {
+                static const uint32_t kWidth = 4;
+                __m128 v;
+
+                Float4() {}
+                Float4(__m128 x) : v(x) {}
+                Float4(float x) : v(_mm_set1_ps(x)) {}
+
+                static Float4 load(const float* p) { return _mm_loadu_ps(p); }
+                void store(float* p) const { _mm_storeu_ps(p, v); }
+            };
+
+            inline Float4 operator+(Float4 a, Float4 b) { return _mm_add_ps(a.v, b.v); }
+            inline Float4 operator-(Float4 a, Float4 b) { return _mm_sub_ps(a.v, b.v); }
+            inline Float4 operator*(Float4 a, Float4 b) { return _mm_mul_ps(a.v, b.v); }
+            inline Float4 operator/(Float4 a, Float4 b) { return _mm_div_ps(a.v, b.v); }
+            inline Float4 operator>(Float4 a, Float4 b) { return _mm_cmpgt_ps(a.v, b.v); }
+            inline Float4 operator<(Float4 a, Float4 b) { return _mm_cmplt_ps(a.v, b.v); }
+            inline Float4 operator&(Float4 a, Float4 b) { return _mm_and_ps(a.v, b.v); }
+            inline Float4 operator|(Float4 a, Float4 b) { return _mm_or_ps(a.v, b.v); }
+            inline Float4 andNot(Float4 mask, Float4 a) { return _mm_andnot_ps(mask.v, a.v); }
+            inline Float4 sqrt(Float4 a) { return _mm_sqrt_ps(a.v); }
+            inline Float4 min(Float4 a, Float4 b) { return _mm_min_ps(a.v, b.v); }
+            inline Float4 max(Float4 a, Float4 b) { return _mm_max_ps(a.v, b.v); }
+            inline Float4 abs(Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+
+#ifdef __AVX__
+            struct Float8
+            {
+                static const uint32_t kWidth = 8;
+                __m256 v;
+
+                Float8() {}
+                Float8(__m256 x) : v(x) {}
+                Float8(float x) : v(_mm256_set1_ps(x)) {}
+
+                static Float8 load(const float* p) { return _mm256_loadu_ps(p); }
+                void store(float* p) const { _mm256_storeu_ps(p, v); }
+            };
+
+            inline Float8 operator+(Float8 a, Float8 b) { return _mm256_add_ps(a.v, b.v); }
+            inline Float8 operator-(Float8 a, Float8 b) { return _mm256_sub_ps(a.v, b.v); }
+            inline Float8 operator*(Float8 a, Float8 b) { return _mm256_mul_ps(a.v, b.v); }
+            inline Float8 operator/(Float8 a, Float8 b) { return _mm256_div_ps(a.v, b.v); }
+            inline Float8 operator>(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+            inline Float8 operator<(Float8 a, Float8 b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+            inline Float8 operator&(Float8 a, Float8 b) { return _mm256_and_ps(a.v, b.v); }
+            inline Float8 operator|(Float8 a, Float8 b) { return _mm256_or_ps(a.v, b.v); }
+            inline Float8 andNot(Float8 mask, Float8 a) { return _mm256_andnot_ps(mask.v, a.v); }
+            inline Float8 sqrt(Float8 a) { return _mm256_sqrt_ps(a.v); }
+            inline Float8 min(Float8 a, Float8 b) { return _mm256_min_ps(a.v, b.v); }
+            inline Float8 max(Float8 a, Float8 b) { return _mm256_max_ps(a.v, b.v); }
+            inline Float8 abs(Float8 a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+
+            using FloatN = Float8;
+#else
+            using FloatN = Float4;
+#endif
+
+            // Masks are all bits set or cleared per lane
+            template<typename F>
+            inline F select(F mask, F a, F b) { return (mask & a) | andNot(mask, b); }
+
+            template<typename F>
+            struct Vec3
+            {
+                F x, y, z;
+            };
+
+            template<typename F>
+            inline Vec3<F> operator+(const Vec3<F>& a, const Vec3<F>& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+            template<typename F>
+            inline Vec3<F> operator-(const Vec3<F>& a, const Vec3<F>& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+            template<typename F>
+            inline Vec3<F> operator*(const Vec3<F>& a, F s) { return { a.x * s, a.y * s, a.z * s }; }
+            template<typename F>
+            inline F dot(const Vec3<F>& a, const Vec3<F>& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+            template<typename F>
+            inline Vec3<F> cross(const Vec3<F>& a, const Vec3<F>& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+            template<typename F>
+            inline Vec3<F> normalize(const Vec3<F>& a) { return a * (F(1.0f) / sqrt(dot(a, a))); }
+            template<typename F>
+            inline Vec3<F> select(F mask, const Vec3<F>& a, const Vec3<F>& b) { return { select(mask, a.x, b.x), select(mask, a.y, b.y), select(mask, a.z, b.z) }; }
+
+            // acos() from Abramowitz and Stegun 4.4.46, absolute error below 2e-8
+            template<typename F>
+            inline F acos(F x)
+            {
+                const F ax = abs(x);
+                F p = F(-0.0012624911f);
+                p = p * ax + F(0.0066700901f);
+                p = p * ax + F(-0.0170881256f);
+                p = p * ax + F(0.0308918810f);
+                p = p * ax + F(-0.0501743046f);
+                p = p * ax + F(0.0889789874f);
+                p = p * ax + F(-0.2145988016f);
+                p = p * ax + F(1.5707963050f);
+                const F r = sqrt(F(1.0f) - ax) * p;
+                return select(x < F(0.0f), F(glm::pi<float>()) - r, r);
+            }
+
+            // With the clamp below theta never gets under 0.001, so theta/sin(theta) is always evaluated and sin(acos(x)) = sqrt(1 - x^2)
+            template<typename F>
+            inline F integrateEdge(const Vec3<F>& v1, const Vec3<F>& v2)
+            {
+                const F cosTheta = min(max(dot(v1, v2), F(-0.9999f)), F(0.9999f));
+                const F theta = acos(cosTheta);
+                return cross(v1, v2).z * theta / sqrt(F(1.0f) - cosTheta * cosTheta);
+            }
+
+            /** ltcEvaluate() for F::kWidth shading points.
+                Instead of the per-configuration clipping table of clipQuadToHorizon(), every edge is clipped on its own and the horizon edge between the
+                exit and entry points closes the polygon. This traces the same clipped polygon, so the sums match.
+            */
+            template<typename F>
+            F evaluateLanes(const Vec3<F>& N, const Vec3<F>& V, const Vec3<F>& P, const F invM[4], const glm::vec3 points[4], bool twoSided)
+            {
+                const F& a = invM[0];
+                const F& b = invM[1];
+                const F& c = invM[2];
+                const F& d = invM[3];
+
+                // Construct orthonormal basis around N
+                const Vec3<F> T1 = normalize(V - N * dot(N, V));
+                const Vec3<F> T2 = normalize(cross(N, T1));
+
+                Vec3<F> L[4];
+                F above[4];
+                for (uint32_t i = 0; i < 4; ++i)
+                {
+                    const Vec3<F> p = { F(points[i].x), F(points[i].y), F(points[i].z) };
+                    const Vec3<F> dir = p - P;
+                    const F lx = dot(dir, T1);
+                    const F ly = dot(dir, T2);
+                    const F lz = dot(dir, N);
+                    L[i] = { lx + d * lz, c * ly, b * lx + a * lz };
+                    above[i] = L[i].z > F(0.0f);
+                }
+
+                F sum(0.0f);
+                Vec3<F> exitPoint = L[0];
+                Vec3<F> entryPoint = L[0];
+                F clipped(0.0f);
+                for (uint32_t i = 0; i < 4; ++i)
+                {
+                    const Vec3<F>& A = L[i];
+                    const Vec3<F>& B = L[(i + 1) % 4];
+                    const F aboveA = above[i];
+                    const F aboveB = above[(i + 1) % 4];
+
+                    // Intersection with the horizon, oriented so the normalized direction lies on the edge
+                    const Vec3<F> X = select(aboveA, B * A.z - A * B.z, A * B.z - B * A.z);
+                    const Vec3<F> start = select(aboveA, A, X);
+                    const Vec3<F> end = select(aboveB, B, X);
+                    sum = sum + ((aboveA | aboveB) & integrateEdge(normalize(start), normalize(end)));
+
+                    const F exits = andNot(aboveB, aboveA);
+                    const F enters = andNot(aboveA, aboveB);
+                    exitPoint = select(exits, X, exitPoint);
+                    entryPoint = select(enters, X, entryPoint);
+                    clipped = clipped | exits;
+                }
+                sum = sum + (clipped & integrateEdge(normalize(exitPoint), normalize(entryPoint)));
+
+                // Two opposite vertices above the horizon can't happen for a planar quad, the shader treats it as fully clipped
+                const F diagonal = andNot(above[1] | above[3], above[0] & above[2]) | andNot(above[0] | above[2], above[1] & above[3]);
+
+                // Negated due to winding order
+                sum = twoSided ? abs(sum) : max(F(0.0f), F(0.0f) - sum);
+                return andNot(diagonal, sum * F(1.0f / (2.0f * glm::pi<float>())));
+            }
+
+            template<typename F>
+            void evaluateBatchImpl(const PointBatch& batch, const glm::vec3 points[4], bool twoSided, float* pResults)
+            {
+                const size_t count = batch.getCount();
+                const float* arrays[] = { batch.normalX.data(), batch.normalY.data(), batch.normalZ.data(), batch.viewX.data(), batch.viewY.data(), batch.viewZ.data(),
+                                          batch.posX.data(), batch.posY.data(), batch.posZ.data(), batch.matA.data(), batch.matB.data(), batch.matC.data(), batch.matD.data() };
+                const uint32_t kArrayCount = arraysize(arrays);
+
+                auto evaluateAt = [&](const float* const* pArrays, size_t offset, float* pOut)
+                {
+                    F v[kArrayCount];
+                    for (uint32_t i = 0; i < kArrayCount; ++i)
+                    {
+                        v[i] = F::load(pArrays[i] + offset);
+                    }
+                    const Vec3<F> N = { v[0], v[1], v[2] };
+                    const Vec3<F> V = { v[3], v[4], v[5] };
+                    const Vec3<F> P = { v[6], v[7], v[8] };
+                    evaluateLanes(N, V, P, &v[9], points, twoSided).store(pOut);
+                };
+
+                size_t i = 0;
+                for (; i + F::kWidth <= count; i += F::kWidth)
+                {
+                    evaluateAt(arrays, i, pResults + i);
+                }
+
+                // Pad the remaining points with a valid configuration, so no lane divides by zero
+                if (i < count)
+                {
+                    float tail[kArrayCount][F::kWidth];
+                    const float* tailArrays[kArrayCount];
+                    for (uint32_t a = 0; a < kArrayCount; ++a)
+                    {
+                        for (uint32_t l = 0; l < F::kWidth; ++l)
+                        {
+                            tail[a][l] = (i + l < count) ? arrays[a][i + l] : 0.0f;
+                        }
+                        tailArrays[a] = tail[a];
+                    }
+                    for (size_t l = count - i; l < F::kWidth; ++l)
+                    {
+                        tail[2][l] = 1.0f;      // N = +z
+                        tail[3][l] = 1.0f;      // V = +x+z
+                        tail[5][l] = 1.0f;
+                        tail[9][l] = 1.0f;      // Identity matrix
+                        tail[11][l] = 1.0f;
+                    }
+
+                    float results[F::kWidth];
+                    evaluateAt(tailArrays, 0, results);
+                    for (size_t l = 0; l < count - i; ++l)
+                    {
+                        pResults[i + l] = results[l];
+                    }
+                }
+            }
+        }
+
+        void evaluateBatch(const PointBatch& batch, const glm::vec3 points[4], bool twoSided, float* pResults)
+        {
+            evaluateBatchImpl<FloatN>(batch, points, twoSided, pResults);
+        }
+
+        uint32_t getBatchLaneCount()
+        {
+            return FloatN::kWidth;
+        }
+    }
+}
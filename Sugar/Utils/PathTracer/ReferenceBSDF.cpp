@@ -0,0 +1,290 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Utils/PathTracer/ReferenceBSDF.h"
+
+namespace Falcor
+{
+    const uint32_t ReferenceBSDF::kMaxLayers;
+    const float ReferenceBSDF::kMinRoughness = 0.02f;
+
+    namespace
+    {
+        const float kPi = 3.14159265f;
+
+        bool isScatteringLayer(uint32_t type)
+        {
+            return type == MatLambert || type == MatConductor || type == MatDielectric;
+        }
+
+        float luminance(const glm::vec3& c)
+        {
+            return glm::dot(c, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+        }
+    }
+
+    void ReferenceBSDF::addLayer(const Layer& layer)
+    {
+        if (mLayerCount < kMaxLayers)
+        {
+            mLayers[mLayerCount++] = layer;
+        }
+    }
+
+    float ReferenceBSDF::evalNdf(uint32_t ndf, float cosThetaM, float roughness)
+    {
+        if (cosThetaM <= 0)
+        {
+            return 0;
+        }
+
+        const float a2 = roughness * roughness;
+        const float cos2 = cosThetaM * cosThetaM;
+        if (ndf == NDFBeckmann)
+        {
+            const float tan2 = (1.0f - cos2) / cos2;
+            return std::exp(-tan2 / a2) / (kPi * a2 * cos2 * cos2);
+        }
+
+        const float d = cos2 * (a2 - 1.0f) + 1.0f;
+        return a2 / (kPi * d * d);
+    }
+
+    float ReferenceBSDF::evalSmithG(uint32_t ndf, const glm::vec3& dir, const glm::vec3& m, float roughness)
+    {
+        if (glm::dot(dir, m) * dir.z <= 0)
+        {
+            return 0;
+        }
+        const float sinThSq = 1.0f - dir.z * dir.z;
+        if (sinThSq <= 0)
+        {
+            return 1;
+        }
+        const float recipSlope = std::sqrt(sinThSq) / dir.z;
+        if (ndf == NDFBeckmann)
+        {
+            // Beckmann G fit from [Walter07]
+            const float a = 1.0f / (roughness * recipSlope);
+            if (a > 1.6f)
+            {
+                return 1;
+            }
+            const float aSq = a * a;
+            return (3.535f * a + 2.181f * aSq) / (1.0f + 2.276f * a + 2.577f * aSq);
+        }
+
+        const float isectRoot = roughness * recipSlope;
+        return 2.0f / (1.0f + std::sqrt(1.0f + isectRoot * isectRoot));
+    }
+
+    float ReferenceBSDF::conductorFresnel(float cosThetaI, float IoR, float kappa)
+    {
+        // Same as conductorFresnel() in SugarBSDFs.slang, which is Mitsuba's fresnelConductorExact
+        const float eta = IoR;
+        const float k = kappa;
+        const float cosThetaI2 = cosThetaI * cosThetaI;
+        const float sinThetaI2 = 1 - cosThetaI2;
+        const float sinThetaI4 = sinThetaI2 * sinThetaI2;
+
+        const float temp1 = eta * eta - k * k - sinThetaI2;
+        const float a2pb2 = std::sqrt(temp1 * temp1 + k * k * eta * eta * 4);
+        const float a = std::sqrt((a2pb2 + temp1) * 0.5f);
+
+        const float term1 = a2pb2 + cosThetaI2;
+        const float term2 = a * (2 * cosThetaI);
+        const float Rs2 = (term1 - term2) / (term1 + term2);
+
+        const float term3 = a2pb2 * cosThetaI2 + sinThetaI4;
+        const float term4 = term2 * sinThetaI2;
+        const float Rp2 = Rs2 * (term3 - term4) / (term3 + term4);
+
+        return 0.5f * (Rp2 + Rs2);
+    }
+
+    float ReferenceBSDF::dielectricFresnel(float cosThetaI, float IoR)
+    {
+        const float realIoR = (cosThetaI >= 0) ? 1.0f / IoR : IoR;
+        const float cosThetaT2 = 1.0f - realIoR * realIoR * (1.0f - cosThetaI * cosThetaI);
+        if (cosThetaT2 <= 0)
+        {
+            // Total internal reflection
+            return 1;
+        }
+        const float cosThetaT = std::sqrt(cosThetaT2);
+        cosThetaI = std::abs(cosThetaI);
+
+        const float Rs = (cosThetaI - IoR * cosThetaT) / (cosThetaI + IoR * cosThetaT);
+        const float Rp = (IoR * cosThetaI - cosThetaT) / (IoR * cosThetaI + cosThetaT);
+        return (Rp * Rp + Rs * Rs) * 0.5f;
+    }
+
+    glm::vec3 ReferenceBSDF::eval(const glm::vec3& wo, const glm::vec3& wi) const
+    {
+        glm::vec3 result(0.0f);
+        for (uint32_t i = 0; i < mLayerCount; i++)
+        {
+            const Layer& layer = mLayers[i];
+            glm::vec3 value(0.0f);
+            float weight = 0;
+
+            switch (layer.type)
+            {
+            case MatLambert:
+                value = glm::vec3(std::max(0.0f, wi.z) / kPi);
+                weight = layer.albedo.w;
+                break;
+            case MatConductor:
+            case MatDielectric:
+                // Like evalSpecularLayer(), transmission and backfacing directions zero the layer and its weight
+                if (wo.z * wi.z > 0)
+                {
+                    const float roughness = std::max(layer.roughness, kMinRoughness);
+                    const glm::vec3 h = glm::normalize(wo + wi);
+                    const float D = evalNdf(layer.ndf, h.z, roughness);
+                    const float G = evalSmithG(layer.ndf, wo, h, roughness) * evalSmithG(layer.ndf, wi, h, roughness);
+                    const float HoE = glm::dot(h, wo);
+                    const float F = (layer.type == MatConductor) ? conductorFresnel(HoE, layer.IoR, layer.kappa) : dielectricFresnel(HoE, layer.IoR);
+                    value = glm::vec3(D * G * F / (4.0f * wo.z));
+                    weight = (1.0f - F) / (layer.IoR * layer.IoR);
+                }
+                break;
+            default:
+                continue;
+            }
+
+            // blendLayer()
+            const glm::vec3 scaledValue = value * glm::vec3(layer.albedo);
+            if (layer.blend == BlendConstant)
+            {
+                weight = layer.albedo.w;
+            }
+            result = (layer.blend != BlendAdd) ? scaledValue + result * weight : result + scaledValue;
+        }
+        return result;
+    }
+
+    void ReferenceBSDF::getLayerPmfs(float pmfs[kMaxLayers]) const
+    {
+        float total = 0;
+        for (uint32_t i = 0; i < mLayerCount; i++)
+        {
+            pmfs[i] = isScatteringLayer(mLayers[i].type) ? std::max(0.0f, luminance(glm::vec3(mLayers[i].albedo))) : 0.0f;
+            total += pmfs[i];
+        }
+        for (uint32_t i = 0; i < mLayerCount; i++)
+        {
+            pmfs[i] = (total > 0) ? pmfs[i] / total : 0.0f;
+        }
+    }
+
+    float ReferenceBSDF::evalLayerPdf(const Layer& layer, const glm::vec3& wo, const glm::vec3& wi) const
+    {
+        if (wi.z <= 0 || wo.z <= 0)
+        {
+            return 0;
+        }
+        if (layer.type == MatLambert)
+        {
+            return wi.z / kPi;
+        }
+
+        // Microfacet normals are drawn proportional to D(m) * cos(m), the Jacobian of the reflection turns it into a density of wi
+        const float roughness = std::max(layer.roughness, kMinRoughness);
+        const glm::vec3 h = glm::normalize(wo + wi);
+        return evalNdf(layer.ndf, h.z, roughness) * h.z / (4.0f * glm::dot(wi, h));
+    }
+
+    float ReferenceBSDF::evalPdf(const glm::vec3& wo, const glm::vec3& wi) const
+    {
+        float pmfs[kMaxLayers];
+        getLayerPmfs(pmfs);
+
+        float pdf = 0;
+        for (uint32_t i = 0; i < mLayerCount; i++)
+        {
+            if (pmfs[i] > 0)
+            {
+                pdf += pmfs[i] * evalLayerPdf(mLayers[i], wo, wi);
+            }
+        }
+        return pdf;
+    }
+
+    bool ReferenceBSDF::sample(const glm::vec3& wo, const glm::vec3& u, glm::vec3& wi, float& pdf) const
+    {
+        pdf = 0;
+        if (wo.z <= 0)
+        {
+            return false;
+        }
+
+        float pmfs[kMaxLayers];
+        getLayerPmfs(pmfs);
+
+        int32_t picked = -1;
+        float cdf = 0;
+        for (uint32_t i = 0; i < mLayerCount; i++)
+        {
+            if (pmfs[i] <= 0)
+            {
+                continue;
+            }
+            picked = (int32_t)i;
+            cdf += pmfs[i];
+            if (u.x < cdf)
+            {
+                break;
+            }
+        }
+        if (picked < 0)
+        {
+            return false;
+        }
+
+        const Layer& layer = mLayers[picked];
+        const float phi = 2.0f * kPi * u.z;
+        if (layer.type == MatLambert)
+        {
+            const float r = std::sqrt(u.y);
+            wi = glm::vec3(r * std::cos(phi), r * std::sin(phi), std::sqrt(std::max(0.0f, 1.0f - u.y)));
+        }
+        else
+        {
+            const float roughness = std::max(layer.roughness, kMinRoughness);
+            const float a2 = roughness * roughness;
+            const float tan2 = (layer.ndf == NDFBeckmann) ? -a2 * std::log(1.0f - u.y) : a2 * u.y / (1.0f - u.y);
+            const float cosThetaM = 1.0f / std::sqrt(1.0f + tan2);
+            const float sinThetaM = std::sqrt(std::max(0.0f, 1.0f - cosThetaM * cosThetaM));
+            const glm::vec3 m(sinThetaM * std::cos(phi), sinThetaM * std::sin(phi), cosThetaM);
+            wi = 2.0f * glm::dot(wo, m) * m - wo;
+        }
+
+        pdf = evalPdf(wo, wi);
+        return pdf > 0;
+    }
+}
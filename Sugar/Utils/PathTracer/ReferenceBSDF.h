@@ -0,0 +1,105 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Falcor.h"
+
+namespace Falcor
+{
+    /** CPU port of the layered material model in SugarShading.slang, used by ReferencePathTracer.
+        Layers are evaluated and blended exactly like evalMaterial() does for a single light, so the reference renders the material the raster path approximates.
+        Differences to the shader:
+        - Roughness is isotropic and taken from roughness.x, like the Mitsuba exporter does. Roughness filtering is not applied.
+        - Roughness is clamped to kMinRoughness instead of dropping near-perfect specular layers.
+        - Emissive layers don't take part in scattering.
+        All directions are in the local shading frame, with the normal along +z.
+    */
+    class ReferenceBSDF
+    {
+    public:
+        static const uint32_t kMaxLayers = MatMaxLayers;
+        static const float kMinRoughness;
+
+        /** A material layer with its texture already applied
+        */
+        struct Layer
+        {
+            uint32_t type = MatLambert;
+            uint32_t ndf = NDFGGX;
+            uint32_t blend = BlendFresnel;
+            glm::vec4 albedo;
+            float roughness = 0;
+            float IoR = 1.5f;
+            float kappa = 0;
+        };
+
+        /** Append a layer. Layers past kMaxLayers are ignored, like in the shader.
+        */
+        void addLayer(const Layer& layer);
+
+        uint32_t getLayerCount() const { return mLayerCount; }
+        const Layer& getLayer(uint32_t index) const { return mLayers[index]; }
+
+        /** Evaluate the blended layers for a pair of directions
+            \param[in] wo Direction towards the viewer
+            \param[in] wi Direction towards the light
+            \return BSDF value times the cosine of the incident direction
+        */
+        glm::vec3 eval(const glm::vec3& wo, const glm::vec3& wi) const;
+
+        /** Sample an incident direction. A layer is picked based on its albedo, then the direction is drawn from its lobe.
+            \param[in] wo Direction towards the viewer
+            \param[in] u Uniform random numbers in [0, 1), the first one picks the layer
+            \param[out] wi Sampled direction towards the light
+            \param[out] pdf Solid angle density of all layers combined
+            \return false if no direction was generated
+        */
+        bool sample(const glm::vec3& wo, const glm::vec3& u, glm::vec3& wi, float& pdf) const;
+
+        /** Get the solid angle density of sample() for a direction
+        */
+        float evalPdf(const glm::vec3& wo, const glm::vec3& wi) const;
+
+        /** Normal distribution functions, matching SugarBSDFs.slang for isotropic roughness
+        */
+        static float evalNdf(uint32_t ndf, float cosThetaM, float roughness);
+
+        /** Smith shadowing and masking for one direction, matching GSmith() in SugarBSDFs.slang
+        */
+        static float evalSmithG(uint32_t ndf, const glm::vec3& dir, const glm::vec3& m, float roughness);
+
+        static float conductorFresnel(float cosThetaI, float IoR, float kappa);
+        static float dielectricFresnel(float cosThetaI, float IoR);
+
+    private:
+        void getLayerPmfs(float pmfs[kMaxLayers]) const;
+        float evalLayerPdf(const Layer& layer, const glm::vec3& wo, const glm::vec3& wi) const;
+
+        Layer mLayers[kMaxLayers];
+        uint32_t mLayerCount = 0;
+    };
+}
@@ -0,0 +1,904 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Utils/PathTracer/ReferencePathTracer.h"
+#include "Graphics/Model/VertexPacking.h"
+#include "Utils/ParallelFor.h"
+#include "Utils/Bitmap.h"
+#include "API/Device.h"
+
+namespace Falcor
+{
+    namespace
+    {
+        const float kPi = 3.14159265f;
+        const uint32_t kTileSize = 16;
+        const uint32_t kRussianRouletteDepth = 3;
+
+        float srgbToLinear(float c)
+        {
+            return (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+
+        float maxComponent(const glm::vec3& v)
+        {
+            return std::max(v.x, std::max(v.y, v.z));
+        }
+
+        bool isFinite(const glm::vec3& v)
+        {
+            return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+        }
+
+        // Offset a ray origin off a surface, scaled with the magnitude of the position to stay above the float precision
+        glm::vec3 offsetRayOrigin(const glm::vec3& P, const glm::vec3& Ng)
+        {
+            const float scale = 1e-4f * std::max(1.0f, maxComponent(glm::abs(P)));
+            return P + Ng * scale;
+        }
+
+        // Orthonormal basis around a unit vector, see "Building an Orthonormal Basis, Revisited" by Duff et al.
+        void createBasis(const glm::vec3& N, glm::vec3& T, glm::vec3& B)
+        {
+            const float sign = (N.z >= 0) ? 1.0f : -1.0f;
+            const float a = -1.0f / (sign + N.z);
+            const float b = N.x * N.y * a;
+            T = glm::vec3(1.0f + sign * N.x * N.x * a, sign * b, -sign * N.x);
+            B = glm::vec3(b, sign + N.y * N.y * a, -N.y);
+        }
+
+        float powerHeuristic(float pdfA, float pdfB)
+        {
+            const float a2 = pdfA * pdfA;
+            const float b2 = pdfB * pdfB;
+            return (a2 + b2 > 0) ? a2 / (a2 + b2) : 0.0f;
+        }
+
+        // Solid angle of the cone a sphere subtends, as 1 - cos of its half angle. Returns 0 when the point is inside the sphere.
+        float getSphereConeSize(const LightData& light, const glm::vec3& P)
+        {
+            const glm::vec3 toCenter = light.worldPos - P;
+            const float dist2 = glm::dot(toCenter, toCenter);
+            const float radius2 = light.radius * light.radius;
+            if (dist2 <= radius2)
+            {
+                return 0;
+            }
+            const float sin2Max = radius2 / dist2;
+            const float cosMax = std::sqrt(std::max(0.0f, 1.0f - sin2Max));
+            return sin2Max / (1.0f + cosMax);
+        }
+
+        // The quad emits on the side its winding faces, see ltcEvaluate()
+        glm::vec3 getPolygonNormal(const LightData& light)
+        {
+            const glm::vec3 n = glm::cross(glm::vec3(light.vertices[2] - light.vertices[0]), glm::vec3(light.vertices[3] - light.vertices[1]));
+            const float len = glm::length(n);
+            return (len > 0) ? n / len : glm::vec3(0.0f);
+        }
+
+        float getTriangleArea(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+        {
+            return 0.5f * glm::length(glm::cross(b - a, c - a));
+        }
+
+        bool intersectTriangle(const Ray& ray, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, float& t)
+        {
+            const glm::vec3 e1 = b - a;
+            const glm::vec3 e2 = c - a;
+            const glm::vec3 p = glm::cross(ray.direction, e2);
+            const float det = glm::dot(e1, p);
+            if (std::abs(det) < 1e-12f)
+            {
+                return false;
+            }
+            const float invDet = 1.0f / det;
+            const glm::vec3 s = ray.origin - a;
+            const float u = glm::dot(s, p) * invDet;
+            if (u < 0 || u > 1)
+            {
+                return false;
+            }
+            const glm::vec3 q = glm::cross(s, e1);
+            const float v = glm::dot(ray.direction, q) * invDet;
+            if (v < 0 || u + v > 1)
+            {
+                return false;
+            }
+            t = glm::dot(e2, q) * invDet;
+            return t > ray.tMin && t < ray.tMax;
+        }
+
+        bool intersectLight(const LightData& light, const Ray& ray, float& t)
+        {
+            switch (light.type)
+            {
+            case LightSphere:
+            {
+                const glm::vec3 toCenter = light.worldPos - ray.origin;
+                const float c = glm::dot(toCenter, toCenter) - light.radius * light.radius;
+                if (c <= 0)
+                {
+                    return false;
+                }
+                const float b = glm::dot(ray.direction, toCenter);
+                const float disc = b * b - c;
+                if (disc < 0)
+                {
+                    return false;
+                }
+                t = b - std::sqrt(disc);
+                return t > ray.tMin && t < ray.tMax;
+            }
+            case LightPolygonal:
+            {
+                if (glm::dot(ray.direction, getPolygonNormal(light)) >= 0)
+                {
+                    return false;
+                }
+                const glm::vec3 v0(light.vertices[0]), v1(light.vertices[1]), v2(light.vertices[2]), v3(light.vertices[3]);
+                return intersectTriangle(ray, v0, v1, v2, t) || intersectTriangle(ray, v0, v2, v3, t);
+            }
+            default:
+                return false;
+            }
+        }
+
+        bool intersectBox(const Ray& ray, const glm::vec3& invDir, const glm::vec3& boxMin, const glm::vec3& boxMax)
+        {
+            const glm::vec3 t0 = (boxMin - ray.origin) * invDir;
+            const glm::vec3 t1 = (boxMax - ray.origin) * invDir;
+            const glm::vec3 tNear = glm::min(t0, t1);
+            const glm::vec3 tFar = glm::max(t0, t1);
+            const float tEnter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, ray.tMin));
+            const float tExit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, ray.tMax));
+            return tEnter <= tExit;
+        }
+    }
+
+    /** PCG32 random number generator, one stream per pixel and pass
+    */
+    class ReferencePathTracer::Sampler
+    {
+    public:
+        Sampler(uint64_t sequence, uint64_t seed)
+        {
+            mIncrement = (sequence << 1u) | 1u;
+            next();
+            mState += seed;
+            next();
+        }
+
+        float next()
+        {
+            const uint64_t oldState = mState;
+            mState = oldState * 6364136223846793005ull + mIncrement;
+            const uint32_t xorShifted = uint32_t(((oldState >> 18u) ^ oldState) >> 27u);
+            const uint32_t rot = uint32_t(oldState >> 59u);
+            const uint32_t value = (xorShifted >> rot) | (xorShifted << ((~rot + 1u) & 31));
+            // 24 bits so the result stays below 1
+            return float(value >> 8) * (1.0f / 16777216.0f);
+        }
+
+        glm::vec2 next2() { const float x = next(); return glm::vec2(x, next()); }
+        glm::vec3 next3() { const float x = next(); const float y = next(); return glm::vec3(x, y, next()); }
+
+    private:
+        uint64_t mState = 0;
+        uint64_t mIncrement = 0;
+    };
+
+    ReferencePathTracer::SharedPtr ReferencePathTracer::create(const Scene::SharedPtr& pScene)
+    {
+        return SharedPtr(new ReferencePathTracer(pScene));
+    }
+
+    ReferencePathTracer::ReferencePathTracer(const Scene::SharedPtr& pScene) : mpScene(pScene)
+    {
+        for (uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+        {
+            const Model* pModel = pScene->getModel(modelID).get();
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                loadMesh(pModel->getMesh(meshID).get());
+            }
+        }
+
+        mpSceneBvh = SceneBvh::create(pScene);
+        prepareLights();
+    }
+
+    bool ReferencePathTracer::loadMesh(const Mesh* pMesh)
+    {
+        if (mMeshIndices.count(pMesh))
+        {
+            return true;
+        }
+
+        MeshData mesh;
+        if (MeshBvh::readMeshData(pMesh, mesh.positions, mesh.indices) == false)
+        {
+            return false;
+        }
+
+        const Vao* pVao = pMesh->getVao().get();
+        const uint32_t vertCnt = pMesh->getVertexCount();
+        for (uint32_t vbIdx = 0; vbIdx < pVao->getVertexBuffersCount(); ++vbIdx)
+        {
+            const VertexBufferLayout* pLayout = pVao->getVertexLayout()->getBufferLayout(vbIdx).get();
+            Buffer* pVB = pVao->getVertexBuffer(vbIdx).get();
+            const uint8_t* pVBData = nullptr;
+            for (uint32_t elemIdx = 0; elemIdx < pLayout->getElementCount(); ++elemIdx)
+            {
+                const std::string& name = pLayout->getElementName(elemIdx);
+                const bool isNormal = (name == VERTEX_NORMAL_NAME && mesh.normals.empty());
+                const bool isTexCoord = (name == VERTEX_TEXCOORD_NAME && mesh.texCoords.empty());
+                if (!isNormal && !isTexCoord)
+                {
+                    continue;
+                }
+                if (pVBData == nullptr)
+                {
+                    pVBData = (const uint8_t*)pVB->map(Buffer::MapType::Read);
+                }
+                if (isNormal)
+                {
+                    readVertexAttribute(pVBData, pLayout, elemIdx, vertCnt, pMesh->getBoundingBox(), mesh.normals);
+                }
+                else
+                {
+                    readVertexAttribute(pVBData, pLayout, elemIdx, vertCnt, pMesh->getBoundingBox(), mesh.texCoords);
+                }
+            }
+            if (pVBData)
+            {
+                pVB->unmap();
+            }
+        }
+
+        mesh.material = loadMaterial(pMesh->getMaterial().get());
+        mMeshIndices[pMesh] = (uint32_t)mMeshes.size();
+        mMeshes.push_back(std::move(mesh));
+        return true;
+    }
+
+    uint32_t ReferencePathTracer::loadMaterial(const Material* pMaterial)
+    {
+        auto it = mMaterialIndices.find(pMaterial);
+        if (it != mMaterialIndices.end())
+        {
+            return it->second;
+        }
+
+        MaterialData material;
+        material.layerCount = pMaterial ? std::min(pMaterial->getNumLayers(), ReferenceBSDF::kMaxLayers) : 0;
+        material.emission = glm::vec3(0.0f);
+        for (uint32_t i = 0; i < material.layerCount; i++)
+        {
+            const Material::Layer layer = pMaterial->getLayer(i);
+            ReferenceBSDF::Layer& dst = material.layers[i];
+            dst.type = (uint32_t)layer.type;
+            dst.ndf = (uint32_t)layer.ndf;
+            dst.blend = (uint32_t)layer.blend;
+            dst.albedo = layer.albedo;
+            dst.roughness = layer.roughness.x;
+            dst.IoR = layer.extraParam.x;
+            dst.kappa = layer.extraParam.y;
+
+            material.textures[i] = layer.pTexture ? loadTexture(layer.pTexture.get()) : -1;
+            material.roughnessInAlpha[i] = false;
+            if (layer.pTexture && (layer.type == Material::Layer::Type::Conductor || layer.type == Material::Layer::Type::Dielectric))
+            {
+                // Same rule as Material::finalize() uses to set ROUGHNESS_CHANNEL_BIT
+                const ResourceFormat format = layer.pTexture->getFormat();
+                material.roughnessInAlpha[i] = getFormatChannelCount(format) == 4 && format != ResourceFormat::BGRX8Unorm && format != ResourceFormat::BGRX8UnormSrgb;
+            }
+
+            if (layer.type == Material::Layer::Type::Emissive)
+            {
+                material.isEmissive = true;
+                material.emission += glm::vec3(layer.albedo);
+            }
+            else if (layer.type == Material::Layer::Type::User)
+            {
+                logWarning("The reference path tracer doesn't support user-defined material layers, material " + pMaterial->getName() + " will render without them.");
+            }
+        }
+
+        const uint32_t index = (uint32_t)mMaterials.size();
+        mMaterialIndices[pMaterial] = index;
+        mMaterials.push_back(material);
+        return index;
+    }
+
+    int32_t ReferencePathTracer::loadTexture(const Texture* pTexture)
+    {
+        auto it = mTextureIndices.find(pTexture);
+        if (it != mTextureIndices.end())
+        {
+            return it->second;
+        }
+
+        mTextureIndices[pTexture] = -1;
+        const ResourceFormat format = pTexture->getFormat();
+        const bool isFloat = (format == ResourceFormat::RGBA32Float);
+        const bool isRgba8 = (format == ResourceFormat::RGBA8Unorm || format == ResourceFormat::RGBA8UnormSrgb);
+        const bool isBgra8 = (format == ResourceFormat::BGRA8Unorm || format == ResourceFormat::BGRA8UnormSrgb || format == ResourceFormat::BGRX8Unorm || format == ResourceFormat::BGRX8UnormSrgb);
+        if (!isFloat && !isRgba8 && !isBgra8)
+        {
+            logWarning("The reference path tracer doesn't support the format of texture " + pTexture->getAbsoluteSourceFilename() + ", the layer albedo is used instead.");
+            return -1;
+        }
+
+        TextureData texture;
+        texture.width = pTexture->getWidth();
+        texture.height = pTexture->getHeight();
+        texture.texels.resize(texture.width * texture.height);
+
+        const std::vector<uint8> data = gpDevice->getRenderContext()->readTextureSubresource(pTexture, pTexture->getSubresourceIndex(0, 0));
+        if (isFloat)
+        {
+            std::memcpy(texture.texels.data(), data.data(), std::min(data.size(), texture.texels.size() * sizeof(glm::vec4)));
+        }
+        else
+        {
+            const bool isSrgb = isSrgbFormat(format);
+            const bool hasAlpha = (format != ResourceFormat::BGRX8Unorm && format != ResourceFormat::BGRX8UnormSrgb);
+            for (size_t i = 0; i < texture.texels.size() && i * 4 + 3 < data.size(); i++)
+            {
+                const uint8* pTexel = &data[i * 4];
+                glm::vec4 c = glm::vec4(pTexel[0], pTexel[1], pTexel[2], pTexel[3]) / 255.0f;
+                if (isBgra8)
+                {
+                    std::swap(c.x, c.z);
+                }
+                if (isSrgb)
+                {
+                    c = glm::vec4(srgbToLinear(c.x), srgbToLinear(c.y), srgbToLinear(c.z), c.w);
+                }
+                if (!hasAlpha)
+                {
+                    c.w = 1;
+                }
+                texture.texels[i] = c;
+            }
+        }
+
+        const int32_t index = (int32_t)mTextures.size();
+        mTextureIndices[pTexture] = index;
+        mTextures.push_back(std::move(texture));
+        return index;
+    }
+
+    void ReferencePathTracer::prepareLights()
+    {
+        mpLightBvh = LightBVH::create();
+        mpLightBvh->update(mpScene.get());
+
+        mLights.resize(mpScene->getLightCount());
+        for (uint32_t i = 0; i < mpScene->getLightCount(); i++)
+        {
+            mLights[i] = mpScene->getLight(i)->getData();
+            if (mLights[i].type == LightArea)
+            {
+                logWarning("The reference path tracer doesn't support mesh area lights, light " + mpScene->getLight(i)->getName() + " is ignored.");
+            }
+        }
+    }
+
+    glm::vec4 ReferencePathTracer::fetchTexture(int32_t textureIndex, const glm::vec2& uv) const
+    {
+        // Bilinear filtering with wrap addressing, no mip-mapping
+        const TextureData& texture = mTextures[textureIndex];
+        const float x = uv.x * texture.width - 0.5f;
+        const float y = uv.y * texture.height - 0.5f;
+        const float fx = std::floor(x);
+        const float fy = std::floor(y);
+        const glm::vec2 w(x - fx, y - fy);
+
+        auto texel = [&texture](int64_t tx, int64_t ty)
+        {
+            const int64_t width = texture.width;
+            const int64_t height = texture.height;
+            tx = ((tx % width) + width) % width;
+            ty = ((ty % height) + height) % height;
+            return texture.texels[size_t(ty * width + tx)];
+        };
+
+        const int64_t x0 = (int64_t)fx;
+        const int64_t y0 = (int64_t)fy;
+        const glm::vec4 top = glm::mix(texel(x0, y0), texel(x0 + 1, y0), w.x);
+        const glm::vec4 bottom = glm::mix(texel(x0, y0 + 1), texel(x0 + 1, y0 + 1), w.x);
+        return glm::mix(top, bottom, w.y);
+    }
+
+    bool ReferencePathTracer::intersect(Ray ray, bool acceptEmissive, SceneBvh::Hit& hit) const
+    {
+        for (;;)
+        {
+            if (mpSceneBvh->raycast(ray, hit) == false)
+            {
+                return false;
+            }
+
+            const uint32_t meshIndex = mMeshIndices.at(hit.instance.pMeshInstance->getObject().get());
+            if (acceptEmissive || mMaterials[mMeshes[meshIndex].material].isEmissive == false)
+            {
+                return true;
+            }
+
+            // Emissive geometry is transparent to everything but camera rays, continue behind it
+            ray.tMin = std::max(std::nextafter(hit.t, FLT_MAX), hit.t * (1.0f + 1e-5f));
+        }
+    }
+
+    bool ReferencePathTracer::isOccluded(const glm::vec3& origin, const glm::vec3& dir, float distance) const
+    {
+        Ray ray;
+        ray.origin = origin;
+        ray.direction = dir;
+        ray.tMax = distance;
+        SceneBvh::Hit hit;
+        return intersect(ray, false, hit);
+    }
+
+    void ReferencePathTracer::computeShadingPoint(const Ray& ray, const SceneBvh::Hit& hit, ShadingPoint& sp) const
+    {
+        const MeshData& mesh = mMeshes[mMeshIndices.at(hit.instance.pMeshInstance->getObject().get())];
+        const glm::mat4 worldMat = hit.instance.pModelInstance->getTransformMatrix() * hit.instance.pMeshInstance->getTransformMatrix();
+
+        const uint32_t i0 = mesh.indices[hit.primitiveID * 3 + 0];
+        const uint32_t i1 = mesh.indices[hit.primitiveID * 3 + 1];
+        const uint32_t i2 = mesh.indices[hit.primitiveID * 3 + 2];
+        const glm::vec3 bary(1.0f - hit.barycentrics.x - hit.barycentrics.y, hit.barycentrics.x, hit.barycentrics.y);
+
+        const glm::vec3 p0 = glm::vec3(worldMat * glm::vec4(mesh.positions[i0], 1.0f));
+        const glm::vec3 p1 = glm::vec3(worldMat * glm::vec4(mesh.positions[i1], 1.0f));
+        const glm::vec3 p2 = glm::vec3(worldMat * glm::vec4(mesh.positions[i2], 1.0f));
+        sp.P = p0 * bary.x + p1 * bary.y + p2 * bary.z;
+
+        // Triangles are double sided, face the geometric normal towards the ray
+        sp.Ng = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+        if (glm::dot(sp.Ng, ray.direction) > 0)
+        {
+            sp.Ng = -sp.Ng;
+        }
+
+        sp.N = sp.Ng;
+        if (mesh.normals.empty() == false)
+        {
+            const glm::vec3 n = mesh.normals[i0] * bary.x + mesh.normals[i1] * bary.y + mesh.normals[i2] * bary.z;
+            const glm::vec3 N = glm::mat3(glm::transpose(glm::inverse(worldMat))) * n;
+            const float len = glm::length(N);
+            if (len > 0)
+            {
+                sp.N = (glm::dot(N, sp.Ng) < 0) ? -N / len : N / len;
+            }
+        }
+        // Interpolated normals can face away from the viewer near silhouettes, fall back to the geometry there
+        if (glm::dot(sp.N, ray.direction) >= 0)
+        {
+            sp.N = sp.Ng;
+        }
+        createBasis(sp.N, sp.T, sp.B);
+
+        glm::vec2 uv(0.0f);
+        if (mesh.texCoords.empty() == false)
+        {
+            uv = mesh.texCoords[i0] * bary.x + mesh.texCoords[i1] * bary.y + mesh.texCoords[i2] * bary.z;
+        }
+
+        const MaterialData& material = mMaterials[mesh.material];
+        sp.pMaterial = &material;
+        sp.bsdf = ReferenceBSDF();
+        for (uint32_t i = 0; i < material.layerCount; i++)
+        {
+            ReferenceBSDF::Layer layer = material.layers[i];
+            if (material.textures[i] >= 0)
+            {
+                layer.albedo = fetchTexture(material.textures[i], uv);
+                if (material.roughnessInAlpha[i])
+                {
+                    layer.roughness = layer.albedo.w;
+                }
+            }
+            sp.bsdf.addLayer(layer);
+        }
+    }
+
+    bool ReferencePathTracer::intersectLights(const Ray& ray, std::vector<uint32_t>& stack, uint32_t& lightIndex, float& t) const
+    {
+        const std::vector<LightBVH::Node>& nodes = mpLightBvh->getNodes();
+        if (nodes.empty())
+        {
+            return false;
+        }
+
+        Ray r = ray;
+        const glm::vec3 invDir = 1.0f / ray.direction;
+        bool found = false;
+
+        stack.clear();
+        stack.push_back(0);
+        while (stack.empty() == false)
+        {
+            const uint32_t nodeIndex = stack.back();
+            stack.pop_back();
+
+            const LightBVH::Node& node = nodes[nodeIndex];
+            if (intersectBox(r, invDir, node.aabbMin, node.aabbMax) == false)
+            {
+                continue;
+            }
+
+            if (node.rightChild == 0)
+            {
+                float lightT;
+                if (intersectLight(mLights[node.lightIndex], r, lightT))
+                {
+                    r.tMax = lightT;
+                    lightIndex = node.lightIndex;
+                    t = lightT;
+                    found = true;
+                }
+            }
+            else
+            {
+                stack.push_back(nodeIndex + 1);
+                stack.push_back(node.rightChild);
+            }
+        }
+        return found;
+    }
+
+    float ReferencePathTracer::evalAreaLightPdf(const LightData& light, const glm::vec3& origin, const glm::vec3& dir, float t) const
+    {
+        if (light.type == LightSphere)
+        {
+            const float coneSize = getSphereConeSize(light, origin);
+            return (coneSize > 0) ? 1.0f / (2.0f * kPi * coneSize) : 0.0f;
+        }
+
+        const glm::vec3 v0(light.vertices[0]), v1(light.vertices[1]), v2(light.vertices[2]), v3(light.vertices[3]);
+        const float area = getTriangleArea(v0, v1, v2) + getTriangleArea(v0, v2, v3);
+        const float cosLight = -glm::dot(dir, getPolygonNormal(light));
+        return (area > 0 && cosLight > 0) ? t * t / (cosLight * area) : 0.0f;
+    }
+
+    glm::vec3 ReferencePathTracer::evalLightContribution(const ShadingPoint& sp, const glm::vec3& wo, const LightData& light, float pmf, Sampler& sampler) const
+    {
+        glm::vec3 wi;
+        glm::vec3 Li = light.intensity;
+        float distance = FLT_MAX;
+        float lightPdf = 0;             // Solid angle density for area lights, 0 for delta lights
+
+        switch (light.type)
+        {
+        case LightDirectional:
+            wi = -glm::normalize(light.worldDir);
+            break;
+        case LightPoint:
+        {
+            // Same attenuation as prepareLightAttribs() in SugarLights.slang
+            const glm::vec3 toLight = light.worldPos - sp.P;
+            const float dist2 = glm::dot(toLight, toLight);
+            distance = std::sqrt(dist2);
+            if (distance <= 0)
+            {
+                return glm::vec3(0.0f);
+            }
+            wi = toLight / distance;
+
+            float atten = 1.0f;
+            const float cosTheta = -glm::dot(wi, light.worldDir);
+            if (cosTheta < light.cosOpeningAngle)
+            {
+                atten = 0;
+            }
+            if (light.penumbraAngle > 0)
+            {
+                const float deltaAngle = light.openingAngle - std::acos(glm::clamp(cosTheta, -1.0f, 1.0f));
+                atten *= glm::clamp((deltaAngle - light.penumbraAngle) / light.penumbraAngle, 0.0f, 1.0f);
+            }
+            Li *= atten / std::max(1e-3f, dist2);
+            break;
+        }
+        case LightSphere:
+        {
+            // Uniformly sample the cone the sphere subtends
+            const float coneSize = getSphereConeSize(light, sp.P);
+            if (coneSize <= 0)
+            {
+                return glm::vec3(0.0f);
+            }
+            const glm::vec3 toCenter = light.worldPos - sp.P;
+            const glm::vec3 axis = glm::normalize(toCenter);
+            glm::vec3 T, B;
+            createBasis(axis, T, B);
+
+            const glm::vec2 u = sampler.next2();
+            const float cosTheta = 1.0f - u.x * coneSize;
+            const float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+            const float phi = 2.0f * kPi * u.y;
+            wi = glm::normalize(T * (sinTheta * std::cos(phi)) + B * (sinTheta * std::sin(phi)) + axis * cosTheta);
+
+            const float b = glm::dot(wi, toCenter);
+            const float disc = b * b - (glm::dot(toCenter, toCenter) - light.radius * light.radius);
+            distance = (disc > 0) ? b - std::sqrt(disc) : b;
+            lightPdf = 1.0f / (2.0f * kPi * coneSize);
+            break;
+        }
+        case LightPolygonal:
+        {
+            // Uniformly sample the area of the quad, split into two triangles
+            const glm::vec3 v0(light.vertices[0]), v1(light.vertices[1]), v2(light.vertices[2]), v3(light.vertices[3]);
+            const float area0 = getTriangleArea(v0, v1, v2);
+            const float area = area0 + getTriangleArea(v0, v2, v3);
+            if (area <= 0)
+            {
+                return glm::vec3(0.0f);
+            }
+
+            const glm::vec3 u = sampler.next3();
+            const bool first = u.x * area < area0;
+            const glm::vec3 b = first ? v1 : v2;
+            const glm::vec3 c = first ? v2 : v3;
+            const float su = std::sqrt(u.y);
+            const glm::vec3 X = v0 * (1.0f - su) + b * (su * (1.0f - u.z)) + c * (su * u.z);
+
+            const glm::vec3 toLight = X - sp.P;
+            const float dist2 = glm::dot(toLight, toLight);
+            distance = std::sqrt(dist2);
+            if (distance <= 0)
+            {
+                return glm::vec3(0.0f);
+            }
+            wi = toLight / distance;
+
+            const float cosLight = -glm::dot(wi, getPolygonNormal(light));
+            if (cosLight <= 0)
+            {
+                return glm::vec3(0.0f);
+            }
+            lightPdf = dist2 / (cosLight * area);
+            break;
+        }
+        default:
+            return glm::vec3(0.0f);
+        }
+
+        if (glm::dot(wi, sp.Ng) <= 0)
+        {
+            return glm::vec3(0.0f);
+        }
+
+        const glm::vec3 wiLocal(glm::dot(wi, sp.T), glm::dot(wi, sp.B), glm::dot(wi, sp.N));
+        const glm::vec3 f = sp.bsdf.eval(wo, wiLocal);
+        if (maxComponent(f) <= 0 || maxComponent(Li) <= 0)
+        {
+            return glm::vec3(0.0f);
+        }
+
+        const glm::vec3 origin = offsetRayOrigin(sp.P, sp.Ng);
+        if (isOccluded(origin, wi, (distance < FLT_MAX) ? distance * 0.999f : FLT_MAX))
+        {
+            return glm::vec3(0.0f);
+        }
+
+        if (lightPdf > 0)
+        {
+            // Area lights can also be hit by BSDF samples, weight both strategies with the power heuristic
+            const float pdf = pmf * lightPdf;
+            return f * Li * (powerHeuristic(pdf, sp.bsdf.evalPdf(wo, wiLocal)) / pdf);
+        }
+        return f * Li / pmf;
+    }
+
+    glm::vec3 ReferencePathTracer::sampleDirectLighting(const ShadingPoint& sp, const glm::vec3& wo, Sampler& sampler) const
+    {
+        glm::vec3 result(0.0f);
+
+        // Lights without bounds, i.e. directional lights, are always sampled
+        for (uint32_t lightIndex : mpLightBvh->getUnboundedLights())
+        {
+            result += evalLightContribution(sp, wo, mLights[lightIndex], 1.0f, sampler);
+        }
+
+        float pmf;
+        const uint32_t lightIndex = mpLightBvh->sample(sp.P, sp.N, sampler.next(), pmf);
+        if (lightIndex != LightBVH::kInvalidIndex && pmf > 0)
+        {
+            result += evalLightContribution(sp, wo, mLights[lightIndex], pmf, sampler);
+        }
+        return result;
+    }
+
+    glm::vec3 ReferencePathTracer::tracePath(Ray ray, uint32_t maxBounces, Sampler& sampler, std::vector<uint32_t>& stack) const
+    {
+        glm::vec3 radiance(0.0f);
+        glm::vec3 throughput(1.0f);
+
+        ShadingPoint sp;
+        glm::vec3 prevP, prevN;
+        float prevBsdfPdf = 0;
+
+        for (uint32_t bounce = 0; ; bounce++)
+        {
+            const bool isCameraRay = (bounce == 0);
+            SceneBvh::Hit hit;
+            const bool found = intersect(ray, isCameraRay, hit);
+
+            // The path leaving the previous vertex may hit an area light before the next surface
+            if (!isCameraRay)
+            {
+                Ray lightRay = ray;
+                if (found)
+                {
+                    lightRay.tMax = hit.t;
+                }
+                uint32_t lightIndex;
+                float t;
+                if (intersectLights(lightRay, stack, lightIndex, t))
+                {
+                    const LightData& light = mLights[lightIndex];
+                    const float lightPdf = mpLightBvh->getPmf(prevP, prevN, lightIndex) * evalAreaLightPdf(light, ray.origin, ray.direction, t);
+                    radiance += throughput * light.intensity * powerHeuristic(prevBsdfPdf, lightPdf);
+                    break;
+                }
+            }
+
+            if (!found)
+            {
+                break;
+            }
+
+            computeShadingPoint(ray, hit, sp);
+            if (sp.pMaterial->isEmissive)
+            {
+                radiance += throughput * sp.pMaterial->emission;
+                break;
+            }
+
+            if (bounce >= maxBounces)
+            {
+                break;
+            }
+
+            const glm::vec3 wo(glm::dot(-ray.direction, sp.T), glm::dot(-ray.direction, sp.B), glm::dot(-ray.direction, sp.N));
+            radiance += throughput * sampleDirectLighting(sp, wo, sampler);
+
+            glm::vec3 wiLocal;
+            float pdf;
+            if (sp.bsdf.sample(wo, sampler.next3(), wiLocal, pdf) == false)
+            {
+                break;
+            }
+            const glm::vec3 wi = glm::normalize(sp.T * wiLocal.x + sp.B * wiLocal.y + sp.N * wiLocal.z);
+            if (glm::dot(wi, sp.Ng) <= 0)
+            {
+                break;
+            }
+
+            throughput *= sp.bsdf.eval(wo, wiLocal) / pdf;
+            if (maxComponent(throughput) <= 0)
+            {
+                break;
+            }
+
+            if (bounce + 1 >= kRussianRouletteDepth)
+            {
+                const float survival = std::min(maxComponent(throughput), 0.95f);
+                if (sampler.next() >= survival)
+                {
+                    break;
+                }
+                throughput /= survival;
+            }
+
+            prevP = sp.P;
+            prevN = sp.N;
+            prevBsdfPdf = pdf;
+
+            ray = Ray();
+            ray.origin = offsetRayOrigin(sp.P, sp.Ng);
+            ray.direction = wi;
+        }
+
+        return radiance;
+    }
+
+    std::vector<glm::vec4> ReferencePathTracer::render(const Camera* pCamera, const Desc& desc)
+    {
+        const uint32_t width = desc.width;
+        const uint32_t height = desc.height;
+        std::vector<glm::vec3> accumulated(size_t(width) * height, glm::vec3(0.0f));
+        std::vector<glm::vec4> image(size_t(width) * height, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+        // The jitter is a translation in clip space, add it to the pixel position to cancel it out of the inverse matrix
+        const glm::mat4 invViewProj = pCamera->getInvViewProjMatrix();
+        const glm::vec2 jitter(2.0f * pCamera->getJitterX(), 2.0f * pCamera->getJitterY());
+        const glm::vec3 cameraPos = pCamera->getPosition();
+
+        const uint32_t tilesX = (width + kTileSize - 1) / kTileSize;
+        const uint32_t tilesY = (height + kTileSize - 1) / kTileSize;
+        const uint32_t samplesPerPass = std::max(1u, desc.samplesPerPass);
+
+        uint32_t sampleCount = 0;
+        while (sampleCount < desc.samplesPerPixel)
+        {
+            const uint32_t passSamples = std::min(samplesPerPass, desc.samplesPerPixel - sampleCount);
+            const uint64_t passSeed = (uint64_t(desc.seed) << 32) | sampleCount;
+
+            parallelFor(0, tilesX * tilesY, [&](size_t tile)
+            {
+                PROFILE_CPU(traceTile);
+                std::vector<uint32_t> stack;
+                const uint32_t x0 = uint32_t(tile % tilesX) * kTileSize;
+                const uint32_t y0 = uint32_t(tile / tilesX) * kTileSize;
+                for (uint32_t y = y0; y < std::min(y0 + kTileSize, height); y++)
+                {
+                    for (uint32_t x = x0; x < std::min(x0 + kTileSize, width); x++)
+                    {
+                        const size_t pixel = size_t(y) * width + x;
+                        Sampler sampler(pixel, passSeed);
+                        glm::vec3 sum(0.0f);
+                        for (uint32_t s = 0; s < passSamples; s++)
+                        {
+                            const glm::vec2 u = sampler.next2();
+                            const glm::vec2 ndc((x + u.x) / width * 2.0f - 1.0f, 1.0f - (y + u.y) / height * 2.0f);
+                            const glm::vec4 target = invViewProj * glm::vec4(ndc + jitter, 0.5f, 1.0f);
+
+                            Ray ray;
+                            ray.origin = cameraPos;
+                            ray.direction = glm::normalize(glm::vec3(target) / target.w - cameraPos);
+
+                            const glm::vec3 radiance = tracePath(ray, desc.maxBounces, sampler, stack);
+                            if (isFinite(radiance))
+                            {
+                                sum += radiance;
+                            }
+                        }
+                        accumulated[pixel] += sum;
+                    }
+                }
+            });
+
+            sampleCount += passSamples;
+
+            for (size_t i = 0; i < image.size(); i++)
+            {
+                image[i] = glm::vec4(accumulated[i] / float(sampleCount), 1.0f);
+            }
+            if (desc.outputFilename.empty() == false)
+            {
+                Bitmap::saveImage(desc.outputFilename, width, height, Bitmap::FileFormat::ExrFile, Bitmap::ExportFlags::None, ResourceFormat::RGBA32Float, true, image.data());
+            }
+        }
+
+        return image;
+    }
+}
@@ -0,0 +1,145 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Falcor.h"
+#include "Graphics/Scene/SceneBvh.h"
+#include "Graphics/LightBVH.h"
+#include "Utils/PathTracer/ReferenceBSDF.h"
+#include <unordered_map>
+
+namespace Falcor
+{
+    /** Multithreaded CPU path tracer used as ground truth for the raster renderer, replacing the round trip through a Mitsuba export.
+        Rays are traced against a SceneBvh. Materials are evaluated with ReferenceBSDF, the CPU port of the Sugar layer model.
+        Point, spot, directional, sphere and polygonal lights are supported. Lights are picked for next event estimation with a LightBVH,
+        area lights are combined with BSDF sampling through multiple importance sampling.
+        Emissive meshes, like the proxies of the area lights, are only visible to camera rays, the lights they represent illuminate the scene instead.
+        Not supported yet: transmission, normal and alpha maps, the sky box and Falcor's LightArea type.
+
+        Usage: create the tracer on the render thread, which reads the geometry and textures back from the GPU once. render() only touches CPU data.
+    */
+    class ReferencePathTracer
+    {
+    public:
+        using SharedPtr = std::shared_ptr<ReferencePathTracer>;
+        using SharedConstPtr = std::shared_ptr<const ReferencePathTracer>;
+
+        struct Desc
+        {
+            uint32_t width = 1024;
+            uint32_t height = 1024;
+            uint32_t samplesPerPixel = 64;
+            uint32_t samplesPerPass = 4;            ///< Samples added to every pixel between two writes of the output file
+            uint32_t maxBounces = 8;
+            uint32_t seed = 0;
+            std::string outputFilename;             ///< EXR file rewritten after every pass, so long renders can be inspected while they run. Nothing is written when empty.
+        };
+
+        /** Create a tracer for a scene. Must be called from the thread owning the render context.
+        */
+        static SharedPtr create(const Scene::SharedPtr& pScene);
+
+        /** Render an image. Tiles are distributed over all cores, the call returns when all samples were taken.
+            \param[in] pCamera Camera to render from. Its jitter is ignored.
+            \param[in] desc Render settings
+            \return Linear radiance, RGBA32Float, top row first
+        */
+        std::vector<glm::vec4> render(const Camera* pCamera, const Desc& desc);
+
+    private:
+        ReferencePathTracer(const Scene::SharedPtr& pScene);
+
+        struct TextureData
+        {
+            uint32_t width = 0;
+            uint32_t height = 0;
+            std::vector<glm::vec4> texels;
+        };
+
+        struct MaterialData
+        {
+            ReferenceBSDF::Layer layers[ReferenceBSDF::kMaxLayers];
+            int32_t textures[ReferenceBSDF::kMaxLayers];      ///< Index into mTextures, -1 for untextured layers
+            bool roughnessInAlpha[ReferenceBSDF::kMaxLayers];
+            uint32_t layerCount = 0;
+            glm::vec3 emission;
+            bool isEmissive = false;
+        };
+
+        struct MeshData
+        {
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec3> normals;
+            std::vector<glm::vec2> texCoords;
+            std::vector<uint32_t> indices;
+            uint32_t material = 0;
+        };
+
+        struct ShadingPoint
+        {
+            glm::vec3 P;
+            glm::vec3 Ng;               ///< Geometric normal, facing the incoming ray
+            glm::vec3 N;                ///< Shading normal, on the same side as Ng
+            glm::vec3 T;
+            glm::vec3 B;
+            const MaterialData* pMaterial = nullptr;
+            ReferenceBSDF bsdf;
+        };
+
+        class Sampler;
+
+        bool loadMesh(const Mesh* pMesh);
+        uint32_t loadMaterial(const Material* pMaterial);
+        int32_t loadTexture(const Texture* pTexture);
+        void prepareLights();
+
+        bool intersect(Ray ray, bool acceptEmissive, SceneBvh::Hit& hit) const;
+        bool isOccluded(const glm::vec3& origin, const glm::vec3& dir, float distance) const;
+        void computeShadingPoint(const Ray& ray, const SceneBvh::Hit& hit, ShadingPoint& sp) const;
+        glm::vec4 fetchTexture(int32_t texture, const glm::vec2& uv) const;
+
+        bool intersectLights(const Ray& ray, std::vector<uint32_t>& stack, uint32_t& lightIndex, float& t) const;
+        float evalAreaLightPdf(const LightData& light, const glm::vec3& origin, const glm::vec3& dir, float t) const;
+        glm::vec3 sampleDirectLighting(const ShadingPoint& sp, const glm::vec3& wo, Sampler& sampler) const;
+        glm::vec3 evalLightContribution(const ShadingPoint& sp, const glm::vec3& wo, const LightData& light, float pmf, Sampler& sampler) const;
+
+        glm::vec3 tracePath(Ray ray, uint32_t maxBounces, Sampler& sampler, std::vector<uint32_t>& stack) const;
+
+        Scene::SharedPtr mpScene;
+        SceneBvh::SharedPtr mpSceneBvh;
+        LightBVH::SharedPtr mpLightBvh;
+        std::vector<LightData> mLights;
+
+        std::vector<MeshData> mMeshes;
+        std::vector<MaterialData> mMaterials;
+        std::vector<TextureData> mTextures;
+        std::unordered_map<const Mesh*, uint32_t> mMeshIndices;
+        std::unordered_map<const Material*, uint32_t> mMaterialIndices;
+        std::unordered_map<const Texture*, int32_t> mTextureIndices;
+    };
+}
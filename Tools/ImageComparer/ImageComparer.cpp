@@ -234,8 +234,74 @@ bool ImageComparer::onMouseEvent(const MouseEvent& mouseEvent)
     return false;
 }
 
+// Compare -left against the reference -right on the CPU and write the metrics without creating a window
+static int runHeadless(const ArgList& args)
+{
+    Logger::showBoxOnError(false);
+
+    if (args.argExists("left") == false || args.argExists("right") == false)
+    {
+        logError("Headless comparison requires -left <image> and -right <reference image>");
+        return 1;
+    }
+
+    // 8-bit images are sRGB unless -linear is given, like the library default
+    ImageMetrics::Options options;
+    options.ldrIsSrgb = args.argExists("linear") == false;
+    if (args.argExists("exposure"))
+    {
+        options.exposure = args["exposure"].asFloat();
+    }
+    if (args.argExists("tilesize"))
+    {
+        options.tileSize = args["tilesize"].asUint();
+    }
+
+    ImageMetrics::Result result;
+    if (ImageMetrics::compareFiles(args["left"].asString(), args["right"].asString(), options, result) == false)
+    {
+        return 1;
+    }
+
+    logInfo("RMSE " + std::to_string(result.rmse) + ", relMSE " + std::to_string(result.relMse) + ", SSIM " + std::to_string(result.ssim) + ", FLIP " + std::to_string(result.flip));
+
+    if (args.argExists("json") && ImageMetrics::saveJson(args["json"].asString(), result, true) == false)
+    {
+        return 1;
+    }
+
+    if (args.argExists("heatmap"))
+    {
+        ImageMetrics::Metric metric = ImageMetrics::Metric::Flip;
+        if (args.argExists("metric"))
+        {
+            const std::string name = args["metric"].asString();
+            for (auto m : { ImageMetrics::Metric::Rmse, ImageMetrics::Metric::RelMse, ImageMetrics::Metric::Ssim, ImageMetrics::Metric::Flip })
+            {
+                if (_stricmp(name.c_str(), ImageMetrics::getMetricName(m)) == 0)
+                {
+                    metric = m;
+                }
+            }
+        }
+
+        if (ImageMetrics::saveHeatmap(args["heatmap"].asString(), result, metric) == false)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPSTR lpCmdLine, _In_ int nShowCmd)
 {
+    ArgList args;
+    args.parseCommandLine(GetCommandLineA());
+    if (args.argExists("headless"))
+    {
+        return runHeadless(args);
+    }
+
     ImageComparer sceneEditor;
     SampleConfig config;
     config.windowDesc.title = "Image Comparer";
@@ -0,0 +1,543 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "LtcFitter.h"
+#include "Graphics/TextureHelper.h"
+#include "Utils/ParallelFor.h"
+#include <array>
+
+namespace
+{
+    const float kPi = glm::pi<float>();
+
+    // Alpha is clamped away from a perfect mirror and the view angle away from grazing, both are numerically degenerate
+    const float kMinAlpha = 1e-4f;
+    const float kMaxTheta = 0.5f * kPi - 1e-3f;
+
+    // Initial simplex size and convergence threshold of the Nelder-Mead search
+    const float kSimplexDelta = 0.05f;
+    const float kTolerance = 1e-5f;
+
+    /** Microfacet reflection BRDF as evaluated by evalMicrofacetTerms() in SugarBSDFs.slang, in a local frame where N = +z
+    */
+    struct Brdf
+    {
+        LtcFitter::Ndf ndf;
+        float alpha;
+
+        // Uses the tangent plane components of H, which stay accurate for very smooth surfaces
+        float evalD(const glm::vec3& H) const
+        {
+            const float a2 = alpha * alpha;
+            const float sin2 = H.x * H.x + H.y * H.y;
+            const float cos2 = H.z * H.z;
+            if (ndf == LtcFitter::Ndf::Beckmann)
+            {
+                return std::exp(-sin2 / (a2 * cos2)) / (kPi * a2 * cos2 * cos2);
+            }
+            const float denom = sin2 + a2 * cos2;
+            return a2 / (kPi * denom * denom);
+        }
+
+        // Matches GSmith()
+        float evalG1(const glm::vec3& dir, const glm::vec3& h) const
+        {
+            if (glm::dot(dir, h) * dir.z <= 0.0f)
+            {
+                return 0.0f;
+            }
+            const float sinThSq = 1.0f - dir.z * dir.z;
+            if (sinThSq <= 0.0f)
+            {
+                return 1.0f;
+            }
+            const float slope = alpha * std::sqrt(sinThSq) / dir.z;
+            if (ndf == LtcFitter::Ndf::Beckmann)
+            {
+                const float a = 1.0f / slope;
+                if (a > 1.6f)
+                {
+                    return 1.0f;
+                }
+                return (3.535f * a + 2.181f * a * a) / (1.0f + 2.276f * a + 2.577f * a * a);
+            }
+            return 2.0f / (1.0f + std::sqrt(1.0f + slope * slope));
+        }
+
+        /** Evaluate the BRDF times the cosine of L, and the pdf of sample() generating L
+        */
+        float eval(const glm::vec3& V, const glm::vec3& L, float& pdf) const
+        {
+            pdf = 0.0f;
+            if (V.z <= 0.0f || L.z <= 0.0f)
+            {
+                return 0.0f;
+            }
+
+            const glm::vec3 H = glm::normalize(V + L);
+            const float D = evalD(H);
+            pdf = std::abs(D * H.z / (4.0f * glm::dot(V, H)));
+            return D * evalG1(V, H) * evalG1(L, H) / (4.0f * V.z);
+        }
+
+        /** Sample a reflected direction from the distribution of normals
+        */
+        glm::vec3 sample(const glm::vec3& V, float u1, float u2) const
+        {
+            const float a2 = alpha * alpha;
+            const float tanSq = (ndf == LtcFitter::Ndf::Beckmann) ? -a2 * std::log(1.0f - u1) : a2 * u1 / (1.0f - u1);
+            const float cosTheta = 1.0f / std::sqrt(1.0f + tanSq);
+            const float sinTheta = std::sqrt(tanSq) * cosTheta;
+            const float phi = 2.0f * kPi * u2;
+            const glm::vec3 H(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+            return 2.0f * glm::dot(V, H) * H - V;
+        }
+    };
+
+    /** Clamped cosine distribution transformed by M = [X Y Z] * [m11 0 m13; 0 m22 0; 0 0 1]
+    */
+    struct LtcDistribution
+    {
+        float m11 = 1.0f;
+        float m22 = 1.0f;
+        float m13 = 0.0f;
+        glm::vec3 X = glm::vec3(1, 0, 0);
+        glm::vec3 Y = glm::vec3(0, 1, 0);
+        glm::vec3 Z = glm::vec3(0, 0, 1);
+        float amplitude = 1.0f;
+
+        glm::mat3 M;
+        glm::mat3 invM;
+        float detM = 1.0f;
+
+        void update()
+        {
+            M = glm::mat3(X, Y, Z) * glm::mat3(m11, 0, 0, 0, m22, 0, m13, 0, 1);
+            invM = glm::inverse(M);
+            detM = std::abs(glm::determinant(M));
+        }
+
+        float eval(const glm::vec3& L) const
+        {
+            const glm::vec3 original = glm::normalize(invM * L);
+            const float l = glm::length(M * original);
+            const float jacobian = detM / (l * l * l);
+            return amplitude * std::max(0.0f, original.z) / (kPi * jacobian);
+        }
+
+        glm::vec3 sample(float u1, float u2) const
+        {
+            const float cosTheta = std::sqrt(u1);
+            const float sinTheta = std::sqrt(1.0f - u1);
+            const float phi = 2.0f * kPi * u2;
+            return glm::normalize(M * glm::vec3(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta));
+        }
+    };
+
+    struct AverageTerms
+    {
+        float norm = 0.0f;
+        float fresnel = 0.0f;
+        glm::vec3 direction = glm::vec3(0, 0, 1);
+    };
+
+    /** Integrate the BRDF norm, its Schlick Fresnel part and its average direction
+    */
+    AverageTerms computeAverageTerms(const Brdf& brdf, const glm::vec3& V, uint32_t sampleCount)
+    {
+        double norm = 0.0;
+        double fresnel = 0.0;
+        glm::dvec3 direction(0.0);
+
+        for (uint32_t j = 0; j < sampleCount; j++)
+        {
+            for (uint32_t i = 0; i < sampleCount; i++)
+            {
+                const float u1 = (i + 0.5f) / sampleCount;
+                const float u2 = (j + 0.5f) / sampleCount;
+                const glm::vec3 L = brdf.sample(V, u1, u2);
+
+                float pdf;
+                const float value = brdf.eval(V, L, pdf);
+                if (pdf > 0.0f)
+                {
+                    const double weight = value / pdf;
+                    const glm::vec3 H = glm::normalize(V + L);
+                    norm += weight;
+                    fresnel += weight * std::pow(1.0f - std::max(glm::dot(V, H), 0.0f), 5.0f);
+                    direction += weight * glm::dvec3(L);
+                }
+            }
+        }
+
+        const double invCount = 1.0 / (double(sampleCount) * sampleCount);
+        AverageTerms terms;
+        terms.norm = float(norm * invCount);
+        terms.fresnel = float(fresnel * invCount);
+
+        // Isotropic BRDF, the average direction lies in the plane of V and N
+        direction.y = 0.0;
+        if (glm::length(direction) > 0.0)
+        {
+            terms.direction = glm::vec3(glm::normalize(direction));
+        }
+        return terms;
+    }
+
+    /** Fitting error, sampled from both distributions and weighted by the sum of their pdfs
+    */
+    float computeError(const LtcDistribution& ltc, const Brdf& brdf, const glm::vec3& V, uint32_t sampleCount)
+    {
+        double error = 0.0;
+        for (uint32_t j = 0; j < sampleCount; j++)
+        {
+            for (uint32_t i = 0; i < sampleCount; i++)
+            {
+                const float u1 = (i + 0.5f) / sampleCount;
+                const float u2 = (j + 0.5f) / sampleCount;
+
+                for (const glm::vec3& L : { ltc.sample(u1, u2), brdf.sample(V, u1, u2) })
+                {
+                    float pdfBrdf;
+                    const float valueBrdf = brdf.eval(V, L, pdfBrdf);
+                    const float valueLtc = ltc.eval(L);
+                    const float pdfLtc = valueLtc / ltc.amplitude;
+                    const double diff = std::abs(valueBrdf - valueLtc);
+                    if (pdfLtc + pdfBrdf > 0.0f)
+                    {
+                        error += diff * diff * diff / (pdfLtc + pdfBrdf);
+                    }
+                }
+            }
+        }
+        return float(error / (double(sampleCount) * sampleCount));
+    }
+
+    /** Minimize func over Dim parameters with the Nelder-Mead downhill simplex method
+        \param[in,out] params Starting point, replaced with the best point found
+        \return The function value at the best point
+    */
+    template<uint32_t Dim, typename Func>
+    float nelderMead(float params[Dim], float delta, float tolerance, uint32_t maxIterations, Func func)
+    {
+        using Point = std::array<float, Dim>;
+        std::array<Point, Dim + 1> simplex;
+        std::array<float, Dim + 1> values;
+
+        for (uint32_t i = 0; i < Dim + 1; i++)
+        {
+            std::copy(params, params + Dim, simplex[i].begin());
+            if (i > 0)
+            {
+                simplex[i][i - 1] += delta;
+            }
+            values[i] = func(simplex[i].data());
+        }
+
+        auto lerpPoint = [](const Point& a, const Point& b, float t)
+        {
+            Point p;
+            for (uint32_t d = 0; d < Dim; d++)
+            {
+                p[d] = a[d] + t * (b[d] - a[d]);
+            }
+            return p;
+        };
+
+        for (uint32_t iteration = 0; iteration < maxIterations; iteration++)
+        {
+            // Find the best, worst and second worst vertices
+            uint32_t best = 0;
+            uint32_t worst = 0;
+            for (uint32_t i = 1; i < Dim + 1; i++)
+            {
+                if (values[i] < values[best]) best = i;
+                if (values[i] > values[worst]) worst = i;
+            }
+            uint32_t secondWorst = best;
+            for (uint32_t i = 0; i < Dim + 1; i++)
+            {
+                if (i != worst && values[i] > values[secondWorst]) secondWorst = i;
+            }
+
+            if (std::abs(values[worst] - values[best]) < tolerance)
+            {
+                break;
+            }
+
+            Point centroid = {};
+            for (uint32_t i = 0; i < Dim + 1; i++)
+            {
+                if (i == worst) continue;
+                for (uint32_t d = 0; d < Dim; d++)
+                {
+                    centroid[d] += simplex[i][d] / Dim;
+                }
+            }
+
+            const Point reflected = lerpPoint(centroid, simplex[worst], -1.0f);
+            const float reflectedValue = func(reflected.data());
+
+            if (reflectedValue < values[best])
+            {
+                const Point expanded = lerpPoint(centroid, simplex[worst], -2.0f);
+                const float expandedValue = func(expanded.data());
+                const bool useExpanded = expandedValue < reflectedValue;
+                simplex[worst] = useExpanded ? expanded : reflected;
+                values[worst] = useExpanded ? expandedValue : reflectedValue;
+                continue;
+            }
+
+            if (reflectedValue < values[secondWorst])
+            {
+                simplex[worst] = reflected;
+                values[worst] = reflectedValue;
+                continue;
+            }
+
+            // Contract towards the better of the worst and the reflected vertex
+            const bool outside = reflectedValue < values[worst];
+            const Point contracted = lerpPoint(centroid, outside ? reflected : simplex[worst], 0.5f);
+            const float contractedValue = func(contracted.data());
+            if (contractedValue < std::min(reflectedValue, values[worst]))
+            {
+                simplex[worst] = contracted;
+                values[worst] = contractedValue;
+                continue;
+            }
+
+            // Shrink everything towards the best vertex
+            for (uint32_t i = 0; i < Dim + 1; i++)
+            {
+                if (i == best) continue;
+                simplex[i] = lerpPoint(simplex[best], simplex[i], 0.5f);
+                values[i] = func(simplex[i].data());
+            }
+        }
+
+        uint32_t best = 0;
+        for (uint32_t i = 1; i < Dim + 1; i++)
+        {
+            if (values[i] < values[best]) best = i;
+        }
+        std::copy(simplex[best].begin(), simplex[best].end(), params);
+        return values[best];
+    }
+
+    /** Per-cell fitting state. m11/m22/m13 carry the seed in and the fitted parameters out.
+    */
+    struct Cell
+    {
+        LtcDistribution ltc;
+        float fresnel = 0.0f;
+        float error = 0.0f;
+    };
+
+    void fitCell(const LtcFitter::Options& options, uint32_t roughnessIndex, uint32_t thetaIndex, Cell& cell)
+    {
+        const float scale = 1.0f / float(options.size - 1);
+        const float roughness = roughnessIndex * scale;
+        const float theta = std::min(thetaIndex * scale * 0.5f * kPi, kMaxTheta);
+
+        Brdf brdf;
+        brdf.ndf = options.ndf;
+        brdf.alpha = std::max(roughness * roughness, kMinAlpha);
+        const glm::vec3 V(std::sin(theta), 0.0f, std::cos(theta));
+
+        const AverageTerms terms = computeAverageTerms(brdf, V, options.sampleCount);
+        LtcDistribution& ltc = cell.ltc;
+        ltc.amplitude = terms.norm;
+        cell.fresnel = terms.fresnel;
+
+        // At normal incidence the lobe is rotationally symmetric, otherwise align the frame with the average direction
+        const bool isotropic = (thetaIndex == 0);
+        if (isotropic)
+        {
+            ltc.X = glm::vec3(1, 0, 0);
+            ltc.Y = glm::vec3(0, 1, 0);
+            ltc.Z = glm::vec3(0, 0, 1);
+        }
+        else
+        {
+            const glm::vec3& L = terms.direction;
+            ltc.X = glm::vec3(L.z, 0, -L.x);
+            ltc.Y = glm::vec3(0, 1, 0);
+            ltc.Z = L;
+        }
+
+        auto setParams = [&ltc, isotropic](const float* params)
+        {
+            ltc.m11 = std::max(params[0], 1e-7f);
+            ltc.m22 = isotropic ? ltc.m11 : std::max(params[1], 1e-7f);
+            ltc.m13 = isotropic ? 0.0f : params[2];
+            ltc.update();
+        };
+
+        auto objective = [&](const float* params)
+        {
+            setParams(params);
+            return computeError(ltc, brdf, V, options.sampleCount);
+        };
+
+        if (isotropic)
+        {
+            float params[1] = { ltc.m11 };
+            cell.error = nelderMead<1>(params, kSimplexDelta, kTolerance, options.maxIterations, objective);
+            setParams(params);
+        }
+        else
+        {
+            float params[3] = { ltc.m11, ltc.m22, ltc.m13 };
+            cell.error = nelderMead<3>(params, kSimplexDelta, kTolerance, options.maxIterations, objective);
+            setParams(params);
+        }
+    }
+}
+
+void LtcFitter::fit(const Options& options, Result& result)
+{
+    const uint32_t size = std::max(options.size, 2u);
+    Options cellOptions = options;
+    cellOptions.size = size;
+
+    // Index by [theta][roughness], like the texture rows
+    std::vector<Cell> cells(size * size);
+    auto cell = [&cells, size](uint32_t r, uint32_t t) -> Cell& { return cells[t * size + r]; };
+
+    CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+
+    // Normal incidence first, from rough to smooth. Each cell starts from its rougher neighbour.
+    for (uint32_t r = size; r-- > 0;)
+    {
+        Cell& c = cell(r, 0);
+        if (r + 1 < size)
+        {
+            c.ltc.m11 = c.ltc.m22 = cell(r + 1, 0).ltc.m11;
+        }
+        fitCell(cellOptions, r, 0, c);
+    }
+
+    // Roughness rows are independent from here on. Within a row each view angle starts from the previous one.
+    parallelFor(0, size, [&](size_t r)
+    {
+        for (uint32_t t = 1; t < size; t++)
+        {
+            Cell& c = cell((uint32_t)r, t);
+            const LtcDistribution& seed = cell((uint32_t)r, t - 1).ltc;
+            c.ltc.m11 = seed.m11;
+            c.ltc.m22 = seed.m22;
+            c.ltc.m13 = seed.m13;
+            fitCell(cellOptions, (uint32_t)r, t, c);
+        }
+    });
+
+    result.size = size;
+    result.mat.resize(cells.size());
+    result.amp.resize(cells.size());
+    result.error.resize(cells.size());
+
+    for (size_t i = 0; i < cells.size(); i++)
+    {
+        // Normalize so that m00 = 1, which ltcMatrix() assumes. glm matrices are indexed [column][row].
+        glm::mat3 invM = glm::inverse(cells[i].ltc.M);
+        invM /= invM[0][0];
+        result.mat[i] = glm::vec4(invM[2][2], invM[0][2], invM[1][1], invM[2][0]);
+        result.amp[i] = glm::vec2(cells[i].ltc.amplitude, cells[i].fresnel);
+        result.error[i] = cells[i].error;
+    }
+
+    const double seconds = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) * 0.001;
+    logInfo("Fitted " + std::to_string(size) + "x" + std::to_string(size) + " " + getNdfName(options.ndf) + " LTC table in " + std::to_string(seconds) + "s on " +
+        std::to_string(getParallelWorkerCount()) + " threads.");
+}
+
+bool LtcFitter::save(const Result& result, const std::string& matFilename, const std::string& ampFilename)
+{
+    return saveTextureDataToDDSFile(matFilename, result.size, result.size, ResourceFormat::RGBA32Float, result.mat.data()) &&
+        saveTextureDataToDDSFile(ampFilename, result.size, result.size, ResourceFormat::RG32Float, result.amp.data());
+}
+
+const char* LtcFitter::getNdfName(Ndf ndf)
+{
+    switch (ndf)
+    {
+    case Ndf::Ggx:
+        return "GGX";
+    case Ndf::Beckmann:
+        return "Beckmann";
+    default:
+        should_not_get_here();
+        return "";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Logger::showBoxOnError(false);
+
+    ArgList args;
+    args.parseCommandLine(concatCommandLine(argc, argv));
+
+    LtcFitter::Options options;
+    if (args.argExists("ndf"))
+    {
+        const std::string ndf = args["ndf"].asString();
+        if (_stricmp(ndf.c_str(), LtcFitter::getNdfName(LtcFitter::Ndf::Beckmann)) == 0)
+        {
+            options.ndf = LtcFitter::Ndf::Beckmann;
+        }
+        else if (_stricmp(ndf.c_str(), LtcFitter::getNdfName(LtcFitter::Ndf::Ggx)) != 0)
+        {
+            logError("Unknown NDF " + ndf + ". Use -ndf ggx or -ndf beckmann.");
+            return 1;
+        }
+    }
+    if (args.argExists("size"))
+    {
+        options.size = args["size"].asUint();
+    }
+    if (args.argExists("samples"))
+    {
+        options.sampleCount = args["samples"].asUint();
+    }
+    if (args.argExists("iterations"))
+    {
+        options.maxIterations = args["iterations"].asUint();
+    }
+
+    const std::string outDir = args.argExists("out") ? args["out"].asString() : ".";
+
+    LtcFitter::Result result;
+    LtcFitter::fit(options, result);
+
+    if (LtcFitter::save(result, outDir + "/ltc_mat.dds", outDir + "/ltc_amp.dds") == false)
+    {
+        return 1;
+    }
+    logInfo("Saved ltc_mat.dds and ltc_amp.dds to " + outDir);
+    return 0;
+}
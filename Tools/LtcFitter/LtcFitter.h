@@ -0,0 +1,73 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include "Falcor.h"
+
+using namespace Falcor;
+
+/** Offline fitter for the linearly transformed cosine (LTC) tables used by the polygonal light shading in LTC.slang.
+    Every (roughness, view angle) cell is fitted with Nelder-Mead against the microfacet BRDF as Sugar evaluates it, i.e. the NDF with separable Smith shadowing/masking.
+    The table is laid out like the shader expects: x is sqrt(alpha), y is the view angle over [0, pi/2].
+*/
+class LtcFitter
+{
+public:
+    /** Normal distribution functions that can be fitted. Match NDFGGX/NDFBeckmann in SugarBSDFs.slang.
+    */
+    enum class Ndf
+    {
+        Ggx,
+        Beckmann
+    };
+
+    struct Options
+    {
+        Ndf ndf = Ndf::Ggx;
+        uint32_t size = 64;             ///< Table resolution along both axes
+        uint32_t sampleCount = 32;      ///< Samples per dimension used to integrate the BRDF and the fitting error
+        uint32_t maxIterations = 100;   ///< Nelder-Mead iteration limit per cell
+    };
+
+    struct Result
+    {
+        uint32_t size = 0;
+        std::vector<glm::vec4> mat;     ///< Normalized inverse matrix per cell, stored as (m22, m20, m11, m02) like ltcMatrix() reads it
+        std::vector<glm::vec2> amp;     ///< BRDF norm and its Schlick Fresnel part per cell
+        std::vector<float> error;       ///< Final fitting error per cell
+    };
+
+    /** Fit a table. Cells are fitted in parallel, each one seeded with the result of an already fitted neighbour.
+    */
+    static void fit(const Options& options, Result& result);
+
+    /** Write the fitted table as ltc_mat/ltc_amp DDS files.
+    */
+    static bool save(const Result& result, const std::string& matFilename, const std::string& ampFilename);
+
+    static const char* getNdfName(Ndf ndf);
+};